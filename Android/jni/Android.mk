@@ -62,6 +62,7 @@ LOCAL_SRC_FILES  := \
   src/Fl_File_Chooser2.cxx \
   src/Fl_File_Icon.cxx \
   src/Fl_File_Input.cxx \
+  src/Fl_Framebuffer_Surface.cxx \
   src/Fl_Graphics_Driver.cxx \
   src/Fl_Group.cxx \
   src/Fl_Help_View.cxx \
@@ -183,6 +184,7 @@ LOCAL_SRC_FILES  := \
   src/drivers/Pico/Fl_Pico_Screen_Driver.cxx \
   src/drivers/Pico/Fl_Pico_Window_Driver.cxx \
   src/drivers/Pico/Fl_Pico_Graphics_Driver.cxx \
+  src/drivers/Pico/Fl_Pico_Framebuffer_Graphics_Driver.cxx \
   src/drivers/Pico/Fl_Pico_Copy_Surface.cxx \
   src/drivers/Pico/Fl_Pico_Image_Surface.cxx \
   src/drivers/PicoAndroid/Fl_PicoAndroid_System_Driver.cxx \
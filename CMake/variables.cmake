@@ -50,6 +50,15 @@ endif(LIB_jpeg)
 string(REPLACE ";" " " IMAGELIBS "${IMAGELIBS}")
 set(STATICIMAGELIBS "${IMAGELIBS}")
 
+# the PostScript driver of the core library compresses images with zlib
+if(FLTK_BUILTIN_ZLIB_FOUND)
+   set(ZLIBLIBS "-lfltk_z")
+   set(STATICZLIBLIBS "\${libdir}/libfltk_z.a")
+else()
+   set(ZLIBLIBS "-lz")
+   set(STATICZLIBLIBS "-lz")
+endif(FLTK_BUILTIN_ZLIB_FOUND)
+
 #######################################################################
 set(CC ${CMAKE_C_COMPILER})
 set(CXX ${CMAKE_CXX_COMPILER})
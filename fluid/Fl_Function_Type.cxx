@@ -20,6 +20,7 @@
 #include <FL/Fl_Preferences.H>
 #include <FL/Fl_File_Chooser.H>
 #include "Fl_Type.h"
+#include "undo.h"
 #include <FL/fl_show_input.H>
 #include <FL/Fl_File_Chooser.H>
 #include "alignment_panel.h"
@@ -235,6 +236,7 @@ void Fl_Function_Type::open() {
     }
     if (c) free((void*)c);
     if (mod) set_modflag(1);
+    undo_changed(this, 0);
     break;
   }
 BREAK2:
@@ -468,6 +470,7 @@ void Fl_Code_Type::open() {
     message = c_check(c); if (message) continue;
     name(c);
     free(c);
+    undo_changed(this, 0);
     break;
   }
 BREAK2:
@@ -559,6 +562,7 @@ void Fl_CodeBlock_Type::open() {
     c = code_after_input->value();
     message = c_check(c); if (message) continue;
     storestring(c, after);
+    undo_changed(this, 0);
     break;
   }
 BREAK2:
@@ -686,6 +690,7 @@ void Fl_Decl_Type::open() {
       comment(0);
     }
     if (c) free((void*)c);
+    undo_changed(this, 0);
     break;
   }
 BREAK2:
@@ -884,6 +889,7 @@ void Fl_Data_Type::open() {
       comment(0);
     }
     if (c) free((void*)c);
+    undo_changed(this, 0);
     break;
   }
 BREAK2:
@@ -1031,6 +1037,7 @@ void Fl_DeclBlock_Type::open() {
       public_ = declblock_public_choice->value();
       redraw_browser();
     }
+    undo_changed(this, 0);
     break;
   }
 BREAK2:
@@ -1217,6 +1224,7 @@ void Fl_Comment_Type::open() {
       mod = 1;
     }
     if (mod) set_modflag(1);
+    undo_changed(this, 0);
     break;
   }
 BREAK2:
@@ -1434,6 +1442,7 @@ void Fl_Class_Type::open() {
       comment(0);
     }
     if (c) free((void*)c);
+    undo_changed(this, 0);
     break;
   }
 BREAK2:
@@ -25,6 +25,7 @@
 #include <FL/Fl_Table.H>
 #include <FL/fl_message.H>
 #include "Fl_Widget_Type.h"
+#include "undo.h"
 #include "../src/flstring.h"
 
 // Override group's resize behavior to do nothing to children:
@@ -54,6 +55,8 @@ void fix_group_size(Fl_Type *tt) {
     int r = x+n->o->w();if (r > R) R = r;
     int b = y+n->o->h();if (b > B) B = b;
   }
+  if (X != t->o->x() || Y != t->o->y() || R-X != t->o->w() || B-Y != t->o->h())
+    undo_changed(t, 0);
   t->o->resize(X,Y,R-X,B-Y);
 }
 
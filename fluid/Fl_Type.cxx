@@ -549,6 +549,8 @@ Fl_Type::Fl_Type() {
   callback_ = 0;
   comment_ = 0;
   rtti = 0;
+  undo_dirty = 2;
+  undo_node = -1;
   level = 0;
   code_position = header_position = -1;
   code_position_end = header_position_end = -1;
@@ -606,6 +608,7 @@ void Fl_Type::add(Fl_Type *p) {
   if (p) p->add_child(this,0);
   open_ = 1;
   fixvisible(this);
+  undo_changed(this);
   set_modflag(1);
   widget_browser->redraw();
 }
@@ -625,6 +628,7 @@ void Fl_Type::insert(Fl_Type *g) {
   g->prev = end;
   fixvisible(this);
   if (parent) parent->add_child(this, g);
+  undo_changed(this);
   widget_browser->redraw();
 }
 
@@ -695,31 +699,34 @@ int storestring(const char *n, const char * & p, int nostrip) {
 void Fl_Type::name(const char *n) {
   int nostrip = is_comment();
   if (storestring(n,name_,nostrip)) {
+    undo_changed(this, 0);
     if (visible) widget_browser->redraw();
   }
 }
 
 void Fl_Type::label(const char *n) {
   if (storestring(n,label_,1)) {
+    undo_changed(this, 0);
     setlabel(label_);
     if (visible && !name_) widget_browser->redraw();
   }
 }
 
 void Fl_Type::callback(const char *n) {
-  storestring(n,callback_);
+  if (storestring(n,callback_)) undo_changed(this, 0);
 }
 
 void Fl_Type::user_data(const char *n) {
-  storestring(n,user_data_);
+  if (storestring(n,user_data_)) undo_changed(this, 0);
 }
 
 void Fl_Type::user_data_type(const char *n) {
-  storestring(n,user_data_type_);
+  if (storestring(n,user_data_type_)) undo_changed(this, 0);
 }
 
 void Fl_Type::comment(const char *n) {
   if (storestring(n,comment_,1)) {
+    undo_changed(this, 0);
     if (visible) widget_browser->redraw();
   }
 }
@@ -842,6 +849,7 @@ void delete_all(int selected_only) {
   if(!selected_only) {
 		include_H_from_C=1;
 		use_FL_COMMAND=0;
+		compress_images=0;
 	}
 
   selection_changed(0);
@@ -958,6 +966,8 @@ void Fl_Type::write_properties() {
     write_word("comment");
     write_word(comment());
   }
+  // the undo system keeps the state of the browser apart:
+  if (undo_writing) return;
   if (is_parent() && open_) write_word("open");
   if (selected) write_word("selected");
 }
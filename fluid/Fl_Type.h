@@ -31,6 +31,7 @@
 #include "Fluid_Image.h"
 #include <FL/fl_draw.H>
 #include <stdarg.h>
+#include <stdio.h>
 
 #ifdef WIN32
   #include "ExternalCodeEditor_WIN32.h"
@@ -66,6 +67,8 @@ public:	// things that should not be public:
   char open_;	// state of triangle in browser
   char visible; // true if all parents are open
   char rtti;	// hack because I have no rtti, this is 0 for base class
+  char undo_dirty; // changed since the undo system wrote it, see undo_changed()
+  int undo_node; // where the undo system wrote it
   int level;	// number of parents over this
   static Fl_Type *first, *last; // linked list of all objects
   Fl_Type *next, *prev;	// linked list of all objects
@@ -855,6 +858,8 @@ int has_toplevel_function(const char *rtype, const char *sig);
 void write_word(const char *);
 void write_string(const char *,...) __fl_attr((__format__ (__printf__, 1, 2)));
 int write_file(const char *, int selected_only = 0);
+void write_file_header(int selected_only);
+void write_stream(FILE *);
 int write_code(const char *cfile, const char *hfile);
 int write_strings(const char *sfile);
 
@@ -877,6 +882,7 @@ extern int indentation;
 extern const char* indent();
 
 int read_file(const char *, int merge);
+int read_stream(FILE *, Fl_Type *parent, long end);
 const char *read_word(int wantbrace = 0);
 void read_error(const char *format, ...);
 
@@ -888,6 +894,7 @@ int storestring(const char *n, const char * & p, int nostrip=0);
 
 extern int include_H_from_C;
 extern int use_FL_COMMAND;
+extern int compress_images;
 
 /*
  * This class is needed for additional command line plugins.
@@ -22,6 +22,7 @@
 #include <FL/Fl_Input.H>
 #include "Fl_Widget_Type.h"
 #include "alignment_panel.h"
+#include "undo.h"
 #include <FL/fl_message.H>
 #include <FL/Fl_Slider.H>
 #include <FL/Fl_Spinner.H>
@@ -210,7 +211,12 @@ Fl_Widget_Type::Fl_Widget_Type() {
 Fl_Widget_Type::~Fl_Widget_Type() {
   if (o) {
     o->hide();
-    if (o->parent()) ((Fl_Group*)o->parent())->remove(*o);
+    Fl_Group *p = o->parent();
+    if (p) {
+      // don't leave the parent with a dangling resizable():
+      if (p->resizable() == o) p->resizable(p);
+      p->remove(*o);
+    }
     delete o;
   }
   if (subclass_) free((void*)subclass_);
@@ -229,28 +235,30 @@ Fl_Widget_Type::~Fl_Widget_Type() {
 }
 
 void Fl_Widget_Type::extra_code(int m,const char *n) {
-  storestring(n,extra_code_[m]);
+  if (storestring(n,extra_code_[m])) undo_changed(this, 0);
 }
 
 extern void redraw_browser();
 void Fl_Widget_Type::subclass(const char *n) {
-  if (storestring(n,subclass_) && visible)
-    redraw_browser();
+  if (storestring(n,subclass_)) {
+    undo_changed(this, 0);
+    if (visible) redraw_browser();
+  }
 }
 
 void Fl_Widget_Type::tooltip(const char *n) {
-  storestring(n,tooltip_);
+  if (storestring(n,tooltip_)) undo_changed(this, 0);
   o->tooltip(n);
 }
 
 void Fl_Widget_Type::image_name(const char *n) {
   setimage(Fluid_Image::find(n));
-  storestring(n,image_name_);
+  if (storestring(n,image_name_)) undo_changed(this, 0);
 }
 
 void Fl_Widget_Type::inactive_name(const char *n) {
   setinactive(Fluid_Image::find(n));
-  storestring(n,inactive_name_);
+  if (storestring(n,inactive_name_)) undo_changed(this, 0);
 }
 
 void Fl_Widget_Type::redraw() {
@@ -866,13 +874,18 @@ uchar Fl_Widget_Type::resizable() const {
 void Fl_Widget_Type::resizable(uchar v) {
   if (v) {
     if (resizable()) return;
-    if (is_window()) ((Fl_Window*)o)->resizable(o);
-    else {
+    if (is_window()) {
+      ((Fl_Window*)o)->resizable(o);
+      undo_changed(this, 0);
+    } else {
       Fl_Group* p = (Fl_Group*)o->parent();
       if (p) p->resizable(o);
+      // the widget that was resizable before is one of the siblings:
+      if (parent) undo_changed(parent);
     }
   } else {
     if (!resizable()) return;
+    undo_changed(this, 0);
     if (is_window()) {
       ((Fl_Window*)o)->resizable(0);
     } else {
@@ -903,11 +916,13 @@ void hotspot_cb(Fl_Light_Button* i,void* v) {
     i->value(current_widget->hotspot());
   } else {
     current_widget->hotspot(i->value());
+    undo_changed(current_widget, 0);
     if (current_widget->is_menu_item()) {current_widget->redraw(); return;}
     if (i->value()) {
       Fl_Type *p = current_widget->parent;
       if (!p || !p->is_widget()) return;
       while (!p->is_window()) p = p->parent;
+      undo_changed(p);
       for (Fl_Type *o = p->next; o && o->level > p->level; o = o->next) {
 	if (o->is_widget() && o != current_widget)
 	  ((Fl_Widget_Type*)o)->hotspot(0);
@@ -2435,7 +2450,12 @@ void Fl_Widget_Type::write_properties() {
     write_string("deimage");
     write_word(inactive_name());
   }
-  write_string("xywh {%d %d %d %d}", o->x(), o->y(), o->w(), o->h());
+  if (undo_writing && is_window() && !(parent && parent->is_widget())) {
+    // where the window is on the screen is no change to the design
+    write_string("xywh {0 0 %d %d}", o->w(), o->h());
+  } else {
+    write_string("xywh {%d %d %d %d}", o->x(), o->y(), o->w(), o->h());
+  }
   Fl_Widget* tplate = ((Fl_Widget_Type*)factory)->o;
   if (is_spinner() && ((Fl_Spinner*)o)->type() != ((Fl_Spinner*)tplate)->type()) {
     write_string("type");
@@ -41,6 +41,7 @@ extern int show_guides;
 
 int include_H_from_C = 1;
 int use_FL_COMMAND = 0;
+int compress_images = 0;
 extern int i18n_type;
 extern const char* i18n_include;
 extern const char* i18n_function;
@@ -183,6 +184,7 @@ void show_project_cb(Fl_Widget *, void *) {
   if(project_window==0) make_project_window();
   include_H_from_C_button->value(include_H_from_C);
   use_FL_COMMAND_button->value(use_FL_COMMAND);
+  compress_images_button->value(compress_images);
   header_file_input->value(header_file_name);
   code_file_input->value(code_file_name);
   i18n_type_chooser->value(i18n_type);
@@ -266,6 +268,13 @@ void use_FL_COMMAND_button_cb(Fl_Check_Button* b, void*) {
   }
 }
 
+void compress_images_button_cb(Fl_Check_Button* b, void*) {
+  if (compress_images != b->value()) {
+    set_modflag(1);
+    compress_images = b->value();
+  }
+}
+
 ////////////////////////////////////////////////////////////////
 
 Fl_Menu_Item window_type_menu[] = {
@@ -483,8 +492,8 @@ void xclass_cb(Fl_Input* i, void* v) {
       if (o->selected && o->is_widget()) {
         mod = 1;
 	Fl_Widget_Type* w = (Fl_Widget_Type*)o;
-	if (w->is_window() || w->is_button())
-	  storestring(i->value(),w->xclass);
+	if ((w->is_window() || w->is_button()) && storestring(i->value(),w->xclass))
+	  undo_changed(w, 0);
 	if (w->is_window()) ((Fl_Window*)(w->o))->xclass(w->xclass);
 	else if (w->is_menu_item()) w->redraw();
       }
@@ -509,8 +518,10 @@ void Overlay_Window::resize(int X,int Y,int W,int H) {
   // do not set the mod flag if the window was not resized. In FLUID, all
   // windows are opened without a given x/y position, so modifying x/y
   // should not mark the project as dirty
-  if (W!=w() || H!=h())
+  if (W!=w() || H!=h()) {
+    if (window) undo_changed(window);
     set_modflag(1);
+  }
 
   Fl_Overlay_Window::resize(X,Y,W,H);
   resizable(t);
@@ -1381,7 +1392,7 @@ void Fl_Window_Type::write_properties() {
   if (xclass) {write_string("xclass"); write_word(xclass);}
   if (sr_min_w || sr_min_h || sr_max_w || sr_max_h)
     write_string("size_range {%d %d %d %d}", sr_min_w, sr_min_h, sr_max_w, sr_max_h);
-  if (o->visible()) write_string("visible");
+  if (o->visible() && !undo_writing) write_string("visible");
 }
 
 extern int pasteoffset;
@@ -26,6 +26,9 @@
 #include <stdlib.h>
 #include <stdarg.h>
 #include <FL/filename.H>
+#if HAVE_LIBZ
+#  include <zlib.h>
+#endif
 
 extern void goto_source_dir(); // in fluid.cxx
 extern void leave_source_dir(); // in fluid.cxx
@@ -43,8 +46,171 @@ static int bitmap_header_written = 0;
 static int image_header_written = 0;
 static int jpeg_header_written = 0;
 
+static char *read_binary(const char *name, int &length) {
+  length = 0;
+  FILE *f = fl_fopen(name, "rb");
+  if (!f) return 0;
+  fseek(f, 0, SEEK_END);
+  size_t nData = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  char *data = 0;
+  if (nData) {
+    data = (char*)calloc(nData, 1);
+    if (fread(data, nData, 1, f)==0) { /* ignore */ }
+    length = (int)nData;
+  }
+  fclose(f);
+  return data;
+}
+
+#if HAVE_LIBZ
+
+// The shared images written to the current code file. Their functions are
+// named after their data, so two images with the same data must only be
+// written once per file.
+static unsigned *shared_images = 0;
+static int shared_count = 0, shared_size = 0, shared_written = 0;
+
+// a 32 bit FNV-1a and a djb2 hash, the pair names the data
+static void hash_data(unsigned *k, const void *data, size_t n) {
+  const unsigned char *p = (const unsigned char *)data;
+  while (n--) {
+    k[0] = (k[0] ^ *p) * 16777619u;
+    k[1] = k[1] * 33 + *p++;
+  }
+}
+
+static void hash_int(unsigned *k, int i) {
+  hash_data(k, &i, sizeof(i));
+}
+
+// Adds the image with this hash to the current code file, returns 0 if
+// it is already in it.
+static int add_shared(const unsigned *hash) {
+  if (shared_written != write_number) {
+    shared_count = 0;
+    shared_written = write_number;
+  }
+  for (int i = 0; i < shared_count; i++)
+    if (shared_images[2*i] == hash[0] && shared_images[2*i+1] == hash[1]) return 0;
+  if (shared_count >= shared_size) {
+    shared_size = shared_size ? 2 * shared_size : 16;
+    shared_images = (unsigned*)realloc(shared_images, 2 * shared_size * sizeof(unsigned));
+  }
+  shared_images[2*shared_count] = hash[0];
+  shared_images[2*shared_count+1] = hash[1];
+  shared_count++;
+  return 1;
+}
+
+// Returns the image data in the form fl_inflate_image() reads, the lines
+// of a pixmap each end with a nul byte. The caller frees the data.
+static char *image_data(Fl_Shared_Image *img, int &length) {
+  if (img->count() > 1) {
+    int ncolors, chars_per_color;
+    sscanf(img->data()[0], "%*d%*d%d%d", &ncolors, &chars_per_color);
+    int n = ncolors < 0 ? 2 : ncolors + 1;
+    int i;
+    length = 0;
+    for (i = 0; i < img->count(); i++) {
+      if (i == 1 && ncolors < 0) length += ncolors * -4 + 1;
+      else if (i < n) length += (int)strlen(img->data()[i]) + 1;
+      else length += img->w() * chars_per_color + 1;
+    }
+    char *data = (char*)malloc(length), *p = data;
+    for (i = 0; i < img->count(); i++) {
+      int len;
+      if (i == 1 && ncolors < 0) len = ncolors * -4;
+      else if (i < n) len = (int)strlen(img->data()[i]);
+      else len = img->w() * chars_per_color;
+      memcpy(p, img->data()[i], len);
+      p[len] = 0;
+      p += len + 1;
+    }
+    return data;
+  }
+  if (img->d() == 0) length = ((img->w() + 7) / 8) * img->h();
+  else {
+    const int extra_data = img->ld() ? (img->ld()-img->w()*img->d()) : 0;
+    length = (img->w() * img->d() + extra_data) * img->h();
+  }
+  char *data = (char*)malloc(length);
+  memcpy(data, img->data()[0], length);
+  return data;
+}
+
+/* Writes the image as an inline function named after a hash of its data.
+ The data is compressed, except for JPEG files. The linker keeps one copy of
+ the function and its static image for the whole program, so an image that
+ several .fl files use is stored and decoded once. */
+void Fluid_Image::write_shared() {
+  int jpeg = strcmp(fl_filename_ext(name()), ".jpg") == 0;
+  int length = 0;
+  char *data = jpeg ? read_binary(name(), length) : image_data(img, length);
+  int d = img->count() > 1 ? -1 : img->d();
+  unsigned hash[2] = { 2166136261u, 5381 };
+  hash_data(hash, data, length);
+  if (jpeg) {
+    // the name is part of the code written for a JPEG image
+    hash_data(hash, fl_filename_name(name()), strlen(fl_filename_name(name())));
+  } else {
+    hash_int(hash, img->w());
+    hash_int(hash, img->h());
+    hash_int(hash, d);
+    hash_int(hash, img->ld());
+  }
+  snprintf(shared_name_, sizeof(shared_name_), "fluid_image_%08x%08x", hash[0], hash[1]);
+  function_name_ = shared_name_;
+  if (!add_shared(hash)) {
+    free(data);
+    return;
+  }
+
+  write_c("\n");
+  if (jpeg) {
+    if (jpeg_header_written != write_number) {
+      write_c("#include <FL/Fl_JPEG_Image.H>\n");
+      jpeg_header_written = write_number;
+    }
+  } else if (image_header_written != write_number) {
+    write_c("#include <FL/Fl_Image.H>\n");
+    image_header_written = write_number;
+  }
+  write_c("inline Fl_Image *%s() {\n", function_name_);
+  write_c("  // %s\n", fl_filename_name(name()));
+  write_c("  static const unsigned char data[] =\n");
+  if (jpeg) {
+    write_cdata(data, length);
+    write_c(";\n  static Fl_Image *image = new Fl_JPEG_Image(\"%s\", data);\n",
+            fl_filename_name(name()));
+  } else {
+    uLongf size = compressBound((uLong)length);
+    Bytef *packed = (Bytef*)malloc(size);
+    if (compress2(packed, &size, (const Bytef*)data, (uLong)length, Z_BEST_COMPRESSION) != Z_OK ||
+        size >= (uLongf)length) {
+      // tiny images get larger, they are written as they are
+      size = (uLongf)length;
+      memcpy(packed, data, length);
+    }
+    write_cdata((const char*)packed, (int)size);
+    write_c(";\n  static Fl_Image *image = fl_inflate_image(data, %d, %d, %d, %d, %d, %d);\n",
+            (int)size, length, img->w(), img->h(), d, img->ld());
+    free(packed);
+  }
+  write_c("  return image;\n}\n");
+  free(data);
+}
+
+#endif // HAVE_LIBZ
+
 void Fluid_Image::write_static() {
   if (!img) return;
+#if HAVE_LIBZ
+  if (compress_images) {
+    write_shared();
+    return;
+  }
+#endif
   const char *idata_name = unique_id(this, "idata", fl_filename_name(name()), 0);
   function_name_ = unique_id(this, "image", fl_filename_name(name()), 0);
   if (img->count() > 1) {
@@ -97,22 +263,13 @@ void Fluid_Image::write_static() {
     }
     write_c("static const unsigned char %s[] =\n", idata_name);
 
-    FILE *f = fl_fopen(name(), "rb");
-    if (!f) {
-      // message = "Can't include binary file. Can't open";
-    } else {
-      fseek(f, 0, SEEK_END);
-      size_t nData = ftell(f);
-      fseek(f, 0, SEEK_SET);
-      if (nData) {
-        char *data = (char*)calloc(nData, 1);
-        if (fread(data, nData, 1, f)==0) { /* ignore */ }
-        write_cdata(data, nData);
-        free(data);
-      }
-      fclose(f);
+    int nData;
+    char *data = read_binary(name(), nData);
+    if (data) {
+      write_cdata(data, nData);
+      free(data);
     }
-    
+
     write_c(";\n");
     write_initializer("Fl_JPEG_Image", "\"%s\", %s", fl_filename_name(name()), idata_name);
   } else {
@@ -31,6 +31,8 @@ class Fluid_Image {
   int refcount;
   Fl_Shared_Image *img;
   const char *function_name_;
+  char shared_name_[32];
+  void write_shared();
 protected:
   Fluid_Image(const char *name); // no public constructor
   ~Fluid_Image(); // no public destructor
@@ -44,21 +44,37 @@ int is_id(char c) {
 ////////////////////////////////////////////////////////////////
 // Generate unique but human-readable identifiers:
 
+// The names are kept in a hash table, so that a design with many widgets
+// does not search a long list for each of them.
+
 struct id {
   char* text;
   void* object;
-  id *left, *right;
-  id (const char* t, void* o) : text(strdup(t)), object(o) {left = right = 0;}
-  ~id();
+  unsigned hash;
+  id* next;
 };
 
-id::~id() {
-  delete left;
-  free((void *)text);
-  delete right;
+static id** id_table;
+static int id_table_size, id_count;
+
+static unsigned id_hash(const char* s) {
+  unsigned h = 2166136261u;
+  while (*s) h = (h ^ (unsigned char)*s++) * 16777619u;
+  return h;
 }
 
-static id* id_root;
+static void clear_ids() {
+  for (int i = 0; i < id_table_size; i++) {
+    for (id *p = id_table[i], *next; p; p = next) {
+      next = p->next;
+      free((void *)p->text);
+      delete p;
+    }
+  }
+  free(id_table);
+  id_table = 0;
+  id_table_size = id_count = 0;
+}
 
 const char* unique_id(void* o, const char* type, const char* name, const char* label) {
   char buffer[128];
@@ -72,23 +88,41 @@ const char* unique_id(void* o, const char* type, const char* name, const char* l
     while (is_id(*n)) *q++ = *n++;
   }
   *q = 0;
-  // okay, search the tree and see if the name was already used:
-  id** p = &id_root;
+  // okay, search the table and see if the name was already used:
+  unsigned h;
   int which = 0;
-  while (*p) {
-    int i = strcmp(buffer, (*p)->text);
-    if (!i) {
-      if ((*p)->object == o) return (*p)->text;
-      // already used, we need to pick a new name:
-      sprintf(q,"%x",++which);
-      p = &id_root;
-      continue;
+  for (;;) {
+    h = id_hash(buffer);
+    id* p = id_table_size ? id_table[h & (id_table_size - 1)] : 0;
+    for (; p; p = p->next)
+      if (p->hash == h && !strcmp(buffer, p->text)) break;
+    if (!p) break;
+    if (p->object == o) return p->text;
+    // already used, we need to pick a new name:
+    sprintf(q,"%x",++which);
+  }
+  if (id_count >= id_table_size) {
+    int size = id_table_size ? 2 * id_table_size : 256;
+    id** t = (id**)calloc(size, sizeof(id*));
+    for (int i = 0; i < id_table_size; i++) {
+      for (id *p = id_table[i], *next; p; p = next) {
+        next = p->next;
+        p->next = t[p->hash & (size - 1)];
+        t[p->hash & (size - 1)] = p;
+      }
     }
-    else if (i < 0) p = &((*p)->left);
-    else p  = &((*p)->right);
+    free(id_table);
+    id_table = t;
+    id_table_size = size;
   }
-  *p = new id(buffer, o);
-  return (*p)->text;
+  id* p = new id;
+  p->text = strdup(buffer);
+  p->object = o;
+  p->hash = h;
+  p->next = id_table[h & (id_table_size - 1)];
+  id_table[h & (id_table_size - 1)] = p;
+  id_count++;
+  return p->text;
 }
 
 ////////////////////////////////////////////////////////////////
@@ -339,24 +373,66 @@ static Fl_Type* write_code(Fl_Type* p) {
 extern const char* header_file_name;
 extern Fl_Class_Type *current_class;
 
+// The code is written to a temporary file first, and only copied to the
+// output file if that does not already contain the same text. This keeps
+// the time stamps of the .cxx and .h files of a design that was saved or
+// compiled again without changing its code, so that make does not
+// recompile them.
+static int code_file_staged, header_file_staged;
+
+static FILE *open_output(const char *name, const char *mode, int &staged) {
+  FILE *f = tmpfile();
+  staged = (f != 0);
+  if (!f) f = fl_fopen(name, mode);
+  return f;
+}
+
+// Copies the temporary file f to name unless name has the same contents,
+// and closes f. Returns 0 on error.
+static int close_output(FILE *f, const char *name, const char *mode, int staged) {
+  if (!staged) return fclose(f) >= 0;
+  char a[4096], b[4096];
+  size_t n, m;
+  int same = 0;
+  if (fflush(f) || fseek(f, 0, SEEK_SET)) {fclose(f); return 0;}
+  FILE *out = fl_fopen(name, mode[1] == 'b' ? "rb" : "r");
+  if (out) {
+    same = 1;
+    do {
+      n = fread(a, 1, sizeof(a), f);
+      m = fread(b, 1, sizeof(b), out);
+      if (n != m || memcmp(a, b, n)) {same = 0; break;}
+    } while (n);
+    fclose(out);
+  }
+  if (!same) {
+    if (fseek(f, 0, SEEK_SET) || !(out = fl_fopen(name, mode))) {fclose(f); return 0;}
+    while ((n = fread(a, 1, sizeof(a), f)) > 0)
+      if (fwrite(a, 1, n, out) != n) break;
+    int err = ferror(f) || ferror(out);
+    if (fclose(out) || err) {fclose(f); return 0;}
+  }
+  return fclose(f) >= 0;
+}
+
 int write_code(const char *s, const char *t) {
   const char *filemode = "w";
   if (write_sourceview) 
     filemode = "wb";
   write_number++;
-  delete id_root; id_root = 0;
+  clear_ids();
   indentation = 0;
   current_class = 0L;
   current_widget_class = 0L;
   if (!s) code_file = stdout;
   else {
-    FILE *f = fl_fopen(s, filemode);
+    FILE *f = open_output(s, filemode, code_file_staged);
     if (!f) return 0;
     code_file = f;
   }
   if (!t) header_file = stdout;
   else {
-    FILE *f = fl_fopen(t, filemode);
+    FILE *f = open_output(t, filemode, header_file_staged);
     if (!f) {fclose(code_file); return 0;}
     header_file = f;
   }
@@ -456,11 +532,11 @@ int write_code(const char *s, const char *t) {
     }
   }
 
-  int x = fclose(code_file);
+  int x = close_output(code_file, s, filemode, code_file_staged);
   code_file = 0;
-  int y = fclose(header_file);
+  int y = t ? close_output(header_file, t, filemode, header_file_staged) : 1;
   header_file = 0;
-  return x >= 0 && y >= 0;
+  return x && y;
 }
 
 int write_strings(const char *sfile) {
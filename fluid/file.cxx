@@ -54,6 +54,13 @@ int close_write() {
 static int needspace;
 int is_id(char); // in code.C
 
+// the undo system writes into a scratch file that it keeps open,
+// a NULL stream ends this:
+void write_stream(FILE *f) {
+  fout = f ? f : stdout;
+  needspace = 0;
+}
+
 // write a string, quoting characters if necessary:
 void write_word(const char *w) {
   if (needspace) putc(' ', fout);
@@ -309,14 +316,16 @@ extern int code_file_set;
 extern const char* header_file_name;
 extern const char* code_file_name;
 
-int write_file(const char *filename, int selected_only) {
-  if (!open_write(filename)) return 0;
+// write the lines before the first type, the version and the settings:
+void write_file_header(int selected_only) {
   write_string("# data file for the Fltk User Interface Designer (fluid)\n"
 	       "version %.4f",FL_VERSION);
   if(!include_H_from_C)
     write_string("\ndo_not_include_H_from_C");
   if(use_FL_COMMAND)
     write_string("\nuse_FL_COMMAND");
+  if (compress_images)
+    write_string("\ncompress_images");
   if (i18n_type) {
     write_string("\ni18n_type %d", i18n_type);
     write_string("\ni18n_include %s", i18n_include);
@@ -334,6 +343,11 @@ int write_file(const char *filename, int selected_only) {
     write_string("\nheader_name"); write_word(header_file_name);
     write_string("\ncode_name"); write_word(code_file_name);
   }
+}
+
+int write_file(const char *filename, int selected_only) {
+  if (!open_write(filename)) return 0;
+  write_file_header(selected_only);
   for (Fl_Type *p = Fl_Type::first; p;) {
     if (!selected_only || p->selected) {
       p->write();
@@ -356,9 +370,13 @@ double read_version;
 
 extern Fl_Type *Fl_Type_make(const char *tn);
 
+static long read_end = -1;
+
 static void read_children(Fl_Type *p, int paste) {
   Fl_Type::current = p;
   for (;;) {
+    // read_stream() stops at a position in the file:
+    if (read_end >= 0 && ftell(fin) >= read_end) break;
     const char *c = read_word();
   REUSE_C:
     if (!c) {
@@ -402,6 +420,10 @@ static void read_children(Fl_Type *p, int paste) {
       use_FL_COMMAND=1;
       goto CONTINUE;
     }
+    if (!strcmp(c,"compress_images")) {
+      compress_images=1;
+      goto CONTINUE;
+    }
     if (!strcmp(c,"i18n_type")) {
       i18n_type = atoi(read_word());
       goto CONTINUE;
@@ -506,6 +528,22 @@ int read_file(const char *filename, int merge) {
   return close_read();
 }
 
+// Read the types in the open file f, up to the position end, as the last
+// children of p. The undo system uses this to replace some types of the
+// design:
+int read_stream(FILE *f, Fl_Type *p, long end) {
+  read_version = FL_VERSION;
+  fin = f;
+  fname = "undo";
+  lineno = 1;
+  read_end = end;
+  read_children(p, 1);
+  read_end = -1;
+  Fl_Type::current = 0;
+  fin = 0;
+  return !ferror(f);
+}
+
 ////////////////////////////////////////////////////////////////
 // Read Forms and XForms fdesign files:
 
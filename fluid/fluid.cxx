@@ -65,6 +65,7 @@
 #  endif // !__WATCOMC__
 #else
 #  include <unistd.h>
+#  include <sys/wait.h>
 #endif
 
 #include "about_panel.h"
@@ -207,6 +208,7 @@ static void external_editor_timer(void*) {
         Fl_Code_Type *code = (Fl_Code_Type*)p;
         // Code changed by external editor?
         if ( code->handle_editor_changes() ) {	// updates ram, file size/mtime
+          undo_changed(code, 0);
           modified++;
         }
         if ( code->is_editing() ) {             // editor open?
@@ -690,6 +692,7 @@ int update_file = 0;		// fluid -u
 int compile_file = 0;		// fluid -c
 int compile_strings = 0;	// fluic -cs
 int batch_mode = 0;		// if set (-c, -u) don't open display
+int batch_jobs = 1;		// fluid -j
 int header_file_set = 0;
 int code_file_set = 0;
 const char* header_file_name = ".h";
@@ -1674,6 +1677,7 @@ void set_modflag(int mf) {
   static char	title[FL_PATH_MAX];
 
   modflag = mf;
+  if (mf) undo_changed(0);
 
   if (main_window) {
     if (!filename) basename = "Untitled.fl";
@@ -1705,10 +1709,86 @@ void set_modflag(int mf) {
 
 ////////////////////////////////////////////////////////////////
 
+// The undo test links the fluid sources with a main() of its own:
+#ifndef FLUID_NO_MAIN
+
+// Restores the settings that reading a .fl file may change, so that each
+// file of a batch is compiled as if fluid was run for it alone.
+static void reset_file_settings() {
+  i18n_type = 0;
+  i18n_include = "";
+  i18n_function = "";
+  i18n_file = "";
+  i18n_set = "";
+  if (!header_file_set) header_file_name = ".h";
+  if (!code_file_set) code_file_name = ".cxx";
+}
+
+// Reads one .fl file and updates or compiles it (fluid -u, -c, -cs),
+// exits with an error message if anything fails.
+static void batch_file(const char *c) {
+  reset_file_settings();
+  set_filename(c);
+  undo_suspend();
+  if (!read_file(c,0)) {
+    fprintf(stderr,"%s : %s\n", c, strerror(errno));
+    exit(1);
+  }
+  undo_resume();
+  if (update_file)		// fluid -u
+    write_file(c,0);
+  if (compile_file) {		// fluid -c[s]
+    if (compile_strings)
+      write_strings_cb(0,0);
+    write_cb(0,0);
+  }
+}
+
+// Processes the n files of a batch, with up to batch_jobs child processes
+// at a time where fork() is available. fluid keeps the design it works on
+// in global variables, so the files of one process are done one after the
+// other. Returns the exit code, no new file is started after one failed.
+static int batch_files(int n, char **files) {
+  int i = 0;
+#if ! (defined(WIN32) && !defined (__CYGWIN__))
+  if (batch_jobs > 1 && n > 1) {
+    int running = 0, failed = 0;
+    while (running || (i < n && !failed)) {
+      if (running < batch_jobs && i < n && !failed) {
+        fflush(stdout);
+        fflush(stderr);
+        pid_t pid = fork();
+        if (pid == 0) {
+          batch_file(files[i]);
+          exit(0);
+        }
+        if (pid < 0) batch_file(files[i]); // no more processes, do it here
+        else running++;
+        i++;
+        continue;
+      }
+      int status;
+      if (wait(&status) < 0) break;
+      running--;
+      if (!WIFEXITED(status) || WEXITSTATUS(status)) failed = 1;
+    }
+    return failed;
+  }
+#endif
+  for (; i < n; i++) batch_file(files[i]);
+  return 0;
+}
+
 static int arg(int argc, char** argv, int& i) {
   if (argv[i][1] == 'u' && !argv[i][2]) {update_file++; batch_mode++; i++; return 1;}
   if (argv[i][1] == 'c' && !argv[i][2]) {compile_file++; batch_mode++; i++; return 1;}
   if (argv[i][1] == 'c' && argv[i][2] == 's' && !argv[i][3]) {compile_file++; compile_strings++; batch_mode++; i++; return 1;}
+  if (argv[i][1] == 'j' && !argv[i][2] && i+1 < argc) {
+    batch_jobs = atoi(argv[i+1]);
+    if (batch_jobs < 1) batch_jobs = 1;
+    i += 2;
+    return 2;
+  }
   if (argv[i][1] == 'o' && !argv[i][2] && i+1 < argc) {
     code_file_name = argv[i+1];
     code_file_set  = 1;
@@ -1756,15 +1836,25 @@ static void sigint(SIGARG) {
 int main(int argc,char **argv) {
   int i = 1;
   
-  if (!Fl::args(argc,argv,i,arg) || i < argc-1) {
+  int ok = Fl::args(argc,argv,i,arg);
+  if (ok && i < argc-1) {
+    // several files can only be given in batch mode, and with extensions
+    // rather than names for the output files
+    ok = batch_mode &&
+         (*code_file_name == '.' && strchr(code_file_name, '/') == NULL) &&
+         (*header_file_name == '.' && strchr(header_file_name, '/') == NULL);
+  }
+  if (!ok || (batch_mode && i == argc)) {
     static const char *msg = 
       "usage: %s <switches> name.fl\n"
-      " -u : update .fl file and exit (may be combined with '-c' or '-cs')\n"
+      "       %s <switches> -u|-c|-cs name.fl ...\n"
+      " -u : update .fl files and exit (may be combined with '-c' or '-cs')\n"
       " -c : write .cxx and .h and exit\n"
       " -cs : write .cxx and .h and strings and exit\n"
+      " -j <n> : with '-u', '-c' or '-cs', process up to n files at a time\n"
       " -o <name> : .cxx output filename, or extension if <name> starts with '.'\n"
       " -h <name> : .h output filename, or extension if <name> starts with '.'\n";
-    int len = (int)(strlen(msg) + strlen(argv[0]) + strlen(Fl::help));
+    int len = (int)(strlen(msg) + 2 * strlen(argv[0]) + strlen(Fl::help));
     Fl_Plugin_Manager pm("commandline");
     int i, n = pm.plugins();
     for (i=0; i<n; i++) {
@@ -1772,7 +1862,7 @@ int main(int argc,char **argv) {
       if (pi) len += strlen(pi->help());
     }
     char *buf = (char*)malloc(len+1);
-    sprintf(buf, msg, argv[0]);
+    sprintf(buf, msg, argv[0], argv[0]);
     for (i=0; i<n; i++) {
       Fl_Commandline_Plugin *pi = (Fl_Commandline_Plugin*)pm.plugin(i);
       if (pi) strcat(buf, pi->help());
@@ -1795,6 +1885,8 @@ int main(int argc,char **argv) {
 
   make_main_window();
 
+  if (batch_mode)		// fluid -u, -c, -cs
+    exit(batch_files(argc - i, argv + i));
 
   if (c) set_filename(c);
   if (!batch_mode) {
@@ -1814,27 +1906,10 @@ int main(int argc,char **argv) {
     }
   }
   undo_suspend();
-  if (c && !read_file(c,0)) {
-    if (batch_mode) {
-      fprintf(stderr,"%s : %s\n", c, strerror(errno));
-      exit(1);
-    }
+  if (c && !read_file(c,0))
     fl_message("Can't read %s: %s", c, strerror(errno));
-  }
   undo_resume();
 
-  if (update_file) {		// fluid -u
-    write_file(c,0);
-    if (!compile_file)
-      exit(0);
-  }
-
-  if (compile_file) {		// fluid -c[s]
-    if (compile_strings)
-      write_strings_cb(0,0);
-    write_cb(0,0);
-    exit(0);
-  }
   set_modflag(0);
   undo_clear();
 #ifndef WIN32
@@ -1859,6 +1934,8 @@ int main(int argc,char **argv) {
   return (0);
 }
 
+#endif // !FLUID_NO_MAIN
+
 //
 // End of "$Id$".
 //
@@ -3,7 +3,7 @@
 //
 // FLUID undo support for the Fast Light Tool Kit (FLTK).
 //
-// Copyright 1998-2010 by Bill Spitzak and others.
+// Copyright 1998-2017 by Bill Spitzak and others.
 //
 // This library is free software. Distribution and use rights are outlined in
 // the file "COPYING" which should have been included with this file.  If this
@@ -22,6 +22,7 @@
 #include <FL/Fl_Preferences.H>
 #include <FL/filename.H>
 #include "../src/flstring.h"
+#include <stdlib.h>
 #if defined(WIN32) && !defined(__CYGWIN__)
 #  include <io.h>
 #  include <windows.h>
@@ -38,16 +39,31 @@
 
 extern Fl_Preferences	fluid_prefs;	// FLUID preferences
 extern Fl_Menu_Item	Main_Menu[];	// Main menu
+extern int		i18n_type;	// Internationalization type
 
 #define UNDO_ITEM	25		// Undo menu item index
 #define REDO_ITEM	26		// Redo menu item index
 
 
 //
-// This file implements an undo system using temporary files; ideally
-// we'd like to do this in memory, however the current data structures
-// and design aren't well-suited...  Instead, we save and restore
-// checkpoint files.
+// This file implements an undo system that keeps the changes in memory.
+// At each checkpoint the types that changed since the previous one are
+// written into a scratch file, the text of the other types is taken from
+// the previous checkpoint, and the two designs are compared. Only the
+// types whose properties changed, and the children of a type where types
+// were added, deleted or moved, are kept, as the .fl text from before and
+// after the change. Undo and redo delete these types and read the other
+// text in their place, the rest of the design is left alone.
+//
+// The code that changes a type marks it with undo_changed(): the setters
+// that use storestring(), resizable(), Fl_Type::add() and insert(), and
+// set_modflag() for the selected types that the panels change. Deleting
+// or moving a type does not change the text of any type.
+//
+// A change of the settings at the top of the .fl file keeps the whole
+// design in two files instead. If the scratch file can not be created
+// at all, the undo system saves and restores checkpoint files of the
+// whole design, like it always did.
 //
 
 
@@ -55,26 +71,34 @@ int undo_current = 0;			// Current undo level in buffer
 int undo_last = 0;			// Last undo level in buffer
 int undo_max = 0;			// Maximum undo level used
 int undo_save = -1;			// Last undo level that was saved
+int undo_writing = 0;			// Writing types for the undo system?
 static int undo_paused = 0;		// Undo checkpointing paused?
+static int undo_select_changed = 0;	// Selection changed while paused?
 
 
+// Size of an undo filename: the user data path, "undo_", the process id,
+// a kind, a number and ".fl"
+#define UNDO_NAME_MAX (FL_PATH_MAX + 48)
+
 // Return the undo filename
-static char *undo_filename(int level, char *buf, int bufsize) {
+static char *undo_filename(int level, char *buf, int bufsize, const char *kind = "") {
   static char	undo_path[FL_PATH_MAX] = "";	// Undo path
 
 
   if (!undo_path[0]) fluid_prefs.getUserdataPath(undo_path, sizeof(undo_path));
 
-  snprintf(buf, bufsize, "%sundo_%d_%d.fl", undo_path, getpid(), level);
+  snprintf(buf, bufsize, "%sundo_%d_%s%d.fl", undo_path, getpid(), kind, level);
   return buf;
 }
 
 
-// Redo menu callback
-void redo_cb(Fl_Widget *, void *) {
-  char	filename[FL_PATH_MAX];			// Undo checkpoint file
+////////////////////////////////////////////////////////////////
+// Checkpoint files, used if there is no scratch file:
 
-  if (undo_current >= undo_last) return;
+static int use_files = 0;		// Use checkpoint files only?
+
+static void file_redo() {
+  char	filename[UNDO_NAME_MAX];		// Undo checkpoint file
 
   undo_suspend();
   if (!read_file(undo_filename(undo_current + 1, filename, sizeof(filename)), 0)) {
@@ -91,13 +115,11 @@ void redo_cb(Fl_Widget *, void *) {
   // Update undo/redo menu items...
   if (undo_current >= undo_last) Main_Menu[REDO_ITEM].deactivate();
   Main_Menu[UNDO_ITEM].activate();
+  undo_resume();
 }
 
-// Undo menu callback
-void undo_cb(Fl_Widget *, void *) {
-  char	filename[FL_PATH_MAX];			// Undo checkpoint file
-
-  if (undo_current <= 0) return;
+static void file_undo() {
+  char	filename[UNDO_NAME_MAX];		// Undo checkpoint file
 
   if (undo_current == undo_last) {
     write_file(undo_filename(undo_current, filename, sizeof(filename)));
@@ -121,21 +143,848 @@ void undo_cb(Fl_Widget *, void *) {
   undo_resume();
 }
 
+static int file_checkpoint() {
+  char	filename[UNDO_NAME_MAX];		// Undo checkpoint filename
+
+  // Save the current UI to a checkpoint file...
+  if (!write_file(undo_filename(undo_current, filename, sizeof(filename)))) {
+    // Don't attempt to do undo stuff if we can't write a checkpoint file...
+    perror(filename);
+    return 0;
+  }
+  return 1;
+}
+
+
+////////////////////////////////////////////////////////////////
+// The design as written by the undo system:
+
+// the state of the browser and of the windows, which is not part of
+// the design and not written with the types:
+enum {
+  IS_OPEN = 1,				// open_ is set
+  IS_SELECTED = 2,			// selected is set
+  IS_SHOWN = 4,				// the window is shown
+  IS_PARENT = 8				// the type has children in the .fl file
+};
+
+struct Undo_UI {
+  int x, y;				// where a window is on the screen
+  int flags;
+};
+
+struct Undo_Node {
+  Fl_Type *type;
+  int level;
+  int parent;				// index of the parent, -1 at the top
+  int last;				// index after the last child
+  int start, end;			// the text of the type without children
+  unsigned hash;			// of that text
+  int copy;				// the node of base with the same text, -1 if written
+  Undo_UI ui;
+};
+
+struct Undo_State {
+  char *text;				// the whole design
+  int header;				// length of the settings before the types
+  int n;				// number of types
+  Undo_Node *node;
+};
+
+// Types that a change replaced, with their children: count[0] types at
+// pos[0] before the change, count[1] types at pos[1] after the change.
+struct Undo_Patch {
+  int parent[2];			// index of their parent, -1 at the top
+  int pos[2], count[2];
+  char *text[2];
+  Undo_UI *ui[2];			// of each type in the text
+};
+
+// The change from one state of the design to another:
+struct Undo_Step {
+  Undo_Step *older;			// the step before in the same undo level
+  int total[2];				// number of types before and after
+  int whole;				// the patch has files of the whole design
+  int n;
+  Undo_Patch *patch;			// ordered by position
+};
+
+static FILE *scratch = 0;		// where the design is written
+static Undo_State base;			// the design at the undo level
+static int base_level = -1;		// the undo level of base, -1 if none
+static Undo_Step **levels = 0;		// the steps from each level to the next
+static int levels_size = 0;
+static int levels_known = 0;		// the first level with known steps
+static int snapshot_count = 0;		// files of the whole design written
+
+struct Undo_Text {
+  char *data;
+  int n, size;
+};
+
+static void add_text(Undo_Text &b, const char *s, int n) {
+  if (b.n + n + 1 > b.size) {
+    b.size = 2 * (b.n + n + 1);
+    b.data = (char*)realloc(b.data, b.size);
+  }
+  memcpy(b.data + b.n, s, n);
+  b.n += n;
+  b.data[b.n] = 0;
+}
+
+static void close_text(Undo_Text &b, int level) {
+  add_text(b, "\n", 1);
+  while (level--) add_text(b, "  ", 2);
+  add_text(b, "}", 1);
+}
+
+// Puts together the text of the types first to end of s, as write_file()
+// would write them. They must be whole subtrees.
+static void range_text(const Undo_State &s, int first, int end, Undo_Text &b) {
+  int *open = (int*)malloc((end - first + 1) * sizeof(int)), n = 0;
+  for (int i = first; i < end; i++) {
+    const Undo_Node &t = s.node[i];
+    while (n && open[n - 1] >= t.level) close_text(b, open[--n]);
+    add_text(b, s.text + t.start, t.end - t.start);
+    if (t.ui.flags & IS_PARENT) {
+      add_text(b, " {", 2);
+      open[n++] = t.level;
+    }
+  }
+  while (n) close_text(b, open[--n]);
+  free(open);
+}
+
+static int is_top_window(Fl_Type *t) {
+  return t->is_window() && !(t->parent && t->parent->is_widget());
+}
+
+static void free_state(Undo_State &s) {
+  free(s.text);
+  free(s.node);
+  s.text = 0;
+  s.node = 0;
+  s.n = s.header = 0;
+}
+
+static void get_ui(Fl_Type *t, Undo_UI &ui) {
+  ui.flags = ui.x = ui.y = 0;
+  if (t->is_parent()) ui.flags |= IS_PARENT;
+  if (t->open_) ui.flags |= IS_OPEN;
+  if (t->selected) ui.flags |= IS_SELECTED;
+  if (is_top_window(t)) {
+    Fl_Widget *o = ((Fl_Widget_Type*)t)->o;
+    if (o->visible()) ui.flags |= IS_SHOWN;
+    ui.x = o->x();
+    ui.y = o->y();
+  }
+}
+
+// Writes t without its children, the same as Fl_Type::write() does.
+static void write_type(Fl_Type *t) {
+  write_indent(t->level);
+  write_word(t->type_name());
+  if (t->is_class()) {
+    const char *p = ((Fl_Class_Type*)t)->prefix();
+    if (p && *p) write_word(p);
+  }
+  write_word(t->name());
+  write_open(t->level);
+  t->write_properties();
+  write_close(t->level);
+}
+
+// Returns what was written into the scratch file.
+static char *read_scratch() {
+  long size = ftell(scratch);
+  if (size < 0 || fflush(scratch) || ferror(scratch)) return 0;
+  rewind(scratch);
+  char *text = (char*)malloc(size + 1);
+  if (fread(text, 1, size, scratch) != (size_t)size) {
+    free(text);
+    return 0;
+  }
+  text[size] = 0;
+  return text;
+}
+
+// Sets the parent and last of the nodes of s, and the hash of the ones
+// that were written.
+static void link_state(Undo_State &s) {
+  int *stack = (int*)malloc((s.n + 1) * sizeof(int));
+  int i, sp = 0;
+  for (i = 0; i < s.n; i ++) {
+    Undo_Node &d = s.node[i];
+    while (sp && s.node[stack[sp - 1]].level >= d.level) s.node[stack[--sp]].last = i;
+    d.parent = sp ? stack[sp - 1] : -1;
+    stack[sp++] = i;
+    if (d.copy >= 0) continue;
+    unsigned h = 2166136261u;
+    for (int j = d.start; j < d.end; j ++) h = (h ^ (unsigned char)s.text[j]) * 16777619u;
+    d.hash = h;
+  }
+  while (sp) s.node[stack[--sp]].last = i;
+  free(stack);
+}
+
+// Writes the design into the scratch file and reads it back into s.
+static int write_state(Undo_State &s) {
+  Fl_Type *t;
+  int i, n = 0;
+
+  for (t = Fl_Type::first; t; t = t->next) n ++;
+  s.node = (Undo_Node*)malloc((n + 1) * sizeof(Undo_Node));
+  s.n = n;
+
+  rewind(scratch);
+  undo_writing = 1;
+  write_stream(scratch);
+  write_file_header(0);
+  s.header = (int)ftell(scratch);
+  for (i = 0, t = Fl_Type::first; t; t = t->next, i ++) {
+    Undo_Node &d = s.node[i];
+    d.type = t;
+    d.level = t->level;
+    d.start = (int)ftell(scratch);
+    write_type(t);
+    d.end = (int)ftell(scratch);
+    d.copy = -1;
+    get_ui(t, d.ui);
+  }
+  write_stream(0);
+  undo_writing = 0;
+
+  s.text = read_scratch();
+  if (!s.text) {
+    free_state(s);
+    return 0;
+  }
+  link_state(s);
+  return 1;
+}
+
+// Fl_Tabs and Fl_Wizard show one of their children and hide the others
+// when one is removed or selected, so all of their children are replaced
+// together, and written at each checkpoint:
+static int shows_one_child(Fl_Type *t) {
+  return t->is_group() &&
+         (!strcmp(t->type_name(), "Fl_Tabs") || !strcmp(t->type_name(), "Fl_Wizard"));
+}
+
+// The types of s are the ones that the undo system wrote.
+static void set_written(const Undo_State &s) {
+  for (int i = 0; i < s.n; i ++) {
+    s.node[i].type->undo_dirty = 0;
+    s.node[i].type->undo_node = i;
+  }
+}
+
+// Marks t as changed since the undo system wrote it, with its children
+// if children is set. NULL marks the selected types and the current one,
+// with their children, which is what the panels change. With checkpoints
+// suspended, as while reading a design, that is done once by undo_resume().
+void undo_changed(Fl_Type *t, int children) {
+  if (!t) {
+    if (undo_paused) {
+      undo_select_changed = 1;
+      return;
+    }
+    undo_select_changed = 0;
+    for (t = Fl_Type::first; t; t = t->next)
+      if (t->selected || t == Fl_Type::current) t->undo_dirty = 2;
+    return;
+  }
+  int dirty = children ? 2 : 1;
+  if (t->undo_dirty < dirty) t->undo_dirty = dirty;
+}
+
+// Writes the design into s like write_state(), but only the types that
+// changed since base was written. The text of the others is copied from
+// base. The selected types are always written, a panel may be changing
+// them without having marked them yet.
+static int write_changes(Undo_State &s) {
+  Fl_Type *t;
+  int i, n = 0, changed = -1;
+
+  if (base_level < 0) return write_state(s);
+  for (t = Fl_Type::first; t; t = t->next) n ++;
+  s.node = (Undo_Node*)malloc((n + 1) * sizeof(Undo_Node));
+  s.n = n;
+
+  rewind(scratch);
+  undo_writing = 1;
+  write_stream(scratch);
+  write_file_header(0);
+  s.header = (int)ftell(scratch);
+  for (i = 0, t = Fl_Type::first; t; t = t->next, i ++) {
+    Undo_Node &d = s.node[i];
+    d.type = t;
+    d.level = t->level;
+    get_ui(t, d.ui);
+    // changed is the level of a type whose children all changed:
+    if (changed >= 0 && t->level <= changed) changed = -1;
+    if (changed < 0 && (t->undo_dirty > 1 || t->selected || t == Fl_Type::current))
+      changed = t->level;
+    int k = t->undo_node;
+    if (changed < 0 && !t->undo_dirty && k >= 0 && k < base.n &&
+        base.node[k].type == t && base.node[k].level == t->level &&
+        !(t->parent && shows_one_child(t->parent))) {
+      d.copy = k;
+      continue;
+    }
+    d.start = (int)ftell(scratch);
+    write_type(t);
+    d.end = (int)ftell(scratch);
+    d.copy = -1;
+  }
+  write_stream(0);
+  undo_writing = 0;
+
+  char *text = read_scratch();
+  if (!text) {
+    free_state(s);
+    return 0;
+  }
+  if (s.header != base.header || memcmp(text, base.text, s.header)) {
+    // the settings changed, they may change how the types are written:
+    free(text);
+    free_state(s);
+    return write_state(s);
+  }
+  Undo_Text b = {0, 0, 0};
+  add_text(b, text, s.header);
+  for (i = 0; i < n; i ++) {
+    Undo_Node &d = s.node[i];
+    const char *from = text;
+    if (d.copy >= 0) {
+      from = base.text;
+      d.start = base.node[d.copy].start;
+      d.end = base.node[d.copy].end;
+      d.hash = base.node[d.copy].hash;
+    }
+    int start = b.n;
+    add_text(b, from + d.start, d.end - d.start);
+    d.start = start;
+    d.end = b.n;
+  }
+  free(text);
+  s.text = b.data;
+  link_state(s);
+  return 1;
+}
+
+// Makes base the design after st was applied to it. Only the types
+// that st has read are written, the text of the others is copied.
+static int update_base(Undo_Step *st, int to) {
+  int from = 1 - to, i = 0, j = 0, k, m;
+  Undo_State s;
+  Undo_Text b = {0, 0, 0};
+  Fl_Type *t = Fl_Type::first;
+
+  s.n = st->total[to];
+  s.header = base.header;
+  s.node = (Undo_Node*)malloc((s.n + 1) * sizeof(Undo_Node));
+  add_text(b, base.text, base.header);
+  for (k = 0; ; k ++) {
+    // the types up to the patch did not change:
+    int end = k < st->n ? st->patch[k].pos[from] : base.n;
+    for (; i < end && t && j < s.n; i ++, j ++, t = t->next) {
+      Undo_Node &d = s.node[j];
+      d.type = t;
+      d.level = t->level;
+      d.start = b.n;
+      add_text(b, base.text + base.node[i].start, base.node[i].end - base.node[i].start);
+      d.end = b.n;
+      d.copy = -1;
+      get_ui(t, d.ui);
+    }
+    if (k == st->n) break;
+    Undo_Patch &p = st->patch[k];
+    if (j + p.count[to] > s.n) break;
+    rewind(scratch);
+    undo_writing = 1;
+    write_stream(scratch);
+    for (m = j; m < j + p.count[to] && t; m ++, t = t->next) {
+      Undo_Node &d = s.node[m];
+      d.type = t;
+      d.level = t->level;
+      d.start = (int)ftell(scratch);
+      write_type(t);
+      d.end = (int)ftell(scratch);
+      d.copy = -1;
+      get_ui(t, d.ui);
+    }
+    write_stream(0);
+    undo_writing = 0;
+    char *text = read_scratch();
+    if (!text || m < j + p.count[to]) {
+      free(text);
+      break;
+    }
+    for (; j < m; j ++) {
+      Undo_Node &d = s.node[j];
+      int start = b.n;
+      add_text(b, text + d.start, d.end - d.start);
+      d.start = start;
+      d.end = b.n;
+    }
+    free(text);
+    i += p.count[from];
+  }
+  s.text = b.data;
+  if (k < st->n || t || j != s.n || i != base.n) {
+    free_state(s);
+    return 0;
+  }
+  link_state(s);
+  free_state(base);
+  base = s;
+  set_written(base);
+  return 1;
+}
+
+// Compares node i of base a with node j of b.
+static int same_text(const Undo_State &a, int i, const Undo_State &b, int j) {
+  const Undo_Node &p = a.node[i], &q = b.node[j];
+  if (q.copy == i) return 1;
+  return p.hash == q.hash && p.end - p.start == q.end - q.start &&
+         !memcmp(a.text + p.start, b.text + q.start, p.end - p.start);
+}
+
+static int same_type(const Undo_State &a, int i, const Undo_State &b, int j) {
+  return a.node[i].type == b.node[j].type && a.node[i].level == b.node[j].level;
+}
+
+static Undo_UI *copy_ui(const Undo_State &s, int first, int count) {
+  Undo_UI *ui = (Undo_UI*)malloc((count + 1) * sizeof(Undo_UI));
+  for (int i = 0; i < count; i ++) ui[i] = s.node[first + i].ui;
+  return ui;
+}
+
+static void free_patch(Undo_Patch &p) {
+  for (int k = 0; k < 2; k ++) {
+    free(p.text[k]);
+    free(p.ui[k]);
+  }
+}
+
+static void add_patch(Undo_Step *st, const Undo_State *s[2],
+                      int parent[2], int pos[2], int count[2]) {
+  int k;
+  if (parent[1] >= 0 && shows_one_child(s[1]->node[parent[1]].type)) {
+    for (k = 0; k < 2; k ++) {
+      pos[k] = parent[k] + 1;
+      count[k] = s[k]->node[parent[k]].last - pos[k];
+    }
+    // the patches before it inside the parent are part of it:
+    while (st->n && (st->patch[st->n - 1].pos[0] >= pos[0] ||
+                     st->patch[st->n - 1].pos[1] >= pos[1]))
+      free_patch(st->patch[--st->n]);
+  }
+  // a patch inside the one before it on either side is part of that one,
+  // so is an empty patch at its end that adds children to one of its types:
+  if (st->n) {
+    Undo_Patch &l = st->patch[st->n - 1];
+    for (k = 0; k < 2; k ++) {
+      int end = l.pos[k] + l.count[k];
+      if (pos[k] < end) return;
+      if (pos[k] == end && !count[k] && parent[k] >= l.pos[k] && parent[k] < end) return;
+    }
+  }
+  st->patch = (Undo_Patch*)realloc(st->patch, (st->n + 1) * sizeof(Undo_Patch));
+  Undo_Patch &p = st->patch[st->n++];
+  for (k = 0; k < 2; k ++) {
+    p.parent[k] = parent[k];
+    p.pos[k] = pos[k];
+    p.count[k] = count[k];
+    Undo_Text b = {0, 0, 0};
+    range_text(*s[k], pos[k], pos[k] + count[k], b);
+    p.text[k] = b.data ? b.data : strdup("");
+    p.ui[k] = copy_ui(*s[k], pos[k], count[k]);
+  }
+}
+
+// Writes the whole design s into a new file, returns its name.
+static char *snapshot(const Undo_State &s) {
+  char	filename[UNDO_NAME_MAX];
+
+  undo_filename(++snapshot_count, filename, sizeof(filename), "whole");
+  FILE *f = fl_fopen(filename, "w");
+  if (!f) return 0;
+  Undo_Text b = {0, 0, 0};
+  add_text(b, s.text, s.header);
+  range_text(s, 0, s.n, b);
+  add_text(b, "\n", 1);
+  int ok = fwrite(b.data, 1, b.n, f) == (size_t)b.n;
+  if (fclose(f)) ok = 0;
+  free(b.data);
+  if (!ok) {
+    unlink(filename);
+    return 0;
+  }
+  return strdup(filename);
+}
+
+static void free_step(Undo_Step *st) {
+  while (st) {
+    Undo_Step *older = st->older;
+    for (int i = 0; i < st->n; i ++) {
+      for (int k = 0; k < 2; k ++)
+        if (st->whole && st->patch[i].text[k]) unlink(st->patch[i].text[k]);
+      free_patch(st->patch[i]);
+    }
+    free(st->patch);
+    free(st);
+    st = older;
+  }
+}
+
+// Returns the change from design b to design a, NULL if there is none.
+static Undo_Step *compare(const Undo_State &b, const Undo_State &a) {
+  const Undo_State *s[2] = {&b, &a};
+  Undo_Step *st = (Undo_Step*)calloc(1, sizeof(Undo_Step));
+  int parent[2], pos[2], count[2];
+  int i, nb = b.n, na = a.n;
+
+  st->total[0] = nb;
+  st->total[1] = na;
+
+  if (b.header != a.header || memcmp(b.text, a.text, b.header)) {
+    // the settings changed, keep all of it:
+    st->whole = 1;
+    st->n = 1;
+    st->patch = (Undo_Patch*)calloc(1, sizeof(Undo_Patch));
+    Undo_Patch &p = st->patch[0];
+    for (int k = 0; k < 2; k ++) {
+      p.parent[k] = -1;
+      p.count[k] = s[k]->n;
+      p.text[k] = snapshot(*s[k]);
+      p.ui[k] = copy_ui(*s[k], 0, s[k]->n);
+      if (!p.text[k]) {
+        free_step(st);
+        return 0;
+      }
+    }
+    return st;
+  }
+
+  // the same types at the start and at the end:
+  int n = nb < na ? nb : na, pre = 0, suf = 0;
+  while (pre < n && same_type(b, pre, a, pre)) pre ++;
+  while (suf < n - pre && same_type(b, nb - 1 - suf, a, na - 1 - suf)) suf ++;
+
+  // types between them were added, deleted or moved, replace the
+  // children of their common parent that contain them:
+  int q = pre;
+  if (pre < nb - suf || pre < na - suf) {
+    int r = pre - 1;
+    while (r >= 0 && (b.node[r].last < nb - suf || a.node[r].last < na - suf))
+      r = b.node[r].parent;
+    int level = r < 0 ? 0 : b.node[r].level + 1;
+    while (q > r + 1 && ((q < nb && b.node[q].level > level) ||
+                         (q < na && a.node[q].level > level)))
+      q --;
+    int eb = nb - suf, ea = na - suf;
+    while (eb < nb && b.node[eb].level > level) eb ++;
+    while (ea < na && a.node[ea].level > level) ea ++;
+    // the types before them that changed:
+    for (i = 0; i < q; i ++) {
+      if (same_text(b, i, a, i)) continue;
+      parent[0] = parent[1] = b.node[i].parent;
+      pos[0] = pos[1] = i;
+      count[0] = b.node[i].last - i;
+      count[1] = a.node[i].last - i;
+      add_patch(st, s, parent, pos, count);
+    }
+    parent[0] = parent[1] = r;
+    pos[0] = pos[1] = q;
+    count[0] = eb - q;
+    count[1] = ea - q;
+    add_patch(st, s, parent, pos, count);
+    q = eb;
+  } else {
+    q = nb;
+    for (i = 0; i < q; i ++) {
+      if (same_text(b, i, a, i)) continue;
+      parent[0] = parent[1] = b.node[i].parent;
+      pos[0] = pos[1] = i;
+      count[0] = b.node[i].last - i;
+      count[1] = a.node[i].last - i;
+      add_patch(st, s, parent, pos, count);
+    }
+  }
+  // the types after them that changed:
+  int d = na - nb;
+  for (i = q; i < nb; i ++) {
+    if (same_text(b, i, a, i + d)) continue;
+    parent[0] = b.node[i].parent;
+    parent[1] = a.node[i + d].parent;
+    pos[0] = i;
+    pos[1] = i + d;
+    count[0] = count[1] = b.node[i].last - i;
+    add_patch(st, s, parent, pos, count);
+  }
+
+  if (!st->n) {
+    free(st);
+    return 0;
+  }
+  return st;
+}
+
+static void apply_ui(Fl_Type *t, const Undo_UI &ui) {
+  t->open_ = (ui.flags & IS_OPEN) ? 1 : 0;
+  if (t->parent) t->visible = t->parent->visible && t->parent->open_;
+  else t->visible = 1;
+  t->new_selected = (ui.flags & IS_SELECTED) ? 1 : 0;
+  if (is_top_window(t)) {
+    Fl_Widget *o = ((Fl_Widget_Type*)t)->o;
+    o->position(ui.x, ui.y);
+    if ((ui.flags & IS_SHOWN) && Fl::first_window()) t->open();
+  }
+}
+
+// Changes the design from one side of st to the other, to = 0 for undo
+// and 1 for redo.
+static int apply_step(Undo_Step *st, int to) {
+  int from = 1 - to, i, k;
+  Fl_Type *t;
+
+  if (st->whole) {
+    Undo_Patch &p = st->patch[0];
+    // read_file() only reads the settings that are there:
+    i18n_type = 0;
+    if (!read_file(p.text[to], 0)) return 0;
+    for (i = 0, t = Fl_Type::first; t && i < p.count[to]; t = t->next, i ++)
+      apply_ui(t, p.ui[to][i]);
+  } else {
+    int n = 0;
+    for (t = Fl_Type::first; t; t = t->next) n ++;
+    if (n != st->total[from]) return 0;
+    FILE *f = tmpfile();
+    if (!f) return 0;
+    long *end = (long*)malloc(st->n * sizeof(long));
+    for (k = 0; k < st->n; k ++) {
+      fputs(st->patch[k].text[to], f);
+      end[k] = ftell(f);
+    }
+    if (fflush(f) || ferror(f)) {
+      free(end);
+      fclose(f);
+      return 0;
+    }
+    Fl_Type **list = (Fl_Type**)malloc((n + 1) * sizeof(Fl_Type*));
+    for (i = 0, t = Fl_Type::first; t; t = t->next) list[i++] = t;
+
+    // from the last to the first, so that the positions stay the same:
+    for (k = st->n - 1; k >= 0; k --) {
+      Undo_Patch &p = st->patch[k];
+      Fl_Type *parent = p.parent[from] < 0 ? 0 : list[p.parent[from]];
+      int level = parent ? parent->level + 1 : 0;
+      Fl_Type *prev = p.pos[from] ? list[p.pos[from] - 1] : 0;
+      for (i = p.pos[from] + p.count[from] - 1; i >= p.pos[from]; i --) delete list[i];
+      // the types are read as the last children of parent, and then
+      // moved before the type that followed the ones that were deleted:
+      Fl_Type *next = prev ? prev->next : Fl_Type::first;
+      if (next && (next->level != level || next->parent != parent)) next = 0;
+      Fl_Type *beyond = 0;
+      if (parent)
+        for (beyond = parent->next; beyond && beyond->level >= level; beyond = beyond->next) {}
+      Fl_Type *tail = beyond ? beyond->prev : Fl_Type::last;
+      fseek(f, k ? end[k - 1] : 0, SEEK_SET);
+      read_stream(f, parent, end[k]);
+      Fl_Type *added = tail ? tail->next : Fl_Type::first;
+      for (i = 0, t = added; t != beyond && i < p.count[to]; t = t->next, i ++)
+        apply_ui(t, p.ui[to][i]);
+      if (next) {
+        for (t = added; t != beyond;) {
+          Fl_Type *after = t->next;
+          while (after != beyond && after->level > level) after = after->next;
+          t->move_before(next);
+          t = after;
+        }
+      }
+      for (t = parent; t; t = t->parent)
+        if (t->is_menu_button()) t->add_child(0, 0);
+    }
+    free(list);
+    free(end);
+    fclose(f);
+  }
+
+  Fl_Type::current = 0;
+  for (t = Fl_Type::first; t; t = t->next)
+    if (t->new_selected) {Fl_Type::current = t; break;}
+  selection_changed(Fl_Type::current);
+  return 1;
+}
+
+// Applies st to the design and to base. fresh is cleared if base can
+// not follow, and has to be written again.
+static int apply_base_step(Undo_Step *st, int to, int &fresh) {
+  if (!apply_step(st, to)) return 0;
+  if (fresh && (st->whole || !update_base(st, to))) fresh = 0;
+  return 1;
+}
+
+// Applies the steps from the oldest to the newest.
+static int redo_steps(Undo_Step *st, int &fresh) {
+  if (!st) return 1;
+  if (!redo_steps(st->older, fresh)) return 0;
+  return apply_base_step(st, 1, fresh);
+}
+
+static void set_level(int level, Undo_Step *st) {
+  if (level >= levels_size) {
+    int n = levels_size ? 2 * levels_size : 64;
+    while (n <= level) n *= 2;
+    levels = (Undo_Step**)realloc(levels, n * sizeof(Undo_Step*));
+    memset(levels + levels_size, 0, (n - levels_size) * sizeof(Undo_Step*));
+    levels_size = n;
+  }
+  free_step(levels[level]);
+  levels[level] = st;
+}
+
+// Keeps the change from base to the current design as the step to the
+// current undo level, and makes the current design the base.
+static int sync_level() {
+  Undo_State s;
+  if (!write_changes(s)) return 0;
+  int c = undo_current;
+  if (c > 0 && base_level != c - 1 && base_level != c) {
+    // the design at the last checkpoint was not written:
+    levels_known = c;
+  } else if (c > 0 && base_level == c - 1) {
+    set_level(c - 1, compare(base, s));
+  } else if (c > 0 && base_level == c) {
+    // changes without a checkpoint, or a checkpoint that was taken back:
+    Undo_Step *st = compare(base, s);
+    if (st) {
+      st->older = c - 1 < levels_size ? levels[c - 1] : 0;
+      if (st->older) levels[c - 1] = st;
+      else set_level(c - 1, st);
+    }
+  }
+  free_state(base);
+  base = s;
+  base_level = c;
+  set_written(base);
+  return 1;
+}
+
+// Takes back the changes made since the base was written, without a
+// checkpoint.
+static int revert_pending() {
+  if (base_level != undo_current) return 0;
+  Undo_State s;
+  if (!write_changes(s)) return 0;
+  Undo_Step *st = compare(base, s);
+  free_state(s);
+  if (!st) return 1;
+  int ok = apply_step(st, 0);
+  free_step(st);
+  // base is the design again, with new types in some places:
+  Fl_Type *t = Fl_Type::first;
+  for (int i = 0; i < base.n && t; i ++, t = t->next) base.node[i].type = t;
+  if (ok) set_written(base);
+  return ok;
+}
+
+// Makes base the design at the current undo level, if it is not yet.
+static void rebase(int fresh) {
+  if (fresh) {
+    base_level = undo_current;
+    return;
+  }
+  free_state(base);
+  base_level = write_state(base) ? undo_current : -1;
+  if (base_level >= 0) set_written(base);
+}
+
+
+////////////////////////////////////////////////////////////////
+
+// Redo menu callback
+void redo_cb(Fl_Widget *, void *) {
+  if (undo_current >= undo_last) return;
+
+  if (use_files) {
+    file_redo();
+    return;
+  }
+
+  undo_suspend();
+  int fresh = 1;
+  if (undo_current < levels_known || !revert_pending() ||
+      !redo_steps(undo_current < levels_size ? levels[undo_current] : 0, fresh)) {
+    // The design is not the one of this undo level, don't redo...
+    undo_resume();
+    return;
+  }
+
+  undo_current ++;
+  rebase(fresh);
+
+  // Update modified flag...
+  set_modflag(undo_current != undo_save);
+
+  // Update undo/redo menu items...
+  if (undo_current >= undo_last) Main_Menu[REDO_ITEM].deactivate();
+  Main_Menu[UNDO_ITEM].activate();
+  undo_resume();
+}
+
+// Undo menu callback
+void undo_cb(Fl_Widget *, void *) {
+  if (undo_current <= 0) return;
+
+  if (use_files) {
+    file_undo();
+    return;
+  }
+
+  undo_suspend();
+  int ok = undo_current == undo_last ? sync_level() : revert_pending();
+  int fresh = 1;
+  if (undo_current <= levels_known) ok = 0;
+  for (Undo_Step *st = undo_current <= levels_size ? levels[undo_current - 1] : 0;
+       ok && st; st = st->older)
+    ok = apply_base_step(st, 0, fresh);
+  if (!ok) {
+    // The design is not the one of this undo level, don't undo...
+    undo_resume();
+    return;
+  }
+
+  undo_current --;
+  rebase(fresh);
+
+  // Update modified flag...
+  set_modflag(undo_current != undo_save);
+
+  // Update undo/redo menu items...
+  if (undo_current <= 0) Main_Menu[UNDO_ITEM].deactivate();
+  Main_Menu[REDO_ITEM].activate();
+  undo_resume();
+}
+
 // Save current file to undo buffer
 void undo_checkpoint() {
-  char	filename[FL_PATH_MAX];			// Undo checkpoint filename
-
 //  printf("undo_checkpoint(): undo_current=%d, undo_paused=%d, modflag=%d\n",
 //         undo_current, undo_paused, modflag);
 
   // Don't checkpoint if undo_suspend() has been called...
   if (undo_paused) return;
 
-  // Save the current UI to a checkpoint file...
-  if (!write_file(undo_filename(undo_current, filename, sizeof(filename)))) {
-    // Don't attempt to do undo stuff if we can't write a checkpoint file...
-    perror(filename);
-    return;
+  if (!use_files && !scratch && !(scratch = tmpfile())) use_files = 1;
+
+  if (use_files) {
+    if (!file_checkpoint()) return;
+  } else {
+    // Don't attempt to do undo stuff if we can't write the design...
+    if (!sync_level()) return;
+    for (int i = undo_current; i < levels_size; i ++) set_level(i, 0);
   }
 
   // Update the saved level...
@@ -154,14 +1003,22 @@ void undo_checkpoint() {
 
 // Clear undo buffer
 void undo_clear() {
-  char	filename[FL_PATH_MAX];			// Undo checkpoint filename
+  char	filename[UNDO_NAME_MAX];		// Undo checkpoint filename
 
 
   // Remove old checkpoint files...
-  for (int i = 0; i <= undo_max; i ++) {
-    unlink(undo_filename(i, filename, sizeof(filename)));
+  if (use_files) {
+    for (int i = 0; i <= undo_max; i ++) {
+      unlink(undo_filename(i, filename, sizeof(filename)));
+    }
   }
 
+  // Free the changes kept in memory...
+  for (int i = 0; i < levels_size; i ++) set_level(i, 0);
+  free_state(base);
+  base_level = -1;
+  levels_known = 0;
+
   // Reset current, last, and save indices...
   undo_current = undo_last = undo_max = 0;
   if (modflag) undo_save = -1;
@@ -171,6 +1028,7 @@ void undo_clear() {
 // Resume undo checkpoints
 void undo_resume() {
   undo_paused = 0;
+  if (undo_select_changed) undo_changed(0);
 }
 
 // Suspend undo checkpoints
@@ -22,9 +22,13 @@
 extern int undo_current;		// Current undo level in buffer
 extern int undo_last;			// Last undo level in buffer
 extern int undo_save;			// Last undo level that was saved
+extern int undo_writing;		// Writing types for the undo system?
+
+class Fl_Type;
 
 void redo_cb(Fl_Widget *, void *);	// Redo menu callback
 void undo_cb(Fl_Widget *, void *);	// Undo menu callback
+void undo_changed(Fl_Type *t, int children = 1); // Mark types that changed
 void undo_checkpoint();			// Save current file to undo buffer
 void undo_clear();			// Clear undo buffer
 void undo_resume();			// Resume undo checkpoints
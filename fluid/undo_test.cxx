@@ -0,0 +1,417 @@
+//
+// "$Id$"
+//
+// FLUID undo regression test for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 1998-2017 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     http://www.fltk.org/COPYING.php
+//
+// Please report all bugs and problems on the following page:
+//
+//     http://www.fltk.org/str.php
+//
+
+//
+// This program is linked with the fluid sources, compiled without fluid's
+// main(). It edits designs the way the fluid menus and panels do, undoes
+// and redoes the edits, and checks that every undo level gives back the
+// design that was current at that level. It returns 0 if all checks pass.
+//
+// Usage: fluid_undo_test [file.fl ...]
+//
+// Without arguments only the built-in Fl_Tabs design is tested. Each file
+// named on the command line is also tested with random edit sequences.
+//
+
+#include <FL/Fl.H>
+#include "Fl_Type.h"
+#include "undo.h"
+#include <FL/filename.H>
+#include "../src/flstring.h"
+#include <stdio.h>
+#include <stdlib.h>
+#if defined(WIN32) && !defined(__CYGWIN__)
+#  include <io.h>
+#  include <windows.h>
+#  define getpid (int)GetCurrentProcessId
+#  define unlink _unlink
+#else
+#  include <unistd.h>
+#endif // WIN32 && !__CYGWIN__
+
+extern int batch_mode;
+extern void make_main_window();
+extern void select_only(Fl_Type *);
+extern void cut_cb(Fl_Widget *, void *);
+extern void delete_cb(Fl_Widget *, void *);
+extern void paste_cb(Fl_Widget *, void *);
+extern void duplicate_cb(Fl_Widget *, void *);
+extern void earlier_cb(Fl_Widget *, void *);
+extern void select_none_cb(Fl_Widget *, void *);
+extern Fl_Type *Fl_Type_make(const char *tn);
+
+// A window with an Fl_Tabs, undo replaces all pages of an Fl_Tabs together:
+static const char *tabs_design =
+  "# data file for the Fltk User Interface Designer (fluid)\n"
+  "version 1.0400\n"
+  "header_name {.h}\n"
+  "code_name {.cxx}\n"
+  "Function {make_window()} {open\n"
+  "} {\n"
+  "  Fl_Window {} {open\n"
+  "    xywh {100 100 320 220} type Double visible\n"
+  "  } {\n"
+  "    Fl_Tabs {} {open\n"
+  "      xywh {10 10 300 160}\n"
+  "    } {\n"
+  "      Fl_Group {} {\n"
+  "        label one open\n"
+  "        xywh {10 35 300 135}\n"
+  "      } {\n"
+  "        Fl_Button {} {\n"
+  "          label a\n"
+  "          xywh {20 45 80 25}\n"
+  "        }\n"
+  "        Fl_Button {} {\n"
+  "          label b\n"
+  "          xywh {20 75 80 25}\n"
+  "        }\n"
+  "      }\n"
+  "      Fl_Group {} {\n"
+  "        label two open\n"
+  "        xywh {10 35 300 135} hide\n"
+  "      } {\n"
+  "        Fl_Input {} {\n"
+  "          label c\n"
+  "          xywh {60 45 100 25}\n"
+  "        }\n"
+  "        Fl_Group {} {open\n"
+  "          xywh {20 80 200 80} box DOWN_BOX\n"
+  "        } {\n"
+  "          Fl_Button {} {\n"
+  "            label d\n"
+  "            xywh {30 90 80 25}\n"
+  "          }\n"
+  "        }\n"
+  "      }\n"
+  "    }\n"
+  "    Fl_Button {} {\n"
+  "      label e\n"
+  "      xywh {10 180 80 25}\n"
+  "    }\n"
+  "  }\n"
+  "}\n";
+
+static char tmp_name[FL_PATH_MAX];	// Design and scratch file of the test
+
+#define MAXLEVEL 4096
+static char *level_text[MAXLEVEL];	// The design at each undo level
+
+// Returns the design as a malloc'd string. Which page of an Fl_Tabs is
+// shown is not part of the undo levels, so the " hide" flags are dropped.
+static char *design_text() {
+  int w = undo_writing;
+  undo_writing = 1;
+  write_stream(0);
+  write_file(tmp_name);
+  undo_writing = w;
+  FILE *f = fopen(tmp_name, "rb");
+  if (!f) return strdup("");
+  fseek(f, 0, SEEK_END);
+  long n = ftell(f);
+  rewind(f);
+  char *s = (char*)malloc(n + 1);
+  n = (long)fread(s, 1, n, f);
+  s[n] = 0;
+  fclose(f);
+  char *d = s;
+  for (char *c = s; *c;) {
+    if (!strncmp(c, " hide", 5) && (!c[5] || c[5] == ' ' || c[5] == '\n')) c += 5;
+    else *d++ = *c++;
+  }
+  *d = 0;
+  return s;
+}
+
+static void set_level_text(int level, char *s) {
+  free(level_text[level]);
+  level_text[level] = s;
+}
+
+static void clear_levels() {
+  for (int i = 0; i < MAXLEVEL; i ++) set_level_text(i, 0);
+}
+
+// Records the design before and after an edit that made one checkpoint.
+static int record_edit(char *before, int level) {
+  if (undo_current != level + 1) {
+    printf("  edit at level %d made %d checkpoints\n", level, undo_current - level);
+    free(before);
+    return 1;
+  }
+  set_level_text(level, before);
+  for (int i = undo_current; i < MAXLEVEL; i ++) set_level_text(i, 0);
+  set_level_text(undo_current, design_text());
+  return 0;
+}
+
+// Compares the design with the one recorded for the current undo level.
+static int check_level(const char *what) {
+  if (!level_text[undo_current]) return 0;
+  char *s = design_text();
+  int r = strcmp(s, level_text[undo_current]) != 0;
+  if (r) printf("  design differs after %s to level %d\n", what, undo_current);
+  free(s);
+  return r;
+}
+
+// Undoes all levels and redoes them again, checking each one.
+static int undo_redo_all() {
+  while (undo_current > 0) {
+    undo_cb(0, 0);
+    if (check_level("undo")) return 1;
+  }
+  while (undo_current < undo_last) {
+    redo_cb(0, 0);
+    if (check_level("redo")) return 1;
+  }
+  return 0;
+}
+
+static Fl_Type *nth_type(int i) {
+  Fl_Type *t = Fl_Type::first;
+  while (t && i--) t = t->next;
+  return t;
+}
+
+static int type_index(Fl_Type *t) {
+  int i = 0;
+  for (Fl_Type *o = Fl_Type::first; o && o != t; o = o->next) i ++;
+  return i;
+}
+
+static int count_types() {
+  return type_index(0);
+}
+
+static Fl_Type *find_label(const char *l) {
+  for (Fl_Type *t = Fl_Type::first; t; t = t->next)
+    if (t->label() && !strcmp(t->label(), l)) return t;
+  return 0;
+}
+
+static int load(const char *filename) {
+  clear_levels();
+  undo_suspend();
+  int r = read_file(filename, 0);
+  undo_resume();
+  undo_clear();
+  if (!r) printf("  can't read %s\n", filename);
+  else set_level_text(0, design_text());
+  return !r;
+}
+
+// Cuts the type and pastes it back into its parent.
+static void cut_paste(Fl_Type *t) {
+  int p = t->parent ? type_index(t->parent) : -1;
+  select_only(t);
+  cut_cb(0, 0);
+  if (p >= 0) select_only(nth_type(p));
+  else select_none_cb(0, 0);
+  paste_cb(0, 0);
+}
+
+// Edits inside the pages of an Fl_Tabs, undoing and redoing all of them
+// after each edit.
+static int test_tabs() {
+  printf("Fl_Tabs pages:\n");
+  FILE *f = fopen(tmp_name, "w");
+  if (!f) return 1;
+  fputs(tabs_design, f);
+  fclose(f);
+  if (load(tmp_name)) return 1;
+  // each edit is an action and the label of the type it works on
+  static const char *edits[][2] = {
+    {"label", "two"}, {"cut", "c"}, {"select", "a"}, {"add", "a"},
+    {"duplicate", "d"}, {"select", "b"}, {"delete", "b"}, {"cut", "changed"},
+    {"duplicate", "a"}, {"label", "d"}, {"select", "c"}, {"delete", "c"},
+    {"cut", "one"}, {"add", "e"}, {0, 0}
+  };
+  for (int i = 0; edits[i][0]; i ++) {
+    Fl_Type *t = find_label(edits[i][1]);
+    if (!t) {
+      printf("  no type labeled %s\n", edits[i][1]);
+      return 1;
+    }
+    printf("  %s %s\n", edits[i][0], edits[i][1]);
+    char *before = design_text();
+    int level = undo_current;
+    switch (edits[i][0][0]) {
+      case 'l' :
+        select_only(t);
+        t->label("changed");
+        break;
+      case 'a' :
+        select_only(t);
+        undo_checkpoint();
+        undo_suspend();
+        Fl_Type_make("Fl_Button");
+        undo_resume();
+        break;
+      case 'd' :
+        select_only(t);
+        if (edits[i][0][1] == 'u') duplicate_cb(0, 0);
+        else delete_cb(0, 0);
+        break;
+      case 'c' :
+        cut_paste(t);
+        break;
+      case 's' :
+        // shows the page of t, without a checkpoint
+        select_only(t);
+        break;
+    }
+    if (edits[i][0][0] == 'c') {
+      // cut and paste make two checkpoints
+      free(before);
+      for (int j = level; j < MAXLEVEL; j ++) set_level_text(j, 0);
+      set_level_text(undo_current, design_text());
+    } else if (edits[i][0][0] == 's') {
+      free(before);
+      set_level_text(level, design_text());
+    } else if (record_edit(before, level)) return 1;
+    // the change after the last checkpoint of a paste is found together
+    // with the next edit, which shows another page:
+    if (edits[i][0][0] != 'c' && undo_redo_all()) return 1;
+  }
+  return 0;
+}
+
+static unsigned int rand_state;
+static int random_int(int n) {
+  rand_state = rand_state * 1103515245 + 12345;
+  return n > 0 ? (int)((rand_state >> 8) % n) : 0;
+}
+
+// Random edits, undos and redos of a design, checking each undo level.
+static int test_random(const char *filename, unsigned int seed, int ops) {
+  printf("%s, seed %u:\n", filename, seed);
+  if (load(filename)) return 1;
+  rand_state = seed;
+  for (int op = 0; op < ops; op ++) {
+    int r = random_int(10);
+    if (r < 2 && undo_current > 0) {
+      undo_cb(0, 0);
+      if (check_level("undo")) return 1;
+      continue;
+    }
+    if (r < 3 && undo_current < undo_last) {
+      redo_cb(0, 0);
+      if (check_level("redo")) return 1;
+      continue;
+    }
+    int n = count_types();
+    Fl_Type *t = nth_type(random_int(n));
+    if (!t) continue;
+    int w = t->is_widget() && !t->is_menu_item();
+    int top = t->is_window() && !t->parent;
+    char buf[32];
+    sprintf(buf, "L%d", op);
+    char *before = design_text();
+    int level = undo_current;
+    if (level != undo_last) {
+      // edits below the last level start a new branch with a checkpoint
+      undo_checkpoint();
+      level = undo_current;
+      for (int j = level; j < MAXLEVEL; j ++) set_level_text(j, 0);
+      set_level_text(level, before);
+      before = design_text();
+    }
+    switch (random_int(7)) {
+      case 0 :
+        select_only(t);
+        undo_checkpoint();
+        undo_suspend();
+        t->label(buf);
+        undo_resume();
+        break;
+      case 1 :
+        if (n < 3) break;
+        select_only(t);
+        delete_cb(0, 0);
+        break;
+      case 2 :
+        if (top) break;
+        select_only(t);
+        duplicate_cb(0, 0);
+        break;
+      case 3 :
+        if (n < 3) break;
+        cut_paste(t);
+        break;
+      case 4 :
+        select_only(t);
+        earlier_cb(0, 0);
+        break;
+      case 5 :
+        if (!w || top) break;
+        select_only(t);
+        undo_checkpoint();
+        {
+          Fl_Widget *o = ((Fl_Widget_Type*)t)->o;
+          o->resize(o->x() + 3, o->y() + 2, o->w() + 4, o->h() + 1);
+        }
+        set_modflag(1);
+        break;
+      default :
+        if (!w) break;
+        select_only(t);
+        undo_checkpoint();
+        undo_suspend();
+        Fl_Type_make(random_int(2) ? "Fl_Button" : "Fl_Group");
+        undo_resume();
+        break;
+    }
+    if (undo_current == level) {
+      // a change without a checkpoint belongs to the current level
+      free(before);
+      set_level_text(level, design_text());
+      continue;
+    }
+    if (undo_current > level + 1) {
+      // cut and paste make two checkpoints
+      free(before);
+      for (int j = level; j < MAXLEVEL; j ++) set_level_text(j, 0);
+      set_level_text(undo_current, design_text());
+      continue;
+    }
+    if (record_edit(before, level)) return 1;
+  }
+  return undo_redo_all();
+}
+
+int main(int argc, char **argv) {
+  batch_mode = 1;
+  make_main_window();
+  snprintf(tmp_name, sizeof(tmp_name), "fluid_undo_test_%d.fl", (int)getpid());
+
+  int failed = test_tabs();
+  for (int i = 1; i < argc && !failed; i ++)
+    for (unsigned int seed = 1; seed <= 10 && !failed; seed ++)
+      failed = test_random(argv[i], seed, 400);
+
+  clear_levels();
+  undo_clear();
+  unlink(tmp_name);
+  puts(failed ? "FAILED" : "PASSED");
+  return failed;
+}
+
+//
+// End of "$Id$".
+//
@@ -26,6 +26,8 @@
 #include <FL/Fl_Window.H>
 #include <FL/Fl_Tooltip.H>
 #include <FL/fl_draw.H>
+#include <FL/Fl_Trace.H>
+#include "Fl_Shortcut_Index.H"
 
 #include <ctype.h>
 #include <stdlib.h>
@@ -124,6 +126,7 @@ Fl_Widget	*Fl::belowmouse_,
 		*Fl::focus_,
 		*Fl::selection_owner_;
 int		Fl::damage_,
+		Fl::widgets_drawn_,
 		Fl::e_number,
 		Fl::e_x,
 		Fl::e_y,
@@ -418,7 +421,9 @@ void Fl::run_checks()
     while (next_check) {
       Check* checkp = next_check;
       next_check = checkp->next;
+      double start = Fl_Trace::enabled() ? Fl_Trace::now() : 0;
       (checkp->cb)(checkp->arg);
+      if (start) Fl_Trace::record(FL_TRACE_CHECK, 0, start);
     }
     next_check = first_check;
   }
@@ -664,14 +669,19 @@ void Fl::redraw() {
   event queue.
 */
 void Fl::flush() {
+  double start = Fl_Trace::enabled() && damage() ? Fl_Trace::now() : 0;
   if (damage()) {
     damage_ = 0;
+    widgets_drawn_ = 0;
     for (Fl_X* i = Fl_X::first; i; i = i->next) {
       Fl_Window* wi = i->w;
       if (wi->driver()->wait_for_expose_value) {damage_ = 1; continue;}
       if (!wi->visible_r()) continue;
       if (wi->damage()) {
+        widgets_drawn_++;
+        double window_start = Fl_Trace::enabled() ? Fl_Trace::now() : 0;
         wi->driver()->flush();
+        if (Fl_Trace::enabled()) Fl_Trace::record_widget(FL_TRACE_WINDOW, wi, window_start);
         wi->clear_damage();
       }
       // destroy damage regions for windows that don't use them:
@@ -682,6 +692,7 @@ void Fl::flush() {
     }
   }
   screen_driver()->flush();
+  if (start) Fl_Trace::record(FL_TRACE_FLUSH, 0, start);
 }
 
 
@@ -1071,6 +1082,26 @@ static int send_event(int event, Fl_Widget* to, Fl_Window* window) {
 }
 
 
+// Sends FL_SHORTCUT to the widgets that have the shortcut and that the
+// search in Fl::handle_() would reach: in the modal window, or else in the
+// window of the event, the first window, or the window below the mouse.
+static int send_indexed_shortcut(Fl_Window *window) {
+  Fl_Widget *widgets[64];
+  int n = Fl_Shortcut_Index::find(widgets, 64);
+  if (!n) return 0;
+  Fl_Window *mouse = Fl::belowmouse() ? Fl::belowmouse()->top_window() : 0;
+  for (int i = 0; i < n; i++) {
+    Fl_Widget *w = widgets[i];
+    if (i && !Fl_Shortcut_Index::contains(w)) continue; // deleted by a callback
+    if (!w->takesevents() || !w->active_r() || !w->visible_r()) continue;
+    Fl_Window *top = w->top_window();
+    if (Fl::modal() ? top != Fl::modal() :
+        top != window && top != Fl::first_window() && top != mouse) continue;
+    if (send_event(FL_SHORTCUT, w, w->window())) return 1;
+  }
+  return 0;
+}
+
 /**
  \brief Set a new event dispatch function.
 
@@ -1297,6 +1328,9 @@ int Fl::handle_(int e, Fl_Window* window)
   case FL_SHORTCUT:
     if (grab()) {wi = grab(); break;} // send it to grab window
 
+    // Try the widgets that have this shortcut, see Fl::shortcut_index():
+    if (Fl_Shortcut_Index::enabled && send_indexed_shortcut(window)) return 1;
+
     // Try it as shortcut, sending to mouse widget and all parents:
     wi = find_active(belowmouse()); // STR #3216
     if (!wi) {
@@ -141,6 +141,7 @@ void Fl_Bitmap::uncache() {
     fl_delete_bitmask((Fl_Bitmask)id_);
     id_ = 0;
   }
+  cache_forget();
 }
 
 void Fl_Bitmap::label(Fl_Widget* widget) {
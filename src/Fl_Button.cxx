@@ -23,6 +23,7 @@
 
 #include <FL/Fl_Radio_Button.H>
 #include <FL/Fl_Toggle_Button.H>
+#include "Fl_Shortcut_Index.H"
 
 
 Fl_Widget_Tracker *Fl_Button::key_release_tracker = 0;
@@ -196,6 +197,11 @@ void Fl_Button::key_release_timeout(void *d)
   delete wt;
 }
 
+void Fl_Button::shortcut(int s) {
+  shortcut_ = s;
+  Fl_Shortcut_Index::set(this, s);
+}
+
 /**
   The constructor creates the button using the given position, size, and label.
 
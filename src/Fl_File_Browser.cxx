@@ -47,6 +47,7 @@
 
 #define SELECTED 1
 #define NOTDISPLAYED 2
+#define ICON_BY_NAME 4		// Fl_File_Browser only: icon looked up when drawn
 
 // TODO -- Warning: The definition of FL_BLINE here is a hack.
 //    Fl_File_Browser should not do this. PLEASE FIX.
@@ -65,6 +66,95 @@ struct FL_BLINE			// data is in a linked list of these
 };
 
 
+//
+// Icons of the lines that load() added, looked up by file name the first
+// time a line is drawn. They are kept in a hash table of the browser so that
+// the data() of the lines remains the user's...
+//
+
+#define ICON_BUCKETS 256	// size of the hash table
+
+struct Fl_File_Browser_Icon
+{
+  Fl_File_Browser_Icon	*next;		// Next icon in bucket
+  Fl_File_Icon		*icon;		// Icon of the file, may be NULL
+  char			name[1];	// start of allocated file name
+};
+
+// The number of lines load() adds in one go when incremental() is set; the
+// first chunk is added by load() itself, the others from an idle callback...
+static const int load_chunk = 1000;
+
+static unsigned icon_hash(const char *name)
+{
+  unsigned h = 2166136261U;
+  while (*name) h = (h ^ (uchar)*name++) * 16777619U;
+  return h % ICON_BUCKETS;
+}
+
+
+//
+// 'Fl_File_Browser::find_icon()' - Return the icon of a file in the directory.
+//
+
+Fl_File_Icon *					// O - Icon or NULL
+Fl_File_Browser::find_icon(const char *name) const	// I - File name
+{
+  Fl_File_Browser_Icon	*ic;			// Current icon
+  Fl_File_Browser_Icon	**bucket;		// Hash bucket of the name
+  char			filename[4096];		// Full path of the file
+
+
+  if (!icons_)
+    ((Fl_File_Browser *)this)->icons_ =
+        (Fl_File_Browser_Icon **)calloc(ICON_BUCKETS, sizeof(Fl_File_Browser_Icon *));
+
+  bucket = icons_ + icon_hash(name);
+  for (ic = *bucket; ic; ic = ic->next)
+    if (!strcmp(ic->name, name))
+      return (ic->icon);
+
+  // This needs a stat() call, hence it is done once per file...
+  ic = (Fl_File_Browser_Icon *)malloc(sizeof(Fl_File_Browser_Icon) + strlen(name));
+  strcpy(ic->name, name);
+  snprintf(filename, sizeof(filename), "%s/%s", directory_, name);
+  ic->icon = Fl_File_Icon::find(filename,
+                                name[0] && name[strlen(name) - 1] == '/' ?
+				Fl_File_Icon::DIRECTORY : Fl_File_Icon::ANY);
+  ic->next = *bucket;
+  *bucket  = ic;
+
+  return (ic->icon);
+}
+
+
+//
+// 'Fl_File_Browser::free_icons()' - Forget the icons looked up so far.
+//
+
+void
+Fl_File_Browser::free_icons()
+{
+  int			i;			// Looping var
+  Fl_File_Browser_Icon	*ic,			// Current icon
+			*next;			// Next icon
+
+
+  if (!icons_)
+    return;
+
+  for (i = 0; i < ICON_BUCKETS; i ++)
+    for (ic = icons_[i]; ic; ic = next)
+    {
+      next = ic->next;
+      free(ic);
+    }
+
+  free(icons_);
+  icons_ = 0;
+}
+
+
 //
 // 'Fl_File_Browser::full_height()' - Return the height of the list.
 //
@@ -270,12 +360,20 @@ Fl_File_Browser::item_draw(void *p,	// I - List item data
   }
   else
   {
+    Fl_File_Icon *icon;			// Icon of the line
+
+    // The lines added by load() get their icon by name and leave data()
+    // to the user, others may have one as data()...
+    if (line->flags & ICON_BY_NAME)
+      icon = find_icon(line->txt);
+    else
+      icon = (Fl_File_Icon *)line->data;
+
     // Draw the icon if it is set...
-    if (line->data)
-      ((Fl_File_Icon *)line->data)->draw(X, Y, iconsize_, iconsize_,
-                                	(line->flags & SELECTED) ? FL_YELLOW :
-				                                   FL_LIGHT2,
-					active_r());
+    if (icon)
+      icon->draw(X, Y, iconsize_, iconsize_,
+                 (line->flags & SELECTED) ? FL_YELLOW : FL_LIGHT2,
+		 active_r());
 
     // Draw the text offset to the right...
     X += iconsize_ + 9;
@@ -368,10 +466,33 @@ Fl_File_Browser::Fl_File_Browser(int        X,  // I - Upper-lefthand X coordina
     : Fl_Browser(X, Y, W, H, l)
 {
   // Initialize the filter pattern, current directory, and icon size...
-  pattern_   = "*";
-  directory_ = "";
-  iconsize_  = (uchar)(3 * textsize() / 2);
-  filetype_  = FILES;
+  pattern_        = "*";
+  directory_      = "";
+  iconsize_       = (uchar)(3 * textsize() / 2);
+  filetype_       = FILES;
+  hide_dot_files_ = 0;
+  incremental_    = 0;
+  files_          = 0;
+  num_files_      = 0;
+  next_file_      = 0;
+  icons_          = 0;
+}
+
+
+//
+// 'Fl_File_Browser::~Fl_File_Browser()' - Destroy a Fl_File_Browser widget.
+//
+
+Fl_File_Browser::~Fl_File_Browser()
+{
+  // Stop loading and free the entries still to be added...
+  if (files_)
+  {
+    Fl::remove_idle(load_cb, this);
+    fl_filename_free_list(&files_, num_files_);
+  }
+
+  free_icons();
 }
 
 
@@ -383,16 +504,22 @@ int						// O - Number of files loaded
 Fl_File_Browser::load(const char     *directory,// I - Directory to load
                       Fl_File_Sort_F *sort)	// I - Sort function to use
 {
-  int		i;				// Looping var
   int		num_files;			// Number of files in directory
-  int		num_dirs;			// Number of directories in list
   char		filename[4096];			// Current file
   Fl_File_Icon	*icon;				// Icon to use
 
 
 //  printf("Fl_File_Browser::load(\"%s\")\n", directory);
 
+  // Stop loading the previous directory...
+  if (files_)
+  {
+    Fl::remove_idle(load_cb, this);
+    fl_filename_free_list(&files_, num_files_);
+  }
+
   clear();
+  free_icons();
 
   directory_ = directory;
 
@@ -411,40 +538,110 @@ Fl_File_Browser::load(const char     *directory,// I - Directory to load
   }
   else
   {
-    dirent	**files;	// Files in in directory
     //
     // Build the file list...
     //
-    num_files = Fl::system_driver()->file_browser_load_directory(directory_, filename, sizeof(filename), &files, sort);
+    num_files = Fl::system_driver()->file_browser_load_directory(directory_, filename, sizeof(filename), &files_, sort);
     if (num_files <= 0)
+    {
+      files_ = 0;
       return (0);
-
-    for (i = 0, num_dirs = 0; i < num_files; i ++) {
-      if (strcmp(files[i]->d_name, "./")) {
-	snprintf(filename, sizeof(filename), "%s/%s", directory_,
-	         files[i]->d_name);
-
-        icon = Fl_File_Icon::find(filename);
-	if ((icon && icon->type() == Fl_File_Icon::DIRECTORY) ||
-            Fl::system_driver()->filename_isdir_quick(filename)) {
-          num_dirs ++;
-          insert(num_dirs, files[i]->d_name, icon);
-	} else if (filetype_ == FILES &&
-	           fl_filename_match(files[i]->d_name, pattern_)) {
-          add(files[i]->d_name, icon);
-	}
-      }
-
-      free(files[i]);
     }
 
-    free(files);
+    //
+    // Add all entries now, or the first ones and the others when the
+    // program waits for events...
+    //
+    num_files_ = num_files;
+    next_file_ = 0;
+
+    if (!incremental_)
+      load_more(num_files);
+    else if (load_more(load_chunk))
+      Fl::add_idle(load_cb, this);
   }
 
   return (num_files);
 }
 
 
+//
+// 'Fl_File_Browser::load_more()' - Add more of the entries found by load().
+//
+
+int						// O - 1 if entries are left
+Fl_File_Browser::load_more(int count)		// I - Number of lines to add
+{
+  //
+  // fl_filename_list() appends a slash to the names of directories, so
+  // no stat() is needed here. The directories are added first, then the
+  // files, both in the sorted order; appending is cheap while inserting
+  // each directory in front of the files made loading quadratic. Icons
+  // are looked up by item_draw(), only for the lines that get drawn.
+  //
+  for (; count > 0 && next_file_ < 2 * num_files_; next_file_ ++) {
+    int pass = next_file_ / num_files_;
+    const char *name = files_[next_file_ % num_files_]->d_name;
+    int isdir = name[0] && name[strlen(name) - 1] == '/';
+
+    if (!strcmp(name, "./"))
+      continue;
+
+    if (hide_dot_files_ && name[0] == '.' && strcmp(name, "../"))
+      continue;
+
+    if (pass == 0 ? isdir :
+        !isdir && filetype_ == FILES && fl_filename_match(name, pattern_)) {
+      add(name);
+      if (Fl_File_Icon::first())
+        ((FL_BLINE *)item_last())->flags |= ICON_BY_NAME;
+      count --;
+    }
+  }
+
+  if (next_file_ < 2 * num_files_)
+    return (1);
+
+  fl_filename_free_list(&files_, num_files_);
+
+  return (0);
+}
+
+
+//
+// 'Fl_File_Browser::load_cb()' - Add entries from an idle callback.
+//
+
+void
+Fl_File_Browser::load_cb(void *d)		// I - Browser
+{
+  Fl_File_Browser	*fb = (Fl_File_Browser *)d;
+
+
+  if (!fb->load_more(load_chunk))
+    Fl::remove_idle(load_cb, d);
+
+  // Update the scrollbar for the new lines...
+  fb->redraw();
+}
+
+
+/**
+  Adds at once the entries that load() has not added yet.
+  \see loading()
+*/
+void
+Fl_File_Browser::load_finish()
+{
+  if (!files_)
+    return;
+
+  Fl::remove_idle(load_cb, this);
+  load_more(num_files_);
+  redraw();
+}
+
+
 //
 // 'Fl_File_Browser::filter()' - Set the filename filter.
 //
@@ -407,6 +407,7 @@ Fl_File_Chooser::count() {
     else return 1;
   }
 
+  fileList->load_finish();
   for (i = 1, fcount = 0; i <= fileList->size(); i ++)
     if (fileList->selected(i)) {
       // See if this file is a directory...
@@ -724,6 +725,7 @@ Fl_File_Chooser::fileListCB()
         // Clicked on a file - see if there are other directories selected...
         int i;
 	const char *temp;
+	fileList->load_finish();
 	for (i = 1; i <= fileList->size(); i ++) {
 	  if (i != fileList->value() && fileList->selected(i)) {
 	    temp = fileList->text(i);
@@ -866,7 +868,9 @@ Fl_File_Chooser::fileNameCB()
       fileName->position(p, m);
     }
 
-    // Other key pressed - do filename completion as possible...
+    // Other key pressed - do filename completion as possible, with all
+    // the files of the directory...
+    fileList->load_finish();
     num_files  = fileList->size();
     min_match  = (int) strlen(filename);
     max_match  = min_match + 1;
@@ -1098,9 +1102,10 @@ Fl_File_Chooser::rescan()
   else
     okButton->deactivate();
 
-  // Build the file list...
+  // Build the file list, large directories while the dialog is shown...
+  fileList->hide_dot_files(Fl::system_driver()->dot_file_hidden() && !showHiddenButton->value());
+  fileList->incremental(1);
   fileList->load(directory_, sort);
-  if (Fl::system_driver()->dot_file_hidden() && !showHiddenButton->value()) remove_hidden_files();
   // Update the preview box...
   update_preview();
 }
@@ -1123,9 +1128,10 @@ void Fl_File_Chooser::rescan_keep_filename()
   char	pathname[FL_PATH_MAX];		// New pathname for filename field
   strlcpy(pathname, fn, sizeof(pathname));
 
-  // Build the file list...
+  // Build the file list, all of it to find the file...
+  fileList->hide_dot_files(Fl::system_driver()->dot_file_hidden() && !showHiddenButton->value());
   fileList->load(directory_, sort);
-  if (Fl::system_driver()->dot_file_hidden() && !showHiddenButton->value()) remove_hidden_files();
+  fileList->load_finish();
   // Update the preview box...
   update_preview();
 
@@ -1427,6 +1433,7 @@ Fl_File_Chooser::value(int f)	// I - File number
   }
 
   // Return a filename from the list...
+  fileList->load_finish();
   for (i = 1, fcount = 0; i <= fileList->size(); i ++)
     if (fileList->selected(i)) {
       // See if this file is a selected file/directory...
@@ -1512,6 +1519,7 @@ Fl_File_Chooser::value(const char *filename)
   okButton->activate();
 
   // Then find the file in the file list and select it...
+  fileList->load_finish();
   fcount = fileList->size();
 
   fileList->deselect(0);
@@ -1540,6 +1548,7 @@ void Fl_File_Chooser::show()
 
 void Fl_File_Chooser::showHidden(int value)
 {
+  fileList->hide_dot_files(!value);
   if (value) {
     fileList->load(directory());
   } else {
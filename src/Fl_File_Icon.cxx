@@ -34,6 +34,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <ctype.h>
 #include <FL/fl_utf8.h>
 #include "flstring.h"
 #include <FL/Fl.H>
@@ -50,6 +51,146 @@
 Fl_File_Icon	*Fl_File_Icon::first_ = (Fl_File_Icon *)0;
 
 
+//
+// Compiled icon patterns...
+//
+// find() is called for every file of a directory listing, and
+// load_system_icons() registers hundreds of patterns. Patterns of the forms
+// "*.ext", "*.{ext1|ext2}" and "{*.ext1|*.ext2}" are entered into a hash
+// table of lowercase extensions, all other patterns are kept in a list that
+// is matched with fl_filename_match(). Both remember the position of the
+// icon in the list of icons, so find() still returns the first match. The
+// index is rebuilt by find() after an icon was created or destroyed.
+//
+
+struct icon_ext			// Extension of a simple pattern
+{
+  char		*ext;		// Lowercase extension
+  int		order;		// Position of the icon in the list
+  Fl_File_Icon	*icon;		// Icon
+  int		next;		// Next extension in the bucket or -1
+};
+
+struct icon_glob		// Any other pattern
+{
+  int		order;		// Position of the icon in the list
+  Fl_File_Icon	*icon;		// Icon
+  int		all;		// Pattern is "*"
+};
+
+static int		index_valid = 0;	// Index matches the icon list?
+static icon_ext		*index_exts = 0;	// Extensions
+static int		index_num_exts = 0,
+			index_alloc_exts = 0;
+static int		*index_buckets = 0;	// First extension of each bucket
+static int		index_num_buckets = 0;	// Power of two
+static icon_glob	*index_globs = 0;	// Other patterns, in list order
+static int		index_num_globs = 0,
+			index_alloc_globs = 0;
+
+
+// Returns the hash of the lowercase of the first n characters of s...
+static unsigned index_hash(const char *s, int n) {
+  unsigned h = 2166136261U;
+  for (; n > 0; n --, s ++)
+    h = (h ^ (unsigned)tolower((unsigned char)*s)) * 16777619U;
+  return h;
+}
+
+// Returns the length of the plain extension at p or 0...
+static int index_ext_length(const char *p) {
+  int n = 0;
+  while (p[n] && !strchr("*?[]{}|,\\/", p[n]) && !(p[n] & 0x80)) n ++;
+  return n;
+}
+
+static void index_add_ext(const char *p, int n, int order, Fl_File_Icon *icon) {
+  if (index_num_exts >= index_alloc_exts) {
+    index_alloc_exts = index_alloc_exts ? 2 * index_alloc_exts : 64;
+    index_exts = (icon_ext *)realloc(index_exts, index_alloc_exts * sizeof(icon_ext));
+  }
+  icon_ext *e = index_exts + index_num_exts ++;
+  e->ext = (char *)malloc(n + 1);
+  for (int i = 0; i < n; i ++) e->ext[i] = (char)tolower(p[i]);
+  e->ext[n] = '\0';
+  e->order = order;
+  e->icon  = icon;
+}
+
+// Enters the extensions of a simple pattern, returns 0 for other patterns.
+// Checks the whole pattern before anything is entered if add is 0...
+static int index_add_pattern(const char *p, int order, Fl_File_Icon *icon, int add) {
+  int n, list;
+
+  if (p[0] == '*' && p[1] == '.' && p[2] != '{') {	// "*.ext"
+    if ((n = index_ext_length(p + 2)) == 0 || p[n + 2]) return 0;
+    if (add) index_add_ext(p + 2, n, order, icon);
+    return 1;
+  }
+
+  if (p[0] == '*' && p[1] == '.') {			// "*.{ext1|ext2}"
+    list = 0;
+    p += 3;
+  } else if (p[0] == '{') {				// "{*.ext1|*.ext2}"
+    list = 1;
+    p ++;
+  } else return 0;
+
+  for (;;) {
+    if (list) {
+      if (p[0] != '*' || p[1] != '.') return 0;
+      p += 2;
+    }
+    if ((n = index_ext_length(p)) == 0) return 0;
+    if (add) index_add_ext(p, n, order, icon);
+    p += n;
+    if (*p == '}') return p[1] == '\0';
+    if (*p != '|' && *p != ',') return 0;
+    p ++;
+  }
+}
+
+// Builds the index from the icon list...
+static void index_build() {
+  int		i, n, order;
+  Fl_File_Icon	*icon;
+
+  for (i = 0; i < index_num_exts; i ++) free(index_exts[i].ext);
+  index_num_exts  = 0;
+  index_num_globs = 0;
+
+  for (icon = Fl_File_Icon::first(), order = 0; icon; icon = icon->next(), order ++) {
+    if (index_add_pattern(icon->pattern(), order, icon, 0)) {
+      index_add_pattern(icon->pattern(), order, icon, 1);
+    } else {
+      if (index_num_globs >= index_alloc_globs) {
+        index_alloc_globs = index_alloc_globs ? 2 * index_alloc_globs : 16;
+        index_globs = (icon_glob *)realloc(index_globs, index_alloc_globs * sizeof(icon_glob));
+      }
+      icon_glob *g = index_globs + index_num_globs ++;
+      g->order = order;
+      g->icon  = icon;
+      g->all   = !strcmp(icon->pattern(), "*");
+    }
+  }
+
+  // Hash the extensions, keeping them in list order in each bucket...
+  for (n = 16; n < 2 * index_num_exts; n *= 2) {/*empty*/}
+  if (n != index_num_buckets) {
+    index_num_buckets = n;
+    index_buckets     = (int *)realloc(index_buckets, n * sizeof(int));
+  }
+  for (i = 0; i < n; i ++) index_buckets[i] = -1;
+  for (i = index_num_exts - 1; i >= 0; i --) {
+    int b = (int)(index_hash(index_exts[i].ext, (int)strlen(index_exts[i].ext)) & (n - 1));
+    index_exts[i].next = index_buckets[b];
+    index_buckets[b]   = i;
+  }
+
+  index_valid = 1;
+}
+
+
 /**
   Creates a new Fl_File_Icon with the specified information.
   \param[in] p filename pattern
@@ -83,6 +224,7 @@ Fl_File_Icon::Fl_File_Icon(const char *p,	/* I - Filename pattern */
   // And add the icon to the list of icons...
   next_  = first_;
   first_ = this;
+  index_valid = 0;
 }
 
 
@@ -107,6 +249,8 @@ Fl_File_Icon::~Fl_File_Icon() {
       prev->next_ = current->next_;
     else
       first_ = current->next_;
+
+    index_valid = 0;
   }
 
   // Free any memory used...
@@ -161,6 +305,9 @@ Fl_File_Icon::find(const char *filename,// I - Name of file */
 {
   Fl_File_Icon	*current;		// Current file in list
   const char	*name;			// Base name of filename
+  const char	*ext;			// Extension in name
+  int		order;			// Position of current in list
+  int		i;			// Looping var
 
 
   // Get file information if needed...
@@ -171,13 +318,43 @@ Fl_File_Icon::find(const char *filename,// I - Name of file */
   // Look at the base name in the filename
   name = fl_filename_name(filename);
 
-  // Loop through the available file types and return any match that
-  // is found...
-  for (current = first_; current != (Fl_File_Icon *)0; current = current->next_)
-    if ((current->type_ == filetype || current->type_ == ANY) &&
-        (fl_filename_match(filename, current->pattern_) ||
-	 fl_filename_match(name, current->pattern_)))
+  if (!index_valid)
+    index_build();
+
+  // Look up every extension of the name ("gz" and "tar.gz" for
+  // "x.tar.gz") in the compiled simple patterns...
+  current = (Fl_File_Icon *)0;
+  order   = index_num_globs + index_num_exts + 1;
+
+  for (ext = strchr(name, '.'); ext; ext = strchr(ext, '.')) {
+    int n = (int)strlen(++ ext);
+
+    for (i = index_buckets[index_hash(ext, n) & (index_num_buckets - 1)];
+         i >= 0 && index_exts[i].order < order; i = index_exts[i].next) {
+      icon_ext *e = index_exts + i;
+      int type = e->icon->type_;
+
+      if ((type == filetype || type == ANY) && !strncasecmp(e->ext, ext, n) &&
+          e->ext[n] == '\0') {
+	current = e->icon;
+	order   = e->order;
+	break;
+      }
+    }
+  }
+
+  // Then try the other patterns that come before the match in the list...
+  for (i = 0; i < index_num_globs && index_globs[i].order < order; i ++) {
+    icon_glob *g = index_globs + i;
+    int type = g->icon->type_;
+
+    if ((type == filetype || type == ANY) &&
+        (g->all || fl_filename_match(filename, g->icon->pattern_) ||
+	 fl_filename_match(name, g->icon->pattern_))) {
+      current = g->icon;
       break;
+    }
+  }
 
   // Return the match (if any)...
   return (current);
@@ -0,0 +1,109 @@
+//
+// "$Id$"
+//
+// Draw-to-memory code for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 1998-2017 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     http://www.fltk.org/COPYING.php
+//
+// Please report all bugs and problems on the following page:
+//
+//     http://www.fltk.org/str.php
+//
+
+#include <FL/Fl_Framebuffer_Surface.H>
+#include "drivers/Pico/Fl_Pico_Framebuffer_Graphics_Driver.H"
+#include <string.h>
+
+
+/** Constructor.
+ \param w and \param h give the size in pixels of the framebuffer,
+ which is initially filled with opaque white.
+ */
+Fl_Framebuffer_Surface::Fl_Framebuffer_Surface(int w, int h) : Fl_Widget_Surface(NULL) {
+  driver(new Fl_Pico_Framebuffer_Graphics_Driver(w, h));
+  width = ((Fl_Pico_Framebuffer_Graphics_Driver*)driver())->buffer_width();
+  height = ((Fl_Pico_Framebuffer_Graphics_Driver*)driver())->buffer_height();
+}
+
+
+/** The destructor. */
+Fl_Framebuffer_Surface::~Fl_Framebuffer_Surface() {
+  delete driver();
+}
+
+void Fl_Framebuffer_Surface::translate(int x, int y) {
+  ((Fl_Pico_Framebuffer_Graphics_Driver*)driver())->translate_all(x, y);
+}
+
+void Fl_Framebuffer_Surface::untranslate() {
+  ((Fl_Pico_Framebuffer_Graphics_Driver*)driver())->untranslate_all();
+}
+
+int Fl_Framebuffer_Surface::printable_rect(int *w, int *h) {
+  *w = width; *h = height;
+  return 0;
+}
+
+
+/** Returns the framebuffer.
+ It holds 4 bytes per pixel in the order red, green, blue, alpha, and lines
+ of 4 * w bytes. The data remain owned by the surface.
+ */
+uchar *Fl_Framebuffer_Surface::pixels() {
+  return ((Fl_Pico_Framebuffer_Graphics_Driver*)driver())->buffer();
+}
+
+
+/** Returns an image made of all drawings sent to the Fl_Framebuffer_Surface object.
+ The returned object contains its own copy of the RGB data.
+ The caller is responsible for deleting the image.
+ */
+Fl_RGB_Image *Fl_Framebuffer_Surface::image() {
+  const uchar *src = pixels();
+  int n = width * height;
+  uchar *data = new uchar[n * 3], *d = data;
+  for (; n > 0; n--, src += 4, d += 3) {
+    d[0] = src[0]; d[1] = src[1]; d[2] = src[2];
+  }
+  Fl_RGB_Image *image = new Fl_RGB_Image(data, width, height);
+  image->alloc_array = 1;
+  return image;
+}
+
+
+/** Sets whether slanted lines, curves and the edges of polygons are drawn anti-aliased.
+ This is on by default. Turn it off to get the same pixels as the X11 drawing functions.
+ */
+void Fl_Framebuffer_Surface::antialias(char onoff) {
+  ((Fl_Pico_Framebuffer_Graphics_Driver*)driver())->antialias(onoff);
+}
+
+/** Returns whether slanted lines and curves are drawn anti-aliased. */
+char Fl_Framebuffer_Surface::antialias() {
+  return ((Fl_Pico_Framebuffer_Graphics_Driver*)driver())->antialias();
+}
+
+/** Sets whether polygons are filled with the non-zero winding rule.
+ By default they are filled with the even-odd rule, like X11 does: the parts
+ of a complex polygon where its contours overlap an even number of times are
+ left out. With the non-zero rule they are filled unless the contours around
+ them wind as often in one direction as in the other.
+ */
+void Fl_Framebuffer_Surface::nonzero_fill(char onoff) {
+  ((Fl_Pico_Framebuffer_Graphics_Driver*)driver())->nonzero_fill(onoff);
+}
+
+/** Returns whether polygons are filled with the non-zero winding rule. */
+char Fl_Framebuffer_Surface::nonzero_fill() {
+  return ((Fl_Pico_Framebuffer_Graphics_Driver*)driver())->nonzero_fill();
+}
+
+//
+// End of "$Id$".
+//
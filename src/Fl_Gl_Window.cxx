@@ -37,6 +37,7 @@ extern int fl_gl_load_plugin;
 
 #ifdef FL_CFG_GFX_OPENGL
 #include "drivers/OpenGL/Fl_OpenGL_Display_Device.H"
+#include "drivers/OpenGL/Fl_OpenGL_Graphics_Driver.H"
 #endif
 
 ////////////////////////////////////////////////////////////////
@@ -376,6 +377,8 @@ void Fl_Gl_Window::draw() {
   glEnable(GL_BLEND); // FIXME: push on state stack
   
   Fl_Window::draw();
+  // the widgets were collected in a vertex array, draw it
+  ((Fl_OpenGL_Graphics_Driver*)fl_graphics_driver)->flush();
 
   glPopMatrix();
   glPopAttrib();
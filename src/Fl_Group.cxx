@@ -25,6 +25,7 @@
 #include <FL/Fl.H>
 #include <FL/Fl_Group.H>
 #include <FL/Fl_Window.H>
+#include <FL/Fl_Trace.H>
 #include <FL/fl_draw.H>
 #include <stdlib.h>
 
@@ -719,8 +720,19 @@ void Fl_Group::draw_children() {
   }
 
   if (damage() & ~FL_DAMAGE_CHILD) { // redraw the entire thing:
+    // The clip region holds all damaged rectangles of the window. Get its
+    // bounding box inside this group once, so that children outside of it
+    // are skipped with a plain rectangle test instead of fl_not_clipped(),
+    // which intersects each child with the whole clip region in the driver.
+    int gx = as_window() ? 0 : x(), gy = as_window() ? 0 : y();
+    int X, Y, W, H;
+    fl_clip_box(gx, gy, w(), h(), X, Y, W, H);
     for (int i=children_; i--;) {
       Fl_Widget& o = **a++;
+      if ((o.x() >= X+W || o.y() >= Y+H || o.x()+o.w() <= X || o.y()+o.h() <= Y) &&
+          o.x() >= gx && o.y() >= gy && o.x()+o.w() <= gx+w() && o.y()+o.h() <= gy+h() &&
+          (!(o.align() & 15) || (o.align() & FL_ALIGN_INSIDE)))
+        continue; // inside this group, but not damaged, and no outside label
       draw_child(o);
       draw_outside_label(o);
     }
@@ -750,7 +762,10 @@ void Fl_Group::draw() {
 void Fl_Group::update_child(Fl_Widget& widget) const {
   if (widget.damage() && widget.visible() && widget.type() < FL_WINDOW &&
       fl_not_clipped(widget.x(), widget.y(), widget.w(), widget.h())) {
+    Fl::widgets_drawn_++;
+    double start = Fl_Trace::enabled() ? Fl_Trace::now() : 0;
     widget.draw();	
+    if (Fl_Trace::enabled()) Fl_Trace::record_widget(FL_TRACE_WIDGET, &widget, start);
     widget.clear_damage();
   }
 }
@@ -764,8 +779,11 @@ void Fl_Group::update_child(Fl_Widget& widget) const {
 void Fl_Group::draw_child(Fl_Widget& widget) const {
   if (widget.visible() && widget.type() < FL_WINDOW &&
       fl_not_clipped(widget.x(), widget.y(), widget.w(), widget.h())) {
+    Fl::widgets_drawn_++;
     widget.clear_damage(FL_DAMAGE_ALL);
+    double start = Fl_Trace::enabled() ? Fl_Trace::now() : 0;
     widget.draw();
+    if (Fl_Trace::enabled()) Fl_Trace::record_widget(FL_TRACE_WIDGET, &widget, start);
     widget.clear_damage();
   }
 }
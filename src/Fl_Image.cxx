@@ -41,7 +41,8 @@ Fl_RGB_Scaling Fl_Image::RGB_scaling_ = FL_RGB_SCALING_NEAREST;
  1 to 4 for color images.
  */
 Fl_Image::Fl_Image(int W, int H, int D) :
-  w_(W), h_(H), d_(D), ld_(0), count_(0), data_(0L)
+  w_(W), h_(H), d_(D), ld_(0), count_(0), data_(0L),
+  cache_prev_(0), cache_next_(0), cache_bytes_(0)
 {}
 
 /**
@@ -49,6 +50,7 @@ Fl_Image::Fl_Image(int W, int H, int D) :
   by the image.
 */
 Fl_Image::~Fl_Image() {
+  cache_forget();
 }
 
 /**
@@ -223,6 +225,97 @@ Fl_RGB_Scaling Fl_Image::RGB_scaling() {
   return RGB_scaling_;
 }
 
+//
+// The cache of image offscreens...
+//
+// The graphics driver reports every draw of an image that keeps an
+// offscreen (an X11 Pixmap, for instance) through cache_used(). The images
+// are kept in a list, most recently drawn first, and the least recently
+// drawn ones are uncached when their offscreens hold more memory than the
+// budget.
+//
+
+Fl_Image *Fl_Image::cache_first_ = 0;
+Fl_Image *Fl_Image::cache_last_ = 0;
+static size_t cache_budget_ = 256 * 1024 * 1024;
+static Fl_Image_Cache_Statistics cache_stats_;
+
+// removes the image from the list
+void Fl_Image::cache_forget() {
+  if (!cache_bytes_) return;
+  if (cache_prev_) cache_prev_->cache_next_ = cache_next_;
+  else cache_first_ = cache_next_;
+  if (cache_next_) cache_next_->cache_prev_ = cache_prev_;
+  else cache_last_ = cache_prev_;
+  cache_prev_ = cache_next_ = 0;
+  cache_stats_.bytes -= cache_bytes_;
+  cache_stats_.images--;
+  cache_bytes_ = 0;
+}
+
+// uncaches images from the back of the list, but not keep, while the
+// offscreens hold more than the budget
+void Fl_Image::cache_evict(Fl_Image *keep) {
+  while (cache_budget_ && cache_stats_.bytes > cache_budget_ && cache_last_ != keep) {
+    Fl_Image *img = cache_last_;
+    img->uncache();
+    img->cache_forget(); // in case a derived class does not
+    cache_stats_.evictions++;
+  }
+}
+
+// The image was drawn from an offscreen that holds that many bytes.
+// Moves it to the front of the list.
+void Fl_Image::cache_used(size_t bytes) {
+  if (!bytes) return;
+  if (cache_bytes_) cache_stats_.hits++;
+  else cache_stats_.misses++;
+  cache_forget();
+  cache_bytes_ = bytes;
+  cache_next_ = cache_first_;
+  if (cache_first_) cache_first_->cache_prev_ = this;
+  else cache_last_ = this;
+  cache_first_ = this;
+  cache_stats_.bytes += bytes;
+  cache_stats_.images++;
+  cache_evict(this);
+}
+
+/**
+ Sets the memory that the offscreens of all images may hold.
+
+ Graphics drivers that keep a copy of the images in the graphics system,
+ like the X11 driver keeps an X Pixmap, free the copies of the least
+ recently drawn images with uncache() when their total size is above this
+ budget. Such an image is copied again when it is next drawn. 0 means no
+ limit. The default is 256 MB.
+ \see cache_statistics()
+ */
+void Fl_Image::cache_budget(size_t bytes) {
+  cache_budget_ = bytes;
+  cache_evict(cache_first_);
+}
+
+/** Returns the memory that the offscreens of all images may hold.
+ \see cache_budget(size_t) */
+size_t Fl_Image::cache_budget() {
+  return cache_budget_;
+}
+
+/**
+ Returns how well the offscreens of images are reused.
+ The counts start when the program starts, or at reset_cache_statistics().
+ \see cache_budget(size_t)
+ */
+void Fl_Image::cache_statistics(Fl_Image_Cache_Statistics &s) {
+  s = cache_stats_;
+}
+
+/** Sets the hits, misses and evictions of cache_statistics() to 0. */
+void Fl_Image::reset_cache_statistics() {
+  cache_stats_.hits = cache_stats_.misses = cache_stats_.evictions = 0;
+}
+
 
 //
 // RGB image class...
@@ -315,6 +408,7 @@ Fl_RGB_Image::~Fl_RGB_Image() {
 
 void Fl_RGB_Image::uncache() {
   Fl_Graphics_Driver::default_driver().uncache(this, id_, mask_);
+  cache_forget();
 }
 
 Fl_Image *Fl_RGB_Image::copy(int W, int H) {
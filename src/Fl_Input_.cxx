@@ -35,6 +35,61 @@ extern void fl_draw(const char*, int, float, float);
 
 ////////////////////////////////////////////////////////////////
 
+// The widths of the prefixes of the last few lines that were measured.
+// Drawing the cursor and the selection, and finding the character under
+// the mouse measure the same line again and again. A line is looked up by
+// its text as expand() wrote it and by the font, so editing the line or
+// changing the font makes it a new line.
+struct Prefix_Widths {
+  char text[MAXBUF];		// the line, as returned by expand()
+  int len;			// strlen(text), -1 if the slot is unused
+  Fl_Graphics_Driver *driver;
+  Fl_Font_Descriptor *descriptor;
+  Fl_Font font;
+  Fl_Fontsize size;
+  double width[MAXBUF];		// fl_width(text, n), < 0 until it is measured
+};
+
+static const int prefix_lines = 4;
+static Prefix_Widths *prefix_widths = 0;
+static int prefix_next = 0;
+
+// Returns fl_width(buf, n) for a line written by expand().
+static double prefix_width(const char *buf, int n) {
+  if (n <= 0) return fl_width(buf, n);
+  if (!prefix_widths) {
+    prefix_widths = (Prefix_Widths*)malloc(prefix_lines * sizeof(Prefix_Widths));
+    for (int i = 0; i < prefix_lines; i++) prefix_widths[i].len = -1;
+  }
+  int len = (int)strlen(buf);
+  if (n > len) return fl_width(buf, n);
+  Fl_Graphics_Driver *driver = fl_graphics_driver;
+  Prefix_Widths *w = 0;
+  for (int i = 0; i < prefix_lines; i++) {
+    Prefix_Widths *c = prefix_widths + i;
+    if (c->len == len && c->driver == driver && c->descriptor == driver->font_descriptor() &&
+        c->font == fl_font() && c->size == fl_size() && !memcmp(c->text, buf, len)) {
+      w = c;
+      break;
+    }
+  }
+  if (!w) {
+    w = prefix_widths + prefix_next;
+    prefix_next = (prefix_next + 1) % prefix_lines;
+    memcpy(w->text, buf, len + 1);
+    w->len = len;
+    w->driver = driver;
+    w->descriptor = driver->font_descriptor();
+    w->font = fl_font();
+    w->size = fl_size();
+    for (int i = 0; i <= len; i++) w->width[i] = -1;
+  }
+  if (w->width[n] < 0) w->width[n] = fl_width(buf, n);
+  return w->width[n];
+}
+
+////////////////////////////////////////////////////////////////
+
 /** \internal
   Converts a given text segment into the text that will be rendered on screen.
 
@@ -141,7 +196,7 @@ double Fl_Input_::expandpos(
     p++;
   }
   if (returnn) *returnn = n;
-  return fl_width(buf, n);
+  return prefix_width(buf, n);
 }
 
 ////////////////////////////////////////////////////////////////
@@ -545,16 +600,19 @@ void Fl_Input_::handle_mouse(int X, int Y, int /*W*/, int /*H*/, int drag) {
     if (e >= value_+size_) break;
     p = e+1;
   }
-  const char *l, *r, *t; double f0 = Fl::event_x()-X+xscroll_;
+  // binary search for the last character that starts left of the mouse,
+  // the positions of the characters grow along the line:
+  const char *l, *r, *t;
   for (l = p, r = e; l<r; ) {
-    double f;
-    int cw = fl_utf8len((char)l[0]);
-    if (cw < 1) cw = 1;
-    t = l+cw;
-    f = X-xscroll_+expandpos(p, t, buf, 0);
-    if (f <= Fl::event_x()) {l = t; f0 = Fl::event_x()-f;}
-    else r = t-cw;
+    t = l+(r-l+1)/2;
+    while (t < r && fl_utf8len((char)t[0]) < 1) t++; // start of a character
+    if (X-xscroll_+expandpos(p, t, buf, 0) <= Fl::event_x()) l = t;
+    else {
+      r = t-1;
+      while (r > l && fl_utf8len((char)r[0]) < 1) r--;
+    }
   }
+  double f0 = Fl::event_x()-X+xscroll_-(l > p ? expandpos(p, l, buf, 0) : 0);
   if (l < e) { // see if closer to character on right:
     double f1;
     int cw = fl_utf8len((char)l[0]);
@@ -130,11 +130,15 @@ public:
   int selected;
   int drawn_selected;	// last redraw has this selected
   int shortcutWidth;
+  int skipped;		// last redraw left out items that were off the screen
   const Fl_Menu_Item* menu;
   menuwindow(const Fl_Menu_Item* m, int X, int Y, int W, int H,
 	     const Fl_Menu_Item* picked, const Fl_Menu_Item* title,
 	     int menubar = 0, int menubar_title = 0, int right_edge = 0);
   ~menuwindow();
+  void init(const Fl_Menu_Item* m, int X, int Y, int W, int H,
+	    const Fl_Menu_Item* picked, const Fl_Menu_Item* title,
+	    int menubar = 0, int menubar_title = 0, int right_edge = 0);
   void set_selected(int);
   int find_selected(int mx, int my);
   int titlex(int);
@@ -290,10 +294,130 @@ menutitle::menutitle(int X, int Y, int W, int H, const Fl_Menu_Item* L) :
   if (L->labelcolor_ || Fl::scheme() || L->labeltype_ > FL_NO_LABEL) clear_overlay();
 }
 
+// The sizes menuwindow::init() measures for the items of a menu.
+struct menu_sizes {
+  int W;		// the widest label, with the submenu arrow
+  int itemheight;
+  int hotKeysw;		// the widest shortcut key
+  int hotModsw;		// the widest shortcut modifiers
+  int no_overlay;	// some item can not be drawn in the overlay planes
+};
+
+static void measure_items(const Fl_Menu_Item* m, menu_sizes& s) {
+  s.W = 0;
+  s.itemheight = 1;
+  s.hotKeysw = s.hotModsw = 0;
+  s.no_overlay = 0;
+  if (m) for (; m->text; m = m->next()) {
+    int hh; 
+    int w1 = m->measure(&hh, button);
+    if (hh+LEADING>s.itemheight) s.itemheight = hh+LEADING;
+    if (m->flags&(FL_SUBMENU|FL_SUBMENU_POINTER)) 
+      w1 += FL_NORMAL_SIZE;
+    if (w1 > s.W) s.W = w1;
+    // calculate the maximum width of all shortcuts
+    if (m->shortcut_) {
+      // s1 is a pointer to the UTF-8 string for the entire shortcut
+      // k points only to the key part (minus the modifier keys)
+      const char *k, *s1 = fl_shortcut_label(m->shortcut_, &k);
+      if (fl_utf_nb_char((const unsigned char*)k, (int) strlen(k))<=4) {
+        // a regular shortcut has a right-justified modifier followed by a left-justified key
+        w1 = int(fl_width(s1, (int) (k-s1)));
+        if (w1 > s.hotModsw) s.hotModsw = w1;
+        w1 = int(fl_width(k))+4;
+        if (w1 > s.hotKeysw) s.hotKeysw = w1;
+      } else {
+        // a shortcut with a long modifier is right-justified to the menu
+        w1 = int(fl_width(s1))+4;
+        if (w1 > (s.hotModsw+s.hotKeysw)) {
+          s.hotModsw = w1-s.hotKeysw;
+        }
+      }
+    }
+    if (m->labelcolor_ || Fl::scheme() || m->labeltype_ > FL_NO_LABEL) s.no_overlay = 1;
+  }
+}
+
+// The sizes of the last menus that were opened. Menus with hundreds of
+// items take long to measure, and they are usually opened again as they
+// were. A menu is found by its first item and by a hash of everything its
+// sizes depend on, so a menu that was changed is measured again.
+struct menu_layout {
+  const Fl_Menu_Item* menu;
+  unsigned hash;
+  menu_sizes sizes;
+};
+
+static const int menu_layouts = 8;
+static menu_layout layout_cache[menu_layouts];
+static int layout_next = 0;
+
+static inline unsigned hash_int(unsigned k, unsigned i) {
+  return (k ^ i) * 16777619u;
+}
+
+// Returns 0 if the sizes of the items can not be cached, because some
+// labels are not text.
+static unsigned hash_items(const Fl_Menu_Item* m) {
+  unsigned k = 2166136261u;
+  const char *c = Fl::scheme();
+  if (c) while (*c) k = hash_int(k, (unsigned char)*c++);
+  k = hash_int(k, (unsigned)FL_NORMAL_SIZE);
+  if (button) {
+    k = hash_int(k, (unsigned)button->textfont());
+    k = hash_int(k, (unsigned)button->textsize());
+  }
+  for (; m->text; m = m->next()) {
+    if (m->labeltype_ >= _FL_MULTI_LABEL) return 0;
+    for (c = m->text; *c; c++) k = hash_int(k, (unsigned char)*c);
+    k = hash_int(k, 0);
+    k = hash_int(k, m->labeltype_);
+    k = hash_int(k, (unsigned)m->labelfont_);
+    k = hash_int(k, (unsigned)m->labelsize_);
+    k = hash_int(k, (unsigned)m->labelcolor_);
+    k = hash_int(k, (unsigned)m->shortcut_);
+    k = hash_int(k, m->flags & (FL_MENU_TOGGLE|FL_MENU_RADIO|FL_SUBMENU|FL_SUBMENU_POINTER));
+  }
+  return k ? k : 1;
+}
+
+static void item_sizes(const Fl_Menu_Item* m, menu_sizes& s) {
+  unsigned hash = m ? hash_items(m) : 0;
+  if (!hash) {
+    measure_items(m, s);
+    return;
+  }
+  for (int i = 0; i < menu_layouts; i++) {
+    if (layout_cache[i].menu == m && layout_cache[i].hash == hash) {
+      s = layout_cache[i].sizes;
+      return;
+    }
+  }
+  measure_items(m, s);
+  menu_layout& l = layout_cache[layout_next];
+  layout_next = (layout_next + 1) % menu_layouts;
+  l.menu = m;
+  l.hash = hash;
+  l.sizes = s;
+}
+
 menuwindow::menuwindow(const Fl_Menu_Item* m, int X, int Y, int Wp, int Hp,
 		       const Fl_Menu_Item* picked, const Fl_Menu_Item* t, 
 		       int menubar, int menubar_title, int right_edge)
   : Fl_Menu_Window(X, Y, Wp, Hp, 0)
+{
+  end();
+  set_modal();
+  clear_border();
+  set_menu_window();
+  title = 0;
+  init(m, X, Y, Wp, Hp, picked, t, menubar, menubar_title, right_edge);
+}
+
+// Sets up the window for a new menu, the window may have been used before.
+void menuwindow::init(const Fl_Menu_Item* m, int X, int Y, int Wp, int Hp,
+		      const Fl_Menu_Item* picked, const Fl_Menu_Item* t, 
+		      int menubar, int menubar_title, int right_edge)
 {
   int scr_x, scr_y, scr_w, scr_h;
   int tx = X, ty = Y;
@@ -301,10 +425,11 @@ menuwindow::menuwindow(const Fl_Menu_Item* m, int X, int Y, int Wp, int Hp,
   Fl::screen_work_area(scr_x, scr_y, scr_w, scr_h);
   if (!right_edge || right_edge > scr_x+scr_w) right_edge = scr_x+scr_w;
 
-  end();
-  set_modal();
-  clear_border();
-  set_menu_window();
+  x(X); y(Y); w(Wp); h(Hp);
+  set_overlay();
+  delete title;
+  title = 0;
+  skipped = 0;
   menu = m;
   if (m) m = m->first(); // find the first item that needs to be rendered
   drawn_selected = -1;
@@ -329,46 +454,19 @@ menuwindow::menuwindow(const Fl_Menu_Item* m, int X, int Y, int Wp, int Hp,
 
   if (menubar) {
     itemheight = 0;
-    title = 0;
     return;
   }
 
-  itemheight = 1;
-
-  int hotKeysw = 0;
-  int hotModsw = 0;
   int Wtitle = 0;
   int Htitle = 0;
   if (t) Wtitle = t->measure(&Htitle, button) + 12;
-  int W = 0;
-  if (m) for (; m->text; m = m->next()) {
-    int hh; 
-    int w1 = m->measure(&hh, button);
-    if (hh+LEADING>itemheight) itemheight = hh+LEADING;
-    if (m->flags&(FL_SUBMENU|FL_SUBMENU_POINTER)) 
-      w1 += FL_NORMAL_SIZE;
-    if (w1 > W) W = w1;
-    // calculate the maximum width of all shortcuts
-    if (m->shortcut_) {
-      // s is a pointer to the UTF-8 string for the entire shortcut
-      // k points only to the key part (minus the modifier keys)
-      const char *k, *s = fl_shortcut_label(m->shortcut_, &k);
-      if (fl_utf_nb_char((const unsigned char*)k, (int) strlen(k))<=4) {
-        // a regular shortcut has a right-justified modifier followed by a left-justified key
-        w1 = int(fl_width(s, (int) (k-s)));
-        if (w1 > hotModsw) hotModsw = w1;
-        w1 = int(fl_width(k))+4;
-        if (w1 > hotKeysw) hotKeysw = w1;
-      } else {
-        // a shortcut with a long modifier is right-justified to the menu
-        w1 = int(fl_width(s))+4;
-        if (w1 > (hotModsw+hotKeysw)) {
-          hotModsw = w1-hotKeysw;
-        }
-      }
-    }
-    if (m->labelcolor_ || Fl::scheme() || m->labeltype_ > FL_NO_LABEL) clear_overlay();
-  }
+  menu_sizes sizes;
+  item_sizes(m, sizes);
+  itemheight = sizes.itemheight;
+  int W = sizes.W;
+  int hotKeysw = sizes.hotKeysw;
+  int hotModsw = sizes.hotModsw;
+  if (sizes.no_overlay) clear_overlay();
   shortcutWidth = hotKeysw;
   if (selected >= 0 && !Wp) X -= W/2;
   int BW = Fl::box_dx(box());
@@ -416,8 +514,6 @@ menuwindow::menuwindow(const Fl_Menu_Item* m, int X, int Y, int Wp, int Hp,
       int ht = Htitle+2*BW+3;
       title = new menutitle(X, Y-ht-dy, Wtitle, ht, t);
     }
-  } else {
-    title = 0;
   }
 }
 
@@ -426,10 +522,40 @@ menuwindow::~menuwindow() {
   delete title;
 }
 
+// Submenus are opened and closed all the time while the mouse moves over
+// a menu. Their windows are kept here when they are closed, and used for
+// the next submenus instead of creating new ones.
+static const int max_spare_menus = 8;
+static menuwindow* spare_menus[max_spare_menus];
+static int num_spare_menus = 0;
+
+static menuwindow* new_menuwindow(const Fl_Menu_Item* m, int X, int Y, int W, int H,
+				  const Fl_Menu_Item* picked, const Fl_Menu_Item* t,
+				  int menubar = 0, int menubar_title = 0, int right_edge = 0) {
+  if (!num_spare_menus)
+    return new menuwindow(m, X, Y, W, H, picked, t, menubar, menubar_title, right_edge);
+  menuwindow* mw = spare_menus[--num_spare_menus];
+  mw->init(m, X, Y, W, H, picked, t, menubar, menubar_title, right_edge);
+  return mw;
+}
+
+static void delete_menuwindow(menuwindow* mw) {
+  if (!mw) return;
+  if (num_spare_menus >= max_spare_menus) {
+    delete mw;
+    return;
+  }
+  mw->hide();
+  delete mw->title;
+  mw->title = 0;
+  spare_menus[num_spare_menus++] = mw;
+}
+
 void menuwindow::position(int X, int Y) {
   if (title) {title->position(X, title->y()+Y-y());}
   Fl_Menu_Window::position(X, Y);
   // x(X); y(Y); // don't wait for response from X
+  if (skipped) redraw(); // items left out may be on the screen now
 }
 
 // scroll so item i is visible on screen
@@ -447,6 +573,7 @@ void menuwindow::autoscroll(int n) {
   }
   Fl_Menu_Window::position(x(), y()+Y);
   // y(y()+Y); // don't wait for response from X
+  if (skipped) redraw(); // items left out may be on the screen now
 }
 
 ////////////////////////////////////////////////////////////////
@@ -510,8 +637,35 @@ void menuwindow::draw() {
   if (damage() != FL_DAMAGE_CHILD) {	// complete redraw
     fl_draw_box(box(), 0, 0, w(), h(), button ? button->color() : color());
     if (menu) {
+      // A menu taller than the screen is mostly off the screen. Only the
+      // items on a screen and in the clip region are drawn, autoscroll()
+      // redraws the menu when it brings the others on the screen.
+      int top = 0, bottom = h();
+      if (itemheight) {
+        int cx, cy, cw, ch;
+        fl_clip_box(0, 0, w(), h(), cx, cy, cw, ch);
+        int sy0 = y() + h(), sy1 = y();
+        for (int i = 0; i < Fl::screen_count(); i++) {
+          int sx, sy, sw, sh;
+          Fl::screen_xywh(sx, sy, sw, sh, i);
+          if (sx >= x() + w() || sx + sw <= x()) continue;
+          if (sy < sy0) sy0 = sy;
+          if (sy + sh > sy1) sy1 = sy + sh;
+        }
+        top = cy > sy0 - y() ? cy : sy0 - y();
+        bottom = cy + ch < sy1 - y() ? cy + ch : sy1 - y();
+      }
+      int first = 0, last = numitems - 1;
+      if (itemheight) {
+        int BW = Fl::box_dx(box());
+        first = (top - BW - 1) / itemheight - 1;
+        last = (bottom - BW - 1) / itemheight + 1;
+        if (first < 0) first = 0;
+      }
+      skipped = first > 0 || last < numitems - 1;
       const Fl_Menu_Item* m; int j;
-      for (m=menu->first(), j=0; m->text; j++, m = m->next()) drawentry(m, j, 0);
+      for (m=menu->first(), j=0; m->text && j <= last; j++, m = m->next())
+        if (j >= first) drawentry(m, j, 0);
     }
   } else {
     if (damage() & FL_DAMAGE_CHILD && selected!=drawn_selected) { // change selection
@@ -927,7 +1081,7 @@ const Fl_Menu_Item* Fl_Menu_Item::pulldown(
     }
 
     // only do rest if item changes:
-    if(pp.fakemenu) {delete pp.fakemenu; pp.fakemenu = 0;} // turn off "menubar button"
+    if(pp.fakemenu) {delete_menuwindow(pp.fakemenu); pp.fakemenu = 0;} // turn off "menubar button"
 
     if (!pp.current_item) { // pointing at nothing
       // turn off selection in deepest menu, but don't erase other menus:
@@ -935,7 +1089,7 @@ const Fl_Menu_Item* Fl_Menu_Item::pulldown(
       continue;
     }
 
-    if(pp.fakemenu) {delete pp.fakemenu; pp.fakemenu = 0;}
+    if(pp.fakemenu) {delete_menuwindow(pp.fakemenu); pp.fakemenu = 0;}
     initial_item = 0; // stop the startup code
     pp.p[pp.menu_number]->autoscroll(pp.item_number);
 
@@ -967,7 +1121,7 @@ const Fl_Menu_Item* Fl_Menu_Item::pulldown(
 	title = 0;
       }
       if (initial_item) { // bring up submenu containing initial item:
-	menuwindow* n = new menuwindow(menutable,X,Y,W,H,initial_item,title,0,0,cw.x());
+	menuwindow* n = new_menuwindow(menutable,X,Y,W,H,initial_item,title,0,0,cw.x());
 	pp.p[pp.nummenus++] = n;
 	// move all earlier menus to line up with this new one:
 	if (n->selected>=0) {
@@ -987,20 +1141,20 @@ const Fl_Menu_Item* Fl_Menu_Item::pulldown(
       } else if (pp.nummenus > pp.menu_number+1 &&
 		 pp.p[pp.menu_number+1]->menu == menutable) {
 	// the menu is already up:
-	while (pp.nummenus > pp.menu_number+2) delete pp.p[--pp.nummenus];
+	while (pp.nummenus > pp.menu_number+2) delete_menuwindow(pp.p[--pp.nummenus]);
 	pp.p[pp.nummenus-1]->set_selected(-1);
       } else {
 	// delete all the old menus and create new one:
-	while (pp.nummenus > pp.menu_number+1) delete pp.p[--pp.nummenus];
-	pp.p[pp.nummenus++]= new menuwindow(menutable, nX, nY,
+	while (pp.nummenus > pp.menu_number+1) delete_menuwindow(pp.p[--pp.nummenus]);
+	pp.p[pp.nummenus++]= new_menuwindow(menutable, nX, nY,
 					  title?1:0, 0, 0, title, 0, menubar, 
 					    (title ? 0 : cw.x()) );
       }
     } else { // !m->submenu():
-      while (pp.nummenus > pp.menu_number+1) delete pp.p[--pp.nummenus];
+      while (pp.nummenus > pp.menu_number+1) delete_menuwindow(pp.p[--pp.nummenus]);
       if (!pp.menu_number && pp.menubar) {
 	// kludge so "menubar buttons" turn "on" by using menu title:
-	pp.fakemenu = new menuwindow(0,
+	pp.fakemenu = new_menuwindow(0,
 				  cw.x()+cw.titlex(pp.item_number),
 				  cw.y()+cw.h(), 0, 0,
 				  0, m, 0, 1);
@@ -1009,8 +1163,8 @@ const Fl_Menu_Item* Fl_Menu_Item::pulldown(
     }
   }
   const Fl_Menu_Item* m = pp.current_item;
-  delete pp.fakemenu;
-  while (pp.nummenus>1) delete pp.p[--pp.nummenus];
+  delete_menuwindow(pp.fakemenu);
+  while (pp.nummenus>1) delete_menuwindow(pp.p[--pp.nummenus]);
   mw.hide();
   Fl::grab(0);
   return m;
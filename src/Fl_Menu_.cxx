@@ -25,6 +25,7 @@
 
 #include <FL/Fl.H>
 #include <FL/Fl_Menu_.H>
+#include "Fl_Shortcut_Index.H"
 #include "flstring.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -418,6 +419,7 @@ int Fl_Menu_::size() const {
 void Fl_Menu_::menu(const Fl_Menu_Item* m) {
   clear();
   value_ = menu_ = (Fl_Menu_Item*)m;
+  Fl_Shortcut_Index::menu_changed(this);
 }
 
 // this version is ok with new Fl_Menu_add code with fl_menu_array_owner:
@@ -465,9 +467,16 @@ void Fl_Menu_::clear() {
     menu_ = 0;
     value_ = 0;
     alloc = 0;
+    Fl_Shortcut_Index::menu_changed(this);
   }
 }
 
+/** Changes the shortcut of item \p i to \p s. */
+void Fl_Menu_::shortcut(int i, int s) {
+  menu_[i].shortcut(s);
+  Fl_Shortcut_Index::menu_changed(this);
+}
+
 /**
  Clears the specified submenu pointed to by \p index of all menu items.
 
@@ -27,6 +27,7 @@
 // string with a % sign in it!
 
 #include <FL/Fl_Menu_.H>
+#include "Fl_Shortcut_Index.H"
 #include "flstring.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -411,6 +412,7 @@ int Fl_Menu_::insert(
   int value_offset = (int) (value_-menu_);
   menu_ = local_array; // in case it reallocated it
   if (value_) value_ = menu_+value_offset;
+  if (shortcut) Fl_Shortcut_Index::menu_changed(this);
   return r;
 }
 
@@ -493,6 +495,7 @@ void Fl_Menu_::remove(int i) {
   }
   // MRS: "n" is the menu size(), which includes the trailing NULL entry...
   memmove(item, next_item, (menu_+n-next_item)*sizeof(Fl_Menu_Item));
+  Fl_Shortcut_Index::menu_changed(this);
 }
 
 //
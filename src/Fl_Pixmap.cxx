@@ -87,6 +87,7 @@ void Fl_Pixmap::uncache() {
     fl_delete_bitmask((Fl_Bitmask)mask_);
     mask_ = 0;
   }
+  cache_forget();
 }
 
 void Fl_Pixmap::label(Fl_Widget* widget) {
@@ -25,6 +25,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdarg.h>
+#include <sys/stat.h>
 #include <FL/fl_utf8.h>
 #include "flstring.h"
 
@@ -807,7 +808,8 @@ Fl_Preferences::RootNode::RootNode( Fl_Preferences *prefs, Root root, const char
 : prefs_(prefs),
   filename_(0L),
   vendor_(0L),
-  application_(0L) {
+  application_(0L),
+  buffer_(0L) {
 
   char *filename = Fl::system_driver()->preference_rootnode(prefs, root, vendor, application);
     filename_    = filename ? strdup(filename) : 0L;
@@ -822,7 +824,8 @@ Fl_Preferences::RootNode::RootNode( Fl_Preferences *prefs, const char *path, con
 : prefs_(prefs),
   filename_(0L),
   vendor_(0L),
-  application_(0L) {
+  application_(0L),
+  buffer_(0L) {
 
   if (!vendor)
     vendor = "unknown";
@@ -845,7 +848,8 @@ Fl_Preferences::RootNode::RootNode( Fl_Preferences *prefs )
 : prefs_(prefs),
   filename_(0L),
   vendor_(0L),
-  application_(0L) {
+  application_(0L),
+  buffer_(0L) {
 }
 
 // destroy the root node and all depending nodes
@@ -866,57 +870,100 @@ Fl_Preferences::RootNode::~RootNode() {
   }
   delete prefs_->node;
   prefs_->node = 0L;
+  if ( buffer_ ) {
+    free( buffer_ );
+    buffer_ = 0L;
+  }
+}
+
+// return the start of the line after p, splitting long lines like fgets() with a 1024 byte buffer
+static const char *next_line( const char *p, const char *end ) {
+  const char *e = ( end-p > 1023 ) ? p+1023 : end;
+  const char *nl = (const char*)memchr( p, '\n', e-p );
+  return nl ? nl+1 : e;
 }
 
-// read a preferences file and construct the group tree and with all entry leafs
+// read a preferences file and construct the group tree
+// - the file stays in memory, and the entries of each group are only
+//   parsed when the group is used for the first time (see Node::readEntries())
 int Fl_Preferences::RootNode::read() {
   if (!filename_)   // RUNTIME preferences
     return -1; 
-  char buf[1024];
+  if ( buffer_ )    // already read
+    return 0;
   FILE *f = fl_fopen( filename_, "rb" );
   if ( !f )
     return -1; 
-  if (fgets( buf, 1024, f )==0) { /* ignore */ }
-  if (fgets( buf, 1024, f )==0) { /* ignore */ }
-  if (fgets( buf, 1024, f )==0) { /* ignore */ }
+  long size = -1;
+  if ( fseek( f, 0, SEEK_END ) == 0 ) size = ftell( f );
+  if ( size < 0 || fseek( f, 0, SEEK_SET ) != 0 ) {
+    fclose( f );
+    return -1;
+  }
+  buffer_ = (char*)malloc( size+1 );
+  size = (long) fread( buffer_, 1, size, f );
+  fclose( f );
+  const char *p = buffer_, *end = buffer_+size;
+  for ( int i = 0; i < 3 && p < end; i++ )	// skip the file header
+    p = next_line( p, end );
   Node *nd = prefs_->node;
-  for (;;) {
-    if ( !fgets( buf, 1024, f ) ) break;	// EOF or Error
-    if ( buf[0]=='[' ) {			// read a new group
-      size_t end = strcspn( buf+1, "]\n\r" );
-      buf[ end+1 ] = 0;
-      nd = prefs_->node->find( buf+1 );
-    } else if ( buf[0]=='+' ) {			// value of previous name/value pair spans multiple lines
-      size_t end = strcspn( buf+1, "\n\r" );
-      if ( end != 0 ) {				// if entry is not empty
-	buf[ end+1 ] = 0;
-	nd->add( buf+1 );
-      }
-    } else {					 // read a name/value pair
-      size_t end = strcspn( buf, "\n\r" );
-      if ( end != 0 ) {				// if entry is not empty
-	buf[ end ] = 0;
-	nd->set( buf );
-      }
+  const char *data = p;
+  while ( p < end ) {
+    const char *e = next_line( p, end );
+    if ( *p=='[' ) {				// start a new group
+      if ( nd ) nd->setEntryData( data, p );
+      char buf[1024];
+      size_t len = e-p-1;
+      memcpy( buf, p+1, len );
+      buf[ len ] = 0;
+      buf[ strcspn( buf, "]\n\r" ) ] = 0;
+      nd = prefs_->node->find( buf );
+      data = e;
     }
+    p = e;
   }
-  fclose( f );
+  if ( nd ) nd->setEntryData( data, end );
   return 0;
 }
 
 // write the group tree and all entry leafs
+// - the file is written under a temporary name and then renamed, so that
+//   a full disk or a crash never leaves a truncated preferences file behind
 int Fl_Preferences::RootNode::write() {
   if (!filename_)   // RUNTIME preferences
     return -1;
   fl_make_path_for_file(filename_);
-  FILE *f = fl_fopen( filename_, "wb" );
-  if ( !f )
+  size_t len = strlen( filename_ );
+  char *tmpname = (char*)malloc( len+5 );
+  memcpy( tmpname, filename_, len );
+  strcpy( tmpname+len, ".tmp" );
+  FILE *f = fl_fopen( tmpname, "wb" );
+  if ( !f ) {
+    free( tmpname );
     return -1;
+  }
   fprintf( f, "; FLTK preferences file format 1.0\n" );
   fprintf( f, "; vendor: %s\n", vendor_ );
   fprintf( f, "; application: %s\n", application_ );
   prefs_->node->write( f );
-  fclose( f );
+  int err = ferror( f );
+  if ( fclose( f ) ) err = 1;
+  if ( !err ) {
+    struct stat st;
+    if ( fl_stat( filename_, &st ) == 0 )	// keep the permissions of the old file
+      fl_chmod( tmpname, st.st_mode & 07777 );
+    if ( fl_rename( tmpname, filename_ ) ) {
+      // some systems do not rename over an existing file
+      fl_unlink( filename_ );
+      err = fl_rename( tmpname, filename_ );
+    }
+  }
+  if ( err ) {
+    fl_unlink( tmpname );
+    free( tmpname );
+    return -1;
+  }
+  free( tmpname );
   if (Fl::system_driver()->preferences_need_protection_check()) {
     // unix: make sure that system prefs are user-readable
     if (strncmp(filename_, "/etc/fltk/", 10) == 0) {
@@ -954,6 +1001,16 @@ char Fl_Preferences::RootNode::getPath( char *path, int pathlen ) {
   return ret;
 }
 
+// nodes with more entries or children than this use hash tables to find them
+#define NODE_HASH_MIN 8
+
+static unsigned node_hash( const char *s, int len ) {
+  unsigned h = 2166136261U;
+  for ( ; len > 0; len--, s++ )
+    h = ( h ^ (unsigned char)*s ) * 16777619U;
+  return h;
+}
+
 // create a node that represents a group
 // - path must be a single word, prferable alnum(), dot and underscore only. Space is ok.
 Fl_Preferences::Node::Node( const char *path ) {
@@ -966,6 +1023,11 @@ Fl_Preferences::Node::Node( const char *path ) {
   indexed_ = 0;
   index_ = 0;
   nIndex_ = NIndex_ = 0;
+  entryHash_ = 0;
+  NEntryHash_ = 0;
+  childHash_ = 0;
+  nChildHash_ = NChildHash_ = 0;
+  data_ = dataEnd_ = 0;
 }
 
 void Fl_Preferences::Node::deleteAllChildren() {
@@ -977,9 +1039,11 @@ void Fl_Preferences::Node::deleteAllChildren() {
   child_ = 0L;
   dirty_ = 1;
   updateIndex();
+  deleteChildHash();
 }
 
 void Fl_Preferences::Node::deleteAllEntries() {
+  data_ = dataEnd_ = 0L;
   if ( entry_ ) {
     for ( int i = 0; i < nEntry_; i++ ) {
       if ( entry_[i].name ) {
@@ -996,6 +1060,11 @@ void Fl_Preferences::Node::deleteAllEntries() {
     nEntry_ = 0;
     NEntry_ = 0;
   }
+  if ( entryHash_ ) {
+    free( entryHash_ );
+    entryHash_ = 0L;
+    NEntryHash_ = 0;
+  }
   dirty_ = 1;
 }
 
@@ -1025,6 +1094,7 @@ char Fl_Preferences::Node::dirty() {
 // write all children
 int Fl_Preferences::Node::write( FILE *f ) {
   if ( next_ ) next_->write( f );
+  if ( data_ ) readEntries();
   fprintf( f, "\n[%s]\n\n", path_ );
   for ( int i = 0; i < nEntry_; i++ ) {
     char *src = entry_[i].value;
@@ -1061,6 +1131,8 @@ void Fl_Preferences::Node::setParent( Node *pn ) {
   sprintf( nameBuffer, "%s/%s", pn->path_, path_ );
   free( path_ );
   path_ = strdup( nameBuffer );
+  if ( pn->childHash_ )
+    pn->hashChild( this );
 }
 
 // find the corresponding root node
@@ -1080,7 +1152,9 @@ Fl_Preferences::Node *Fl_Preferences::Node::addChild( const char *path ) {
   char *name = strdup( nameBuffer );
   Node *nd = find( name );
   free( name );
-  dirty_ = 1;
+  // only a new group changes the file, and a new group is always empty
+  if ( !nd || ( !nd->nEntry_ && !nd->data_ && !nd->child_ ) )
+    dirty_ = 1;
   updateIndex();
   return nd;
 }
@@ -1088,18 +1162,18 @@ Fl_Preferences::Node *Fl_Preferences::Node::addChild( const char *path ) {
 // create and set, or change an entry within this node
 void Fl_Preferences::Node::set( const char *name, const char *value )
 {
-  for ( int i=0; i<nEntry_; i++ ) {
-    if ( strcmp( name, entry_[i].name ) == 0 ) {
-      if ( !value ) return; // annotation
-      if ( strcmp( value, entry_[i].value ) != 0 ) {
-	if ( entry_[i].value )
-	  free( entry_[i].value );
-	entry_[i].value = strdup( value );
-	dirty_ = 1;
-      }
-      lastEntrySet = i;
-      return;
+  if ( data_ ) readEntries();
+  int i = getEntry( name );
+  if ( i >= 0 ) {
+    if ( !value ) return; // annotation
+    if ( strcmp( value, entry_[i].value ) != 0 ) {
+      if ( entry_[i].value )
+	free( entry_[i].value );
+      entry_[i].value = strdup( value );
+      dirty_ = 1;
     }
+    lastEntrySet = i;
+    return;
   }
   if ( NEntry_==nEntry_ ) {
     NEntry_ = NEntry_ ? NEntry_*2 : 10;
@@ -1110,6 +1184,14 @@ void Fl_Preferences::Node::set( const char *name, const char *value )
   lastEntrySet = nEntry_;
   nEntry_++;
   dirty_ = 1;
+  if ( nEntry_ > NODE_HASH_MIN && 2*nEntry_ > NEntryHash_ ) {
+    hashEntries();
+  } else if ( entryHash_ ) {
+    unsigned mask = NEntryHash_ - 1;
+    unsigned h = node_hash( name, (int) strlen( name ) ) & mask;
+    while ( entryHash_[h] ) h = ( h+1 ) & mask;
+    entryHash_[h] = nEntry_;
+  }
 }
 
 // create or set a value (or annotation) from a single line in the file buffer
@@ -1136,6 +1218,7 @@ void Fl_Preferences::Node::set( const char *line ) {
 
 // add more data to an existing entry
 void Fl_Preferences::Node::add( const char *line ) {
+  if ( data_ ) readEntries();
   if ( lastEntrySet<0 || lastEntrySet>=nEntry_ ) return;
   char *&dst = entry_[ lastEntrySet ].value;
   size_t a = strlen( dst );
@@ -1153,6 +1236,16 @@ const char *Fl_Preferences::Node::get( const char *name ) {
 
 // find the index of an entry, returns -1 if no such entry
 int Fl_Preferences::Node::getEntry( const char *name ) {
+  if ( data_ ) readEntries();
+  if ( entryHash_ ) {
+    unsigned mask = NEntryHash_ - 1;
+    for ( unsigned h = node_hash( name, (int) strlen( name ) ) & mask; entryHash_[h]; h = ( h+1 ) & mask ) {
+      int i = entryHash_[h] - 1;
+      if ( strcmp( name, entry_[i].name ) == 0 )
+	return i;
+    }
+    return -1;
+  }
   for ( int i=0; i<nEntry_; i++ ) {
     if ( strcmp( name, entry_[i].name ) == 0 ) {
       return i;
@@ -1165,12 +1258,125 @@ int Fl_Preferences::Node::getEntry( const char *name ) {
 char Fl_Preferences::Node::deleteEntry( const char *name ) {
   int ix = getEntry( name );
   if ( ix == -1 ) return 0;
+  free( entry_[ix].name );
+  if ( entry_[ix].value ) free( entry_[ix].value );
   memmove( entry_+ix, entry_+ix+1, (nEntry_-ix-1) * sizeof(Entry) );
   nEntry_--;
   dirty_ = 1;
+  if ( entryHash_ ) hashEntries();	// the entries after ix moved
   return 1;
 }
 
+// remember where the entries of this group are in the file buffer
+void Fl_Preferences::Node::setEntryData( const char *data, const char *end ) {
+  if ( data == end ) return;
+  if ( data_ ) readEntries();	// the group appears more than once in the file
+  data_ = data;
+  dataEnd_ = end;
+}
+
+// create the entries from the lines in the file buffer
+void Fl_Preferences::Node::readEntries() {
+  const char *p = data_, *end = dataEnd_;
+  data_ = dataEnd_ = 0L;
+  char dirt = dirty_;				// reading is not a change
+  char buf[1024];
+  while ( p < end ) {
+    const char *e = next_line( p, end );
+    memcpy( buf, p, e-p );
+    buf[ e-p ] = 0;
+    p = e;
+    if ( buf[0]=='+' ) {			// value of previous name/value pair spans multiple lines
+      size_t len = strcspn( buf+1, "\n\r" );
+      if ( len != 0 ) {				// if entry is not empty
+	buf[ len+1 ] = 0;
+	add( buf+1 );
+      }
+    } else {					 // read a name/value pair
+      size_t len = strcspn( buf, "\n\r" );
+      if ( len != 0 ) {				// if entry is not empty
+	buf[ len ] = 0;
+	set( buf );
+      }
+    }
+  }
+  dirty_ = dirt;
+}
+
+// (re)build the hash table of entries, or remove it if there are only a few
+void Fl_Preferences::Node::hashEntries() {
+  if ( nEntry_ <= NODE_HASH_MIN ) {
+    if ( entryHash_ ) free( entryHash_ );
+    entryHash_ = 0L;
+    NEntryHash_ = 0;
+    return;
+  }
+  int n = 32;
+  while ( n < 4*nEntry_ ) n *= 2;
+  if ( n != NEntryHash_ ) {
+    if ( entryHash_ ) free( entryHash_ );
+    entryHash_ = (int*)malloc( n * sizeof(int) );
+    NEntryHash_ = n;
+  }
+  memset( entryHash_, 0, n * sizeof(int) );
+  unsigned mask = n - 1;
+  for ( int i = 0; i < nEntry_; i++ ) {
+    unsigned h = node_hash( entry_[i].name, (int) strlen( entry_[i].name ) ) & mask;
+    while ( entryHash_[h] ) h = ( h+1 ) & mask;
+    entryHash_[h] = i+1;
+  }
+}
+
+// find the child node with the given name (len characters), returns 0 if there is none
+Fl_Preferences::Node *Fl_Preferences::Node::findChild( const char *name, int len ) {
+  if ( !childHash_ ) {
+    int n = 0;
+    for ( Node *nd = child_; nd; nd = nd->next_, n++ ) {
+      const char *nm = nd->name();
+      if ( strncmp( nm, name, len ) == 0 && nm[len] == 0 )
+	return nd;
+    }
+    if ( n <= NODE_HASH_MIN )
+      return 0;
+    for ( Node *nd = child_; nd; nd = nd->next_ )
+      hashChild( nd );
+    return 0;
+  }
+  unsigned mask = NChildHash_ - 1;
+  for ( unsigned h = node_hash( name, len ) & mask; childHash_[h]; h = ( h+1 ) & mask ) {
+    const char *nm = childHash_[h]->name();
+    if ( strncmp( nm, name, len ) == 0 && nm[len] == 0 )
+      return childHash_[h];
+  }
+  return 0;
+}
+
+// add a child node to the hash table of children, growing it as needed
+void Fl_Preferences::Node::hashChild( Node *nd ) {
+  if ( 2*( nChildHash_+1 ) > NChildHash_ ) {
+    Node **old = childHash_;
+    int i, n = NChildHash_;
+    NChildHash_ = n ? 2*n : 32;
+    childHash_ = (Node**)calloc( NChildHash_, sizeof(Node*) );
+    nChildHash_ = 0;
+    for ( i = 0; i < n; i++ )
+      if ( old[i] ) hashChild( old[i] );
+    if ( old ) free( old );
+  }
+  const char *nm = nd->name();
+  unsigned mask = NChildHash_ - 1;
+  unsigned h = node_hash( nm, (int) strlen( nm ) ) & mask;
+  while ( childHash_[h] ) h = ( h+1 ) & mask;
+  childHash_[h] = nd;
+  nChildHash_++;
+}
+
+void Fl_Preferences::Node::deleteChildHash() {
+  if ( childHash_ ) free( childHash_ );
+  childHash_ = 0L;
+  nChildHash_ = NChildHash_ = 0;
+}
+
 // find a group somewhere in the tree starting here
 // - this method will always return a valid node (except for memory allocation problems)
 // - if the node was not found, 'find' will create the required branch
@@ -1180,13 +1386,11 @@ Fl_Preferences::Node *Fl_Preferences::Node::find( const char *path ) {
     if ( path[ len ] == 0 )
       return this;
     if ( path[ len ] == '/' ) {
-      Node *nd;
-      for ( nd = child_; nd; nd = nd->next_ ) {
-	Node *nn = nd->find( path );
-	if ( nn ) return nn;
-      }
       const char *s = path+len+1;
       const char *e = strchr( s, '/' );
+      int n = e ? (int)(e-s) : (int) strlen( s );
+      Node *nd = findChild( s, n );
+      if ( nd ) return nd->find( path );
       if (e) strlcpy( nameBuffer, s, e-s+1 );
       else strlcpy( nameBuffer, s, sizeof(nameBuffer));
       nd = new Node( nameBuffer );
@@ -1217,23 +1421,15 @@ Fl_Preferences::Node *Fl_Preferences::Node::search( const char *path, int offset
 	return nn->search( path+2, 2 ); // do a relative search on the root node
       }
     }
-    offset = (int) strlen( path_ ) + 1;
   }
-  int len = (int) strlen( path_ );
-  if ( len < offset-1 ) return 0;
-  len -= offset;
-  if ( ( len <= 0 ) || ( strncmp( path, path_+offset, len ) == 0 ) ) {
-    if ( len > 0 && path[ len ] == 0 )
-      return this;
-    if ( len <= 0 || path[ len ] == '/' ) {
-      for ( Node *nd = child_; nd; nd = nd->next_ ) {
-	Node *nn = nd->search( path, offset );
-	if ( nn ) return nn;
-      }
-      return 0;
-    }
+  // walk down the tree one group name at a time
+  Node *nd = this;
+  for (;;) {
+    const char *e = strchr( path, '/' );
+    nd = nd->findChild( path, e ? (int)(e-path) : (int) strlen( path ) );
+    if ( !nd || !e ) return nd;
+    path = e+1;
   }
-  return 0;
 }
 
 // return the number of child nodes (groups)
@@ -1302,6 +1498,7 @@ char Fl_Preferences::Node::remove() {
     }
     parent()->dirty_ = 1;
     parent()->updateIndex();
+    parent()->deleteChildHash();
   }
   delete this;
   return ( nd != 0 );
@@ -0,0 +1,293 @@
+//
+// "$Id$"
+//
+// Shortcut index for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 1998-2017 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     http://www.fltk.org/COPYING.php
+//
+// Please report all bugs and problems on the following page:
+//
+//     http://www.fltk.org/str.php
+//
+
+// Two hash tables: one from each key to the widgets that have a shortcut
+// with it, and one from each widget to its keys. A key is the shortcut
+// with the case of the character and the shift flags removed, because
+// Fl::test_shortcut() matches that loosely.
+
+#include "Fl_Shortcut_Index.H"
+#include <FL/Fl.H>
+#include <FL/Fl_Menu_.H>
+#include <FL/fl_utf8.h>
+#include <stdlib.h>
+#include <string.h>
+
+int Fl_Shortcut_Index::enabled = 0;
+
+// the widgets with one key
+struct Fl_Shortcut_Key {
+  unsigned key;
+  Fl_Widget **widgets;
+  int n, size;
+  Fl_Shortcut_Key *next;
+};
+
+// the keys of one widget
+struct Fl_Shortcut_Member {
+  Fl_Widget *widget;
+  unsigned *keys;
+  int nkeys;
+  int dirty; // a menu whose keys must be found again
+  Fl_Shortcut_Member *next;
+};
+
+static Fl_Shortcut_Key **key_table;
+static int key_table_size, nkey_lists;
+static Fl_Shortcut_Member **member_table;
+static int member_table_size, nmembers, ndirty;
+
+static unsigned hash_key(unsigned key) {
+  return key * 2654435761U;
+}
+
+static unsigned hash_widget(Fl_Widget *w) {
+  return (unsigned)((fl_uintptr_t)w >> 4) * 2654435761U;
+}
+
+// the key of a shortcut or of a keyboard event
+static unsigned index_key(unsigned modifiers, unsigned key) {
+  return (modifiers & (FL_META|FL_ALT|FL_CTRL)) | (unsigned)fl_tolower(key & FL_KEY_MASK);
+}
+
+// makes the table twice as big when it is full, size is a power of 2
+template <class T> static void grow(T **&table, int &size, int count, unsigned (*hash)(T*)) {
+  if (count < size) return;
+  int new_size = size ? 2 * size : 64;
+  T **t = (T**)calloc(new_size, sizeof(T*));
+  for (int i = 0; i < size; i++) {
+    T *e = table[i];
+    while (e) {
+      T *next = e->next;
+      unsigned h = hash(e) & (new_size - 1);
+      e->next = t[h];
+      t[h] = e;
+      e = next;
+    }
+  }
+  free(table);
+  table = t;
+  size = new_size;
+}
+
+static unsigned hash_of(Fl_Shortcut_Key *k) { return hash_key(k->key); }
+static unsigned hash_of(Fl_Shortcut_Member *m) { return hash_widget(m->widget); }
+
+static Fl_Shortcut_Key *find_key(unsigned key) {
+  if (!key_table) return 0;
+  Fl_Shortcut_Key *k = key_table[hash_key(key) & (key_table_size - 1)];
+  while (k && k->key != key) k = k->next;
+  return k;
+}
+
+static void add_key(unsigned key, Fl_Widget *w) {
+  Fl_Shortcut_Key *k = find_key(key);
+  if (!k) {
+    grow(key_table, key_table_size, nkey_lists, hash_of);
+    k = (Fl_Shortcut_Key*)calloc(1, sizeof(Fl_Shortcut_Key));
+    k->key = key;
+    unsigned h = hash_key(key) & (key_table_size - 1);
+    k->next = key_table[h];
+    key_table[h] = k;
+    nkey_lists++;
+  }
+  if (k->n == k->size) {
+    k->size = k->size ? 2 * k->size : 4;
+    k->widgets = (Fl_Widget**)realloc(k->widgets, k->size * sizeof(Fl_Widget*));
+  }
+  k->widgets[k->n++] = w;
+}
+
+static void remove_key(unsigned key, Fl_Widget *w) {
+  Fl_Shortcut_Key *k = find_key(key);
+  if (!k) return;
+  for (int i = 0; i < k->n; i++) {
+    if (k->widgets[i] == w) {
+      memmove(k->widgets + i, k->widgets + i + 1, (k->n - i - 1) * sizeof(Fl_Widget*));
+      k->n--;
+      break;
+    }
+  }
+}
+
+static Fl_Shortcut_Member **find_member(Fl_Widget *w) {
+  if (!member_table) return 0;
+  Fl_Shortcut_Member **m = member_table + (hash_widget(w) & (member_table_size - 1));
+  while (*m && (*m)->widget != w) m = &(*m)->next;
+  return *m ? m : 0;
+}
+
+static Fl_Shortcut_Member *add_member(Fl_Widget *w) {
+  Fl_Shortcut_Member **p = find_member(w);
+  if (p) return *p;
+  grow(member_table, member_table_size, nmembers, hash_of);
+  Fl_Shortcut_Member *m = (Fl_Shortcut_Member*)calloc(1, sizeof(Fl_Shortcut_Member));
+  m->widget = w;
+  unsigned h = hash_widget(w) & (member_table_size - 1);
+  m->next = member_table[h];
+  member_table[h] = m;
+  nmembers++;
+  return m;
+}
+
+static void set_keys(Fl_Shortcut_Member *m, const unsigned *keys, int n) {
+  int i;
+  for (i = 0; i < m->nkeys; i++) remove_key(m->keys[i], m->widget);
+  m->keys = (unsigned*)realloc(m->keys, n * sizeof(unsigned));
+  m->nkeys = n;
+  for (i = 0; i < n; i++) {
+    m->keys[i] = keys[i];
+    add_key(keys[i], m->widget);
+  }
+}
+
+static int compare_keys(const void *a, const void *b) {
+  unsigned x = *(const unsigned*)a, y = *(const unsigned*)b;
+  return x < y ? -1 : x > y;
+}
+
+// adds the keys of all items of the menu and its submenus
+static void menu_keys(const Fl_Menu_Item *m, unsigned *&keys, int &n, int &size, int depth) {
+  if (!m || depth > 32) return;
+  for (int nest = 0; ; m++) {
+    if (!m->text) {
+      if (!nest) break;
+      nest--;
+      continue;
+    }
+    if (m->shortcut()) {
+      if (n == size) {
+        size = size ? 2 * size : 64;
+        keys = (unsigned*)realloc(keys, size * sizeof(unsigned));
+      }
+      keys[n++] = index_key(m->shortcut(), m->shortcut());
+    }
+    if (m->flags & FL_SUBMENU) nest++;
+    else if (m->flags & FL_SUBMENU_POINTER) menu_keys((const Fl_Menu_Item*)m->user_data(), keys, n, size, depth + 1);
+  }
+}
+
+// finds the keys of the menus that changed since the last keyboard event
+static void update_menus() {
+  static unsigned *keys;
+  static int size;
+  for (int i = 0; ndirty && i < member_table_size; i++) {
+    for (Fl_Shortcut_Member *m = member_table[i]; m; m = m->next) {
+      if (!m->dirty) continue;
+      int n = 0;
+      menu_keys(((Fl_Menu_*)m->widget)->menu(), keys, n, size, 0);
+      qsort(keys, n, sizeof(unsigned), compare_keys);
+      int u = 0;
+      for (int k = 0; k < n; k++) if (!u || keys[k] != keys[u - 1]) keys[u++] = keys[k];
+      set_keys(m, keys, u);
+      m->dirty = 0;
+      ndirty--;
+    }
+  }
+}
+
+void Fl_Shortcut_Index::set(Fl_Widget *w, unsigned int shortcut) {
+  if (!enabled) return;
+  if (!shortcut && !find_member(w)) return;
+  unsigned key = index_key(shortcut, shortcut);
+  set_keys(add_member(w), &key, shortcut ? 1 : 0);
+}
+
+void Fl_Shortcut_Index::menu_changed(Fl_Widget *w) {
+  if (!enabled) return;
+  Fl_Shortcut_Member *m = add_member(w);
+  if (!m->dirty) {
+    m->dirty = 1;
+    ndirty++;
+  }
+}
+
+void Fl_Shortcut_Index::remove(Fl_Widget *w) {
+  if (!nmembers) return;
+  Fl_Shortcut_Member **p = find_member(w);
+  if (!p) return;
+  Fl_Shortcut_Member *m = *p;
+  set_keys(m, 0, 0);
+  if (m->dirty) ndirty--;
+  *p = m->next;
+  free(m->keys);
+  free(m);
+  nmembers--;
+}
+
+int Fl_Shortcut_Index::contains(Fl_Widget *w) {
+  return find_member(w) != 0;
+}
+
+int Fl_Shortcut_Index::find(Fl_Widget **widgets, int size) {
+  if (!nmembers) return 0;
+  if (ndirty) update_menus();
+  // the keys that Fl::test_shortcut() may match: the key, the first
+  // character typed, and Ctrl+'^_' typed as Ctrl+'_'
+  unsigned keys[3];
+  int nkeys = 0, n = 0, i;
+  unsigned c = fl_utf8decode(Fl::event_text(), Fl::event_text() + Fl::event_length(), 0);
+  keys[nkeys++] = index_key(Fl::event_state(), Fl::event_key());
+  if (Fl::event_length()) keys[nkeys++] = index_key(Fl::event_state(), c);
+  if ((Fl::event_state() & FL_CTRL) && c < 0x20) keys[nkeys++] = index_key(Fl::event_state(), c ^ 0x40);
+  for (int k = 0; k < nkeys; k++) {
+    for (i = 0; i < k && keys[i] != keys[k]; i++) {}
+    if (i < k) continue; // looked up already
+    Fl_Shortcut_Key *list = find_key(keys[k]);
+    if (!list) continue;
+    for (int j = 0; j < list->n && n < size; j++) {
+      for (i = 0; i < n && widgets[i] != list->widgets[j]; i++) {}
+      if (i == n) widgets[n++] = list->widgets[j];
+    }
+  }
+  return n;
+}
+
+/**
+ Makes FL_SHORTCUT events go first to the widgets that have the shortcut.
+
+ Normally FLTK finds the widget for a shortcut by sending the event to
+ the widgets of the window, one after the other, and each Fl_Menu_ looks
+ at all its items. That takes long in windows with thousands of widgets
+ or menu items.
+
+ With the index, FLTK keeps a table of the Fl_Button::shortcut() of the
+ buttons and the shortcuts of the menu items of all Fl_Menu_ widgets, and
+ sends the event to the widgets that have the shortcut of the key first.
+ Only when none of them takes it, the event goes to all widgets as before,
+ for instance to widgets with an '&' shortcut in their label or with a
+ handle() method of their own.
+
+ The index is off by default. Turn it on before creating the widgets,
+ the shortcuts of widgets created before are only found the slow way.
+ Menu items that are changed directly instead of through the Fl_Menu_
+ methods are found the slow way, too.
+ */
+void Fl::shortcut_index(int on) {
+  Fl_Shortcut_Index::enabled = on;
+}
+
+/** Returns whether the shortcut index is on.
+ \see Fl::shortcut_index(int) */
+int Fl::shortcut_index() {
+  return Fl_Shortcut_Index::enabled;
+}
+
+//
+// End of "$Id$".
+//
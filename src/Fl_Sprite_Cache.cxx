@@ -0,0 +1,307 @@
+//
+// "$Id$"
+//
+// Sprite cache for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 1998-2017 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     http://www.fltk.org/COPYING.php
+//
+// Please report all bugs and problems on the following page:
+//
+//     http://www.fltk.org/str.php
+//
+
+#include "Fl_Sprite_Cache.H"
+#include <FL/Fl_Image_Surface.H>
+#include <FL/Fl_Device.H>
+#include <FL/fl_draw.H>
+#include <stdlib.h>
+#include <string.h>
+
+int Fl_Sprite_Cache::enabled = 1;
+size_t Fl_Sprite_Cache::budget = 8 * 1024 * 1024;
+
+// larger boxes are drawn the slow way, they hardly repeat
+static const int max_pixels = 256 * 256;
+
+enum { SEEN, CACHED, FAILED };
+
+struct Sprite {
+  Sprite *next;			// in the hash chain
+  Sprite *newer, *older;	// in the list of recently drawn sprites
+  unsigned hash;
+  Fl_Box_Draw_F *box;		// the box function, NULL for a symbol
+  char *label;			// the symbol, NULL for a box
+  int w, h;			// the size of the box or symbol
+  int dx, dy, sw, sh;		// where the sprite is, relative to the box
+  Fl_Color color;
+  char active;			// Fl::draw_box_active()
+  char state;
+  Fl_RGB_Image *image;
+  size_t bytes;
+};
+
+static Sprite **table = 0;
+static int table_size = 0, count = 0;
+static Sprite *newest = 0, *oldest = 0;
+static size_t total_bytes = 0;
+
+static unsigned hash_key(Fl_Box_Draw_F *box, const char *label, int w, int h, Fl_Color c, int active) {
+  unsigned k = 2166136261u;
+  if (label) while (*label) k = (k ^ (unsigned char)*label++) * 16777619u;
+  else k = (k ^ (unsigned)(fl_uintptr_t)box) * 16777619u;
+  k = (k ^ (unsigned)w) * 16777619u;
+  k = (k ^ (unsigned)h) * 16777619u;
+  k = (k ^ (unsigned)c) * 16777619u;
+  return (k ^ (unsigned)active) * 16777619u;
+}
+
+static void unlink_lru(Sprite *s) {
+  if (s->newer) s->newer->older = s->older; else newest = s->older;
+  if (s->older) s->older->newer = s->newer; else oldest = s->newer;
+}
+
+static void link_lru(Sprite *s) {
+  s->newer = 0;
+  s->older = newest;
+  if (newest) newest->newer = s; else oldest = s;
+  newest = s;
+}
+
+static void remove_sprite(Sprite *s) {
+  Sprite **p = table + (s->hash & (table_size - 1));
+  while (*p != s) p = &(*p)->next;
+  *p = s->next;
+  unlink_lru(s);
+  total_bytes -= s->bytes;
+  count--;
+  delete s->image;
+  free(s->label);
+  delete s;
+}
+
+// frees the least recently drawn sprites until the cache fits its budget
+static void evict(Sprite *keep) {
+  while (total_bytes > Fl_Sprite_Cache::budget && oldest && oldest != keep)
+    remove_sprite(oldest);
+}
+
+static Sprite *find(Fl_Box_Draw_F *box, const char *label, int w, int h, Fl_Color c, int active) {
+  unsigned hash = hash_key(box, label, w, h, c, active);
+  if (table_size) {
+    for (Sprite *s = table[hash & (table_size - 1)]; s; s = s->next) {
+      if (s->hash == hash && s->box == box && s->w == w && s->h == h && s->color == c &&
+          s->active == active && (!label || !strcmp(s->label, label))) {
+        unlink_lru(s);
+        link_lru(s);
+        return s;
+      }
+    }
+  }
+  if (count >= table_size) {
+    int n = table_size ? 2 * table_size : 256;
+    Sprite **t = (Sprite**)calloc(n, sizeof(Sprite*));
+    for (int i = 0; i < table_size; i++) {
+      for (Sprite *s = table[i], *next; s; s = next) {
+        next = s->next;
+        s->next = t[s->hash & (n - 1)];
+        t[s->hash & (n - 1)] = s;
+      }
+    }
+    free(table);
+    table = t;
+    table_size = n;
+  }
+  Sprite *s = new Sprite;
+  memset(s, 0, sizeof(Sprite));
+  s->hash = hash;
+  s->box = box;
+  s->label = label ? strdup(label) : 0;
+  s->w = w; s->h = h;
+  s->color = c;
+  s->active = (char)active;
+  s->state = SEEN;
+  s->bytes = sizeof(Sprite) + (label ? strlen(label) + 1 : 0);
+  s->next = table[hash & (table_size - 1)];
+  table[hash & (table_size - 1)] = s;
+  link_lru(s);
+  count++;
+  total_bytes += s->bytes;
+  evict(s);
+  return s;
+}
+
+// Draws the sprite on black and on white, the difference is its alpha.
+// Returns NULL if it can not be drawn as an image.
+static Fl_RGB_Image *render(Sprite *s) {
+  int W = s->sw, H = s->sh;
+  Fl_RGB_Image *shot[2];
+  Fl_Color saved = fl_color();
+  Fl_Image_Surface *surface = new Fl_Image_Surface(W, H);
+  Fl_Surface_Device::push_current(surface);
+  for (int i = 0; i < 2; i++) {
+    fl_color(i ? 255 : 0, i ? 255 : 0, i ? 255 : 0);
+    fl_rectf(0, 0, W, H);
+    if (s->box) s->box(0, 0, W, H, s->color);
+    else fl_draw_symbol(s->label, -s->dx, -s->dy, s->w, s->h, s->color);
+    shot[i] = surface->image();
+  }
+  Fl_Surface_Device::pop_current();
+  delete surface;
+  // the surfaces share some graphics state with the display
+  fl_restore_clip();
+  fl_color(saved);
+
+  Fl_RGB_Image *image = 0;
+  if (shot[0] && shot[1] && shot[0]->d() >= 3 && shot[0]->d() == shot[1]->d() &&
+      shot[0]->w() == W && shot[0]->h() == H && shot[1]->w() == W && shot[1]->h() == H) {
+    int d = shot[0]->d();
+    int ld = shot[0]->ld() ? shot[0]->ld() : W * d;
+    const uchar *black = (const uchar*)shot[0]->data()[0];
+    const uchar *white = (const uchar*)shot[1]->data()[0];
+    uchar *rgba = new uchar[W * H * 4], *q = rgba;
+    int opaque = 1;
+    for (int y = 0; y < H; y++) {
+      const uchar *b = black + y * ld, *w = white + y * ld;
+      for (int x = 0; x < W; x++, b += d, w += d, q += 4) {
+        // over black a pixel is a*c, over white a*c + (1-a)*255
+        int diff = w[0] - b[0];
+        if (w[1] - b[1] > diff) diff = w[1] - b[1];
+        if (w[2] - b[2] > diff) diff = w[2] - b[2];
+        int a = 255 - (diff < 0 ? 0 : diff);
+        q[3] = (uchar)a;
+        if (a == 255) { q[0] = b[0]; q[1] = b[1]; q[2] = b[2]; continue; }
+        opaque = 0;
+        for (int k = 0; k < 3; k++) {
+          int v = a ? b[k] * 255 / a : 0;
+          q[k] = (uchar)(v > 255 ? 255 : v);
+        }
+      }
+    }
+    if (opaque) {
+      // the box covers all its pixels, draw it without alpha
+      for (int i = 0; i < W * H; i++) {
+        rgba[3*i] = rgba[4*i]; rgba[3*i+1] = rgba[4*i+1]; rgba[3*i+2] = rgba[4*i+2];
+      }
+      image = new Fl_RGB_Image(rgba, W, H, 3);
+      image->alloc_array = 1;
+    } else if (fl_can_do_alpha_blending()) {
+      image = new Fl_RGB_Image(rgba, W, H, 4);
+      image->alloc_array = 1;
+    } else {
+      delete[] rgba;
+    }
+  }
+  delete shot[0];
+  delete shot[1];
+  return image;
+}
+
+// whether a sprite of w * h pixels may be drawn from the cache now
+static int usable(int w, int h) {
+  return Fl_Sprite_Cache::enabled && Fl_Sprite_Cache::budget &&
+         w > 0 && h > 0 && w * h <= max_pixels &&
+         Fl_Surface_Device::surface() == Fl_Display_Device::display_device();
+}
+
+static int draw_sprite(Sprite *s, int x, int y) {
+  if (s->state == SEEN) {
+    // drawn for the second time, it is probably going to be drawn again
+    s->image = render(s);
+    s->state = s->image ? CACHED : FAILED;
+    if (s->image) {
+      size_t pixels = (size_t)s->sw * s->sh;
+      // the image, and its copy on the display
+      s->bytes += pixels * s->image->d() + pixels * 4;
+      total_bytes += pixels * s->image->d() + pixels * 4;
+      evict(s);
+    }
+  }
+  if (s->state != CACHED) return 0;
+  s->image->draw(x + s->dx, y + s->dy);
+  return 1;
+}
+
+int Fl_Sprite_Cache::draw_box(Fl_Box_Draw_F *f, int x, int y, int w, int h, Fl_Color c) {
+  if (!usable(w, h)) return 0;
+  if (!fl_not_clipped(x, y, w, h)) return 1;
+  Sprite *s = find(f, 0, w, h, c, Fl::draw_box_active());
+  if (s->state == SEEN && !s->sw) {
+    s->sw = w; s->sh = h;
+    return 0;
+  }
+  return draw_sprite(s, x, y);
+}
+
+int Fl_Sprite_Cache::draw_symbol(const char *label, int x, int y, int w, int h, Fl_Color c,
+                                 int bx, int by, int bw, int bh) {
+  if (!usable(bw, bh)) return 0;
+  // the symbol is drawn with the current transformation
+  if (fl_transform_x(0, 0) != 0 || fl_transform_y(0, 0) != 0 ||
+      fl_transform_x(1, 0) != 1 || fl_transform_y(1, 0) != 0 ||
+      fl_transform_x(0, 1) != 0 || fl_transform_y(0, 1) != 1) return 0;
+  if (!fl_not_clipped(bx, by, bw, bh)) return 1;
+  Sprite *s = find(0, label, w, h, c, 1);
+  if (s->state == SEEN && !s->sw) {
+    s->dx = bx - x; s->dy = by - y;
+    s->sw = bw; s->sh = bh;
+    return 0;
+  }
+  return draw_sprite(s, x, y);
+}
+
+void Fl_Sprite_Cache::clear() {
+  while (oldest) remove_sprite(oldest);
+}
+
+/**
+ Turns the sprite cache on or off.
+
+ Some box types, like the ones of the "plastic" and "gleam" schemes,
+ and the symbols of fl_draw_symbol() are drawn with many lines and colors.
+ With the cache on, a box or symbol that is drawn on the display for the
+ second time with the same size and colors is rendered into an image, and
+ drawn as that image from then on. The images are freed when the colormap
+ changes, and the least recently drawn ones when they need more memory
+ than Fl::sprite_cache_budget().
+
+ The cache is on by default. Turning it off frees all images.
+ Boxes and symbols are only cached while drawing on the display, not while
+ printing or drawing into an Fl_Image_Surface. Symbols added with
+ fl_add_symbol() that are not scalable are never cached.
+ \version 1.4.0
+ */
+void Fl::sprite_cache(int on) {
+  Fl_Sprite_Cache::enabled = on;
+  if (!on) Fl_Sprite_Cache::clear();
+}
+
+/** Returns whether the sprite cache is on.
+ \see Fl::sprite_cache(int) */
+int Fl::sprite_cache() {
+  return Fl_Sprite_Cache::enabled;
+}
+
+/** Sets the memory the sprite cache may use, in bytes.
+ The default is 8 MB, 0 turns the cache off.
+ \see Fl::sprite_cache(int) */
+void Fl::sprite_cache_budget(size_t bytes) {
+  Fl_Sprite_Cache::budget = bytes;
+  if (!bytes) Fl_Sprite_Cache::clear();
+  else evict(0);
+}
+
+/** Returns the memory the sprite cache may use, in bytes.
+ \see Fl::sprite_cache_budget(size_t) */
+size_t Fl::sprite_cache_budget() {
+  return Fl_Sprite_Cache::budget;
+}
+
+//
+// End of "$Id$".
+//
@@ -26,6 +26,7 @@
 #include <stdarg.h>
 #include <string.h>
 #include "flstring.h"
+#include "utf8_internal.h"
 #include <time.h>
 
 const int Fl_System_Driver::fl_NoValue =     0x0000;
@@ -230,9 +231,15 @@ unsigned Fl_System_Driver::utf8towc(const char* src, unsigned srclen, wchar_t* d
       return count;
     }
     if (!(*p & 0x80)) { /* ascii */
+      if (e-p >= 8 && dstlen-count > 8 && fl_utf8_ascii8(p)) {
+        for (int i = 0; i < 8; i++) dst[count+i] = p[i];
+        p += 8;
+        count += 8;
+        continue;
+      }
       dst[count] = *p++;
     } else {
-      int len; unsigned ucs = fl_utf8decode(p,e,&len);
+      int len; unsigned ucs = fl_utf8decode_fast(p,e,&len);
       p += len;
       dst[count] = (wchar_t)ucs;
     }
@@ -240,9 +247,11 @@ unsigned Fl_System_Driver::utf8towc(const char* src, unsigned srclen, wchar_t* d
   }
   /* we filled dst, measure the rest: */
   while (p < e) {
-    if (!(*p & 0x80)) p++;
-    else {
-      int len; fl_utf8decode(p,e,&len);
+    if (!(*p & 0x80)) {
+      if (e-p >= 8 && fl_utf8_ascii8(p)) {p += 8; count += 8; continue;}
+      p++;
+    } else {
+      int len; fl_utf8decode_fast(p,e,&len);
       p += len;
     }
     ++count;
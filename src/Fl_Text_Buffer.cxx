@@ -20,6 +20,7 @@
 #include <stdlib.h>
 #include <FL/fl_utf8.h>
 #include "flstring.h"
+#include "utf8_internal.h"
 #include <ctype.h>
 #include <FL/Fl.H>
 #include <FL/Fl_Text_Buffer.H>
@@ -1645,6 +1646,14 @@ static int utf8_input_filter(char *buffer, 		// result buffer we fill with utf8
       p = line;
       if (endline - line < l) break;	// sequence *still* extends past end? stop loop
     }
+    if (l == 1 && !(*p & 0x80)) {	// copy a run of ascii characters as is
+      int n = (int)fl_utf8_ascii_span(p, (unsigned)(endline - p));
+      if (n > buffer + buflen - q) n = (int)(buffer + buflen - q);
+      memcpy(q, p, n);
+      q += n;
+      p += n;
+      continue;
+    }
     while ( l > 0) {
       u = fl_utf8decode(p, p+l, &lp);	// get single utf8 encoded char as a Unicode value
       lq = fl_utf8encode(u, multibyte);	// re-encode Unicode value to utf8 in multibyte[]
@@ -1683,7 +1692,7 @@ const char *Fl_Text_Buffer::file_encoding_warning_message =
   if (!(fp = fl_fopen(file, "r")))
     return 1;
   char *buffer = new char[buflen + 1];  
-  char *endline, line[100];
+  char *endline, line[4096];
   int l;
   input_file_was_transcoded = false;
   endline = line;
@@ -0,0 +1,327 @@
+//
+// "$Id$"
+//
+// Event loop tracing for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 1998-2017 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     http://www.fltk.org/COPYING.php
+//
+// Please report all bugs and problems on the following page:
+//
+//     http://www.fltk.org/str.php
+//
+
+#include <FL/Fl_Trace.H>
+#include <FL/Fl_Widget.H>
+#include <FL/fl_utf8.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__GXX_RTTI) || defined(_CPPRTTI)
+#  define FL_TRACE_RTTI 1
+#  include <typeinfo>
+#  if defined(__GNUC__)
+#    include <cxxabi.h>
+#  endif
+#endif
+#ifdef WIN32
+#  include <windows.h>
+#else
+#  include <time.h>
+#  include <sys/time.h>
+#endif
+
+int Fl_Trace::enabled_ = 0;
+double Fl_Trace::budget_ = 0.016;
+Fl_Trace_Handler Fl_Trace::handler_ = 0;
+void *Fl_Trace::handler_data_ = 0;
+
+static const char *phase_names[FL_TRACE_PHASES] = {
+  "timeout", "check", "idle", "fd", "awake", "event", "flush", "window",
+  "widget", "user"
+};
+
+static Fl_Trace_Histogram phases[FL_TRACE_PHASES];
+
+// the widget classes, with an open addressing hash of their names
+struct Trace_Class {
+  const char *name;	// as returned by class_name(), compared with strcmp()
+  Fl_Trace_Histogram histogram;
+};
+static Trace_Class *classes = 0;
+static int nclasses = 0, classes_size = 0;
+static int *class_hash = 0, class_hash_size = 0;
+
+// the most recent spans, a ring buffer
+static Fl_Trace_Span *spans = 0;
+static int spans_size = 65536, nspans = 0, next_span = 0;
+
+// now() when tracing was turned on, spans start relative to it
+static double origin = 0;
+
+static unsigned hash_name(const char *s) {
+  unsigned h = 2166136261u;
+  while (*s) h = (h ^ (unsigned char)*s++) * 16777619u;
+  return h;
+}
+
+// the name of the class of a widget: its typeid() name, or without run-time
+// type information the kind of widget and its type(), like "Fl_Group type 2"
+static const char *class_name(const Fl_Widget *widget) {
+#ifdef FL_TRACE_RTTI
+  return typeid(*widget).name();
+#else
+  static char *names[3][256];
+  Fl_Widget *w = (Fl_Widget*)widget;
+  int kind = w->as_window() ? 0 : w->as_group() ? 1 : 2;
+  int type = widget->type();
+  if (!names[kind][type]) {
+    static const char *kinds[3] = { "Fl_Window", "Fl_Group", "Fl_Widget" };
+    char buf[40];
+    if (type) snprintf(buf, sizeof(buf), "%s type %d", kinds[kind], type);
+    else strcpy(buf, kinds[kind]);
+    names[kind][type] = strdup(buf);
+  }
+  return names[kind][type];
+#endif
+}
+
+// the name shown for a class_name(), demangled where the compiler can
+static const char *readable_name(const char *name) {
+#if defined(FL_TRACE_RTTI) && defined(__GNUC__)
+  int status = 0;
+  char *n = abi::__cxa_demangle(name, 0, 0, &status);
+  if (n && !status) return n;
+  free(n);
+#endif
+  return name;
+}
+
+static int find_class(const char *name) {
+  unsigned h = hash_name(name);
+  if (class_hash_size) {
+    for (unsigned i = h & (class_hash_size - 1); class_hash[i] >= 0; i = (i + 1) & (class_hash_size - 1)) {
+      const char *n = classes[class_hash[i]].name;
+      if (n == name || !strcmp(n, name)) return class_hash[i];
+    }
+  }
+  if (nclasses >= classes_size) {
+    classes_size = classes_size ? 2 * classes_size : 64;
+    classes = (Trace_Class*)realloc(classes, classes_size * sizeof(Trace_Class));
+  }
+  if (2 * (nclasses + 1) > class_hash_size) {
+    // keep the hash at most half full
+    free(class_hash);
+    class_hash_size = class_hash_size ? 2 * class_hash_size : 128;
+    class_hash = (int*)malloc(class_hash_size * sizeof(int));
+    for (int i = 0; i < class_hash_size; i++) class_hash[i] = -1;
+    for (int k = 0; k < nclasses; k++) {
+      unsigned i = hash_name(classes[k].name) & (class_hash_size - 1);
+      while (class_hash[i] >= 0) i = (i + 1) & (class_hash_size - 1);
+      class_hash[i] = k;
+    }
+  }
+  Trace_Class *c = classes + nclasses;
+  memset(c, 0, sizeof(Trace_Class));
+  c->name = name;
+  c->histogram.name = readable_name(name);
+  unsigned i = h & (class_hash_size - 1);
+  while (class_hash[i] >= 0) i = (i + 1) & (class_hash_size - 1);
+  class_hash[i] = nclasses;
+  return nclasses++;
+}
+
+static void add_to_histogram(Fl_Trace_Histogram &h, double duration, double budget) {
+  h.count++;
+  h.total += duration;
+  if (duration > h.max) h.max = duration;
+  if (duration > budget) h.over_budget++;
+  int b = 0;
+  for (double us = duration * 1e6; us >= 2 && b < FL_TRACE_BUCKETS - 1; us *= 0.5) b++;
+  h.buckets[b]++;
+}
+
+/**
+ Returns the duration, in seconds, that \p p percent of the spans did not exceed.
+ The result is the upper end of the histogram bucket, or max in the last one.
+ */
+double Fl_Trace_Histogram::percentile(double p) const {
+  if (!count) return 0;
+  double n = count * p / 100, sum = 0;
+  for (int b = 0; b < FL_TRACE_BUCKETS - 1; b++) {
+    sum += buckets[b];
+    if (sum >= n) {
+      double end = (double)(2 << b) * 1e-6;
+      return end < max ? end : max;
+    }
+  }
+  return max;
+}
+
+/**
+ Turns tracing on or off.
+ Turning it on the first time, or after reset(), starts the clock of the spans.
+ */
+void Fl_Trace::enable(int on) {
+  if (on && !origin) origin = now();
+  enabled_ = on;
+}
+
+/**
+ Returns a time in seconds, for measuring durations.
+ */
+double Fl_Trace::now() {
+#ifdef WIN32
+  static double scale = 0;
+  LARGE_INTEGER t;
+  if (!scale) {
+    QueryPerformanceFrequency(&t);
+    scale = 1.0 / (double)t.QuadPart;
+  }
+  QueryPerformanceCounter(&t);
+  return (double)t.QuadPart * scale;
+#elif defined(CLOCK_MONOTONIC)
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+#else
+  struct timeval t;
+  gettimeofday(&t, 0);
+  return t.tv_sec + t.tv_usec * 1e-6;
+#endif
+}
+
+/**
+ Records the drawing of \p widget that started at \p start, as returned by
+ now(), and ends now. \p phase is FL_TRACE_WIDGET or FL_TRACE_WINDOW, the
+ span is also added to the histogram of the class of \p widget.
+ */
+void Fl_Trace::record_widget(Fl_Trace_Phase phase, const Fl_Widget *widget, double start) {
+  if (enabled_) add(phase, 0, widget, start, now());
+}
+
+void Fl_Trace::add(Fl_Trace_Phase phase, const char *name, const Fl_Widget *widget, double start, double end) {
+  if (!start || !origin) return; // tracing was turned on during the span
+  double duration = end - start;
+  add_to_histogram(phases[phase], duration, budget_);
+  if (widget) {
+    int k = find_class(class_name(widget)); // may move classes
+    Fl_Trace_Histogram &h = classes[k].histogram;
+    add_to_histogram(h, duration, budget_);
+    if (!name) name = h.name;
+  }
+  if (!name) name = phase_names[phase];
+  Fl_Trace_Span span;
+  span.phase = phase;
+  span.name = name;
+  span.widget = widget;
+  span.start = start - origin;
+  span.duration = duration;
+  if (spans_size) {
+    if (!spans) spans = (Fl_Trace_Span*)malloc(spans_size * sizeof(Fl_Trace_Span));
+    spans[next_span] = span;
+    if (++next_span >= spans_size) next_span = 0;
+    if (nspans < spans_size) nspans++;
+  }
+  if (handler_) handler_(span, handler_data_);
+}
+
+/**
+ Sets a function that is called with each span when it was measured.
+ The widget of the span may only be used during the call.
+ Pass NULL to remove the handler.
+ */
+void Fl_Trace::handler(Fl_Trace_Handler h, void *data) {
+  handler_ = h;
+  handler_data_ = data;
+}
+
+/**
+ Sets how many of the most recent spans are kept for write_chrome_trace().
+ The default is 65536, 0 keeps none. This discards the spans kept so far.
+ */
+void Fl_Trace::capacity(int n) {
+  free(spans);
+  spans = 0;
+  spans_size = n > 0 ? n : 0;
+  nspans = next_span = 0;
+}
+
+/** Returns how many spans are kept for write_chrome_trace() */
+int Fl_Trace::capacity() {
+  return spans_size;
+}
+
+/** Returns the histogram of \p phase */
+const Fl_Trace_Histogram *Fl_Trace::phase(Fl_Trace_Phase phase) {
+  if (phase < 0 || phase >= FL_TRACE_PHASES) return 0;
+  phases[phase].name = phase_names[phase];
+  return phases + phase;
+}
+
+/** Returns the number of widget classes that were drawn while tracing */
+int Fl_Trace::widget_classes() {
+  return nclasses;
+}
+
+/**
+ Returns the histogram of the \p i'th widget class, in the order they were
+ first drawn. It sums up the FL_TRACE_WIDGET and FL_TRACE_WINDOW spans.
+ */
+const Fl_Trace_Histogram *Fl_Trace::widget_class(int i) {
+  return i >= 0 && i < nclasses ? &classes[i].histogram : 0;
+}
+
+/** Returns the class name of \p widget, as shown in the histograms and traces */
+const char *Fl_Trace::widget_class_name(const Fl_Widget *widget) {
+  int k = find_class(class_name(widget));
+  return classes[k].histogram.name;
+}
+
+/**
+ Clears the histograms and the spans kept, and restarts the clock.
+ The classes stay in the list, with a count of 0.
+ */
+void Fl_Trace::reset() {
+  memset(phases, 0, sizeof(phases));
+  for (int i = 0; i < nclasses; i++) {
+    const char *n = classes[i].histogram.name;
+    memset(&classes[i].histogram, 0, sizeof(Fl_Trace_Histogram));
+    classes[i].histogram.name = n;
+  }
+  nspans = next_span = 0;
+  origin = enabled_ ? now() : 0;
+}
+
+/**
+ Writes the spans kept to \p filename in the Chrome trace event format.
+ Returns 0 on success, -1 if the file could not be written.
+ */
+int Fl_Trace::write_chrome_trace(const char *filename) {
+  FILE *f = fl_fopen(filename, "w");
+  if (!f) return -1;
+  fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", f);
+  int i = nspans < spans_size ? 0 : next_span;
+  for (int n = 0; n < nspans; n++) {
+    const Fl_Trace_Span &s = spans[i];
+    if (++i >= spans_size) i = 0;
+    fputs(n ? ",\n{\"name\":\"" : "{\"name\":\"", f);
+    for (const char *c = s.name; *c; c++) {
+      if (*c == '"' || *c == '\\') putc('\\', f);
+      if ((unsigned char)*c >= ' ') putc(*c, f);
+    }
+    fprintf(f, "\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":1}",
+            phase_names[s.phase], s.start * 1e6, s.duration * 1e6);
+  }
+  fputs("\n]}\n", f);
+  return fclose(f) ? -1 : 0;
+}
+
+//
+// End of "$Id$".
+//
@@ -22,6 +22,7 @@
 #include <FL/Fl_Tooltip.H>
 #include <FL/fl_draw.H>
 #include <stdlib.h>
+#include "Fl_Shortcut_Index.H"
 #include "flstring.h"
 
 
@@ -190,6 +191,7 @@ Fl_Widget::~Fl_Widget() {
   fl_throw_focus(this);
   // remove stale entries from default callback queue (Fl::readqueue())
   if (callback_ == default_callback) cleanup_readqueue(this);
+  Fl_Shortcut_Index::remove(this);
 }
 
 /** Draws a focus box for the widget at the given position and size */
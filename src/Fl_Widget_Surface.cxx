@@ -50,6 +50,8 @@ void Fl_Widget_Surface::draw(Fl_Widget* widget, int delta_x, int delta_y)
   is_window = (widget->as_window() != NULL);
   uchar old_damage = widget->damage();
   widget->damage(FL_DAMAGE_ALL);
+  // a window that is not mapped ignores damage(), e.g. when rendering headlessly
+  if (is_window && !widget->as_window()->shown()) widget->clear_damage(FL_DAMAGE_ALL);
   // set origin to the desired top-left position of the widget
   origin(&old_x, &old_y);
   new_x = old_x + delta_x;
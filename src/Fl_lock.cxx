@@ -19,6 +19,7 @@
 #include "config_lib.h"
 #include <FL/Fl.H>
 #include <FL/Fl_System_Driver.H>
+#include <FL/Fl_Trace.H>
 
 #include <stdlib.h>
 
@@ -336,7 +337,9 @@ static void thread_awake_cb(int fd, void*) {
   Fl_Awake_Handler func;
   void *data;
   while (Fl::get_awake_handler_(func, data)==0) {
+    double start = Fl_Trace::enabled() ? Fl_Trace::now() : 0;
     (*func)(data);
+    if (start) Fl_Trace::record(FL_TRACE_AWAKE, 0, start);
   }
 }
 
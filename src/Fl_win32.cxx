@@ -63,6 +63,7 @@ void fl_cleanup_dc_list(void);
 #include <FL/Fl_Tooltip.H>
 #include <FL/Fl_Paged_Device.H>
 #include <FL/Fl_Shared_Image.H>
+#include <FL/Fl_Trace.H>
 #include "flstring.h"
 #include "drivers/GDI/Fl_Font.H"
 #include <stdio.h>
@@ -363,7 +364,9 @@ static void process_awake_handler_requests(void) {
   Fl_Awake_Handler func;
   void *data;
   while (Fl::get_awake_handler_(func, data) == 0) {
+    double start = Fl_Trace::enabled() ? Fl_Trace::now() : 0;
     func(data);
+    if (start) Fl_Trace::record(FL_TRACE_AWAKE, 0, start);
   }
 }
 
@@ -32,6 +32,7 @@
 #  include <FL/fl_draw.H>
 #  include <FL/Fl_Paged_Device.H>
 #  include <FL/Fl_Shared_Image.H>
+#  include <FL/Fl_Trace.H>
 #  include <FL/fl_ask.H>
 #  include <FL/filename.H>
 #  include <stdio.h>
@@ -203,15 +204,81 @@ static Fl_Window* send_motion;
 extern Fl_Window* fl_xmousewin;
 #endif
 static bool in_a_window; // true if in any of our windows, even destroyed ones
+
+static int coalesce_events = FL_X11_COALESCE_ALL;
+static int event_batch = 0;
+static Fl_X11_Event_Counts event_counts;
+
+// Merges the queued events that xevent makes obsolete into it, and returns
+// how many. Only consecutive events are merged, so that clicks and key
+// presses keep the mouse position they had, and the windows get their
+// ConfigureNotify events in the order the other events need them. Motion
+// events are merged while the button and modifier state stays the same, and
+// only the last ConfigureNotify is kept, because fl_handle() asks the server
+// where the window is anyway. Expose events are not merged: the window
+// collects their rectangles in its damage region.
+static int coalesce(XEvent &xevent) {
+  int n = 0;
+  XEvent next;
+  switch (xevent.type) {
+  case MotionNotify:
+    if (!(coalesce_events & FL_X11_COALESCE_MOTION)) break;
+    while (XEventsQueued(fl_display, QueuedAlready)) {
+      XPeekEvent(fl_display, &next);
+      if (next.type != MotionNotify || next.xmotion.window != xevent.xmotion.window ||
+          next.xmotion.state != xevent.xmotion.state) break;
+      XNextEvent(fl_display, &xevent);
+      n++;
+    }
+    break;
+  case ConfigureNotify:
+    if (!(coalesce_events & FL_X11_COALESCE_CONFIGURE)) break;
+    while (XEventsQueued(fl_display, QueuedAlready)) {
+      XPeekEvent(fl_display, &next);
+      if (next.type != ConfigureNotify || next.xconfigure.window != xevent.xconfigure.window ||
+          next.xany.window != xevent.xany.window) break;
+      XNextEvent(fl_display, &xevent);
+      n++;
+    }
+    break;
+  }
+  return n;
+}
+
+// names of the X event types, for Fl_Trace
+static const char *event_names[LASTEvent] = {
+  "X event", "X event", "KeyPress", "KeyRelease", "ButtonPress",
+  "ButtonRelease", "MotionNotify", "EnterNotify", "LeaveNotify", "FocusIn",
+  "FocusOut", "KeymapNotify", "Expose", "GraphicsExpose", "NoExpose",
+  "VisibilityNotify", "CreateNotify", "DestroyNotify", "UnmapNotify",
+  "MapNotify", "MapRequest", "ReparentNotify", "ConfigureNotify",
+  "ConfigureRequest", "GravityNotify", "ResizeRequest", "CirculateNotify",
+  "CirculateRequest", "PropertyNotify", "SelectionClear", "SelectionRequest",
+  "SelectionNotify", "ColormapNotify", "ClientMessage", "MappingNotify",
+  "GenericEvent"
+};
+
 static void do_queued_events() {
   in_a_window = true;
+  int events = 0, coalesced = 0;
   while (XEventsQueued(fl_display,QueuedAfterReading)) {
+    // leave the rest to the next call, after the windows were drawn
+    if (event_batch && events >= event_batch) break;
     XEvent xevent;
     XNextEvent(fl_display, &xevent);
-    if (fl_send_system_handlers(&xevent))
-      continue;
-    fl_handle(xevent);
-  }
+    if (coalesce_events) coalesced += coalesce(xevent);
+    events++;
+    double start = Fl_Trace::enabled() ? Fl_Trace::now() : 0;
+    if (!fl_send_system_handlers(&xevent))
+      fl_handle(xevent);
+    if (start) Fl_Trace::record(FL_TRACE_EVENT, xevent.type >= 0 && xevent.type < LASTEvent ?
+                                event_names[xevent.type] : event_names[0], start);
+  }
+  event_counts.loops++;
+  event_counts.events += events;
+  event_counts.coalesced += coalesced;
+  event_counts.last_events = events;
+  event_counts.last_coalesced = coalesced;
   // we send FL_LEAVE only if the mouse did not enter some other window:
   if (!in_a_window) Fl::handle(FL_LEAVE, 0);
 #if CONSOLIDATE_MOTION
@@ -222,6 +289,40 @@ static void do_queued_events() {
 #endif
 }
 
+/**
+ Sets which X events FLTK merges before it handles them.
+ \p which is a combination of FL_X11_COALESCE_MOTION and
+ FL_X11_COALESCE_CONFIGURE, the default is FL_X11_COALESCE_ALL.
+ Handlers added with Fl::add_system_handler() only see the merged events,
+ turn this off if they need all of them.
+ */
+void fl_x11_coalesce_events(int which) {
+  coalesce_events = which;
+}
+
+/** Returns which X events FLTK merges, see fl_x11_coalesce_events(int). */
+int fl_x11_coalesce_events() {
+  return coalesce_events;
+}
+
+/**
+ Sets how many X events FLTK handles at most before it draws the windows
+ again. 0, the default, handles all queued events first.
+ */
+void fl_x11_event_batch(int max_events) {
+  event_batch = max_events;
+}
+
+/** Returns how many X events FLTK handled and merged. */
+void fl_x11_event_counts(Fl_X11_Event_Counts &counts) {
+  counts = event_counts;
+}
+
+/** Sets the counts of fl_x11_event_counts() to 0. */
+void fl_x11_reset_event_counts() {
+  memset(&event_counts, 0, sizeof(event_counts));
+}
+
 // these pointers are set by the Fl::lock() function:
 static void nothing() {}
 void (*fl_lock_function)() = nothing;
@@ -269,15 +370,20 @@ int Fl_X11_Screen_Driver::poll_or_select_with_delay(double time_to_wait) {
   if (n > 0) {
     for (int i=0; i<nfds; i++) {
 #  if USE_POLL
-      if (pollfds[i].revents) fd[i].cb(pollfds[i].fd, fd[i].arg);
+      if (!pollfds[i].revents) continue;
+      double start = Fl_Trace::enabled() ? Fl_Trace::now() : 0;
+      fd[i].cb(pollfds[i].fd, fd[i].arg);
 #  else
       int f = fd[i].fd;
       short revents = 0;
       if (FD_ISSET(f,&fdt[0])) revents |= POLLIN;
       if (FD_ISSET(f,&fdt[1])) revents |= POLLOUT;
       if (FD_ISSET(f,&fdt[2])) revents |= POLLERR;
-      if (fd[i].events & revents) fd[i].cb(f, fd[i].arg);
+      if (!(fd[i].events & revents)) continue;
+      double start = Fl_Trace::enabled() ? Fl_Trace::now() : 0;
+      fd[i].cb(f, fd[i].arg);
 #  endif
+      if (start) Fl_Trace::record(FL_TRACE_FD, 0, start);
     }
   }
   return n;
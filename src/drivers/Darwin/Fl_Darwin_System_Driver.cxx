@@ -129,7 +129,7 @@ int Fl_Darwin_System_Driver::filename_list(const char *d, dirent ***list, int (*
     if (de->d_name[len-1]!='/' && len<=FL_PATH_MAX) {
       // Use memcpy for speed since we already know the length of the string...
       memcpy(name, de->d_name, len+1);
-      if (fl_filename_isdir(fullname)) {
+      if (dirent_isdir(de, fullname)) {
         char *dst = newde->d_name + newlen;
         *dst++ = '/';
         *dst = 0;
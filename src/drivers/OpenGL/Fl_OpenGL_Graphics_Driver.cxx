@@ -21,6 +21,211 @@
 
 #include <FL/gl.h>
 #include "Fl_OpenGL_Graphics_Driver.H"
+#include <FL/math.h>
+#include <stdlib.h>
+
+// the vertex array is drawn when it holds that many vertices
+static const int max_vertices = 3 * 16384;
+
+// texture coordinates of an opaque texel, see glyph_texture()
+static const float white_u = 1.0f / 1024, white_v = 1.0f / 1024;
+static const float texture_scale = 1.0f / 1024;
+
+
+Fl_OpenGL_Graphics_Driver::Fl_OpenGL_Graphics_Driver() {
+  vertices_ = 0;
+  nvertices_ = vertices_size_ = 0;
+  rgba_[0] = rgba_[1] = rgba_[2] = 0; rgba_[3] = 255;
+  clip_[0][2] = -1;
+  line_width_ = 1;
+  dashes_[0] = 0;
+  path_ = 0;
+  path_size_ = 0;
+  glyphs_ = 0;
+  texture_ = 0;
+}
+
+/**
+ Draws all triangles collected since the last call.
+ The OpenGL state that this changes is restored before returning. FLTK calls
+ this at the end of Fl_Gl_Window::draw(), code that draws with the driver
+ and then changes the projection must call it before.
+ */
+void Fl_OpenGL_Graphics_Driver::flush() {
+  if (!nvertices_) return;
+  glPushAttrib(GL_ENABLE_BIT | GL_TEXTURE_BIT | GL_COLOR_BUFFER_BIT);
+  glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+  glDisable(GL_DEPTH_TEST);
+  glDisable(GL_LIGHTING);
+  glDisable(GL_CULL_FACE);
+  glEnable(GL_BLEND);
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  glEnable(GL_TEXTURE_2D);
+  glBindTexture(GL_TEXTURE_2D, glyph_texture());
+  glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+  glEnableClientState(GL_VERTEX_ARRAY);
+  glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+  glEnableClientState(GL_COLOR_ARRAY);
+  glDisableClientState(GL_NORMAL_ARRAY);
+  glVertexPointer(2, GL_FLOAT, sizeof(Vertex), &vertices_->x);
+  glTexCoordPointer(2, GL_FLOAT, sizeof(Vertex), &vertices_->u);
+  glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(Vertex), &vertices_->r);
+  glDrawArrays(GL_TRIANGLES, 0, nvertices_);
+  glPopClientAttrib();
+  glPopAttrib();
+  nvertices_ = 0;
+}
+
+// returns room for n more vertices in the array
+Fl_OpenGL_Graphics_Driver::Vertex *Fl_OpenGL_Graphics_Driver::add_vertices(int n) {
+  if (nvertices_ + n > vertices_size_) {
+    if (nvertices_ + n > max_vertices) flush();
+    if (n > vertices_size_) {
+      vertices_size_ = n > max_vertices ? n : max_vertices;
+      vertices_ = (Vertex*)realloc(vertices_, vertices_size_ * sizeof(Vertex));
+    }
+  }
+  Vertex *v = vertices_ + nvertices_;
+  nvertices_ += n;
+  return v;
+}
+
+inline void Fl_OpenGL_Graphics_Driver::Vertex::set(float X, float Y, float U, float V, const uchar *rgba) {
+  x = X; y = Y; u = U; v = V;
+  r = rgba[0]; g = rgba[1]; b = rgba[2]; a = rgba[3];
+}
+
+// Fills the rectangle between x and r, y and b, clipped. The pixel at
+// (0, 0) lies between -0.5 and 0.5 in both directions.
+void Fl_OpenGL_Graphics_Driver::add_rect(float x, float y, float r, float b) {
+  const int *c = clip_[rstackptr];
+  if (c[2] >= 0) {
+    if (x < c[0] - 0.5f) x = c[0] - 0.5f;
+    if (y < c[1] - 0.5f) y = c[1] - 0.5f;
+    if (r > c[0] + c[2] - 0.5f) r = c[0] + c[2] - 0.5f;
+    if (b > c[1] + c[3] - 0.5f) b = c[1] + c[3] - 0.5f;
+  }
+  if (r <= x || b <= y) return;
+  Vertex *v = add_vertices(6);
+  v->set(x, y, white_u, white_v, rgba_);
+  v[1].set(r, y, white_u, white_v, rgba_);
+  v[2].set(r, b, white_u, white_v, rgba_);
+  v[3] = v[0];
+  v[4] = v[2];
+  v[5].set(x, b, white_u, white_v, rgba_);
+}
+
+// Draws the rectangle between x and r, y and b with the glyph texture,
+// starting at texel (u, v).
+void Fl_OpenGL_Graphics_Driver::add_glyph(float x, float y, float r, float b, float u, float v) {
+  const int *c = clip_[rstackptr];
+  float u1 = u + (r - x), v1 = v + (b - y);
+  if (c[2] >= 0) {
+    float d;
+    if ((d = c[0] - 0.5f - x) > 0) { x += d; u += d; }
+    if ((d = c[1] - 0.5f - y) > 0) { y += d; v += d; }
+    if ((d = r - (c[0] + c[2] - 0.5f)) > 0) { r -= d; u1 -= d; }
+    if ((d = b - (c[1] + c[3] - 0.5f)) > 0) { b -= d; v1 -= d; }
+  }
+  if (r <= x || b <= y) return;
+  u *= texture_scale; v *= texture_scale; u1 *= texture_scale; v1 *= texture_scale;
+  Vertex *t = add_vertices(6);
+  t->set(x, y, u, v, rgba_);
+  t[1].set(r, y, u1, v, rgba_);
+  t[2].set(r, b, u1, v1, rgba_);
+  t[3] = t[0];
+  t[4] = t[2];
+  t[5].set(x, b, u, v1, rgba_);
+}
+
+// clips the polygon xy of n vertices at one side of the clip rectangle,
+// returns the number of vertices written to out
+static int clip_polygon(const float *xy, int n, float *out, int axis, float limit, int keep_below) {
+  int k = 0;
+  for (int i = 0; i < n; i++) {
+    const float *a = xy + 2 * i, *b = xy + 2 * ((i + 1) % n);
+    int ina = keep_below ? a[axis] <= limit : a[axis] >= limit;
+    int inb = keep_below ? b[axis] <= limit : b[axis] >= limit;
+    if (ina) { out[k++] = a[0]; out[k++] = a[1]; }
+    if (ina != inb) {
+      float t = (limit - a[axis]) / (b[axis] - a[axis]);
+      out[k++] = a[0] + t * (b[0] - a[0]);
+      out[k++] = a[1] + t * (b[1] - a[1]);
+    }
+  }
+  return k / 2;
+}
+
+// Fills the convex polygon xy of n vertices, clipped.
+void Fl_OpenGL_Graphics_Driver::add_polygon(const float *xy, int n) {
+  if (n < 3) return;
+  const int *c = clip_[rstackptr];
+  float *buffer = 0;
+  if (c[2] >= 0) {
+    float x = xy[0], y = xy[1], r = x, b = y;
+    for (int i = 1; i < n; i++) {
+      if (xy[2*i] < x) x = xy[2*i]; else if (xy[2*i] > r) r = xy[2*i];
+      if (xy[2*i+1] < y) y = xy[2*i+1]; else if (xy[2*i+1] > b) b = xy[2*i+1];
+    }
+    float cx = c[0] - 0.5f, cy = c[1] - 0.5f, cr = cx + c[2], cb = cy + c[3];
+    if (r <= cx || x >= cr || b <= cy || y >= cb) return;
+    if (x < cx || y < cy || r > cr || b > cb) {
+      // each side adds at most one vertex
+      buffer = new float[4 * (n + 4)];
+      float *p = buffer, *q = buffer + 2 * (n + 4);
+      n = clip_polygon(xy, n, p, 0, cx, 0);
+      n = clip_polygon(p, n, q, 0, cr, 1);
+      n = clip_polygon(q, n, p, 1, cy, 0);
+      n = clip_polygon(p, n, q, 1, cb, 1);
+      xy = q;
+    }
+  }
+  if (n >= 3) {
+    Vertex *v = add_vertices(3 * (n - 2));
+    for (int i = 2; i < n; i++, v += 3) {
+      v->set(xy[0], xy[1], white_u, white_v, rgba_);
+      v[1].set(xy[2*i-2], xy[2*i-1], white_u, white_v, rgba_);
+      v[2].set(xy[2*i], xy[2*i+1], white_u, white_v, rgba_);
+    }
+  }
+  delete[] buffer;
+}
+
+// Draws a line through the centers of the pixels at both ends with the
+// current line width and dashes, as one or more rectangles.
+void Fl_OpenGL_Graphics_Driver::add_line(float x, float y, float x1, float y1) {
+  float dx = x1 - x, dy = y1 - y;
+  // pixels are counted along the major axis, like OpenGL line stipples do
+  float steps = fabsf(dx) > fabsf(dy) ? fabsf(dx) : fabsf(dy);
+  int pixels = (int)(steps + 0.5f) + 1;
+  float half = line_width_ * 0.5f, nx = 0, ny = 0;
+  if (steps > 0) {
+    dx /= steps; dy /= steps;
+    if (dx && dy) {
+      float len = sqrtf(dx * dx + dy * dy);
+      nx = -dy / len * half; ny = dx / len * half;
+    }
+  } else {
+    dx = 1; // a single pixel
+  }
+  int i = 0, k = 0, on = 1;
+  while (i < pixels) {
+    int run = dashes_[0] ? (uchar)dashes_[k] : pixels;
+    if (on) {
+      float t = i - 0.5f, t1 = (i + run < pixels ? i + run : pixels) - 0.5f;
+      float ax = x + dx * t, ay = y + dy * t, bx = x + dx * t1, by = y + dy * t1;
+      if (!dy) add_rect(ax < bx ? ax : bx, y - half, ax < bx ? bx : ax, y + half);
+      else if (!dx) add_rect(x - half, ay < by ? ay : by, x + half, ay < by ? by : ay);
+      else {
+        float q[8] = { ax + nx, ay + ny, bx + nx, by + ny, bx - nx, by - ny, ax - nx, ay - ny };
+        add_polygon(q, 4);
+      }
+    }
+    i += run;
+    on = !on;
+    if (dashes_[0] && !dashes_[++k]) k = 0;
+  }
+}
 
 #endif // FL_CFG_GFX_OPENGL_RECT_CXX
 
@@ -39,17 +39,20 @@ void Fl_OpenGL_Graphics_Driver::arc(int x,int y,int w,int h,double a1,double a2)
   if (w <= 0 || h <= 0) return;
   while (a2<a1) a2 += 360.0;  // TODO: write a sensible fmod angle alignment here
   a1 = a1/180.0f*M_PI; a2 = a2/180.0f*M_PI;
+  // the outline goes through the centers of the pixels at the border
   double cx = x + 0.5f*w - 0.5f, cy = y + 0.5f*h - 0.5f;
+  double rx = 0.5f*(w-1), ry = 0.5f*(h-1);
   double rMax; if (w<h) rMax = h/2; else rMax = w/2;
   int nSeg = (int)(10 * sqrt(rMax))+1;
   double incr = (a2-a1)/(double)nSeg;
 
-  glBegin(GL_LINE_STRIP);
+  float px = (float)(cx+cos(a1)*rx), py = (float)(cy-sin(a1)*ry);
   for (int i=0; i<nSeg; i++) {
-    glVertex2d(cx+cos(a1)*rMax, cy-sin(a1)*rMax);
     a1 += incr;
+    float qx = (float)(cx+cos(a1)*rx), qy = (float)(cy-sin(a1)*ry);
+    add_line(px, py, qx, qy);
+    px = qx; py = qy;
   }
-  glEnd();
 }
 
 void Fl_OpenGL_Graphics_Driver::pie(int x,int y,int w,int h,double a1,double a2) {
@@ -57,17 +60,21 @@ void Fl_OpenGL_Graphics_Driver::pie(int x,int y,int w,int h,double a1,double a2)
   while (a2<a1) a2 += 360.0;  // TODO: write a sensible fmod angle alignment here
   a1 = a1/180.0f*M_PI; a2 = a2/180.0f*M_PI;
   double cx = x + 0.5f*w - 0.5f, cy = y + 0.5f*h - 0.5f;
+  double rx = 0.5f*w, ry = 0.5f*h;
   double rMax; if (w<h) rMax = h/2; else rMax = w/2;
   int nSeg = (int)(10 * sqrt(rMax))+1;
   double incr = (a2-a1)/(double)nSeg;
 
-  glBegin(GL_TRIANGLE_FAN);
-  glVertex2d(cx, cy);
-  for (int i=0; i<nSeg+1; i++) {
-    glVertex2d(cx+cos(a1)*rMax, cy-sin(a1)*rMax);
+  // one triangle per segment, a pie wider than 180 degrees is not convex
+  float xy[6];
+  xy[0] = (float)cx; xy[1] = (float)cy;
+  xy[4] = (float)(cx+cos(a1)*rx); xy[5] = (float)(cy-sin(a1)*ry);
+  for (int i=0; i<nSeg; i++) {
     a1 += incr;
+    xy[2] = xy[4]; xy[3] = xy[5];
+    xy[4] = (float)(cx+cos(a1)*rx); xy[5] = (float)(cy-sin(a1)*ry);
+    add_polygon(xy, 3);
   }
-  glEnd();
 }
 
 #endif // FL_CFG_GFX_OPENGL_ARCI_CXX
@@ -61,15 +61,14 @@ void Fl_OpenGL_Graphics_Driver::color(Fl_Color i) {
     color((uchar)(rgb >> 24), (uchar)(rgb >> 16), (uchar)(rgb >> 8));
   } else {
     Fl_Graphics_Driver::color(i);
-    uchar red, green, blue;
-    Fl::get_color(i, red, green, blue);
-    glColor3ub(red, green, blue);
+    Fl::get_color(i, rgba_[0], rgba_[1], rgba_[2]);
   }
 }
 
 void Fl_OpenGL_Graphics_Driver::color(uchar r,uchar g,uchar b) {
   Fl_Graphics_Driver::color( fl_rgb_color(r, g, b) );
-  glColor3ub(r,g,b);
+  // stored in the vertices, see add_vertices()
+  rgba_[0] = r; rgba_[1] = g; rgba_[2] = b;
 }
 
 //
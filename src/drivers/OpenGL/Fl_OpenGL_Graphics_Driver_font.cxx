@@ -35,6 +35,11 @@
 #include <FL/Fl_RGB_Image.H>
 #include <FL/Fl.H>
 #include <FL/fl_draw.H>
+#include <FL/Fl_Image_Surface.H>
+#include <FL/fl_utf8.h>
+#include <FL/math.h>
+#include <stdlib.h>
+#include <string.h>
 
 
 // FIXME: check out FreeGlut:
@@ -172,18 +177,273 @@ FL_EXPORT int glutStrokeWidth(void *font, int character);
 
 #else
 
-// use gl_font()/gl_draw() to draw GL text
+/*
+ Text is drawn from a texture of glyphs. Each glyph is rendered once by the
+ graphics driver of the display, with the platform's font engine, and copied
+ into the texture. Characters are then drawn as textured rectangles in the
+ vertex array of the driver, so that a line of text costs no OpenGL call.
+ When the texture is full, it is emptied and filled again.
+ */
+
+// the texture is texture_size x texture_size texels of alpha values
+static const int texture_size = 1024;
+
+class Fl_OpenGL_Glyph_Cache {
+public:
+  struct Glyph {
+    unsigned c;
+    Fl_Font font;
+    Fl_Fontsize size; // 0 in unused slots
+    float advance; // from this character to the next
+    short x, y, w, h; // the bitmap, relative to the pen position on the baseline
+    short u, v; // top left texel
+  };
+private:
+  Glyph *table; // open addressing, the size is a power of 2
+  int table_size, count;
+  struct Shelf { short y, h, x; } shelves[texture_size / 4];
+  int nshelves, top; // top: first unused texture row
+  static unsigned hash(Fl_Font f, Fl_Fontsize s, unsigned c) {
+    return (c * 2654435761U) ^ ((unsigned)f * 40503U) ^ ((unsigned)s << 16);
+  }
+public:
+  Fl_OpenGL_Glyph_Cache() : table(0), table_size(0) { clear(); }
+  ~Fl_OpenGL_Glyph_Cache() { delete[] table; }
+  Glyph *find(Fl_Font f, Fl_Fontsize s, unsigned c) {
+    if (!count) return 0;
+    for (unsigned i = hash(f, s, c) & (table_size - 1); ; i = (i + 1) & (table_size - 1)) {
+      Glyph *g = table + i;
+      if (!g->size) return 0;
+      if (g->c == c && g->size == s && g->font == f) return g;
+    }
+  }
+  // inserts a glyph that was not found
+  Glyph *add(Fl_Font f, Fl_Fontsize s, unsigned c) {
+    if (2 * (count + 1) > table_size) {
+      Glyph *old = table;
+      int old_size = table_size;
+      table_size = table_size ? 2 * table_size : 256;
+      table = new Glyph[table_size];
+      for (int i = 0; i < table_size; i++) table[i].size = 0;
+      count = 0;
+      for (int i = 0; i < old_size; i++) {
+        if (old[i].size) *add(old[i].font, old[i].size, old[i].c) = old[i];
+      }
+      delete[] old;
+    }
+    unsigned i = hash(f, s, c) & (table_size - 1);
+    while (table[i].size) i = (i + 1) & (table_size - 1);
+    Glyph *g = table + i;
+    g->c = c; g->font = f; g->size = s;
+    count++;
+    return g;
+  }
+  // reserves w x h texels, returns 0 if the texture is full
+  int place(int w, int h, short &u, short &v) {
+    w++; h++; // keep a row and a column free between glyphs
+    Shelf *best = 0;
+    for (int i = 0; i < nshelves; i++) {
+      Shelf *s = shelves + i;
+      if (s->h >= h && s->h <= h + h / 4 + 1 && s->x + w <= texture_size) { best = s; break; }
+    }
+    if (!best && top + h <= texture_size && nshelves < (int)(sizeof(shelves) / sizeof(shelves[0]))) {
+      best = shelves + nshelves++;
+      best->y = (short)top; best->h = (short)h; best->x = 0;
+      top += h;
+    }
+    if (!best) { // any shelf that is high enough
+      for (int i = 0; i < nshelves && !best; i++) {
+        if (shelves[i].h >= h && shelves[i].x + w <= texture_size) best = shelves + i;
+      }
+      if (!best) return 0;
+    }
+    u = best->x; v = best->y;
+    best->x += w;
+    return 1;
+  }
+  void clear() {
+    delete[] table;
+    table = 0;
+    table_size = count = 0;
+    nshelves = top = 0;
+    short u, v;
+    place(2, 2, u, v); // the opaque texels at (0, 0)
+  }
+};
+
+Fl_OpenGL_Graphics_Driver::~Fl_OpenGL_Graphics_Driver() {
+  free(vertices_);
+  free(path_);
+  delete glyphs_;
+}
+
+// Returns the glyph texture, after creating it if needed. All OpenGL contexts
+// of FLTK share their textures, a new texture is needed when all contexts
+// were deleted.
+unsigned Fl_OpenGL_Graphics_Driver::glyph_texture() {
+  if (texture_ && glIsTexture(texture_)) return texture_;
+  if (glyphs_) glyphs_->clear();
+  GLuint texture;
+  glGenTextures(1, &texture);
+  glPushAttrib(GL_TEXTURE_BIT);
+  glPushClientAttrib(GL_CLIENT_PIXEL_STORE_BIT);
+  glBindTexture(GL_TEXTURE_2D, texture);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+  glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+  glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+  uchar *zero = (uchar*)calloc(texture_size, texture_size);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, texture_size, texture_size, 0, GL_ALPHA, GL_UNSIGNED_BYTE, zero);
+  free(zero);
+  static const uchar opaque[4] = {255, 255, 255, 255};
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 2, 2, GL_ALPHA, GL_UNSIGNED_BYTE, opaque);
+  glPopClientAttrib();
+  glPopAttrib();
+  texture_ = texture;
+  return texture_;
+}
+
+/**
+ Renders characters in white on black, for the glyph texture.
+ Draws the characters \p c[i] in the current font with their pen positions
+ at (\p x[i], \p y) in a \p w x \p h image, and stores the brightness of
+ each pixel in \p alpha. This implementation draws with the display's
+ graphics driver into an Fl_Image_Surface.
+ */
+void Fl_OpenGL_Graphics_Driver::render_glyphs(int n, const unsigned *c, const int *x, int y, int w, int h, uchar *alpha) {
+  Fl_Image_Surface *surface = new Fl_Image_Surface(w, h);
+  Fl_Surface_Device::push_current(surface);
+  fl_color(FL_BLACK);
+  fl_rectf(0, 0, w, h);
+  fl_color(FL_WHITE);
+  fl_font(font_, size_);
+  char buf[4];
+  for (int i = 0; i < n; i++) fl_draw(buf, fl_utf8encode(c[i], buf), x[i], y);
+  Fl_RGB_Image *image = surface->image();
+  Fl_Surface_Device::pop_current();
+  delete surface;
+  int d = image->d(), ld = image->ld() ? image->ld() : image->w() * d;
+  const uchar *data = (const uchar*)image->data()[0];
+  memset(alpha, 0, w * h);
+  for (int j = 0; j < h && j < image->h(); j++) {
+    const uchar *p = data + j * ld;
+    for (int i = 0; i < w && i < image->w(); i++, p += d) alpha[j * w + i] = *p;
+  }
+  delete image;
+}
+
+// renders the characters of str that are not in the glyph texture yet
+void Fl_OpenGL_Graphics_Driver::cache_glyphs(const char *str, int n) {
+  const int max_glyphs = 64;
+  unsigned c[max_glyphs];
+  int x[max_glyphs];
+  float advance[max_glyphs];
+  const char *end = str + n;
+  while (str < end) {
+    int k = 0, len;
+    while (str < end && k < max_glyphs) {
+      unsigned u = fl_utf8decode(str, end, &len);
+      str += len;
+      if (glyphs_->find(font_, size_, u)) continue;
+      int i = 0;
+      while (i < k && c[i] != u) i++;
+      if (i == k) c[k++] = u;
+    }
+    if (!k) return;
+
+    // one cell per character, with room for parts outside of the advance
+    Fl_Surface_Device::push_current(Fl_Display_Device::display_device());
+    fl_font(font_, size_);
+    int height = fl_height(), descent = fl_descent(), pad = size_ / 4 + 2, w = 0;
+    for (int i = 0; i < k; i++) {
+      advance[i] = (float)fl_width(c[i]);
+      x[i] = w + pad;
+      w += (int)ceilf(advance[i]) + 2 * pad;
+    }
+    Fl_Surface_Device::pop_current();
+    int h = height + 2 * pad, baseline = pad + height - descent;
+    uchar *alpha = new uchar[w * h];
+    render_glyphs(k, c, x, baseline, w, h, alpha);
+
+    glPushAttrib(GL_TEXTURE_BIT);
+    glPushClientAttrib(GL_CLIENT_PIXEL_STORE_BIT);
+    glBindTexture(GL_TEXTURE_2D, glyph_texture());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, w);
+    for (int i = 0; i < k; i++) {
+      // the smallest box around the pixels of the glyph
+      int l = x[i] - pad, r = x[i] + (int)ceilf(advance[i]) + pad, t = h, b = 0, left = r, right = l;
+      for (int j = 0; j < h; j++) {
+        const uchar *p = alpha + j * w;
+        for (int q = l; q < r; q++) {
+          if (!p[q]) continue;
+          if (j < t) t = j;
+          b = j + 1;
+          if (q < left) left = q;
+          if (q >= right) right = q + 1;
+        }
+      }
+      if (b <= t) left = right = t = b = 0;
+      Fl_OpenGL_Glyph_Cache::Glyph g;
+      g.advance = advance[i];
+      g.x = (short)(left - x[i]); g.y = (short)(t - baseline);
+      g.w = (short)(right - left); g.h = (short)(b - t);
+      g.u = g.v = 0;
+      if (g.w && !glyphs_->place(g.w, g.h, g.u, g.v)) {
+        // the texture is full: draw what uses it and start again
+        flush();
+        glyphs_->clear();
+        if (!glyphs_->place(g.w, g.h, g.u, g.v)) g.w = g.h = 0;
+      }
+      if (g.w) {
+        glPixelStorei(GL_UNPACK_SKIP_PIXELS, left);
+        glPixelStorei(GL_UNPACK_SKIP_ROWS, t);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, g.u, g.v, g.w, g.h, GL_ALPHA, GL_UNSIGNED_BYTE, alpha);
+      }
+      Fl_OpenGL_Glyph_Cache::Glyph *cached = glyphs_->add(font_, size_, c[i]);
+      g.c = cached->c; g.font = cached->font; g.size = cached->size;
+      *cached = g;
+    }
+    glPopClientAttrib();
+    glPopAttrib();
+    delete[] alpha;
+  }
+}
 
 void Fl_OpenGL_Graphics_Driver::font(Fl_Font face, Fl_Fontsize fsize) {
+  Fl_Graphics_Driver::font(face, fsize);
+  // text is measured by the display's driver
   Fl_Surface_Device::push_current(Fl_Display_Device::display_device());
-  gl_font(face, fsize);
+  fl_font(face, fsize);
   Fl_Surface_Device::pop_current();
 }
 
 void Fl_OpenGL_Graphics_Driver::draw(const char* str, int n, int x, int y) {
-  Fl_Surface_Device::push_current(Fl_Display_Device::display_device());
-  gl_draw(str, n, x, y);
-  Fl_Surface_Device::pop_current();
+  if (n <= 0 || size_ <= 0) return;
+  glyph_texture(); // before the glyphs are looked up, in case it was lost
+  if (!glyphs_) glyphs_ = new Fl_OpenGL_Glyph_Cache;
+  cache_glyphs(str, n);
+  const char *end = str + n;
+  double pen = x;
+  while (str < end) {
+    int len;
+    unsigned c = fl_utf8decode(str, end, &len);
+    Fl_OpenGL_Glyph_Cache::Glyph *g = glyphs_->find(font_, size_, c);
+    if (!g) { // removed from a full texture by the other characters
+      cache_glyphs(str, len);
+      g = glyphs_->find(font_, size_, c);
+    }
+    str += len;
+    if (g->w) {
+      float gx = floorf((float)pen + 0.5f) + g->x - 0.5f, gy = y + g->y - 0.5f;
+      add_glyph(gx, gy, gx + g->w, gy + g->h, g->u, g->v);
+    }
+    pen += g->advance;
+  }
 }
 
 double Fl_OpenGL_Graphics_Driver::width(const char *str, int n) {
@@ -193,6 +453,13 @@ double Fl_OpenGL_Graphics_Driver::width(const char *str, int n) {
   return w;
 }
 
+double Fl_OpenGL_Graphics_Driver::width(unsigned int c) {
+  Fl_Surface_Device::push_current(Fl_Display_Device::display_device());
+  double w = fl_width(c);
+  Fl_Surface_Device::pop_current();
+  return w;
+}
+
 int Fl_OpenGL_Graphics_Driver::descent() {
   Fl_Surface_Device::push_current(Fl_Display_Device::display_device());
   int d = fl_descent();
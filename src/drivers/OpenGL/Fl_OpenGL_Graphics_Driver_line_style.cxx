@@ -36,30 +36,29 @@
 // OpenGL implementation does not support custom patterns
 // OpenGL implementation does not support cap and join types
 
+// lengths of dashes and gaps, in line widths, as the 16 bit OpenGL line
+// stipple patterns that this driver used before
+static const char *dash_patterns[] = {
+  "",             // FL_SOLID
+  "\4\4",         // FL_DASH        ....****....****
+  "\1\1",         // FL_DOT         .*.*.*.*.*.*.*.*
+  "\3\2\1\2",     // FL_DASHDOT     ..*..***..*..***
+  "\3\1\1\1\1\1"  // FL_DASHDOTDOT  .*.*.***.*.*.***
+};
+
 void Fl_OpenGL_Graphics_Driver::line_style(int style, int width, char* dashes) {
 
   if (width<1) width = 1;
+  line_width_ = width;
 
-  if (style==FL_SOLID) {
-    glLineStipple(1, 0xFFFF);
-    glDisable(GL_LINE_STIPPLE);
-  } else {
-    switch (style) {
-      case FL_DASH:
-        glLineStipple(width, 0x0F0F); // ....****....****
-        break;
-      case FL_DOT:
-        glLineStipple(width, 0x5555); // .*.*.*.*.*.*.*.*
-        break;
-      case FL_DASHDOT:
-        glLineStipple(width, 0x2727); // ..*..***..*..***
-        break;
-      case FL_DASHDOTDOT:
-        glLineStipple(width, 0x5757); // .*.*.***.*.*.***
-        break;
-    }
-    glEnable(GL_LINE_STIPPLE);
+  int i = 0;
+  if (dashes && *dashes) {
+    for (; dashes[i] && i < (int)sizeof(dashes_) - 1; i++) dashes_[i] = dashes[i];
+  } else if ((style & 0xff) > FL_SOLID && (style & 0xff) <= FL_DASHDOTDOT) {
+    const char *d = dash_patterns[style & 0xff];
+    for (; d[i]; i++) dashes_[i] = (char)(d[i] * width < 255 ? d[i] * width : 255);
   }
+  dashes_[i] = 0;
 }
 
 #endif // FL_CFG_GFX_OPENGL_LINE_STYLE_CXX
@@ -36,163 +36,147 @@
 // --- line and polygon drawing with integer coordinates
 
 void Fl_OpenGL_Graphics_Driver::point(int x, int y) {
-  glBegin(GL_POINTS);
-  glVertex2i(x, y);
-  glEnd();
+  add_rect(x-0.5f, y-0.5f, x+0.5f, y+0.5f);
 }
 
 void Fl_OpenGL_Graphics_Driver::rect(int x, int y, int w, int h) {
-  glBegin(GL_LINE_LOOP);
-  glVertex2i(x, y);
-  glVertex2i(x+w, y);
-  glVertex2i(x+w, y+h);
-  glVertex2i(x, y+h);
-  glEnd();
+  if (w<=0 || h<=0) return;
+  if (line_width_ > 1 || dashes_[0]) {
+    loop(x, y, x+w-1, y, x+w-1, y+h-1, x, y+h-1);
+    return;
+  }
+  if (w<3 || h<3) { // no inside
+    add_rect(x-0.5f, y-0.5f, x+w-0.5f, y+h-0.5f);
+    return;
+  }
+  add_rect(x-0.5f, y-0.5f, x+w-0.5f, y+0.5f);
+  add_rect(x-0.5f, y+h-1.5f, x+w-0.5f, y+h-0.5f);
+  add_rect(x-0.5f, y+0.5f, x+0.5f, y+h-1.5f);
+  add_rect(x+w-1.5f, y+0.5f, x+w-0.5f, y+h-1.5f);
 }
 
 void Fl_OpenGL_Graphics_Driver::rectf(int x, int y, int w, int h) {
   if (w<=0 || h<=0) return;
-  // OpenGL has the natural origin at the bottom left. Drawing in FLTK
-  // coordinates requires that we shift the rectangle one pixel up.
-  glBegin(GL_POLYGON);
-  glVertex2i(x, y-1);
-  glVertex2i(x+w, y-1);
-  glVertex2i(x+w, y+h-1);
-  glVertex2i(x, y+h-1);
-  glEnd();
+  add_rect(x-0.5f, y-0.5f, x+w-0.5f, y+h-0.5f);
 }
 
 void Fl_OpenGL_Graphics_Driver::line(int x, int y, int x1, int y1) {
-  glBegin(GL_LINE_STRIP);
-  glVertex2i(x, y);
-  glVertex2i(x1, y1);
-  glEnd();
-  point(x1, y1);
+  add_line(x, y, x1, y1);
 }
 
 void Fl_OpenGL_Graphics_Driver::line(int x, int y, int x1, int y1, int x2, int y2) {
-  glBegin(GL_LINE_STRIP);
-  glVertex2i(x, y);
-  glVertex2i(x1, y1);
-  glVertex2i(x2, y2);
-  glEnd();
-  point(x2, y2);
+  add_line(x, y, x1, y1);
+  add_line(x1, y1, x2, y2);
 }
 
 void Fl_OpenGL_Graphics_Driver::xyline(int x, int y, int x1) {
-  glBegin(GL_LINE_STRIP);
-  glVertex2i(x, y);
-  glVertex2i(x1, y);
-  glEnd();
-  point(x1, y);
+  add_line(x, y, x1, y);
 }
 
 void Fl_OpenGL_Graphics_Driver::xyline(int x, int y, int x1, int y2) {
-  glBegin(GL_LINE_STRIP);
-  glVertex2i(x, y);
-  glVertex2i(x1, y);
-  glVertex2i(x1, y2);
-  glEnd();
-  point(x1, y2);
+  add_line(x, y, x1, y);
+  add_line(x1, y, x1, y2);
 }
 
 void Fl_OpenGL_Graphics_Driver::xyline(int x, int y, int x1, int y2, int x3) {
-  glBegin(GL_LINE_STRIP);
-  glVertex2i(x, y);
-  glVertex2i(x1, y);
-  glVertex2i(x1, y2);
-  glVertex2i(x3, y2);
-  glEnd();
-  point(x3, y2);
+  add_line(x, y, x1, y);
+  add_line(x1, y, x1, y2);
+  add_line(x1, y2, x3, y2);
 }
 
 void Fl_OpenGL_Graphics_Driver::yxline(int x, int y, int y1) {
-  glBegin(GL_LINE_STRIP);
-  glVertex2i(x, y);
-  glVertex2i(x, y1);
-  glEnd();
-  point(x, y1);
+  add_line(x, y, x, y1);
 }
 
 void Fl_OpenGL_Graphics_Driver::yxline(int x, int y, int y1, int x2) {
-  glBegin(GL_LINE_STRIP);
-  glVertex2i(x, y);
-  glVertex2i(x, y1);
-  glVertex2i(x2, y1);
-  glEnd();
-  point(x2, y1);
+  add_line(x, y, x, y1);
+  add_line(x, y1, x2, y1);
 }
 
 void Fl_OpenGL_Graphics_Driver::yxline(int x, int y, int y1, int x2, int y3) {
-  glBegin(GL_LINE_STRIP);
-  glVertex2i(x, y);
-  glVertex2i(x, y1);
-  glVertex2i(x2, y1);
-  glVertex2i(x2, y3);
-  glEnd();
-  point(x2, y3);
+  add_line(x, y, x, y1);
+  add_line(x, y1, x2, y1);
+  add_line(x2, y1, x2, y3);
 }
 
 void Fl_OpenGL_Graphics_Driver::loop(int x0, int y0, int x1, int y1, int x2, int y2) {
-  glBegin(GL_LINE_LOOP);
-  glVertex2i(x0, y0);
-  glVertex2i(x1, y1);
-  glVertex2i(x2, y2);
-  glEnd();
+  add_line(x0, y0, x1, y1);
+  add_line(x1, y1, x2, y2);
+  add_line(x2, y2, x0, y0);
 }
 
 void Fl_OpenGL_Graphics_Driver::loop(int x0, int y0, int x1, int y1, int x2, int y2, int x3, int y3) {
-  glBegin(GL_LINE_LOOP);
-  glVertex2i(x0, y0);
-  glVertex2i(x1, y1);
-  glVertex2i(x2, y2);
-  glVertex2i(x3, y3);
-  glEnd();
+  add_line(x0, y0, x1, y1);
+  add_line(x1, y1, x2, y2);
+  add_line(x2, y2, x3, y3);
+  add_line(x3, y3, x0, y0);
 }
 
 void Fl_OpenGL_Graphics_Driver::polygon(int x0, int y0, int x1, int y1, int x2, int y2) {
-  glBegin(GL_POLYGON);
-  glVertex2i(x0, y0);
-  glVertex2i(x1, y1);
-  glVertex2i(x2, y2);
-  glEnd();
+  float xy[6] = { (float)x0, (float)y0, (float)x1, (float)y1, (float)x2, (float)y2 };
+  add_polygon(xy, 3);
 }
 
 void Fl_OpenGL_Graphics_Driver::polygon(int x0, int y0, int x1, int y1, int x2, int y2, int x3, int y3) {
-  glBegin(GL_POLYGON);
-  glVertex2i(x0, y0);
-  glVertex2i(x1, y1);
-  glVertex2i(x2, y2);
-  glVertex2i(x3, y3);
-  glEnd();
+  float xy[8] = { (float)x0, (float)y0, (float)x1, (float)y1, (float)x2, (float)y2, (float)x3, (float)y3 };
+  add_polygon(xy, 4);
 }
 
+// Clipping is done while the triangles are collected, so that changing the
+// clip rectangle does not interrupt the vertex array.
+
 void Fl_OpenGL_Graphics_Driver::push_clip(int x, int y, int w, int h) {
-  // TODO: implement OpenGL clipping
-  if (rstackptr < region_stack_max) rstack[++rstackptr] = 0L;
+  if (rstackptr < region_stack_max) {
+    int *c = clip_[++rstackptr];
+    if (w < 0) w = 0;
+    if (h < 0) h = 0;
+    const int *p = clip_[rstackptr-1];
+    if (p[2] >= 0) { // intersect with the current clip rectangle
+      int r = x+w, b = y+h;
+      if (x < p[0]) x = p[0];
+      if (y < p[1]) y = p[1];
+      if (r > p[0]+p[2]) r = p[0]+p[2];
+      if (b > p[1]+p[3]) b = p[1]+p[3];
+      w = r > x ? r-x : 0;
+      h = b > y ? b-y : 0;
+    }
+    c[0] = x; c[1] = y; c[2] = w; c[3] = h;
+    rstack[rstackptr] = 0L;
+  }
   else Fl::warning("Fl_OpenGL_Graphics_Driver::push_clip: clip stack overflow!\n");
+  restore_clip();
 }
 
 int Fl_OpenGL_Graphics_Driver::clip_box(int x, int y, int w, int h, int &X, int &Y, int &W, int &H) {
-  // TODO: implement OpenGL clipping
   X = x; Y = y; W = w, H = h;
-  return 0;
+  const int *c = clip_[rstackptr];
+  if (c[2] < 0) return 0;
+  int r = x+w, b = y+h;
+  if (X < c[0]) X = c[0];
+  if (Y < c[1]) Y = c[1];
+  if (r > c[0]+c[2]) r = c[0]+c[2];
+  if (b > c[1]+c[3]) b = c[1]+c[3];
+  W = r > X ? r-X : 0;
+  H = b > Y ? b-Y : 0;
+  return X != x || Y != y || W != w || H != h;
 }
 
 int Fl_OpenGL_Graphics_Driver::not_clipped(int x, int y, int w, int h) {
-  // TODO: implement OpenGL clipping
-  return 1;
+  const int *c = clip_[rstackptr];
+  if (c[2] < 0) return 1;
+  return x < c[0]+c[2] && y < c[1]+c[3] && x+w > c[0] && y+h > c[1];
 }
 
 void Fl_OpenGL_Graphics_Driver::push_no_clip() {
-  // TODO: implement OpenGL clipping
-  if (rstackptr < region_stack_max) rstack[++rstackptr] = 0;
+  if (rstackptr < region_stack_max) {
+    rstack[++rstackptr] = 0;
+    clip_[rstackptr][2] = -1;
+  }
   else Fl::warning("Fl_OpenGL_Graphics_Driver::push_no_clip: clip stack overflow!\n");
   restore_clip();
 }
 
 void Fl_OpenGL_Graphics_Driver::pop_clip() {
-  // TODO: implement OpenGL clipping
   if (rstackptr > 0) {
     rstackptr--;
   } else Fl::warning("Fl_OpenGL_Graphics_Driver::pop_clip: clip stack underflow!\n");
@@ -200,7 +184,6 @@ void Fl_OpenGL_Graphics_Driver::pop_clip() {
 }
 
 void Fl_OpenGL_Graphics_Driver::restore_clip() {
-  // TODO: implement OpenGL clipping
   fl_clip_state_number++;
 }
 
@@ -30,6 +30,7 @@
 #include <FL/fl_draw.H>
 #include <FL/gl.h>
 #include <FL/math.h>
+#include <stdlib.h>
 
 
 // Event though there are faster versions of the functions in OpenGL,
@@ -45,90 +46,165 @@
 // double Fl_OpenGL_Graphics_Driver::transform_dx(double x, double y)
 // double Fl_OpenGL_Graphics_Driver::transform_dy(double x, double y)
 
+// The vertices of a path are collected in path_ and turned into triangles
+// when the path ends.
+
 void Fl_OpenGL_Graphics_Driver::begin_points() {
-  glBegin(GL_POINTS);
+  Fl_Graphics_Driver::begin_points();
 }
 
 void Fl_OpenGL_Graphics_Driver::end_points() {
-  glEnd();
+  for (int i = 0; i < n; i++) {
+    float x = floorf(path_[2*i] + 0.5f), y = floorf(path_[2*i+1] + 0.5f);
+    add_rect(x-0.5f, y-0.5f, x+0.5f, y+0.5f);
+  }
 }
 
 void Fl_OpenGL_Graphics_Driver::begin_line() {
-  glBegin(GL_LINE_STRIP);
+  Fl_Graphics_Driver::begin_line();
 }
 
 void Fl_OpenGL_Graphics_Driver::end_line() {
-  glEnd();
+  if (n < 2) {
+    end_points();
+    return;
+  }
+  draw_path_lines(0);
 }
 
 void Fl_OpenGL_Graphics_Driver::begin_loop() {
-  glBegin(GL_LINE_LOOP);
+  Fl_Graphics_Driver::begin_loop();
 }
 
 void Fl_OpenGL_Graphics_Driver::end_loop() {
-  glEnd();
+  fixloop();
+  if (n < 2) {
+    end_points();
+    return;
+  }
+  draw_path_lines(n > 2);
 }
 
 void Fl_OpenGL_Graphics_Driver::begin_polygon() {
-  glBegin(GL_POLYGON);
+  Fl_Graphics_Driver::begin_polygon();
 }
 
 void Fl_OpenGL_Graphics_Driver::end_polygon() {
-  glEnd();
+  fixloop();
+  if (n < 3) {
+    end_line();
+    return;
+  }
+  add_polygon(path_, n);
 }
 
 void Fl_OpenGL_Graphics_Driver::begin_complex_polygon() {
-  glBegin(GL_POLYGON);
+  begin_polygon();
+  gap_ = 0;
 }
 
 void Fl_OpenGL_Graphics_Driver::gap() {
-  glEnd();
-  glBegin(GL_POLYGON);
+  while (n>gap_+2 && path_[2*n-2] == path_[2*gap_] && path_[2*n-1] == path_[2*gap_+1]) n--;
+  if (n > gap_+2) {
+    transformed_vertex(path_[2*gap_], path_[2*gap_+1]);
+    gap_ = n;
+  } else {
+    n = gap_;
+  }
 }
 
-// FXIME: non-convex polygons are not supported yet
-// use gluTess* functions to do this; search for gluBeginPolygon
 void Fl_OpenGL_Graphics_Driver::end_complex_polygon() {
-  glEnd();
+  gap();
+  if (n < 3) {
+    end_line();
+    return;
+  }
+  fill_path();
 }
 
-// remove equal points from closed path
-void Fl_OpenGL_Graphics_Driver::fixloop() { }
+void Fl_OpenGL_Graphics_Driver::fixloop() {  // remove equal points from closed path
+  while (n>2 && path_[2*n-2] == path_[0] && path_[2*n-1] == path_[1]) n--;
+}
 
 void Fl_OpenGL_Graphics_Driver::transformed_vertex(double xf, double yf) {
-  glVertex2d(xf, yf);
+  float x = (float)xf, y = (float)yf;
+  if (n && x == path_[2*n-2] && y == path_[2*n-1]) return;
+  if (n >= path_size_) {
+    path_size_ = path_ ? 2*path_size_ : 16;
+    path_ = (float*)realloc(path_, 2*path_size_*sizeof(float));
+  }
+  path_[2*n] = x;
+  path_[2*n+1] = y;
+  n++;
 }
 
 void Fl_OpenGL_Graphics_Driver::vertex(double x,double y) {
   transformed_vertex(x*m.a + y*m.c + m.x, x*m.b + y*m.d + m.y);
 }
 
+void Fl_OpenGL_Graphics_Driver::draw_path_lines(int closed) {
+  for (int i = 1; i < n; i++)
+    add_line(path_[2*i-2], path_[2*i-1], path_[2*i], path_[2*i+1]);
+  if (closed)
+    add_line(path_[2*n-2], path_[2*n-1], path_[0], path_[1]);
+}
+
+// Fills the path with the even-odd rule, one rectangle for each horizontal
+// span of pixels whose centers are inside, as XFillPolygon() does.
+void Fl_OpenGL_Graphics_Driver::fill_path() {
+  float top = path_[1], bottom = top;
+  for (int i = 1; i < n; i++) {
+    if (path_[2*i+1] < top) top = path_[2*i+1];
+    else if (path_[2*i+1] > bottom) bottom = path_[2*i+1];
+  }
+  int y0 = (int)ceilf(top), y1 = (int)floorf(bottom);
+  const int *c = clip_[rstackptr];
+  if (c[2] >= 0) {
+    if (y0 < c[1]) y0 = c[1];
+    if (y1 > c[1]+c[3]-1) y1 = c[1]+c[3]-1;
+  }
+  float *xs = new float[n];
+  for (int y = y0; y <= y1; y++) {
+    int k = 0;
+    for (int i = 0, j = n-1; i < n; j = i++) {
+      float ax = path_[2*j], ay = path_[2*j+1], bx = path_[2*i], by = path_[2*i+1];
+      if ((ay <= y) != (by <= y)) {
+        float x = ax + (y - ay) * (bx - ax) / (by - ay);
+        int l = k++;
+        for (; l > 0 && xs[l-1] > x; l--) xs[l] = xs[l-1];
+        xs[l] = x;
+      }
+    }
+    for (int i = 0; i + 1 < k; i += 2)
+      add_rect(ceilf(xs[i]) - 0.5f, y - 0.5f, ceilf(xs[i+1]) - 0.5f, y + 0.5f);
+  }
+  delete[] xs;
+}
+
 void Fl_OpenGL_Graphics_Driver::circle(double cx, double cy, double r) {
+  double xt = transform_x(cx, cy);
+  double yt = transform_y(cx, cy);
   double rx = r * (m.c ? sqrt(m.a*m.a+m.c*m.c) : fabs(m.a));
   double ry = r * (m.b ? sqrt(m.b*m.b+m.d*m.d) : fabs(m.d));
   double rMax;
   if (ry>rx) rMax = ry; else rMax = rx;
 
-  // from http://slabode.exofire.net/circle_draw.shtml and many other places
   int num_segments = (int)(10 * sqrt(rMax))+1;
-  double theta = 2 * M_PI / float(num_segments);
-  double tangetial_factor = tan(theta);
-  double radial_factor = cosf(theta);//calculate the radial factor
-  double x = r; //we start at angle = 0
-  double y = 0;
-
-  glBegin(GL_LINE_LOOP);
-  for(int ii = 0; ii < num_segments; ii++) {
-    vertex(x + cx, y + cy); // output vertex
-    double tx = -y;
-    double ty = x;
-    x += tx * tangetial_factor;
-    y += ty * tangetial_factor;
-    x *= radial_factor;
-    y *= radial_factor;
-  } 
-  glEnd(); 
-
+  float *xy = new float[2*num_segments];
+  for (int i = 0; i < num_segments; i++) {
+    double a = 2 * M_PI * i / num_segments;
+    xy[2*i] = (float)(xt + rx * cos(a));
+    xy[2*i+1] = (float)(yt + ry * sin(a));
+  }
+  if (what == POLYGON) {
+    add_polygon(xy, num_segments);
+  } else {
+    for (int i = 0; i < num_segments; i++) {
+      int k = (i+1) % num_segments;
+      add_line(xy[2*i], xy[2*i+1], xy[2*k], xy[2*k+1]);
+    }
+  }
+  delete[] xy;
 }
 
 #endif // FL_CFG_GFX_OPENGL_VERTEX_CXX
@@ -0,0 +1,778 @@
+//
+// "$Id$"
+//
+// Software rasterizer drawing into memory for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 1998-2017 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     http://www.fltk.org/COPYING.php
+//
+// Please report all bugs and problems on the following page:
+//
+//     http://www.fltk.org/str.php
+//
+
+#include "../../config_lib.h"
+#include "Fl_Pico_Framebuffer_Graphics_Driver.H"
+#include <FL/Fl.H>
+#include <FL/fl_draw.H>
+#include <FL/Fl_Image.H>
+#include <FL/Fl_Bitmap.H>
+#include <FL/Fl_Pixmap.H>
+#include <FL/math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ Coordinates follow the X11 conventions that the rest of FLTK expects:
+ pixel (x, y) is centered on the integer point (x, y), lines include both
+ of their end points, and a filled polygon covers the pixels whose center
+ is inside it, left and top edges included, right and bottom edges excluded.
+ Anti-aliased polygons cover the same pixels if their edges are horizontal
+ or vertical on integer coordinates, see Fl_Pico_Rasterizer.
+ */
+
+
+Fl_Pico_Framebuffer_Graphics_Driver::Fl_Pico_Framebuffer_Graphics_Driver(int w, int h)
+{
+  if (w < 1) w = 1;
+  if (h < 1) h = 1;
+  width_ = w;
+  height_ = h;
+  buffer_ = (uchar*)malloc((size_t)w * h * 4);
+  memset(buffer_, 0xff, (size_t)w * h * 4); // opaque white
+  line_width_ = 1;
+  antialias_ = 1;
+  nonzero_ = 0;
+  offset_x_ = offset_y_ = depth_ = 0;
+  clip_ptr_ = 0;
+  clip_stack_[0].x = 0; clip_stack_[0].y = 0; clip_stack_[0].r = w; clip_stack_[0].b = h;
+  path_ = NULL; path_n_ = path_size_ = 0;
+  contour_ = NULL; contour_n_ = contour_size_ = 0;
+  color(FL_BLACK);
+}
+
+
+Fl_Pico_Framebuffer_Graphics_Driver::~Fl_Pico_Framebuffer_Graphics_Driver()
+{
+  free(buffer_);
+  free(path_);
+  free(contour_);
+}
+
+
+void Fl_Pico_Framebuffer_Graphics_Driver::translate_all(int dx, int dy)
+{
+  stack_x_[depth_] = offset_x_;
+  stack_y_[depth_] = offset_y_;
+  offset_x_ = stack_x_[depth_] + dx;
+  offset_y_ = stack_y_[depth_] + dy;
+  push_matrix();
+  translate(dx, dy);
+  if (depth_ < (int)(sizeof(stack_x_)/sizeof(int)) - 1) depth_++;
+  else Fl::warning("%s: translate stack overflow!", "Fl_Pico_Framebuffer_Graphics_Driver");
+}
+
+
+void Fl_Pico_Framebuffer_Graphics_Driver::untranslate_all()
+{
+  if (depth_ > 0) depth_--;
+  offset_x_ = stack_x_[depth_];
+  offset_y_ = stack_y_[depth_];
+  pop_matrix();
+}
+
+
+// --- pixel level helpers, all in framebuffer coordinates
+
+void Fl_Pico_Framebuffer_Graphics_Driver::blend_pixel_(int x, int y, int alpha)
+{
+  const clip_rect &c = clip_();
+  if (alpha <= 0 || x < c.x || x >= c.r || y < c.y || y >= c.b) return;
+  uchar *p = pixel_address_(x, y);
+  if (alpha >= 255) {
+    *(unsigned*)p = pixel_;
+  } else {
+    int ia = 255 - alpha;
+    p[0] = (uchar)((red_ * alpha + p[0] * ia + 127) / 255);
+    p[1] = (uchar)((green_ * alpha + p[1] * ia + 127) / 255);
+    p[2] = (uchar)((blue_ * alpha + p[2] * ia + 127) / 255);
+    p[3] = (uchar)(p[3] + ((255 - p[3]) * alpha + 127) / 255);
+  }
+}
+
+
+void Fl_Pico_Framebuffer_Graphics_Driver::hspan_(int x, int x1, int y)
+{
+  const clip_rect &c = clip_();
+  if (y < c.y || y >= c.b) return;
+  if (x < c.x) x = c.x;
+  if (x1 >= c.r) x1 = c.r - 1;
+  if (x > x1) return;
+  unsigned *p = (unsigned*)pixel_address_(x, y);
+  unsigned pixel = pixel_;
+  for (int n = x1 - x + 1; n > 0; n--) *p++ = pixel;
+}
+
+
+void Fl_Pico_Framebuffer_Graphics_Driver::fill_rect_(int x, int y, int w, int h)
+{
+  const clip_rect &c = clip_();
+  int x1 = x + w, y1 = y + h;
+  if (x < c.x) x = c.x;
+  if (y < c.y) y = c.y;
+  if (x1 > c.r) x1 = c.r;
+  if (y1 > c.b) y1 = c.b;
+  if (x >= x1 || y >= y1) return;
+  unsigned pixel = pixel_;
+  for (; y < y1; y++) {
+    unsigned *p = (unsigned*)pixel_address_(x, y);
+    for (int n = x1 - x; n > 0; n--) *p++ = pixel;
+  }
+}
+
+
+// Xiaolin Wu's anti-aliased line, stepping along the major axis
+void Fl_Pico_Framebuffer_Graphics_Driver::aa_segment_(double x, double y, double x1, double y1)
+{
+  double t;
+  int steep = fabs(y1 - y) > fabs(x1 - x);
+  if (steep) {
+    t = x; x = y; y = t;
+    t = x1; x1 = y1; y1 = t;
+  }
+  if (x > x1) {
+    t = x; x = x1; x1 = t;
+    t = y; y = y1; y1 = t;
+  }
+  double gradient = (x1 > x) ? (y1 - y) / (x1 - x) : 0;
+  int i = (int)floor(x + 0.5), n = (int)floor(x1 + 0.5);
+  const clip_rect &c = clip_();
+  int lo = steep ? c.y : c.x, hi = (steep ? c.b : c.r) - 1;
+  if (i < lo) i = lo;
+  if (n > hi) n = hi;
+  double v = y + gradient * (i - x);
+  for (; i <= n; i++, v += gradient) {
+    double fv = floor(v);
+    int iv = (int)fv;
+    int a = (int)((v - fv) * 255 + 0.5);
+    if (steep) {
+      blend_pixel_(iv, i, 255 - a);
+      blend_pixel_(iv + 1, i, a);
+    } else {
+      blend_pixel_(i, iv, 255 - a);
+      blend_pixel_(i, iv + 1, a);
+    }
+  }
+}
+
+
+// Draws one line segment with the current line width
+void Fl_Pico_Framebuffer_Graphics_Driver::segment_(double x, double y, double x1, double y1)
+{
+  if (line_width_ > 1) {
+    // a wide line is the filled rectangle around the segment
+    double dx = x1 - x, dy = y1 - y, len = sqrt(dx * dx + dy * dy);
+    if (len == 0) { dx = 1; dy = 0; len = 1; }
+    double nx = -dy / len * line_width_ / 2, ny = dx / len * line_width_ / 2;
+    path_point q[4] = { {x + nx, y + ny}, {x1 + nx, y1 + ny}, {x1 - nx, y1 - ny}, {x - nx, y - ny} };
+    int start = 0;
+    fill_(q, 4, &start, 1);
+    return;
+  }
+  int ix = (int)floor(x + 0.5), iy = (int)floor(y + 0.5);
+  int ix1 = (int)floor(x1 + 0.5), iy1 = (int)floor(y1 + 0.5);
+  if (iy == iy1 && y == iy && y1 == iy1) {
+    if (ix > ix1) { int t = ix; ix = ix1; ix1 = t; }
+    hspan_(ix, ix1, iy);
+    return;
+  }
+  if (ix == ix1 && x == ix && x1 == ix1) {
+    if (iy > iy1) { int t = iy; iy = iy1; iy1 = t; }
+    const clip_rect &c = clip_();
+    if (ix < c.x || ix >= c.r) return;
+    if (iy < c.y) iy = c.y;
+    if (iy1 >= c.b) iy1 = c.b - 1;
+    for (; iy <= iy1; iy++) *(unsigned*)pixel_address_(ix, iy) = pixel_;
+    return;
+  }
+  if (antialias_) {
+    aa_segment_(x, y, x1, y1);
+    return;
+  }
+  // Bresenham
+  int dx = abs(ix1 - ix), dy = abs(iy1 - iy);
+  int sx = ix < ix1 ? 1 : -1, sy = iy < iy1 ? 1 : -1;
+  int err = dx - dy;
+  for (;;) {
+    blend_pixel_(ix, iy, 255);
+    if (ix == ix1 && iy == iy1) break;
+    int e2 = 2 * err;
+    if (e2 > -dy) { err -= dy; ix += sx; }
+    if (e2 < dx) { err += dx; iy += sy; }
+  }
+}
+
+
+void Fl_Pico_Framebuffer_Graphics_Driver::stroke_(const path_point *p, int n, int closed)
+{
+  if (n == 1) {
+    segment_(p[0].x, p[0].y, p[0].x, p[0].y);
+    return;
+  }
+  for (int i = 1; i < n; i++) segment_(p[i-1].x, p[i-1].y, p[i].x, p[i].y);
+  if (closed && n > 2) segment_(p[n-1].x, p[n-1].y, p[0].x, p[0].y);
+}
+
+
+// Scanline fill of one or more closed contours. Contour i is made
+// of the points start[i] ... start[i+1]-1 (or n-1 for the last one).
+void Fl_Pico_Framebuffer_Graphics_Driver::fill_(const path_point *p, int n, const int *start, int ns)
+{
+  if (n < 3) return;
+  raster_.reset();
+  for (int s = 0; s < ns; s++) {
+    int first = start[s], last = s + 1 < ns ? start[s+1] : n;
+    if (first >= last) continue;
+    raster_.move_to(p[first].x, p[first].y);
+    for (int i = first + 1; i < last; i++) raster_.line_to(p[i].x, p[i].y);
+  }
+  const clip_rect &c = clip_();
+  raster_.render(c.x, c.y, c.r - c.x, c.b - c.y,
+                 nonzero_ ? Fl_Pico_Rasterizer::NON_ZERO : Fl_Pico_Rasterizer::EVEN_ODD,
+                 antialias_, fill_span_, this);
+}
+
+
+// Draws a span of a polygon, the rasterizer has clipped it already
+void Fl_Pico_Framebuffer_Graphics_Driver::fill_span_(void *data, int x, int y, int n, const uchar *coverage)
+{
+  Fl_Pico_Framebuffer_Graphics_Driver *d = (Fl_Pico_Framebuffer_Graphics_Driver*)data;
+  uchar *p = d->pixel_address_(x, y);
+  if (!coverage) {
+    unsigned pixel = d->pixel_;
+    for (unsigned *q = (unsigned*)p; n > 0; n--) *q++ = pixel;
+    return;
+  }
+  int r = d->red_, g = d->green_, b = d->blue_;
+  for (; n > 0; n--, p += 4) {
+    int alpha = *coverage++;
+    if (alpha == 255) { *(unsigned*)p = d->pixel_; continue; }
+    if (!alpha) continue;
+    int ia = 255 - alpha;
+    p[0] = (uchar)((r * alpha + p[0] * ia + 127) / 255);
+    p[1] = (uchar)((g * alpha + p[1] * ia + 127) / 255);
+    p[2] = (uchar)((b * alpha + p[2] * ia + 127) / 255);
+    p[3] = (uchar)(p[3] + ((255 - p[3]) * alpha + 127) / 255);
+  }
+}
+
+
+// --- paths
+
+void Fl_Pico_Framebuffer_Graphics_Driver::add_point_(double x, double y)
+{
+  if (path_n_ >= path_size_) {
+    path_size_ = path_size_ ? 2 * path_size_ : 64;
+    path_ = (path_point*)realloc(path_, path_size_ * sizeof(path_point));
+  }
+  path_[path_n_].x = x;
+  path_[path_n_].y = y;
+  path_n_++;
+}
+
+
+void Fl_Pico_Framebuffer_Graphics_Driver::add_contour_()
+{
+  if (contour_n_ > 0 && contour_[contour_n_-1] == path_n_) return; // still empty
+  if (contour_n_ >= contour_size_) {
+    contour_size_ = contour_size_ ? 2 * contour_size_ : 8;
+    contour_ = (int*)realloc(contour_, contour_size_ * sizeof(int));
+  }
+  contour_[contour_n_++] = path_n_;
+}
+
+
+void Fl_Pico_Framebuffer_Graphics_Driver::begin_points()
+{
+  what = POINT_;
+  path_n_ = contour_n_ = 0;
+  add_contour_();
+}
+
+
+void Fl_Pico_Framebuffer_Graphics_Driver::begin_line()
+{
+  what = LINE;
+  path_n_ = contour_n_ = 0;
+  add_contour_();
+}
+
+
+void Fl_Pico_Framebuffer_Graphics_Driver::begin_loop()
+{
+  what = LOOP;
+  path_n_ = contour_n_ = 0;
+  add_contour_();
+}
+
+
+void Fl_Pico_Framebuffer_Graphics_Driver::begin_polygon()
+{
+  what = POLYGON;
+  path_n_ = contour_n_ = 0;
+  add_contour_();
+}
+
+
+void Fl_Pico_Framebuffer_Graphics_Driver::begin_complex_polygon()
+{
+  what = POLYGON;
+  path_n_ = contour_n_ = 0;
+  add_contour_();
+}
+
+
+void Fl_Pico_Framebuffer_Graphics_Driver::transformed_vertex(double xf, double yf)
+{
+  if (!contour_n_) add_contour_();
+  if (path_n_ > contour_[contour_n_-1] && path_[path_n_-1].x == xf && path_[path_n_-1].y == yf)
+    return;
+  add_point_(xf, yf);
+}
+
+
+void Fl_Pico_Framebuffer_Graphics_Driver::gap()
+{
+  add_contour_();
+}
+
+
+void Fl_Pico_Framebuffer_Graphics_Driver::end_points()
+{
+  for (int i = 0; i < path_n_; i++)
+    blend_pixel_((int)floor(path_[i].x + 0.5), (int)floor(path_[i].y + 0.5), 255);
+  path_n_ = contour_n_ = 0;
+}
+
+
+void Fl_Pico_Framebuffer_Graphics_Driver::end_line()
+{
+  for (int s = 0; s < contour_n_; s++) {
+    int first = contour_[s], last = s + 1 < contour_n_ ? contour_[s+1] : path_n_;
+    if (last > first) stroke_(path_ + first, last - first, 0);
+  }
+  path_n_ = contour_n_ = 0;
+}
+
+
+void Fl_Pico_Framebuffer_Graphics_Driver::end_loop()
+{
+  for (int s = 0; s < contour_n_; s++) {
+    int first = contour_[s], last = s + 1 < contour_n_ ? contour_[s+1] : path_n_;
+    if (last > first) stroke_(path_ + first, last - first, 1);
+  }
+  path_n_ = contour_n_ = 0;
+}
+
+
+void Fl_Pico_Framebuffer_Graphics_Driver::end_polygon()
+{
+  fill_(path_, path_n_, contour_, contour_n_);
+  path_n_ = contour_n_ = 0;
+}
+
+
+void Fl_Pico_Framebuffer_Graphics_Driver::end_complex_polygon()
+{
+  fill_(path_, path_n_, contour_, contour_n_);
+  path_n_ = contour_n_ = 0;
+}
+
+
+// Appends the points of an elliptic arc to the path, angles in degrees
+// counter-clockwise from 3 o'clock, optionally preceded by the center.
+void Fl_Pico_Framebuffer_Graphics_Driver::ellipse_(double x, double y, double rx, double ry,
+                                                    double a1, double a2, int center)
+{
+  if (center) add_point_(x, y);
+  int segs = (int)(fabs(a2 - a1) * (rx + ry) / 200);  // about 2 pixels per segment
+  if (segs < 8) segs = 8;
+  double a = a1 * M_PI / 180, step = (a2 - a1) * M_PI / 180 / segs;
+  for (int i = 0; i <= segs; i++, a += step) add_point_(x + cos(a) * rx, y - sin(a) * ry);
+}
+
+
+void Fl_Pico_Framebuffer_Graphics_Driver::circle(double x, double y, double r)
+{
+  double xt = transform_x(x, y);
+  double yt = transform_y(x, y);
+  double rx = r * (m.c ? sqrt(m.a*m.a+m.c*m.c) : fabs(m.a));
+  double ry = r * (m.b ? sqrt(m.b*m.b+m.d*m.d) : fabs(m.d));
+  // the circle is drawn at once, after the vertices of the current path
+  int first = path_n_, start = 0;
+  ellipse_(xt, yt, rx, ry, 0, 360, 0);
+  if (what == POLYGON) fill_(path_ + first, path_n_ - first, &start, 1);
+  else stroke_(path_ + first, path_n_ - first, 1);
+  path_n_ = first;
+}
+
+
+void Fl_Pico_Framebuffer_Graphics_Driver::arc(int x, int y, int w, int h, double a1, double a2)
+{
+  if (w <= 0 || h <= 0) return;
+  double rx = (w - 1) / 2.0, ry = (h - 1) / 2.0;
+  int first = path_n_;
+  ellipse_(x + offset_x_ + rx, y + offset_y_ + ry, rx, ry, a1, a2, 0);
+  stroke_(path_ + first, path_n_ - first, 0);
+  path_n_ = first;
+}
+
+
+void Fl_Pico_Framebuffer_Graphics_Driver::pie(int x, int y, int w, int h, double a1, double a2)
+{
+  if (w <= 0 || h <= 0) return;
+  double rx = (w - 1) / 2.0, ry = (h - 1) / 2.0;
+  int first = path_n_, start = 0, partial = fabs(a2 - a1) < 360;
+  if (antialias_) {
+    // the anti-aliased fill covers the pixel squares of the box, like XFillArc()
+    ellipse_(x + offset_x_ + w / 2.0, y + offset_y_ + h / 2.0, w / 2.0, h / 2.0, a1, a2, partial);
+    fill_(path_ + first, path_n_ - first, &start, 1);
+    path_n_ = first;
+  }
+  ellipse_(x + offset_x_ + rx, y + offset_y_ + ry, rx, ry, a1, a2, partial);
+  if (!antialias_) fill_(path_ + first, path_n_ - first, &start, 1);
+  // like XDrawArc() + XFillArc(), the outline belongs to the pie
+  stroke_(path_ + first + partial, path_n_ - first - partial, 0);
+  path_n_ = first;
+}
+
+
+// --- primitives
+
+void Fl_Pico_Framebuffer_Graphics_Driver::point(int x, int y)
+{
+  blend_pixel_(x + offset_x_, y + offset_y_, 255);
+}
+
+
+void Fl_Pico_Framebuffer_Graphics_Driver::rectf(int x, int y, int w, int h)
+{
+  if (w <= 0 || h <= 0) return;
+  fill_rect_(x + offset_x_, y + offset_y_, w, h);
+}
+
+
+void Fl_Pico_Framebuffer_Graphics_Driver::line(int x, int y, int x1, int y1)
+{
+  segment_(x + offset_x_, y + offset_y_, x1 + offset_x_, y1 + offset_y_);
+}
+
+
+void Fl_Pico_Framebuffer_Graphics_Driver::xyline(int x, int y, int x1)
+{
+  if (x1 < x) { int t = x; x = x1; x1 = t; }
+  if (line_width_ > 1) {
+    fill_rect_(x + offset_x_, y + offset_y_ - line_width_ / 2, x1 - x + 1, line_width_);
+  } else {
+    hspan_(x + offset_x_, x1 + offset_x_, y + offset_y_);
+  }
+}
+
+
+void Fl_Pico_Framebuffer_Graphics_Driver::yxline(int x, int y, int y1)
+{
+  if (y1 < y) { int t = y; y = y1; y1 = t; }
+  int w = line_width_ > 1 ? line_width_ : 1;
+  fill_rect_(x + offset_x_ - w / 2, y + offset_y_, w, y1 - y + 1);
+}
+
+
+void Fl_Pico_Framebuffer_Graphics_Driver::polygon(int x0, int y0, int x1, int y1, int x2, int y2)
+{
+  double X = offset_x_, Y = offset_y_;
+  path_point q[3] = { {x0 + X, y0 + Y}, {x1 + X, y1 + Y}, {x2 + X, y2 + Y} };
+  int start = 0;
+  fill_(q, 3, &start, 1);
+}
+
+
+void Fl_Pico_Framebuffer_Graphics_Driver::polygon(int x0, int y0, int x1, int y1, int x2, int y2, int x3, int y3)
+{
+  double X = offset_x_, Y = offset_y_;
+  path_point q[4] = { {x0 + X, y0 + Y}, {x1 + X, y1 + Y}, {x2 + X, y2 + Y}, {x3 + X, y3 + Y} };
+  int start = 0;
+  fill_(q, 4, &start, 1);
+}
+
+
+// --- clipping, a stack of rectangles in framebuffer coordinates
+
+void Fl_Pico_Framebuffer_Graphics_Driver::push_clip(int x, int y, int w, int h)
+{
+  if (clip_ptr_ >= FL_REGION_STACK_SIZE - 1) {
+    Fl::warning("Fl_Pico_Framebuffer_Graphics_Driver::push_clip: clip stack overflow!\n");
+    return;
+  }
+  const clip_rect &c = clip_();
+  clip_rect r;
+  x += offset_x_; y += offset_y_;
+  r.x = x > c.x ? x : c.x;
+  r.y = y > c.y ? y : c.y;
+  r.r = x + w < c.r ? x + w : c.r;
+  r.b = y + h < c.b ? y + h : c.b;
+  if (w <= 0 || h <= 0 || r.r <= r.x || r.b <= r.y) r.r = r.x, r.b = r.y; // empty
+  clip_stack_[++clip_ptr_] = r;
+  restore_clip();
+}
+
+
+int Fl_Pico_Framebuffer_Graphics_Driver::clip_box(int x, int y, int w, int h, int &X, int &Y, int &W, int &H)
+{
+  X = x; Y = y; W = w; H = h;
+  const clip_rect &c = clip_();
+  x += offset_x_;
+  y += offset_y_;
+  int r = x + w, b = y + h;
+  if (r <= c.x || b <= c.y || x >= c.r || y >= c.b || c.r <= c.x) { // completely outside
+    W = H = 0;
+    return 2;
+  }
+  if (x >= c.x && y >= c.y && r <= c.r && b <= c.b) return 0; // completely inside
+  if (x < c.x) x = c.x;
+  if (y < c.y) y = c.y;
+  if (r > c.r) r = c.r;
+  if (b > c.b) b = c.b;
+  X = x - offset_x_; Y = y - offset_y_; W = r - x; H = b - y;
+  return 1;
+}
+
+
+int Fl_Pico_Framebuffer_Graphics_Driver::not_clipped(int x, int y, int w, int h)
+{
+  const clip_rect &c = clip_();
+  x += offset_x_;
+  y += offset_y_;
+  return x + w > c.x && y + h > c.y && x < c.r && y < c.b;
+}
+
+
+void Fl_Pico_Framebuffer_Graphics_Driver::push_no_clip()
+{
+  if (clip_ptr_ >= FL_REGION_STACK_SIZE - 1) {
+    Fl::warning("Fl_Pico_Framebuffer_Graphics_Driver::push_no_clip: clip stack overflow!\n");
+    return;
+  }
+  clip_rect &r = clip_stack_[++clip_ptr_];
+  r.x = 0; r.y = 0; r.r = width_; r.b = height_;
+  restore_clip();
+}
+
+
+void Fl_Pico_Framebuffer_Graphics_Driver::pop_clip()
+{
+  if (clip_ptr_ > 0) clip_ptr_--;
+  else Fl::warning("Fl_Pico_Framebuffer_Graphics_Driver::pop_clip: clip stack underflow!\n");
+  restore_clip();
+}
+
+
+// --- attributes
+
+void Fl_Pico_Framebuffer_Graphics_Driver::line_style(int style, int width, char* dashes)
+{
+  // only the line width is supported, dashes and caps are ignored
+  line_width_ = width > 1 ? width : 1;
+}
+
+
+void Fl_Pico_Framebuffer_Graphics_Driver::color(Fl_Color c)
+{
+  uchar r, g, b;
+  Fl::get_color(c, r, g, b);
+  color_ = c;
+  red_ = r; green_ = g; blue_ = b;
+  uchar *p = (uchar*)&pixel_;
+  p[0] = r; p[1] = g; p[2] = b; p[3] = 0xff;
+}
+
+
+void Fl_Pico_Framebuffer_Graphics_Driver::color(uchar r, uchar g, uchar b)
+{
+  color(fl_rgb_color(r, g, b));
+}
+
+
+// --- images
+
+// Copies or blends W*H pixels to the framebuffer at X,Y. Pixels are D bytes
+// apart and lines L bytes apart, and have 1 (gray), 2 (gray, alpha),
+// 3 (RGB) or 4 (RGBA) channels.
+void Fl_Pico_Framebuffer_Graphics_Driver::blit_(const uchar *buf, int X, int Y, int W, int H,
+                                                 int D, int L, int channels)
+{
+  const clip_rect &c = clip_();
+  int x = X > c.x ? X : c.x, r = X + W < c.r ? X + W : c.r;
+  int y = Y > c.y ? Y : c.y, b = Y + H < c.b ? Y + H : c.b;
+  if (x >= r || y >= b) return;
+  int n = r - x;
+  for (; y < b; y++) {
+    const uchar *s = buf + (long)(y - Y) * L + (long)(x - X) * D;
+    uchar *d = pixel_address_(x, y);
+    int i, a;
+    switch (channels) {
+      case 1:
+        for (i = n; i > 0; i--, s += D, d += 4) {
+          d[0] = d[1] = d[2] = s[0]; d[3] = 0xff;
+        }
+        break;
+      case 3:
+        for (i = n; i > 0; i--, s += D, d += 4) {
+          d[0] = s[0]; d[1] = s[1]; d[2] = s[2]; d[3] = 0xff;
+        }
+        break;
+      case 2:
+        for (i = n; i > 0; i--, s += D, d += 4) {
+          if ((a = s[1]) == 0) continue;
+          if (a == 255) {
+            d[0] = d[1] = d[2] = s[0]; d[3] = 0xff;
+          } else {
+            int ia = 255 - a, v = s[0] * a + 127;
+            d[0] = (uchar)((v + d[0] * ia) / 255);
+            d[1] = (uchar)((v + d[1] * ia) / 255);
+            d[2] = (uchar)((v + d[2] * ia) / 255);
+            d[3] = (uchar)(d[3] + ((255 - d[3]) * a + 127) / 255);
+          }
+        }
+        break;
+      default:
+        for (i = n; i > 0; i--, s += D, d += 4) {
+          if ((a = s[3]) == 0) continue;
+          if (a == 255) {
+            d[0] = s[0]; d[1] = s[1]; d[2] = s[2]; d[3] = 0xff;
+          } else {
+            int ia = 255 - a;
+            d[0] = (uchar)((s[0] * a + d[0] * ia + 127) / 255);
+            d[1] = (uchar)((s[1] * a + d[1] * ia + 127) / 255);
+            d[2] = (uchar)((s[2] * a + d[2] * ia + 127) / 255);
+            d[3] = (uchar)(d[3] + ((255 - d[3]) * a + 127) / 255);
+          }
+        }
+        break;
+    }
+  }
+}
+
+
+void Fl_Pico_Framebuffer_Graphics_Driver::draw_image(const uchar* buf, int X, int Y, int W, int H, int D, int L)
+{
+  const int alpha = !!(abs(D) & FL_IMAGE_WITH_ALPHA);
+  if (alpha) D ^= FL_IMAGE_WITH_ALPHA;
+  if (!D) D = 3;
+  if (!L) L = W * abs(D);
+  blit_(buf, X + offset_x_, Y + offset_y_, W, H, D, L, (abs(D) >= 3 ? 3 : 1) + alpha);
+}
+
+
+void Fl_Pico_Framebuffer_Graphics_Driver::draw_image_mono(const uchar* buf, int X, int Y, int W, int H, int D, int L)
+{
+  if (!D) D = 1;
+  if (!L) L = W * abs(D);
+  blit_(buf, X + offset_x_, Y + offset_y_, W, H, D, L, 1);
+}
+
+
+// Same as blit_(), but the pixels of each line are delivered by a callback
+void Fl_Pico_Framebuffer_Graphics_Driver::blit_(Fl_Draw_Image_Cb cb, void *data, int X, int Y, int W, int H,
+                                                 int D, int channels)
+{
+  // only ask the callback for the visible part of each line
+  const clip_rect &c = clip_();
+  int x = X > c.x ? X : c.x, r = X + W < c.r ? X + W : c.r;
+  int y = Y > c.y ? Y : c.y, b = Y + H < c.b ? Y + H : c.b;
+  if (x >= r || y >= b) return;
+  uchar *line = new uchar[(r - x) * D];
+  for (; y < b; y++) {
+    cb(data, x - X, y - Y, r - x, line);
+    blit_(line, x, y, r - x, 1, D, 0, channels);
+  }
+  delete[] line;
+}
+
+
+void Fl_Pico_Framebuffer_Graphics_Driver::draw_image(Fl_Draw_Image_Cb cb, void* data, int X, int Y, int W, int H, int D)
+{
+  const int alpha = !!(abs(D) & FL_IMAGE_WITH_ALPHA);
+  if (alpha) D ^= FL_IMAGE_WITH_ALPHA;
+  D = abs(D);
+  if (!D) D = 3;
+  blit_(cb, data, X + offset_x_, Y + offset_y_, W, H, D, (D >= 3 ? 3 : 1) + alpha);
+}
+
+
+void Fl_Pico_Framebuffer_Graphics_Driver::draw_image_mono(Fl_Draw_Image_Cb cb, void* data, int X, int Y, int W, int H, int D)
+{
+  D = abs(D);
+  if (!D) D = 1;
+  blit_(cb, data, X + offset_x_, Y + offset_y_, W, H, D, 1);
+}
+
+
+void Fl_Pico_Framebuffer_Graphics_Driver::draw(Fl_RGB_Image *img, int XP, int YP, int WP, int HP, int cx, int cy)
+{
+  int X, Y, W, H;
+  // Don't draw an empty image...
+  if (!img->d() || !img->array) {
+    Fl_Graphics_Driver::draw_empty(img, XP, YP);
+    return;
+  }
+  if (start_image(img, XP, YP, WP, HP, cx, cy, X, Y, W, H)) return;
+  int ld = img->ld();
+  if (ld == 0) ld = img->w() * img->d();
+  blit_(img->array + cy * ld + cx * img->d(), X + offset_x_, Y + offset_y_, W, H,
+        img->d(), ld, img->d());
+}
+
+
+void Fl_Pico_Framebuffer_Graphics_Driver::draw(Fl_Pixmap *pxm, int XP, int YP, int WP, int HP, int cx, int cy)
+{
+  if (!pxm->data() || pxm->w() <= 0 || pxm->h() <= 0) {
+    Fl_Graphics_Driver::draw_empty(pxm, XP, YP);
+    return;
+  }
+  // the transparent pixels of the pixmap become the alpha channel
+  Fl_RGB_Image rgb(pxm, Fl_Graphics_Driver::color());
+  draw(&rgb, XP, YP, WP, HP, cx, cy);
+}
+
+
+void Fl_Pico_Framebuffer_Graphics_Driver::draw(Fl_Bitmap *bm, int XP, int YP, int WP, int HP, int cx, int cy)
+{
+  int X, Y, W, H;
+  if (!bm->array) {
+    Fl_Graphics_Driver::draw_empty(bm, XP, YP);
+    return;
+  }
+  if (start_image(bm, XP, YP, WP, HP, cx, cy, X, Y, W, H)) return;
+  int ld = (bm->w() + 7) / 8;
+  X += offset_x_; Y += offset_y_;
+  for (int j = 0; j < H; j++) {
+    const uchar *row = bm->array + (cy + j) * ld;
+    int i = 0;
+    while (i < W) {
+      // fill each run of set bits as one span
+      while (i < W && !(row[(cx + i) >> 3] & (1 << ((cx + i) & 7)))) i++;
+      int first = i;
+      while (i < W && (row[(cx + i) >> 3] & (1 << ((cx + i) & 7)))) i++;
+      if (i > first) hspan_(X + first, X + i - 1, Y + j);
+    }
+  }
+}
+
+//
+// End of "$Id$".
+//
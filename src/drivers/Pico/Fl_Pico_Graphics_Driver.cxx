@@ -19,12 +19,30 @@
 
 #include "../../config_lib.h"
 #include "Fl_Pico_Graphics_Driver.H"
+#include "Fl_Pico_Rasterizer.H"
 #include <FL/fl_draw.H>
 #include <FL/math.h>
 
 
 static int sign(int x) { return (x>0)-(x<0); }
 
+// the contours of the current polygon
+static Fl_Pico_Rasterizer raster;
+
+
+void Fl_Pico_Graphics_Driver::fill_span_(void *data, int x, int y, int n, const uchar *)
+{
+  ((Fl_Pico_Graphics_Driver*)data)->xyline(x, y, x + n - 1);
+}
+
+
+void Fl_Pico_Graphics_Driver::fill_polygon_()
+{
+  // there is no clipping, only the spans that fit in a short are drawn
+  raster.render(-32768, -32768, 65536, 65536, Fl_Pico_Rasterizer::EVEN_ODD, 0, fill_span_, this);
+  raster.reset();
+}
+
 
 void Fl_Pico_Graphics_Driver::point(int x, int y)
 {
@@ -171,20 +189,22 @@ void Fl_Pico_Graphics_Driver::loop(int x0, int y0, int x1, int y1, int x2, int y
 
 void Fl_Pico_Graphics_Driver::polygon(int x0, int y0, int x1, int y1, int x2, int y2)
 {
-  // FIXME: fill
-  line(x0, y0, x1, y1);
-  line(x1, y1, x2, y2);
-  line(x2, y2, x0, y0);
+  raster.reset();
+  raster.move_to(x0, y0);
+  raster.line_to(x1, y1);
+  raster.line_to(x2, y2);
+  fill_polygon_();
 }
 
 
 void Fl_Pico_Graphics_Driver::polygon(int x0, int y0, int x1, int y1, int x2, int y2, int x3, int y3)
 {
-  // FIXME: fill
-  line(x0, y0, x1, y1);
-  line(x1, y1, x2, y2);
-  line(x2, y2, x3, y3);
-  line(x3, y3, x0, y0);
+  raster.reset();
+  raster.move_to(x0, y0);
+  raster.line_to(x1, y1);
+  raster.line_to(x2, y2);
+  raster.line_to(x3, y3);
+  fill_polygon_();
 }
 
 
@@ -195,6 +215,7 @@ void Fl_Pico_Graphics_Driver::push_clip(int x, int y, int w, int h)
 
 int Fl_Pico_Graphics_Driver::clip_box(int x, int y, int w, int h, int &X, int &Y, int &W, int &H)
 {
+  X = x; Y = y; W = w; H = h;
   return 0;
 }
 
@@ -231,6 +252,7 @@ void Fl_Pico_Graphics_Driver::begin_complex_polygon()
 {
   what = POLYGON;
   pn = 0;
+  raster.reset();
 }
 
 
@@ -252,6 +274,7 @@ void Fl_Pico_Graphics_Driver::begin_polygon()
 {
   what = POLYGON;
   pn = 0;
+  raster.reset();
 }
 
 
@@ -262,8 +285,11 @@ void Fl_Pico_Graphics_Driver::transformed_vertex(double x, double y)
       case POINT_:  point(x, y); break;
       case LINE:    line(px, py, x, y); break;
       case LOOP:    line(px, py, x, y); break;
-      case POLYGON: line(px, py, x, y); break; // FIXME: fill!
+      case POLYGON: raster.line_to(x, y); break;
     }
+  } else if (what == POLYGON) {
+    // the first vertex, or the first one after gap()
+    raster.move_to(x, y);
   }
   if (pn==0 ) { pxf = x; pyf = y; }
   px = x; py = y;
@@ -298,14 +324,14 @@ void Fl_Pico_Graphics_Driver::end_loop()
 
 void Fl_Pico_Graphics_Driver::end_polygon()
 {
-  line(px, py, pxf, pyf);  // FIXME: fill!
+  fill_polygon_();
   pn = 0;
 }
 
 
 void Fl_Pico_Graphics_Driver::end_complex_polygon()
 {
-  line(px, py, pxf, pyf);  // FIXME: fill!
+  fill_polygon_();
   pn = 0;
 }
 
@@ -378,7 +404,15 @@ void Fl_Pico_Graphics_Driver::arc(int xi, int yi, int w, int h, double a1, doubl
 
 void Fl_Pico_Graphics_Driver::pie(int x, int y, int w, int h, double a1, double a2)
 {
-  // FIXME: implement this
+  if (w <= 0 || h <= 0) return;
+  double rx = w / 2.0, ry = h / 2.0, cx = x + rx, cy = y + ry;
+  int segs = (int)(fabs(a2 - a1) * (rx + ry) / 200);  // about 2 pixels per segment
+  if (segs < 8) segs = 8;
+  double a = a1 * M_PI / 180, step = (a2 - a1) * M_PI / 180 / segs;
+  raster.reset();
+  raster.move_to(cx, cy);
+  for (int i = 0; i <= segs; i++, a += step) raster.line_to(cx + cos(a) * rx, cy - sin(a) * ry);
+  fill_polygon_();
 }
 
 
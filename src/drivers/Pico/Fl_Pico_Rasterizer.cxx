@@ -0,0 +1,393 @@
+//
+// "$Id$"
+//
+// Scanline polygon rasterizer for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 1998-2017 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     http://www.fltk.org/COPYING.php
+//
+// Please report all bugs and problems on the following page:
+//
+//     http://www.fltk.org/str.php
+//
+
+#include "Fl_Pico_Rasterizer.H"
+#include <FL/math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  include <emmintrin.h>
+#  define FL_PICO_SSE2 1
+#endif
+
+/*
+ The anti-aliased fill sums up the signed area that each edge covers to its
+ right, cell by cell, in a row of floats (this is how the font-rs rasterizer
+ works). The coverage of a pixel is then the sum of the cells up to it: the
+ winding number of the pixel for the non-zero rule, folded into 0 ... 1 for
+ the even-odd rule. Rows are done one at a time, so the buffers only hold
+ one row and the edges are split at the scanlines as they are drawn.
+ */
+
+
+Fl_Pico_Rasterizer::Fl_Pico_Rasterizer()
+{
+  edges_ = NULL; edge_n_ = edge_size_ = 0;
+  active_ = NULL;
+  cross_ = NULL; cross_size_ = 0;
+  acc_ = NULL; cover_ = NULL; row_size_ = 0;
+  runs_ = NULL; run_n_ = run_size_ = 0;
+  start_x_ = start_y_ = x_ = y_ = 0;
+  open_ = 0;
+}
+
+
+Fl_Pico_Rasterizer::~Fl_Pico_Rasterizer()
+{
+  free(edges_);
+  free(active_);
+  free(cross_);
+  free(acc_);
+  free(cover_);
+  free(runs_);
+}
+
+
+/** Removes all contours. */
+void Fl_Pico_Rasterizer::reset()
+{
+  edge_n_ = 0;
+  open_ = 0;
+}
+
+
+/** Closes the current contour and starts a new one at x, y. */
+void Fl_Pico_Rasterizer::move_to(double x, double y)
+{
+  close();
+  start_x_ = x_ = x;
+  start_y_ = y_ = y;
+  open_ = 1;
+}
+
+
+/** Adds the edge from the current point to x, y to the current contour. */
+void Fl_Pico_Rasterizer::line_to(double x, double y)
+{
+  if (!open_) {
+    move_to(x, y);
+    return;
+  }
+  add_edge_(x_, y_, x, y);
+  x_ = x; y_ = y;
+}
+
+
+/** Closes the current contour with an edge back to its first point. */
+void Fl_Pico_Rasterizer::close()
+{
+  if (!open_) return;
+  add_edge_(x_, y_, start_x_, start_y_);
+  open_ = 0;
+}
+
+
+void Fl_Pico_Rasterizer::add_edge_(double ax, double ay, double bx, double by)
+{
+  // horizontal edges cross no scanline, and add no area
+  if (ay == by || !(ay == ay && by == by && ax == ax && bx == bx)) return;
+  if (edge_n_ >= edge_size_) {
+    edge_size_ = edge_size_ ? 2 * edge_size_ : 64;
+    edges_ = (edge*)realloc(edges_, edge_size_ * sizeof(edge));
+    active_ = (int*)realloc(active_, edge_size_ * sizeof(int));
+  }
+  edge &e = edges_[edge_n_++];
+  e.ax = ax; e.ay = ay; e.bx = bx; e.by = by;
+  if (ay < by) {
+    e.x0 = ax; e.y0 = ay; e.y1 = by; e.dir = 1;
+  } else {
+    e.x0 = bx; e.y0 = by; e.y1 = ay; e.dir = -1;
+  }
+  e.dxdy = (bx - ax) / (by - ay);
+}
+
+
+int Fl_Pico_Rasterizer::compare_edges_(const void *a, const void *b)
+{
+  double ya = ((const edge*)a)->y0, yb = ((const edge*)b)->y0;
+  return ya < yb ? -1 : ya > yb;
+}
+
+
+/**
+ Fills the contours, the current one is closed first.
+ Only the pixels inside the clip rectangle x, y, w, h are passed to \p cb.
+ \param rule EVEN_ODD or NON_ZERO
+ \param antialias non-zero to compute the coverage of the pixels on the edges
+ */
+void Fl_Pico_Rasterizer::render(int x, int y, int w, int h, int rule, int antialias,
+                                Span_Cb cb, void *data)
+{
+  close();
+  if (edge_n_ < 2 || w <= 0 || h <= 0) return;
+  // the edges are looked at from top to bottom
+  qsort(edges_, edge_n_, sizeof(edge), compare_edges_);
+  if (antialias) render_aa_(x, y, x + w, y + h, rule, cb, data);
+  else render_aliased_(x, y, x + w, y + h, rule, cb, data);
+}
+
+
+// Samples each scanline at the pixel centers, like XFillPolygon() does.
+void Fl_Pico_Rasterizer::render_aliased_(int cx, int cy, int cr, int cb, int rule,
+                                         Span_Cb span, void *data)
+{
+  if (edge_n_ > cross_size_) {
+    cross_size_ = edge_size_;
+    cross_ = (crossing*)realloc(cross_, cross_size_ * sizeof(crossing));
+  }
+  double ymax = edges_[0].y1;
+  int i;
+  for (i = 1; i < edge_n_; i++) if (edges_[i].y1 > ymax) ymax = edges_[i].y1;
+  int y = (int)ceil(edges_[0].y0), y1 = (int)ceil(ymax);
+  if (y < cy) y = cy;
+  if (y1 > cb) y1 = cb;
+  int next = 0, na = 0;
+  for (; y < y1; y++) {
+    // the edges from y0 included to y1 excluded cross the scanline
+    while (next < edge_n_ && edges_[next].y0 <= y) active_[na++] = next++;
+    int nc = 0;
+    for (i = 0; i < na;) {
+      const edge &e = edges_[active_[i]];
+      if (e.y1 <= y) {
+        active_[i] = active_[--na];
+        continue;
+      }
+      double x = e.ax + (y - e.ay) * (e.bx - e.ax) / (e.by - e.ay);
+      int k = nc++;
+      while (k > 0 && cross_[k-1].x > x) { cross_[k] = cross_[k-1]; k--; }
+      cross_[k].x = x;
+      cross_[k].dir = e.dir;
+      i++;
+    }
+    int winding = 0;
+    double xa = 0;
+    for (i = 0; i < nc; i++) {
+      int was_in = rule == NON_ZERO ? winding != 0 : winding & 1;
+      winding += cross_[i].dir;
+      int is_in = rule == NON_ZERO ? winding != 0 : winding & 1;
+      if (is_in && !was_in) {
+        xa = cross_[i].x;
+      } else if (was_in && !is_in) {
+        double xb = cross_[i].x;
+        if (xb <= cx || xa >= cr) continue;
+        int x0 = (int)ceil(xa < cx ? cx : xa), x1 = (int)ceil(xb > cr ? cr : xb);
+        if (x1 > x0) span(data, x0, y, x1 - x0, NULL);
+      }
+    }
+  }
+}
+
+
+// Adds the signed area of xa, ya to xb, yb to the cells, 0 <= x <= w.
+void Fl_Pico_Rasterizer::accumulate_(double xa, double ya, double xb, double yb, int dir)
+{
+  float d = (float)((yb - ya) * dir);
+  if (d == 0) return;
+  float *acc = acc_;
+  double x0 = xa < xb ? xa : xb, x1 = xa < xb ? xb : xa;
+  // x0 and x1 are not negative, this is floor() and ceil() without a call
+  int x0i = (int)x0, x1i = (int)x1;
+  if (x1i < x1) x1i++;
+  double x0floor = x0i, x1ceil = x1i;
+  if (run_n_ >= run_size_) {
+    run_size_ = run_size_ ? 2 * run_size_ : 64;
+    runs_ = (cell_run*)realloc(runs_, run_size_ * sizeof(cell_run));
+  }
+  cell_run &r = runs_[run_n_++];
+  r.x0 = x0i;
+  if (x1i <= x0i + 1) {
+    // within one cell, the rest of the area goes to the next one
+    float xmf = (float)(0.5 * (xa + xb) - x0floor);
+    acc[x0i] += d - d * xmf;
+    acc[x0i + 1] += d * xmf;
+    r.x1 = x0i + 1;
+    return;
+  }
+  float s = (float)(1 / (x1 - x0));
+  float x0f = (float)(x0 - x0floor);
+  float a0 = 0.5f * s * (1 - x0f) * (1 - x0f);
+  float x1f = (float)(x1 - x1ceil + 1);
+  float am = 0.5f * s * x1f * x1f;
+  acc[x0i] += d * a0;
+  if (x1i == x0i + 2) {
+    acc[x0i + 1] += d * (1 - a0 - am);
+  } else {
+    float a1 = s * (1.5f - x0f);
+    acc[x0i + 1] += d * (a1 - a0);
+    for (int xi = x0i + 2; xi < x1i - 1; xi++) acc[xi] += d * s;
+    float a2 = a1 + (x1i - x0i - 3) * s;
+    acc[x1i - 1] += d * (1 - a2 - am);
+  }
+  acc[x1i] += d * am;
+  r.x1 = x1i;
+}
+
+
+// Adds the part of an edge that is within one row, from xa, ya to xb, yb.
+// ya and yb are from 0 to 1, the row is w pixels wide from x = 0.
+void Fl_Pico_Rasterizer::cell_line_(double xa, double ya, double xb, double yb, int dir, int w)
+{
+  if ((xa < 0 && xb > 0) || (xa > 0 && xb < 0)) {
+    double ym = ya + (0 - xa) * (yb - ya) / (xb - xa);
+    cell_line_(xa, ya, 0, ym, dir, w);
+    cell_line_(0, ym, xb, yb, dir, w);
+    return;
+  }
+  if ((xa < w && xb > w) || (xa > w && xb < w)) {
+    double ym = ya + (w - xa) * (yb - ya) / (xb - xa);
+    cell_line_(xa, ya, w, ym, dir, w);
+    cell_line_(w, ym, xb, yb, dir, w);
+    return;
+  }
+  // on the right of the row, it changes no pixel
+  if (xa >= w && xb >= w) return;
+  // on the left of the row, it covers all pixels
+  if (xa < 0 || xb < 0) xa = xb = 0;
+  accumulate_(xa, ya, xb, yb, dir);
+}
+
+
+// Turns n cells into the coverage of their pixels, sum is the sum of the
+// cells before them. Returns the sum up to the last cell read, that is
+// up to the next multiple of 4 with SSE2.
+static float coverage(const float *acc, uchar *cover, int n, float sum, int nonzero)
+{
+  int i;
+#if FL_PICO_SSE2
+  __m128 carry = _mm_set1_ps(sum);
+  const __m128 absmask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+  const __m128 one = _mm_set1_ps(1), two = _mm_set1_ps(2);
+  const __m128 half = _mm_set1_ps(0.5f), scale = _mm_set1_ps(255);
+  for (i = 0; i < n; i += 4) {
+    // prefix sum of 4 cells, plus the sum of the cells before them
+    __m128 v = _mm_loadu_ps(acc + i);
+    v = _mm_add_ps(v, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(v), 4)));
+    v = _mm_add_ps(v, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(v), 8)));
+    v = _mm_add_ps(v, carry);
+    carry = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3));
+    __m128 a = _mm_and_ps(v, absmask);
+    if (nonzero) {
+      a = _mm_min_ps(a, one);
+    } else {
+      __m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(_mm_mul_ps(a, half)));
+      a = _mm_sub_ps(a, _mm_mul_ps(t, two));
+      a = _mm_min_ps(a, _mm_sub_ps(two, a));
+    }
+    __m128i c = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(a, scale), half));
+    c = _mm_packs_epi32(c, c);
+    c = _mm_packus_epi16(c, c);
+    int bytes = _mm_cvtsi128_si32(c);
+    memcpy(cover + i, &bytes, 4);
+  }
+  return _mm_cvtss_f32(carry);
+#else
+  for (i = 0; i < n; i++) {
+    sum += acc[i];
+    float a = sum < 0 ? -sum : sum;
+    if (nonzero) {
+      if (a > 1) a = 1;
+    } else {
+      a -= 2 * (int)(a * 0.5f);
+      if (a > 1) a = 2 - a;
+    }
+    cover[i] = (uchar)(a * 255 + 0.5f);
+  }
+  return sum;
+#endif
+}
+
+
+void Fl_Pico_Rasterizer::render_aa_(int cx, int cy, int cr, int cb, int rule,
+                                    Span_Cb span, void *data)
+{
+  int w = cr - cx;
+  // room for the cells right of the row, and for reading 4 cells at once
+  if (w + 8 > row_size_) {
+    free(acc_);
+    free(cover_);
+    row_size_ = w + 8;
+    acc_ = (float*)calloc(row_size_, sizeof(float));
+    cover_ = (uchar*)malloc(row_size_);
+  }
+  double ymax = edges_[0].y1;
+  int i;
+  for (i = 1; i < edge_n_; i++) if (edges_[i].y1 > ymax) ymax = edges_[i].y1;
+  int y = (int)floor(edges_[0].y0), y1 = (int)ceil(ymax);
+  if (y < cy) y = cy;
+  if (y1 > cb) y1 = cb;
+  int next = 0, na = 0;
+  for (; y < y1; y++) {
+    // the edges from y0 to y1 that overlap the row from y to y + 1
+    while (next < edge_n_ && edges_[next].y0 < y + 1) active_[na++] = next++;
+    run_n_ = 0;
+    for (i = 0; i < na;) {
+      const edge &e = edges_[active_[i]];
+      if (e.y1 <= y) {
+        active_[i] = active_[--na];
+        continue;
+      }
+      double ya = e.y0 > y ? e.y0 : y, yb = e.y1 < y + 1 ? e.y1 : y + 1;
+      double xa = e.x0 + (ya - e.y0) * e.dxdy - cx, xb = e.x0 + (yb - e.y0) * e.dxdy - cx;
+      if (xa >= 0 && xb >= 0 && xa <= w && xb <= w) accumulate_(xa, ya - y, xb, yb - y, e.dir);
+      else cell_line_(xa, ya - y, xb, yb - y, e.dir, w);
+      i++;
+    }
+    if (!run_n_) continue;
+    // sort the cells the edges touched from left to right, and merge the
+    // runs less than 4 cells apart, so that reading 4 cells at once only
+    // reads empty ones after the end of a run
+    int nr = 0;
+    for (i = 1; i < run_n_; i++) {
+      cell_run r = runs_[i];
+      int k = i;
+      while (k > 0 && runs_[k-1].x0 > r.x0) { runs_[k] = runs_[k-1]; k--; }
+      runs_[k] = r;
+    }
+    for (i = 0; i < run_n_; i++) {
+      if (nr && runs_[i].x0 <= runs_[nr-1].x1 + 4) {
+        if (runs_[i].x1 > runs_[nr-1].x1) runs_[nr-1].x1 = runs_[i].x1;
+      } else {
+        runs_[nr++] = runs_[i];
+      }
+    }
+    // the pixels between the runs are covered like the last pixel of a run
+    float sum = 0;
+    for (i = 0; i < nr; i++) {
+      int a = runs_[i].x0, b = runs_[i].x1;
+      if (a < w) {
+        int n = (b < w ? b + 1 : w) - a;
+        sum = coverage(acc_ + a, cover_, n, sum, rule == NON_ZERO);
+        span(data, cx + a, y, n, cover_);
+        int end = i + 1 < nr && runs_[i+1].x0 < w ? runs_[i+1].x0 : w;
+        uchar c = cover_[n - 1];
+        if (b + 1 < end && c == 255) {
+          span(data, cx + b + 1, y, end - b - 1, NULL);
+        } else if (b + 1 < end && c) {
+          memset(cover_, c, end - b - 1);
+          span(data, cx + b + 1, y, end - b - 1, cover_);
+        }
+      }
+      memset(acc_ + a, 0, (b - a + 1) * sizeof(float));
+    }
+  }
+}
+
+//
+// End of "$Id$".
+//
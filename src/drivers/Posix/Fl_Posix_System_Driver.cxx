@@ -85,6 +85,19 @@ int Fl_Posix_System_Driver::file_type(const char *filename)
   return filetype;
 }
 
+// Tells whether a directory entry is a directory, for filename_list().
+// Uses the file type that readdir() returned if it is known, which saves a
+// stat() call per file (many on network file systems); symbolic links still
+// need stat().
+int Fl_Posix_System_Driver::dirent_isdir(const struct dirent *de, const char *fullname)
+{
+#ifdef DT_DIR
+  if (de->d_type == DT_DIR) return 1;
+  if (de->d_type != DT_UNKNOWN && de->d_type != DT_LNK) return 0;
+#endif
+  return fl_filename_isdir(fullname);
+}
+
 const char *Fl_Posix_System_Driver::getpwnam(const char *login) {
   struct passwd *pwd;
   pwd = ::getpwnam(login);
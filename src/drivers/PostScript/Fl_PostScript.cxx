@@ -26,6 +26,10 @@
 #include <FL/Fl_Native_File_Chooser.H>
 #include <FL/Fl_System_Driver.H>
 #include <stdarg.h>
+#include <string.h>
+
+// size of the buffer that collects PostScript text before it goes to the file
+static const int ps_buffer_size = 65536;
 
 const char *Fl_PostScript_File_Device::file_chooser_title = "Select a .ps file";
 
@@ -38,6 +42,12 @@ Fl_PostScript_Graphics_Driver::Fl_PostScript_Graphics_Driver(void)
   //lang_level_ = 3;
   lang_level_ = 2;
   mask = 0;
+  interpolate_ = 0;
+  image_cache_ = NULL;
+  buffer_ = new char[ps_buffer_size];
+  lbuffer_ = 0;
+  gsave_level_ = 0;
+  color_level_ = font_level_ = line_level_ = clip_level_ = -1;
   ps_filename_ = NULL;
   scale_x = scale_y = 1.;
   bg_r = bg_g = bg_b = 255;
@@ -46,6 +56,8 @@ Fl_PostScript_Graphics_Driver::Fl_PostScript_Graphics_Driver(void)
 /** \brief The destructor. */
 Fl_PostScript_Graphics_Driver::~Fl_PostScript_Graphics_Driver() {
   if(ps_filename_) free(ps_filename_);
+  delete_image_cache();
+  delete[] buffer_;
 }
 
 Fl_PostScript_File_Device::Fl_PostScript_File_Device(void)
@@ -109,6 +121,7 @@ Fl_PostScript_File_Device::~Fl_PostScript_File_Device() {
 
 int Fl_PostScript_Graphics_Driver::clocale_printf(const char *format, ...)
 {
+  flush();
   va_list args;
   va_start(args, format);
   int retval = Fl::system_driver()->clocale_printf(output, format, args);
@@ -118,6 +131,171 @@ int Fl_PostScript_Graphics_Driver::clocale_printf(const char *format, ...)
 
 #ifndef FL_DOXYGEN
 
+//
+// PostScript text is collected in buffer_ and formatted by print(), which
+// knows the few printf() directives the driver uses. Numbers are written
+// without stdio and without looking at the current locale.
+//
+
+// writes the buffered PostScript text to the output file
+void Fl_PostScript_Graphics_Driver::flush()
+{
+  if (lbuffer_) fwrite(buffer_, 1, lbuffer_, output);
+  lbuffer_ = 0;
+}
+
+// outputs n characters as is
+void Fl_PostScript_Graphics_Driver::put(const char *s, int n)
+{
+  if (lbuffer_ + n > ps_buffer_size) {
+    flush();
+    if (n > ps_buffer_size) {
+      fwrite(s, 1, n, output);
+      return;
+    }
+  }
+  memcpy(buffer_ + lbuffer_, s, n);
+  lbuffer_ += n;
+}
+
+void Fl_PostScript_Graphics_Driver::put(const char *s)
+{
+  put(s, (int)strlen(s));
+}
+
+static char *print_unsigned(char *p, unsigned u)
+{
+  char digits[10];
+  int n = 0;
+  do {
+    digits[n++] = '0' + u % 10;
+    u /= 10;
+  } while (u);
+  while (n) *p++ = digits[--n];
+  return p;
+}
+
+static const unsigned print_pow10[10] = {
+  1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+// writes d with the given number of decimals like %.<decimals>f,
+// or like %g when decimals < 0: 6 significant digits and no trailing zeros
+static char *print_double(char *p, double d, int decimals)
+{
+  double a = d < 0 ? -d : d;
+  int trim = (decimals < 0);
+  if (trim) {
+    if (a >= 100000) decimals = 0;
+    else if (a >= 10000) decimals = 1;
+    else if (a >= 1000) decimals = 2;
+    else if (a >= 100) decimals = 3;
+    else if (a >= 10) decimals = 4;
+    else if (a >= 1) decimals = 5;
+    else if (a >= 0.1) decimals = 6;
+    else if (a >= 0.01) decimals = 7;
+    else if (a >= 0.001) decimals = 8;
+    else decimals = 9;
+  }
+  double scaled = decimals <= 9 ? a * print_pow10[decimals] : 4e9;
+  if (!(scaled < 4e9 - 1)) { // too large, too many decimals, or not a number
+    int l = trim ? snprintf(p, 40, "%g", d) : snprintf(p, 40, "%.*f", decimals, d);
+    if (l > 39) l = 39;
+    for (int i = 0; i < l; i++) if (p[i] == ',') p[i] = '.';
+    return p + l;
+  }
+  unsigned v = (unsigned)scaled;
+  scaled -= v;
+  if (scaled > 0.5 || (scaled == 0.5 && (v & 1))) v++; // ties to even, like printf()
+  unsigned fraction = v % print_pow10[decimals];
+  if (d < 0 && v) *p++ = '-';
+  p = print_unsigned(p, v / print_pow10[decimals]);
+  if (trim) {
+    while (decimals && fraction % 10 == 0) {
+      fraction /= 10;
+      decimals--;
+    }
+  }
+  if (decimals) {
+    *p++ = '.';
+    for (int i = decimals - 1; i >= 0; i--) {
+      p[i] = '0' + fraction % 10;
+      fraction /= 10;
+    }
+    p += decimals;
+  }
+  return p;
+}
+
+// outputs text formatted like printf(format, ...) in the C locale;
+// knows %d, %i, %c, %s, %%, %g, %f and %.<n>f
+void Fl_PostScript_Graphics_Driver::print(const char *format, ...)
+{
+  va_list args;
+  va_start(args, format);
+  char *p = buffer_ + lbuffer_;
+  const char *f = format;
+  while (*f) {
+    if (p - buffer_ > ps_buffer_size - 64) { // keep room for one directive
+      lbuffer_ = (int)(p - buffer_);
+      flush();
+      p = buffer_;
+    }
+    if (*f != '%') {
+      *p++ = *f++;
+      continue;
+    }
+    f++;
+    int decimals = 6;
+    if (*f == '.') {
+      for (decimals = 0, f++; *f >= '0' && *f <= '9'; f++) decimals = 10 * decimals + *f - '0';
+    }
+    switch (*f) {
+      case 'd':
+      case 'i': {
+        int i = va_arg(args, int);
+        if (i < 0) *p++ = '-';
+        p = print_unsigned(p, i < 0 ? 0u - (unsigned)i : (unsigned)i);
+        break;
+      }
+      case 'g':
+        p = print_double(p, va_arg(args, double), -1);
+        break;
+      case 'f':
+        p = print_double(p, va_arg(args, double), decimals);
+        break;
+      case 'c':
+        *p++ = (char)va_arg(args, int);
+        break;
+      case 's':
+        lbuffer_ = (int)(p - buffer_);
+        put(va_arg(args, const char *));
+        p = buffer_ + lbuffer_;
+        break;
+      case 0:
+        f--;
+        break;
+      default:
+        *p++ = *f;
+        break;
+    }
+    f++;
+  }
+  lbuffer_ = (int)(p - buffer_);
+  va_end(args);
+}
+
+// the output restored n graphics states: forget what they had set;
+// state_saved() forgets the clip, whose coordinates may change after it
+void Fl_PostScript_Graphics_Driver::state_restored(int n)
+{
+  gsave_level_ -= n;
+  if (color_level_ > gsave_level_) color_level_ = -1;
+  if (font_level_ > gsave_level_) font_level_ = -1;
+  if (line_level_ > gsave_level_) line_level_ = -1;
+  if (clip_level_ > gsave_level_) clip_level_ = -1;
+}
+
 //  Prolog string 
 
 static const char * prolog =
@@ -184,6 +362,7 @@ static const char * prolog =
 "/SRGB { setrgbcolor } bind def\n"
 
 "/A85RLE { /ASCII85Decode filter /RunLengthDecode filter } bind def\n" // ASCII85Decode followed by RunLengthDecode filters
+// IDS, defined by start_postscript(), gives the data source of images
 
 //  color images 
 
@@ -191,7 +370,7 @@ static const char * prolog =
 "translate \n"
 "sx sy scale px py 8 \n"
 "[ px 0 0 py neg 0 py ]\n"
-"currentfile A85RLE\n false 3"
+"IDS\n false 3"
 " colorimage GR\n"
 "} bind def\n"
 
@@ -203,7 +382,7 @@ static const char * prolog =
 
 
 "[ px 0 0 py neg 0 py ]\n"
-"currentfile A85RLE\n"
+"IDS\n"
 "image GR\n"
 "} bind def\n"
 
@@ -213,7 +392,7 @@ static const char * prolog =
 "translate \n"
 "sx sy scale px py true \n"
 "[ px 0 0 py neg 0 py ]\n"
-"currentfile A85RLE\n"
+"IDS\n"
 "imagemask GR\n"
 "} bind def\n"
 
@@ -252,6 +431,14 @@ static const char * prolog =
 
 static const char * prolog_2 =  // prolog relevant only if lang_level >1
 
+// data source reading the strings of an array, for images drawn more than once
+// usage: array IDA
+// the procedure returned carries its own dictionary with the array and the index
+// of the next string, so it works whatever dictionaries are open when it is called
+"/IDA { 2 dict begin /ida_a exch def /ida_i 0 def currentdict end\n"
+"[ exch /begin cvx { ida_i ida_a length lt { ida_a ida_i get /ida_i ida_i 1 add def } { () } ifelse } "
+"/exec cvx /end cvx ] cvx } bind def\n"
+
 // color image dictionaries
 "/CII {GS /inter exch def /py exch def /px exch def /sy exch def /sx exch def \n"
 "translate \n"
@@ -264,7 +451,7 @@ static const char * prolog_2 =  // prolog relevant only if lang_level >1
 "/Height py def\n"
 "/BitsPerComponent 8 def\n"
 "/Interpolate inter def\n"
-"/DataSource currentfile A85RLE def\n"
+"/DataSource IDS def\n"
 "/MultipleDataSources false def\n"
 "/ImageMatrix [ px 0 0 py neg 0 py ] def\n"
 "/Decode [ 0 1 0 1 0 1 ] def\n"
@@ -284,7 +471,7 @@ static const char * prolog_2 =  // prolog relevant only if lang_level >1
 "/BitsPerComponent 8 def\n"
 
 "/Interpolate inter def\n"
-"/DataSource currentfile A85RLE def\n"
+"/DataSource IDS def\n"
 "/MultipleDataSources false def\n"
 "/ImageMatrix [ px 0 0 py neg 0 py ] def\n"
 "/Decode [ 0 1 ] def\n"
@@ -389,7 +576,7 @@ static const char * prolog_2_pixmap =  // prolog relevant only if lang_level ==
 "pixmap_w pixmap_h scale "
 "pixmap_sx pixmap_sy 8 "
 "pixmap_mat "
-"currentfile A85RLE "
+"IDS "
 "false 3 "
 "colorimage "
 "end "
@@ -407,7 +594,7 @@ static const char * prolog_2_pixmap =  // prolog relevant only if lang_level ==
 "pixmap_sx pixmap_sy\n"
 "true\n"
 "pixmap_mat\n"
-"currentfile A85RLE\n"
+"IDS\n"
 "imagemask\n"
 "GR\n"
 "} bind def\n"
@@ -429,7 +616,7 @@ static const char * prolog_3 = // prolog relevant only if lang_level >2
 "/Height py def\n"
 "/BitsPerComponent 8 def\n"
 "/Interpolate inter def\n"
-"/DataSource currentfile A85RLE def\n"
+"/DataSource IDS def\n"
 "/MultipleDataSources false def\n"
 "/ImageMatrix [ px 0 0 py neg 0 py ] def\n"
 
@@ -470,7 +657,7 @@ static const char * prolog_3 = // prolog relevant only if lang_level >2
 "/Height py def\n"
 "/BitsPerComponent 8 def\n"
 "/Interpolate inter def\n"
-"/DataSource currentfile A85RLE def\n"
+"/DataSource IDS def\n"
 "/MultipleDataSources false def\n"
 "/ImageMatrix [ px 0 0 py neg 0 py ] def\n"
 
@@ -507,6 +694,7 @@ int Fl_PostScript_Graphics_Driver::start_postscript (int pagecount,
 //returns 0 iff OK
 {
   int w, h, x;
+  lbuffer_ = 0; // output is a new file
   if (format == Fl_Paged_Device::A4) {
     left_margin = 18;
     top_margin = 18;
@@ -524,46 +712,53 @@ int Fl_PostScript_Graphics_Driver::start_postscript (int pagecount,
     ph_ = Fl_Paged_Device::page_formats[format].height;
   }
   
-  fputs("%!PS-Adobe-3.0\n", output);
-  fputs("%%Creator: FLTK\n", output);
+  put("%!PS-Adobe-3.0\n");
+  put("%%Creator: FLTK\n");
   if (lang_level_>1)
-    fprintf(output, "%%%%LanguageLevel: %i\n" , lang_level_);
+    print("%%%%LanguageLevel: %i\n" , lang_level_);
   if ((pages_ = pagecount))
-    fprintf(output, "%%%%Pages: %i\n", pagecount);
+    print("%%%%Pages: %i\n", pagecount);
   else
-    fputs("%%Pages: (atend)\n", output);
-  fprintf(output, "%%%%BeginFeature: *PageSize %s\n", Fl_Paged_Device::page_formats[format].name );
+    put("%%Pages: (atend)\n");
+  print("%%%%BeginFeature: *PageSize %s\n", Fl_Paged_Device::page_formats[format].name );
   w = Fl_Paged_Device::page_formats[format].width;
   h = Fl_Paged_Device::page_formats[format].height;
   if (lang_level_ == 3 && (layout & Fl_Paged_Device::LANDSCAPE) ) { x = w; w = h; h = x; }
-  fprintf(output, "<</PageSize[%d %d]>>setpagedevice\n", w, h );
-  fputs("%%EndFeature\n", output);
-  fputs("%%EndComments\n", output);
-  fputs(prolog, output);
+  print("<</PageSize[%d %d]>>setpagedevice\n", w, h );
+  put("%%EndFeature\n");
+  put("%%EndComments\n");
+  put(prolog);
   if (lang_level_ > 1) {
-    fputs(prolog_2, output);
+    put(prolog_2);
     }
   if (lang_level_ == 2) {
-    fputs(prolog_2_pixmap, output);
+    put(prolog_2_pixmap);
     }
   if (lang_level_ > 2)
-    fputs(prolog_3, output);
+    put(prolog_3);
+#if HAVE_LIBZ
+  if (lang_level_ >= 3) // image data are compressed with FlateEncode
+    put("/IDS { currentfile /ASCII85Decode filter /FlateDecode filter } bind def\n");
+  else
+#endif
+    put("/IDS { currentfile A85RLE } bind def\n");
   if (lang_level_ >= 3) {
-    fputs("/CS { clipsave } bind def\n", output);
-    fputs("/CR { cliprestore } bind def\n", output);
+    put("/CS { clipsave } bind def\n");
+    put("/CR { cliprestore } bind def\n");
   } else {
-    fputs("/CS { GS } bind def\n", output);
-    fputs("/CR { GR } bind def\n", output);
+    put("/CS { GS } bind def\n");
+    put("/CR { GR } bind def\n");
   }
   page_policy_ = 1;
   
   
-  fputs("%%EndProlog\n",output);
+  put("%%EndProlog\n");
   if (lang_level_ >= 2)
-    fprintf(output,"<< /Policies << /Pagesize 1 >> >> setpagedevice\n");
+    put("<< /Policies << /Pagesize 1 >> >> setpagedevice\n");
   
   reset();
   nPages=0;
+  delete_image_cache();
   return 0;
 }
 
@@ -575,6 +770,8 @@ void Fl_PostScript_Graphics_Driver::recover(){
 
 void Fl_PostScript_Graphics_Driver::reset(){
   gap_=1;
+  gsave_level_ = 0;
+  color_level_ = font_level_ = line_level_ = clip_level_ = -1;
   clip_=0;
   cr_=cg_=cb_=0;
   Fl_Graphics_Driver::font(FL_HELVETICA, 12);
@@ -594,7 +791,7 @@ void Fl_PostScript_Graphics_Driver::reset(){
 void Fl_PostScript_Graphics_Driver::page_policy(int p){
   page_policy_ = p;
   if(lang_level_>=2)
-    fprintf(output,"<< /Policies << /Pagesize %i >> >> setpagedevice\n", p);
+    print("<< /Policies << /Pagesize %i >> >> setpagedevice\n", p);
 }
 
 // //////////////////// paging //////////////////////////////////////////
@@ -604,51 +801,54 @@ void Fl_PostScript_Graphics_Driver::page_policy(int p){
 void Fl_PostScript_Graphics_Driver::page(double pw, double ph, int media) {
   
   if (nPages){
-    fprintf(output, "CR\nGR\nGR\nGR\nSP\nrestore\n");
+    put("CR\nGR\nGR\nGR\nSP\nrestore\n");
   }
   ++nPages;
-  fprintf(output, "%%%%Page: %i %i\n" , nPages , nPages);
-  fprintf(output, "%%%%PageBoundingBox: 0 0 %d %d\n", pw > ph ? (int)ph : (int)pw , pw > ph ? (int)pw : (int)ph);
+  print("%%%%Page: %i %i\n" , nPages , nPages);
+  print("%%%%PageBoundingBox: 0 0 %d %d\n", pw > ph ? (int)ph : (int)pw , pw > ph ? (int)pw : (int)ph);
   if (pw>ph){
-    fprintf(output, "%%%%PageOrientation: Landscape\n");
+    print("%%%%PageOrientation: Landscape\n");
   }else{
-    fprintf(output, "%%%%PageOrientation: Portrait\n");
+    print("%%%%PageOrientation: Portrait\n");
   }
   
-  fprintf(output, "%%%%BeginPageSetup\n");
+  print("%%%%BeginPageSetup\n");
   if((media & Fl_Paged_Device::MEDIA) &&(lang_level_>1)){
     int r = media & Fl_Paged_Device::REVERSED;
     if(r) r = 2;
-    fprintf(output, "<< /PageSize [%i %i] /Orientation %i>> setpagedevice\n", (int)(pw+.5), (int)(ph+.5), r);
+    print("<< /PageSize [%i %i] /Orientation %i>> setpagedevice\n", (int)(pw+.5), (int)(ph+.5), r);
   }
-  fprintf(output, "%%%%EndPageSetup\n");
+  print("%%%%EndPageSetup\n");
   
 /*  pw_ = pw;
   ph_ = ph;*/
   reset();
   
-  fprintf(output, "save\n");
-  fprintf(output, "GS\n");
-  clocale_printf( "%g %g TR\n", (double)0 /*lm_*/ , ph_ /* - tm_*/);
-  fprintf(output, "1 -1 SC\n");
+  put("save\n");
+  put("GS\n");
+  state_saved(2);
+  print("%g %g TR\n", (double)0 /*lm_*/ , ph_ /* - tm_*/);
+  put("1 -1 SC\n");
   line_style(0);
-  fprintf(output, "GS\n");
+  put("GS\n");
+  state_saved();
   
   if (!((media & Fl_Paged_Device::MEDIA) &&(lang_level_>1))){
     if (pw > ph) {
       if(media & Fl_Paged_Device::REVERSED) {
-        fprintf(output, "-90 rotate %i 0 translate\n", int(-pw));
+        print("-90 rotate %i 0 translate\n", int(-pw));
 	}
       else {
-        fprintf(output, "90 rotate -%i -%i translate\n", (lang_level_ == 2 ? int(pw - ph) : 0), int(ph));
+        print("90 rotate -%i -%i translate\n", (lang_level_ == 2 ? int(pw - ph) : 0), int(ph));
 	}
       }
       else {
 	if(media & Fl_Paged_Device::REVERSED)
-	  fprintf(output, "180 rotate %i %i translate\n", int(-pw), int(-ph));
+	  print("180 rotate %i %i translate\n", int(-pw), int(-ph));
 	}
   }
-  fprintf(output, "GS\nCS\n");
+  put("GS\nCS\n");
+  state_saved(lang_level_ < 3 ? 2 : 1);
 }
 
 void Fl_PostScript_Graphics_Driver::page(int format){
@@ -664,144 +864,63 @@ void Fl_PostScript_Graphics_Driver::page(int format){
 
 void Fl_PostScript_Graphics_Driver::rect(int x, int y, int w, int h) {
   // Commented code does not work, i can't find the bug ;-(
-  // fprintf(output, "GS\n");
-  //  fprintf(output, "%i, %i, %i, %i R\n", x , y , w, h);
-  //  fprintf(output, "GR\n");
-  fprintf(output, "GS\n");
-  fprintf(output,"BP\n");
-  fprintf(output, "%i %i MT\n", x , y);
-  fprintf(output, "%i %i LT\n", x+w-1 , y);
-  fprintf(output, "%i %i LT\n", x+w-1 , y+h-1);
-  fprintf(output, "%i %i LT\n", x , y+h-1);
-  fprintf(output, "ECP\n");
-  fprintf(output, "GR\n");
+  // put("GS\n");
+  //  print("%i, %i, %i, %i R\n", x , y , w, h);
+  //  put("GR\n");
+  print("GS\nBP\n%i %i MT\n%i %i LT\n%i %i LT\n%i %i LT\nECP\nGR\n",
+        x, y, x+w-1, y, x+w-1, y+h-1, x, y+h-1);
 }
 
 void Fl_PostScript_Graphics_Driver::rectf(int x, int y, int w, int h) {
-  clocale_printf( "%g %g %i %i FR\n", x-0.5, y-0.5, w, h);
+  print("%g %g %i %i FR\n", x-0.5, y-0.5, w, h);
 }
 
 void Fl_PostScript_Graphics_Driver::line(int x1, int y1, int x2, int y2) {
-  fprintf(output, "GS\n");
-  fprintf(output, "%i %i %i %i L\n", x1 , y1, x2 ,y2);
-  fprintf(output, "GR\n");
+  print("GS\n%i %i %i %i L\nGR\n", x1, y1, x2, y2);
 }
 
 void Fl_PostScript_Graphics_Driver::line(int x0, int y0, int x1, int y1, int x2, int y2) {
-  fprintf(output, "GS\n");
-  fprintf(output,"BP\n");
-  fprintf(output, "%i %i MT\n", x0 , y0);
-  fprintf(output, "%i %i LT\n", x1 , y1);
-  fprintf(output, "%i %i LT\n", x2 , y2);
-  fprintf(output, "ELP\n");
-  fprintf(output, "GR\n");
+  print("GS\nBP\n%i %i MT\n%i %i LT\n%i %i LT\nELP\nGR\n", x0, y0, x1, y1, x2, y2);
 }
 
 void Fl_PostScript_Graphics_Driver::xyline(int x, int y, int x1, int y2, int x3){
-  fprintf(output, "GS\n");
-  fprintf(output,"BP\n");
-  fprintf(output, "%i %i MT\n", x , y );
-  fprintf(output, "%i %i LT\n", x1 , y );
-  fprintf(output, "%i %i LT\n", x1 , y2);
-  fprintf(output,"%i %i LT\n", x3 , y2);
-  fprintf(output, "ELP\n");
-  fprintf(output, "GR\n");
+  print("GS\nBP\n%i %i MT\n%i %i LT\n%i %i LT\n%i %i LT\nELP\nGR\n", x, y, x1, y, x1, y2, x3, y2);
 }
 
-
 void Fl_PostScript_Graphics_Driver::xyline(int x, int y, int x1, int y2){
-  
-  fprintf(output, "GS\n");
-  fprintf(output,"BP\n");
-  fprintf(output, "%i %i MT\n", x , y);
-  fprintf(output,"%i %i LT\n", x1 , y);
-  fprintf(output, "%i %i LT\n", x1 , y2 );
-  fprintf(output, "ELP\n");
-  fprintf(output, "GR\n");
+  print("GS\nBP\n%i %i MT\n%i %i LT\n%i %i LT\nELP\nGR\n", x, y, x1, y, x1, y2);
 }
 
 void Fl_PostScript_Graphics_Driver::xyline(int x, int y, int x1){
-  fprintf(output, "GS\n");
-  fprintf(output,"BP\n");
-  fprintf(output, "%i %i MT\n", x , y);
-  fprintf(output, "%i %i LT\n", x1 , y );
-  fprintf(output, "ELP\n");
-  
-  fprintf(output, "GR\n");
+  print("GS\nBP\n%i %i MT\n%i %i LT\nELP\nGR\n", x, y, x1, y);
 }
 
 void Fl_PostScript_Graphics_Driver::yxline(int x, int y, int y1, int x2, int y3){
-  fprintf(output, "GS\n");
-  
-  fprintf(output,"BP\n");
-  fprintf(output,"%i %i MT\n", x , y);
-  fprintf(output, "%i %i LT\n", x , y1 );
-  fprintf(output, "%i %i LT\n", x2 , y1 );
-  fprintf(output , "%i %i LT\n", x2 , y3);
-  fprintf(output, "ELP\n");
-  fprintf(output, "GR\n");
+  print("GS\nBP\n%i %i MT\n%i %i LT\n%i %i LT\n%i %i LT\nELP\nGR\n", x, y, x, y1, x2, y1, x2, y3);
 }
 
 void Fl_PostScript_Graphics_Driver::yxline(int x, int y, int y1, int x2){
-  fprintf(output, "GS\n");
-  fprintf(output,"BP\n");
-  fprintf(output, "%i %i MT\n", x , y);
-  fprintf(output, "%i %i LT\n", x , y1);
-  fprintf(output, "%i %i LT\n", x2 , y1);
-  fprintf(output, "ELP\n");
-  fprintf(output, "GR\n");
+  print("GS\nBP\n%i %i MT\n%i %i LT\n%i %i LT\nELP\nGR\n", x, y, x, y1, x2, y1);
 }
 
 void Fl_PostScript_Graphics_Driver::yxline(int x, int y, int y1){
-  fprintf(output, "GS\n");
-  fprintf(output,"BP\n");
-  fprintf(output, "%i %i MT\n", x , y);
-  fprintf(output, "%i %i LT\n", x , y1);
-  fprintf(output, "ELP\n");
-  fprintf(output, "GR\n");
+  print("GS\nBP\n%i %i MT\n%i %i LT\nELP\nGR\n", x, y, x, y1);
 }
 
 void Fl_PostScript_Graphics_Driver::loop(int x0, int y0, int x1, int y1, int x2, int y2) {
-  fprintf(output, "GS\n");
-  fprintf(output,"BP\n");
-  fprintf(output, "%i %i MT\n", x0 , y0);
-  fprintf(output, "%i %i LT\n", x1 , y1);
-  fprintf(output, "%i %i LT\n", x2 , y2);
-  fprintf(output, "ECP\n");
-  fprintf(output, "GR\n");
+  print("GS\nBP\n%i %i MT\n%i %i LT\n%i %i LT\nECP\nGR\n", x0, y0, x1, y1, x2, y2);
 }
 
 void Fl_PostScript_Graphics_Driver::loop(int x0, int y0, int x1, int y1, int x2, int y2, int x3, int y3) {
-  fprintf(output, "GS\n");
-  fprintf(output,"BP\n");
-  fprintf(output, "%i %i MT\n", x0 , y0);
-  fprintf(output, "%i %i LT\n", x1 , y1);
-  fprintf(output, "%i %i LT\n", x2 , y2);
-  fprintf(output, "%i %i LT\n", x3 , y3);
-  fprintf(output, "ECP\n");
-  fprintf(output, "GR\n");
+  print("GS\nBP\n%i %i MT\n%i %i LT\n%i %i LT\n%i %i LT\nECP\nGR\n", x0, y0, x1, y1, x2, y2, x3, y3);
 }
 
 void Fl_PostScript_Graphics_Driver::polygon(int x0, int y0, int x1, int y1, int x2, int y2) {
-  fprintf(output, "GS\n");
-  fprintf(output,"BP\n");
-  fprintf(output, "%i %i MT\n", x0 , y0);
-  fprintf(output,"%i %i LT\n", x1 , y1);
-  fprintf(output, "%i %i LT\n", x2 , y2);
-  fprintf(output, "EFP\n");
-  fprintf(output, "GR\n");
+  print("GS\nBP\n%i %i MT\n%i %i LT\n%i %i LT\nEFP\nGR\n", x0, y0, x1, y1, x2, y2);
 }
 
 void Fl_PostScript_Graphics_Driver::polygon(int x0, int y0, int x1, int y1, int x2, int y2, int x3, int y3) {
-  fprintf(output, "GS\n");
-  fprintf(output,"BP\n");
-  fprintf(output, "%i %i MT\n", x0 , y0 );
-  fprintf(output, "%i %i LT\n", x1 , y1 );
-  fprintf(output, "%i %i LT\n", x2 , y2 );
-  fprintf(output, "%i %i LT\n", x3 , y3 );
-  
-  fprintf(output, "EFP\n");
-  fprintf(output, "GR\n");
+  print("GS\nBP\n%i %i MT\n%i %i LT\n%i %i LT\n%i %i LT\nEFP\nGR\n", x0, y0, x1, y1, x2, y2, x3, y3);
 }
 
 void Fl_PostScript_Graphics_Driver::point(int x, int y){
@@ -839,50 +958,56 @@ void Fl_PostScript_Graphics_Driver::line_style(int style, int width, char* dashe
     
   }else
     linedash_[0]=0;
+  if (line_level_ >= 0 && ps_linewidth_ == width && ps_linestyle_ == style && !strcmp(ps_linedash_, linedash_))
+    return; // the output already uses this line style
+  ps_linewidth_ = width;
+  ps_linestyle_ = style;
+  strcpy(ps_linedash_, linedash_);
+  line_level_ = gsave_level_;
   char width0 = 0;
   if(!width){
     width=1; //for screen drawing compatibility
     width0=1;
   }
   
-  fprintf(output, "%i setlinewidth\n", width);
+  print("%i setlinewidth\n", width);
   
   if(!style && (!dashes || !(*dashes)) && width0) //system lines
     style = FL_CAP_SQUARE;
   
   int cap = (style &0xf00) >> 8;
   if(cap) cap--;
-  fprintf(output,"%i setlinecap\n", cap);
+  print("%i setlinecap\n", cap);
   
   int join = (style & 0xf000) >> 12;
   
   if(join) join--;
-  fprintf(output,"%i setlinejoin\n", join);
+  print("%i setlinejoin\n", join);
   
   
-  fprintf(output, "[");
+  put("[");
   if(dashes && *dashes){
     while(*dashes){
-      fprintf(output, "%i ", *dashes);
+      print("%i ", *dashes);
       dashes++;
     }
   }else{
     if(style & 0x200){ // round and square caps, dash length need to be adjusted
       const double *dt = dashes_cap[style & 0xff];
       while (*dt >= 0){
-        clocale_printf("%g ",width * (*dt));
+        print("%g ",width * (*dt));
         dt++;
       }
     }else{
       
       const int *ds = dashes_flat[style & 0xff];
       while (*ds >= 0){
-	fprintf(output, "%i ",width * (*ds));
+	print("%i ",width * (*ds));
         ds++;
       }
     }
   }
-  fprintf(output, "] 0 setdash\n");
+  put("] 0 setdash\n");
 }
 
 static const char *_fontNames[] = {
@@ -911,9 +1036,13 @@ void Fl_PostScript_Graphics_Driver::font(int f, int s) {
   Fl_Font_Descriptor *desc = driver.font_descriptor();
   this->font_descriptor(desc);
   if (f < FL_FREE_FONT) {
-    fprintf(output, "/%s SF\n" , _fontNames[f]);
+    if (font_level_ >= 0 && ps_font_ == f && ps_size_ == s) return;
+    ps_font_ = f;
+    ps_size_ = s;
+    font_level_ = gsave_level_;
+    print("/%s SF\n" , _fontNames[f]);
     float ps_size = driver.scale_font_for_PostScript(desc, s);
-    clocale_printf("%.1f FS\n", ps_size);
+    print("%.1f FS\n", ps_size);
   }
 }
 
@@ -946,23 +1075,28 @@ void Fl_PostScript_Graphics_Driver::color(Fl_Color c) {
 void Fl_PostScript_Graphics_Driver::color(unsigned char r, unsigned char g, unsigned char b) {
   Fl_Graphics_Driver::color( fl_rgb_color(r, g, b) );
   cr_ = r; cg_ = g; cb_ = b;
+  if (color_level_ >= 0 && ps_color_ == Fl_Graphics_Driver::color()) return;
+  ps_color_ = Fl_Graphics_Driver::color();
+  color_level_ = gsave_level_;
   if (r == g && g == b) {
     double gray = r/255.0;
-    clocale_printf("%g GL\n", gray);
+    print("%g GL\n", gray);
   } else {
     double fr, fg, fb;
     fr = r/255.0;
     fg = g/255.0;
     fb = b/255.0;
-    clocale_printf("%g %g %g SRGB\n", fr , fg , fb);
+    print("%g %g %g SRGB\n", fr , fg , fb);
   }
 }
 
 void Fl_PostScript_Graphics_Driver::draw(int angle, const char *str, int n, int x, int y)
 {
-  fprintf(output, "GS %d %d translate %d rotate\n", x, y, - angle);
+  print("GS %d %d translate %d rotate\n", x, y, - angle);
+  state_saved();
   this->transformed_draw(str, n, 0, 0);
-  fprintf(output, "GR\n");
+  put("GR\n");
+  state_restored();
 }
 
 
@@ -1034,18 +1168,15 @@ void Fl_PostScript_Graphics_Driver::transformed_draw_extra(const char* str, int
   delete[] img;
   // write the string image to PostScript as a scaled bitmask
   scale = w2 / float(w);
-  clocale_printf("%g %g %g %g %d %d MI\n", x, y - h*0.77/scale, w2/scale, h/scale, w2, h);
+  print("%g %g %g %g %d %d MI\n", x, y - h*0.77/scale, w2/scale, h/scale, w2, h);
   uchar *di;
   int wmask = (w2+7)/8;
-  void *rle85 = prepare_rle85();
+  void *big = prepare_image85();
   for (int j = h - 1; j >= 0; j--){
     di = mask + j * wmask;
-    for (int i = 0; i < wmask; i++){
-      write_rle85(*di, rle85);
-      di++;
-    }
+    write_image85(big, di, wmask);
   }
-  close_rle85(rle85); fputc('\n', output);
+  close_image85(big); put("\n");
   delete[] mask;
 }
 
@@ -1082,7 +1213,7 @@ void Fl_PostScript_Graphics_Driver::transformed_draw(const char* str, int n, dou
     transformed_draw_extra(str, n, x, y, w, false);
     return;
     }
-  fprintf(output, "%d <~", w);
+  print("%d <~", w);
   void *data = prepare85();
   // transforms UTF8 encoding to our custom PostScript encoding as follows:
   // extract each unicode character
@@ -1104,7 +1235,7 @@ void Fl_PostScript_Graphics_Driver::transformed_draw(const char* str, int n, dou
       utf = code;
       }
     else { // unhandled character: draw all string as bitmap image
-      fprintf(output, "~> pop pop\n"); // close and ignore the opened hex string
+      put("~> pop pop\n"); // close and ignore the opened hex string
       transformed_draw_extra(str, n, x, y, w, false);
       return;
     }
@@ -1112,7 +1243,7 @@ void Fl_PostScript_Graphics_Driver::transformed_draw(const char* str, int n, dou
     uchar c[2]; c[1] = utf & 0xFF; c[0] = (utf & 0xFF00)>>8; write85(data, c, 2);
   }
   close85(data);
-  clocale_printf(" %g %g show_pos_width\n", x, y);
+  print(" %g %g show_pos_width\n", x, y);
 }
 
 void Fl_PostScript_Graphics_Driver::rtl_draw(const char* str, int n, int x, int y) {
@@ -1121,86 +1252,92 @@ void Fl_PostScript_Graphics_Driver::rtl_draw(const char* str, int n, int x, int
 }
 
 void Fl_PostScript_Graphics_Driver::concat(){
-  clocale_printf("[%g %g %g %g %g %g] CT\n", fl_matrix->a , fl_matrix->b , fl_matrix->c , fl_matrix->d , fl_matrix->x , fl_matrix->y);
+  print("[%g %g %g %g %g %g] CT\n", fl_matrix->a , fl_matrix->b , fl_matrix->c , fl_matrix->d , fl_matrix->x , fl_matrix->y);
 }
 
 void Fl_PostScript_Graphics_Driver::reconcat(){
-  clocale_printf("[%g %g %g %g %g %g] RCT\n" , fl_matrix->a , fl_matrix->b , fl_matrix->c , fl_matrix->d , fl_matrix->x , fl_matrix->y);
+  print("[%g %g %g %g %g %g] RCT\n" , fl_matrix->a , fl_matrix->b , fl_matrix->c , fl_matrix->d , fl_matrix->x , fl_matrix->y);
 }
 
 /////////////////  transformed (double) drawings ////////////////////////////////
 
 
 void Fl_PostScript_Graphics_Driver::begin_points(){
-  fprintf(output, "GS\n");
+  put("GS\n");
+  state_saved();
   concat();
   
-  fprintf(output, "BP\n");
+  put("BP\n");
   gap_=1;
   shape_=POINTS;
 }
 
 void Fl_PostScript_Graphics_Driver::begin_line(){
-  fprintf(output, "GS\n");
+  put("GS\n");
+  state_saved();
   concat();
-  fprintf(output, "BP\n");
+  put("BP\n");
   gap_=1;
   shape_=LINE;
 }
 
 void Fl_PostScript_Graphics_Driver::begin_loop(){
-  fprintf(output, "GS\n");
+  put("GS\n");
+  state_saved();
   concat();
-  fprintf(output, "BP\n");
+  put("BP\n");
   gap_=1;
   shape_=LOOP;
 }
 
 void Fl_PostScript_Graphics_Driver::begin_polygon(){
-  fprintf(output, "GS\n");
+  put("GS\n");
+  state_saved();
   concat();
-  fprintf(output, "BP\n");
+  put("BP\n");
   gap_=1;
   shape_=POLYGON;
 }
 
 void Fl_PostScript_Graphics_Driver::vertex(double x, double y){
   if(shape_==POINTS){
-    clocale_printf("%g %g MT\n", x , y);
+    print("%g %g MT\n", x , y);
     gap_=1;
     return;
   }
   if(gap_){
-    clocale_printf("%g %g MT\n", x , y);
+    print("%g %g MT\n", x , y);
     gap_=0;
   }else
-    clocale_printf("%g %g LT\n", x , y);
+    print("%g %g LT\n", x , y);
 }
 
 void Fl_PostScript_Graphics_Driver::curve(double x, double y, double x1, double y1, double x2, double y2, double x3, double y3){
   if(shape_==NONE) return;
   if(gap_)
-    clocale_printf("%g %g MT\n", x , y);
+    print("%g %g MT\n", x , y);
   else
-    clocale_printf("%g %g LT\n", x , y);
+    print("%g %g LT\n", x , y);
   gap_=0;
   
-  clocale_printf("%g %g %g %g %g %g curveto \n", x1 , y1 , x2 , y2 , x3 , y3);
+  print("%g %g %g %g %g %g curveto \n", x1 , y1 , x2 , y2 , x3 , y3);
 }
 
 
 void Fl_PostScript_Graphics_Driver::circle(double x, double y, double r){
   if(shape_==NONE){
-    fprintf(output, "GS\n");
+    put("GS\n");
+    state_saved();
     concat();
-    //    fprintf(output, "BP\n");
-    clocale_printf("%g %g %g 0 360 arc\n", x , y , r);
+    //    put("BP\n");
+    print("%g %g %g 0 360 arc\n", x , y , r);
     reconcat();
-    //    fprintf(output, "ELP\n");
-    fprintf(output, "GR\n");
+    //    put("ELP\n");
+    put("GR\n");
+    state_restored();
   }else
     
-    clocale_printf("%g %g %g 0 360 arc\n", x , y , r);
+    print("%g %g %g 0 360 arc\n", x , y , r);
   
 }
 
@@ -1208,63 +1345,70 @@ void Fl_PostScript_Graphics_Driver::arc(double x, double y, double r, double sta
   if(shape_==NONE) return;
   gap_=0;
   if(start>a)
-    clocale_printf("%g %g %g %g %g arc\n", x , y , r , -start, -a);
+    print("%g %g %g %g %g arc\n", x , y , r , -start, -a);
   else
-    clocale_printf("%g %g %g %g %g arcn\n", x , y , r , -start, -a);
+    print("%g %g %g %g %g arcn\n", x , y , r , -start, -a);
   
 }
 
 void Fl_PostScript_Graphics_Driver::arc(int x, int y, int w, int h, double a1, double a2) {
   if (w <= 1 || h <= 1) return;
-  fprintf(output, "GS\n");
-  //fprintf(output, "BP\n");
+  put("GS\n");
+  state_saved();
+  //put("BP\n");
   begin_line();
-  clocale_printf("%g %g TR\n", x + w/2.0 -0.5 , y + h/2.0 - 0.5);
-  clocale_printf("%g %g SC\n", (w-1)/2.0 , (h-1)/2.0 );
+  print("%g %g TR\n", x + w/2.0 -0.5 , y + h/2.0 - 0.5);
+  print("%g %g SC\n", (w-1)/2.0 , (h-1)/2.0 );
   arc(0,0,1,a2,a1);
-  //  fprintf(output, "0 0 1 %g %g arc\n" , -a1 , -a2);
-  clocale_printf("%g %g SC\n", 2.0/(w-1) , 2.0/(h-1) );
-  clocale_printf("%g %g TR\n", -x - w/2.0 +0.5 , -y - h/2.0 +0.5);
+  //  print("0 0 1 %g %g arc\n" , -a1 , -a2);
+  print("%g %g SC\n", 2.0/(w-1) , 2.0/(h-1) );
+  print("%g %g TR\n", -x - w/2.0 +0.5 , -y - h/2.0 +0.5);
   end_line();
   
-  //  fprintf(output, "%g setlinewidth\n",  2/sqrt(w*h));
-  //  fprintf(output, "ELP\n");
-  //  fprintf(output, 2.0/w , 2.0/w , " SC\n";
-  //  fprintf(output, (-x - w/2.0) , (-y - h/2)  , " TR\n";
-  fprintf(output, "GR\n");
+  //  print("%g setlinewidth\n",  2/sqrt(w*h));
+  //  put("ELP\n");
+  //  print(2.0/w , 2.0/w , " SC\n";
+  //  print((-x - w/2.0) , (-y - h/2)  , " TR\n";
+  put("GR\n");
+  state_restored();
 }
 
 void Fl_PostScript_Graphics_Driver::pie(int x, int y, int w, int h, double a1, double a2) {
-  fprintf(output, "GS\n");
+  put("GS\n");
+  state_saved();
   begin_polygon();
-  clocale_printf("%g %g TR\n", x + w/2.0 -0.5 , y + h/2.0 - 0.5);
-  clocale_printf("%g %g SC\n", (w-1)/2.0 , (h-1)/2.0 );
+  print("%g %g TR\n", x + w/2.0 -0.5 , y + h/2.0 - 0.5);
+  print("%g %g SC\n", (w-1)/2.0 , (h-1)/2.0 );
   vertex(0,0);
   arc(0.0,0.0, 1, a2, a1);
   end_polygon();
-  fprintf(output, "GR\n");
+  put("GR\n");
+  state_restored();
 }
 
 void Fl_PostScript_Graphics_Driver::end_points(){
   gap_=1;
   reconcat();
-  fprintf(output, "ELP\n"); //??
-  fprintf(output, "GR\n");
+  put("ELP\n"); //??
+  put("GR\n");
+  state_restored();
   shape_=NONE;
 }
 
 void Fl_PostScript_Graphics_Driver::end_line(){
   gap_=1;
   reconcat();
-  fprintf(output, "ELP\n");
-  fprintf(output, "GR\n");
+  put("ELP\n");
+  put("GR\n");
+  state_restored();
   shape_=NONE;
 }
 void Fl_PostScript_Graphics_Driver::end_loop(){
   gap_=1;
   reconcat();
-  fprintf(output, "ECP\n");
-  fprintf(output, "GR\n");
+  put("ECP\n");
+  put("GR\n");
+  state_restored();
   shape_=NONE;
 }
 
@@ -1272,33 +1416,47 @@ void Fl_PostScript_Graphics_Driver::end_polygon(){
   
   gap_=1;
   reconcat();
-  fprintf(output, "EFP\n");
-  fprintf(output, "GR\n");
+  put("EFP\n");
+  put("GR\n");
+  state_restored();
   shape_=NONE;
 }
 
 void Fl_PostScript_Graphics_Driver::transformed_vertex(double x, double y){
   reconcat();
   if(gap_){
-    clocale_printf("%g %g MT\n", x , y);
+    print("%g %g MT\n", x , y);
     gap_=0;
   }else
-    clocale_printf("%g %g LT\n", x , y);
+    print("%g %g LT\n", x , y);
   concat();
 }
 
 /////////////////////////////   Clipping /////////////////////////////////////////////
 
+// makes the output clip to x,y,w,h, or not clip if w < 0, unless it already does
+void Fl_PostScript_Graphics_Driver::output_clip(int x, int y, int w, int h) {
+  if (clip_level_ >= 0 && ps_clip_[0] == x && ps_clip_[1] == y && ps_clip_[2] == w && ps_clip_[3] == h)
+    return;
+  put("CR\nCS\n");
+  if(lang_level_<3) { // CR and CS restore and save the whole graphics state
+    state_restored();
+    state_saved();
+    recover();
+  }
+  if (w >= 0)
+    print("%g %g %i %i CL\n", x - 0.5, y - 0.5, w, h);
+  // uh, -0.5 is to match screen clipping, for floats there should be something beter
+  ps_clip_[0] = x; ps_clip_[1] = y; ps_clip_[2] = w; ps_clip_[3] = h;
+  clip_level_ = gsave_level_;
+}
+
 void Fl_PostScript_Graphics_Driver::push_clip(int x, int y, int w, int h) {
   Clip * c=new Clip();
   clip_box(x,y,w,h,c->x,c->y,c->w,c->h);
   c->prev=clip_;
   clip_=c;
-  fprintf(output, "CR\nCS\n");
-  if(lang_level_<3)
-    recover();
-  clocale_printf("%g %g %i %i CL\n", clip_->x-0.5 , clip_->y-0.5 , clip_->w  , clip_->h);
-  
+  output_clip(clip_->x, clip_->y, clip_->w, clip_->h);
 }
 
 void Fl_PostScript_Graphics_Driver::push_no_clip() {
@@ -1306,9 +1464,7 @@ void Fl_PostScript_Graphics_Driver::push_no_clip() {
   c->prev=clip_;
   clip_=c;
   clip_->x = clip_->y = clip_->w = clip_->h = -1;
-  fprintf(output, "CR\nCS\n");
-  if(lang_level_<3)
-    recover();
+  output_clip(-1, -1, -1, -1);
 }
 
 void Fl_PostScript_Graphics_Driver::pop_clip() {
@@ -1316,12 +1472,10 @@ void Fl_PostScript_Graphics_Driver::pop_clip() {
   Clip * c=clip_;
   clip_=clip_->prev;
   delete c;
-  fprintf(output, "CR\nCS\n");
   if(clip_ && clip_->w >0)
-    clocale_printf("%g %g %i %i CL\n", clip_->x - 0.5, clip_->y - 0.5, clip_->w  , clip_->h);
-  // uh, -0.5 is to match screen clipping, for floats there should be something beter
-  if(lang_level_<3)
-    recover();
+    output_clip(clip_->x, clip_->y, clip_->w, clip_->h);
+  else
+    output_clip(-1, -1, -1, -1);
 }
 
 int Fl_PostScript_Graphics_Driver::clip_box(int x, int y, int w, int h, int &X, int &Y, int &W, int &H){
@@ -1397,8 +1551,10 @@ void Fl_PostScript_File_Device::origin(int x, int y)
   x_offset = x;
   y_offset = y;
   Fl_PostScript_Graphics_Driver *ps = driver();
-  ps->clocale_printf("GR GR GS %d %d TR  %f %f SC %d %d TR %f rotate GS\n",
+  ps->print("GR GR GS %d %d TR  %f %f SC %d %d TR %f rotate GS\n",
 	  ps->left_margin, ps->top_margin, ps->scale_x, ps->scale_y, x, y, ps->angle);
+  ps->state_restored(2);
+  ps->state_saved(2);
 }
 
 void Fl_PostScript_File_Device::scale (float s_x, float s_y)
@@ -1407,26 +1563,32 @@ void Fl_PostScript_File_Device::scale (float s_x, float s_y)
   Fl_PostScript_Graphics_Driver *ps = driver();
   ps->scale_x = s_x;
   ps->scale_y = s_y;
-  ps->clocale_printf("GR GR GS %d %d TR  %f %f SC %f rotate GS\n",
+  ps->print("GR GR GS %d %d TR  %f %f SC %f rotate GS\n",
 	  ps->left_margin, ps->top_margin, ps->scale_x, ps->scale_y, ps->angle);
+  ps->state_restored(2);
+  ps->state_saved(2);
 }
 
 void Fl_PostScript_File_Device::rotate (float rot_angle)
 {
   Fl_PostScript_Graphics_Driver *ps = driver();
   ps->angle = - rot_angle;
-  ps->clocale_printf("GR GR GS %d %d TR  %f %f SC %d %d TR %f rotate GS\n",
+  ps->print("GR GR GS %d %d TR  %f %f SC %d %d TR %f rotate GS\n",
 	  ps->left_margin, ps->top_margin, ps->scale_x, ps->scale_y, x_offset, y_offset, ps->angle);
+  ps->state_restored(2);
+  ps->state_saved(2);
 }
 
 void Fl_PostScript_File_Device::translate(int x, int y)
 {
-  fprintf(driver()->output, "GS %d %d translate GS\n", x, y);
+  driver()->print("GS %d %d translate GS\n", x, y);
+  driver()->state_saved(2);
 }
 
 void Fl_PostScript_File_Device::untranslate(void)
 {
-  fprintf(driver()->output, "GR GR\n");
+  driver()->put("GR GR\n");
+  driver()->state_restored(2);
 }
 
 int Fl_PostScript_File_Device::start_page (void)
@@ -1437,7 +1599,9 @@ int Fl_PostScript_File_Device::start_page (void)
   y_offset = 0;
   ps->scale_x = ps->scale_y = 1.;
   ps->angle = 0;
-  fprintf(ps->output, "GR GR GS %d %d translate GS\n", ps->left_margin, ps->top_margin);
+  ps->print("GR GR GS %d %d translate GS\n", ps->left_margin, ps->top_margin);
+  ps->state_restored(2);
+  ps->state_saved(2);
   return 0;
 }
 
@@ -1446,20 +1610,31 @@ int Fl_PostScript_File_Device::end_page (void)
   return 0;
 }
 
+void Fl_PostScript_File_Device::language_level(int level)
+{
+  if (level >= 2 && level <= 3) driver()->lang_level_ = level;
+}
+
+int Fl_PostScript_File_Device::language_level()
+{
+  return driver()->lang_level_;
+}
+
 void Fl_PostScript_File_Device::end_job (void)
 // finishes PostScript & closes file
 {
   Fl_PostScript_Graphics_Driver *ps = driver();
   if (ps->nPages) {  // for eps nPages is 0 so it is fine ....
-    fprintf(ps->output, "CR\nGR\nGR\nGR\nSP\n restore\n");
+    ps->put("CR\nGR\nGR\nGR\nSP\n restore\n");
     if (!ps->pages_){
-      fprintf(ps->output, "%%%%Trailer\n");
-      fprintf(ps->output, "%%%%Pages: %i\n" , ps->nPages);
+      ps->print("%%%%Trailer\n");
+      ps->print("%%%%Pages: %i\n" , ps->nPages);
     };
   } else
-    fprintf(ps->output, "GR\n restore\n");
-  fputs("%%EOF",ps->output);
+    ps->put("GR\n restore\n");
+  ps->put("%%EOF");
   ps->reset();
+  ps->flush();
   fflush(ps->output);
   if(ferror(ps->output)) {
     fl_alert ("Error during PostScript data output.");
@@ -20,6 +20,7 @@
 #if !defined(FL_DOXYGEN) && !defined(FL_NO_PRINT_SUPPORT)
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <math.h>
 #include <string.h>
 
@@ -27,6 +28,9 @@
 #include <FL/Fl.H>
 #include <FL/Fl_Pixmap.H>
 #include <FL/Fl_Bitmap.H>
+#if HAVE_LIBZ
+#  include <zlib.h>
+#endif
 
 
 //
@@ -37,21 +41,56 @@ struct struct85 {
   uchar bytes4[4]; // holds up to 4 input bytes
   int l4;          // # of unencoded input bytes
   int blocks;      // counter to insert newlines after 80 output characters
-  uchar chars5[5]; // holds 5 output characters
+  Fl_PostScript_Graphics_Driver *ps; // receives the output characters, or NULL to keep them in text
+  char *text;      // output characters kept in memory
+  size_t ltext, atext;
+  int chunk;       // if not 0, # of input bytes after which a new <~ ~> string begins
+  int lchunk;      // # of input bytes in the current string
+  int lout;        // # of output characters in out
+  char out[4096];  // output characters not yet written
 };
 
-
-void *Fl_PostScript_Graphics_Driver::prepare85() // prepare to produce ASCII85-encoded output
+static struct85 *new85(Fl_PostScript_Graphics_Driver *ps)
 {
   struct85 *big = new struct85;
   big->l4 = 0;
   big->blocks = 0;
+  big->ps = ps;
+  big->text = 0;
+  big->ltext = big->atext = 0;
+  big->chunk = big->lchunk = 0;
+  big->lout = 0;
   return big;
 }
 
+// writes the buffered output characters to the file or to the text
+static void flush85(struct85 *big)
+{
+  if (big->ps) {
+    big->ps->put(big->out, big->lout);
+  } else {
+    if (big->ltext + big->lout > big->atext) {
+      big->atext = 2 * big->atext + sizeof(big->out);
+      big->text = (char*)realloc(big->text, big->atext);
+    }
+    memcpy(big->text + big->ltext, big->out, big->lout);
+    big->ltext += big->lout;
+  }
+  big->lout = 0;
+}
+
+// outputs a short string as is
+static void text85(struct85 *big, const char *s)
+{
+  int l = (int)strlen(s);
+  if (big->lout + l > (int)sizeof(big->out)) flush85(big);
+  memcpy(big->out + big->lout, s, l);
+  big->lout += l;
+}
+
 // ASCII85-encodes 4 input bytes from bytes4 into chars5 array
 // returns # of output chars
-static int convert85(const uchar *bytes4, uchar *chars5)
+static int convert85(const uchar *bytes4, char *chars5)
 {
   if (bytes4[0] == 0 && bytes4[1] == 0 && bytes4[2] == 0 && bytes4[3] == 0) {
     chars5[0] = 'z';
@@ -69,40 +108,68 @@ static int convert85(const uchar *bytes4, uchar *chars5)
   return 5;
 }
 
-
-void Fl_PostScript_Graphics_Driver::write85(void *data, const uchar *p, int len) // sends len input bytes for ASCII85 encoding
+// sends len input bytes for ASCII85 encoding
+static void put85(struct85 *big, const uchar *p, int len)
 {
-  struct85 *big = (struct85 *)data;
   const uchar *last = p + len;
   while (p < last) {
-    int c = 4 - big->l4;
-    if (last-p < c) c = last-p;
-    memcpy(big->bytes4 + big->l4, p, c);
-    p += c;
-    big->l4 += c;
-    if (big->l4 == 4) {
-      c = convert85(big->bytes4, big->chars5);
-      fwrite(big->chars5, c, 1, output);
+    if (big->l4 == 0 && last - p >= 4) { // encode directly from the input
+      big->lout += convert85(p, big->out + big->lout);
+      p += 4;
+    } else {
+      int c = 4 - big->l4;
+      if (last-p < c) c = (int)(last-p);
+      memcpy(big->bytes4 + big->l4, p, c);
+      p += c;
+      big->l4 += c;
+      if (big->l4 < 4) break;
+      big->lout += convert85(big->bytes4, big->out + big->lout);
       big->l4 = 0;
-      if (++big->blocks >= 16) { fputc('\n', output); big->blocks = 0; }
     }
+    if (++big->blocks >= 16) { big->out[big->lout++] = '\n'; big->blocks = 0; }
+    if (big->chunk && (big->lchunk += 4) >= big->chunk) { // keep strings below 64 KB
+      text85(big, "~>\n<~");
+      big->lchunk = 0;
+      big->blocks = 0;
+    }
+    if (big->lout > (int)sizeof(big->out) - 8) flush85(big);
   }
 }
 
-
-void Fl_PostScript_Graphics_Driver::close85(void *data)  // stops ASCII85-encoding after processing remaining unencoded input bytes, if any
+// stops ASCII85-encoding after processing remaining unencoded input bytes, if any
+static void end85(struct85 *big)
 {
-  struct85 *big = (struct85 *)data;
   int l;
   if (big->l4) { // # of remaining unencoded input bytes
+    char chars5[5];
     l = big->l4;
     while (l < 4) big->bytes4[l++] = 0; // complete them with 0s
-    l = convert85(big->bytes4, big->chars5); // encode them
-    if (l == 1) memset(big->chars5, '!', 5);
-    fwrite(big->chars5, big->l4 + 1, 1, output);
+    l = convert85(big->bytes4, chars5); // encode them
+    if (l == 1) memset(chars5, '!', 5);
+    chars5[big->l4 + 1] = 0;
+    text85(big, chars5);
   }
-  fputs("~>", output); // write EOD mark
-  delete big;
+  text85(big, "~>"); // write EOD mark
+  flush85(big);
+}
+
+
+void *Fl_PostScript_Graphics_Driver::prepare85() // prepare to produce ASCII85-encoded output
+{
+  return new85(this);
+}
+
+
+void Fl_PostScript_Graphics_Driver::write85(void *data, const uchar *p, int len) // sends len input bytes for ASCII85 encoding
+{
+  put85((struct85 *)data, p, len);
+}
+
+
+void Fl_PostScript_Graphics_Driver::close85(void *data)  // stops ASCII85-encoding after processing remaining unencoded input bytes, if any
+{
+  end85((struct85 *)data);
+  delete (struct85 *)data;
 }
 
 //
@@ -111,7 +178,9 @@ void Fl_PostScript_Graphics_Driver::close85(void *data)  // stops ASCII85-encodi
 
 //
 // Implementation of the /RunLengthEncode + /ASCII85Encode PostScript filter
-// as described in "PostScript LANGUAGE REFERENCE third edition" p. 142
+// as described in "PostScript LANGUAGE REFERENCE third edition" p. 142,
+// and of the /FlateEncode + /ASCII85Encode filter that replaces it with
+// PostScript level 3.
 //
 
 struct struct_rle85 {
@@ -121,28 +190,19 @@ struct struct_rle85 {
   int run_length; // current length of run
 };
 
-void *Fl_PostScript_Graphics_Driver::prepare_rle85() // prepare to produce RLE+ASCII85-encoded output
+// sends one input byte to RLE+ASCII85 encoding
+static inline void write_rle85(struct_rle85 *rle, uchar b)
 {
-  struct_rle85 *rle = new struct_rle85;
-  rle->count = 0;
-  rle->run_length = 0;
-  rle->data85 = (struct85*)prepare85();
-  return rle;
-}
-
-
-void Fl_PostScript_Graphics_Driver::write_rle85(uchar b, void *data) // sends one input byte to RLE+ASCII85 encoding
-{
-  struct_rle85 *rle = (struct_rle85 *)data;
   uchar c;
   if (rle->run_length > 0) { // if within a run
     if (b == rle->buffer[0] &&  rle->run_length < 128) { // the run can be extended
       rle->run_length++;
       return;
     } else { // output the run
-      c = (uchar)(257 - rle->run_length);
-      write85(rle->data85, &c, 1); // the run-length info
-      write85(rle->data85, rle->buffer, 1); // the byte of the run
+      uchar run[2];
+      run[0] = (uchar)(257 - rle->run_length); // the run-length info
+      run[1] = rle->buffer[0]; // the byte of the run
+      put85(rle->data85, run, 2);
       rle->run_length = 0;
     }
   }
@@ -150,8 +210,8 @@ void Fl_PostScript_Graphics_Driver::write_rle85(uchar b, void *data) // sends on
     // about to begin a run
     if (rle->count > 2) { // there is non-run data before the run in the buffer
       c = (uchar)(rle->count-2 - 1);
-      write85(rle->data85, &c, 1); // length of non-run data
-      write85(rle->data85, rle->buffer, rle->count-2); // non-run data
+      put85(rle->data85, &c, 1); // length of non-run data
+      put85(rle->data85, rle->buffer, rle->count-2); // non-run data
     }
     rle->run_length = 3;
     rle->buffer[0] = b;
@@ -160,31 +220,124 @@ void Fl_PostScript_Graphics_Driver::write_rle85(uchar b, void *data) // sends on
   }
   if (rle->count >= 128) { // the non-run buffer is full, output it
     c = (uchar)(rle->count - 1);
-    write85(rle->data85, &c, 1); // length of non-run data
-    write85(rle->data85, rle->buffer, rle->count); // non-run data
+    put85(rle->data85, &c, 1); // length of non-run data
+    put85(rle->data85, rle->buffer, rle->count); // non-run data
     rle->count = 0;
   }
   rle->buffer[rle->count++] = b; // add byte to end of non-run buffer
 }
 
-
-void Fl_PostScript_Graphics_Driver::close_rle85(void *data) // stop doing RLE+ASCII85 encoding
+// stop doing RLE encoding
+static void close_rle85(struct_rle85 *rle)
 {
-  struct_rle85 *rle = (struct_rle85 *)data;
   uchar c;
   if (rle->run_length > 0) { // if within a run, output it
     c = (uchar)(257 - rle->run_length);
-    write85(rle->data85, &c, 1);
-    write85(rle->data85, rle->buffer, 1);
+    put85(rle->data85, &c, 1);
+    put85(rle->data85, rle->buffer, 1);
   } else if (rle->count) { // output the non-run buffer, if not empty
     c = (uchar)(rle->count - 1);
-    write85(rle->data85, &c, 1);
-    write85(rle->data85, rle->buffer, rle->count);
+    put85(rle->data85, &c, 1);
+    put85(rle->data85, rle->buffer, rle->count);
   }
   c = (uchar)128;
-  write85(rle->data85, &c, 1); // output EOD mark
-  close85(rle->data85); // close ASCII85 encoding process
-  delete rle;
+  put85(rle->data85, &c, 1); // output EOD mark
+}
+
+struct struct_image85 {
+  struct85 *data85;
+  struct_rle85 rle;
+#if HAVE_LIBZ
+  z_stream *flate;   // used instead of rle when not NULL
+  uchar zbuffer[4096];
+#endif
+};
+
+// prepares to encode image data, flate selects FlateEncode over RunLengthEncode
+static struct_image85 *image85_new(struct85 *data85, int flate)
+{
+  struct_image85 *img = new struct_image85;
+  img->data85 = data85;
+  img->rle.data85 = data85;
+  img->rle.count = 0;
+  img->rle.run_length = 0;
+#if HAVE_LIBZ
+  img->flate = 0;
+  if (flate) {
+    img->flate = new z_stream;
+    memset(img->flate, 0, sizeof(z_stream));
+    if (deflateInit(img->flate, Z_DEFAULT_COMPRESSION) != Z_OK) {
+      delete img->flate;
+      img->flate = 0;
+    }
+  }
+#endif
+  return img;
+}
+
+#if HAVE_LIBZ
+static void deflate85(struct_image85 *img, const uchar *p, int len, int flush)
+{
+  img->flate->next_in = (Bytef*)p;
+  img->flate->avail_in = len;
+  do {
+    img->flate->next_out = img->zbuffer;
+    img->flate->avail_out = sizeof(img->zbuffer);
+    deflate(img->flate, flush);
+    put85(img->data85, img->zbuffer, sizeof(img->zbuffer) - img->flate->avail_out);
+  } while (img->flate->avail_out == 0);
+}
+#endif
+
+static void image85_write(struct_image85 *img, const uchar *p, int len)
+{
+#if HAVE_LIBZ
+  if (img->flate) {
+    deflate85(img, p, len, Z_NO_FLUSH);
+    return;
+  }
+#endif
+  const uchar *last = p + len;
+  while (p < last) write_rle85(&img->rle, *p++);
+}
+
+// flushes the compressed data and closes ASCII85 encoding, the struct85 remains
+static void image85_close(struct_image85 *img)
+{
+#if HAVE_LIBZ
+  if (img->flate) {
+    deflate85(img, NULL, 0, Z_FINISH);
+    deflateEnd(img->flate);
+    delete img->flate;
+  } else
+#endif
+  close_rle85(&img->rle);
+  end85(img->data85);
+  delete img;
+}
+
+
+void *Fl_PostScript_Graphics_Driver::prepare_image85() // prepare to produce compressed and ASCII85-encoded output
+{
+#if HAVE_LIBZ
+  return image85_new(new85(this), lang_level_ >= 3);
+#else
+  return image85_new(new85(this), 0);
+#endif
+}
+
+
+void Fl_PostScript_Graphics_Driver::write_image85(void *data, const uchar *p, int len) // sends len input bytes
+{
+  image85_write((struct_image85 *)data, p, len);
+}
+
+
+void Fl_PostScript_Graphics_Driver::close_image85(void *data) // stop doing compression + ASCII85 encoding
+{
+  struct85 *big = ((struct_image85 *)data)->data85;
+  image85_close((struct_image85 *)data);
+  delete big;
 }
 
 //
@@ -347,6 +500,18 @@ static inline uchar swap_byte(const uchar b) {
   return (swapped[b & 0xF] << 4) | swapped[b >> 4];
 }
 
+// sends n mask bytes, each bitwise inverted
+static void write_mask85(struct_image85 *big, const uchar *mask, int n) {
+  uchar buffer[256];
+  while (n > 0) {
+    int l = n < (int)sizeof(buffer) ? n : (int)sizeof(buffer);
+    for (int i = 0; i < l; i++) buffer[i] = swap_byte(mask[i]);
+    image85_write(big, buffer, l);
+    mask += l;
+    n -= l;
+  }
+}
+
 
 struct callback_data {
   const uchar *data;
@@ -365,6 +530,80 @@ static void draw_image_cb(void *data, int x, int y, int w, uchar *buf) {
 }
 
 
+// Writes the PostScript command that draws an image, followed by its data
+// unless they come from a cached array. gray is 1 for draw_image_mono().
+static void image_command(Fl_PostScript_Graphics_Driver *ps, int ix, int iy, int iw, int ih, int gray) {
+  double x = ix, y = iy, w = iw, h = ih;
+  const char *interpol = ps->interpolate() ? "true" : "false";
+  const char *name = gray ? "G" : "C";
+  if (ps->lang_level_ > 1) {
+    if (ps->mask && ps->lang_level_ > 2) {
+      ps->print("%g %g %g %g %i %i %i %i %s %sIM\n", x , y+h , w , -h , iw , ih, ps->mx, ps->my, interpol, name);
+    }
+    else if (ps->mask && ps->lang_level_ == 2 && !gray) {
+      ps->print(" %g %g %g %g %d %d pixmap_plot\n", x, y, w, h, iw, ih);
+    }
+    else {
+      ps->print("%g %g %g %g %i %i %s %sII\n", x , y+h , w , -h , iw , ih, interpol, name);
+    }
+  } else {
+    ps->print("%g %g %g %g %i %i %sI", x , y+h , w , -h , iw , ih, name);
+  }
+}
+
+
+// Sends the rows of an image, from data or from call, preceded with PostScript level 3
+// by the rows of its mask. mix is 1 to blend pixels with the background according to their alpha.
+static void write_image_rows(Fl_PostScript_Graphics_Driver *ps, struct_image85 *big,
+                             const uchar *data, int LD, Fl_Draw_Image_Cb call, void *cb_data,
+                             int iw, int ih, int D, int gray, int mix) {
+  int ND = gray ? 1 : 3; // bytes per pixel in PostScript
+  uchar *rgbdata = call ? new uchar[iw*D] : NULL;
+  uchar *row = new uchar[iw*ND];
+  const uchar *curmask = ps->mask;
+  int mask_rows = (ps->mask && ps->lang_level_ > 2) ? ps->my/ih : 0; // for alpha pseudo-masking
+  int mask_bytes = (ps->mx+7)/8;
+  unsigned bg = (ps->bg_r + ps->bg_g + ps->bg_b)/3;
+  for (int j = 0; j < ih; j++) {
+    if (mask_rows) {  // InterleaveType 2 mask data
+      write_mask85(big, curmask, mask_rows * mask_bytes);
+      curmask += mask_rows * mask_bytes;
+    }
+    const uchar *curdata;
+    if (call) {
+      call(cb_data, 0, j, iw, rgbdata);
+      curdata = rgbdata;
+    } else {
+      curdata = data + j*LD;
+    }
+    if (D == ND && !mix) { // the pixels can be sent as they are
+      image85_write(big, curdata, iw*ND);
+      continue;
+    }
+    uchar *o = row;
+    for (int i = 0; i < iw; i++, curdata += D) {
+      if (mix) { // can do mixing using bg_* colors
+        unsigned int a2 = curdata[ND]; //must be int
+        unsigned int a = 255-a2;
+        if (gray) {
+          *o++ = (a2 * curdata[0] + bg * a)/255;
+        } else {
+          *o++ = (a2 * curdata[0] + ps->bg_r * a)/255;
+          *o++ = (a2 * curdata[1] + ps->bg_g * a)/255;
+          *o++ = (a2 * curdata[2] + ps->bg_b * a)/255;
+        }
+      } else {
+        *o++ = curdata[0];
+        if (!gray) { *o++ = curdata[1]; *o++ = curdata[2]; }
+      }
+    }
+    image85_write(big, row, iw*ND);
+  }
+  delete[] row;
+  delete[] rgbdata;
+}
+
+
 void Fl_PostScript_Graphics_Driver::draw_image(const uchar *data, int ix, int iy, int iw, int ih, int D, int LD) {
   if (D<3){ //mono
     draw_image_mono(data, ix, iy, iw, ih, D, LD);
@@ -375,6 +614,8 @@ void Fl_PostScript_Graphics_Driver::draw_image(const uchar *data, int ix, int iy
 
   if (!LD) LD = iw*D;
 
+  if (draw_cached_image(data, ix, iy, iw, ih, D, LD, 0)) return;
+
   cb_data.data = data;
   cb_data.D = D;
   cb_data.LD = LD;
@@ -383,188 +624,201 @@ void Fl_PostScript_Graphics_Driver::draw_image(const uchar *data, int ix, int iy
 }
 
 void Fl_PostScript_Graphics_Driver::draw_image(Fl_Draw_Image_Cb call, void *data, int ix, int iy, int iw, int ih, int D) {
-  double x = ix, y = iy, w = iw, h = ih;
+  put("save\n");
+  image_command(this, ix, iy, iw, ih, 0);
 
-  int level2_mask = 0;
-  fprintf(output,"save\n");
-  int i,j,k;
-  const char * interpol;
-  if (lang_level_ > 1) {
-    if (interpolate_) interpol="true";
-    else interpol="false";
-    if (mask && lang_level_ > 2) {
-      fprintf(output, "%g %g %g %g %i %i %i %i %s CIM\n", x , y+h , w , -h , iw , ih, mx, my, interpol);
-    }
-    else if (mask && lang_level_ == 2) {
-      level2_mask = 1; // use method for drawing masked color image with PostScript level 2
-      fprintf(output, " %g %g %g %g %d %d pixmap_plot\n", x, y, w, h, iw, ih);
-    }
-    else {
-      fprintf(output, "%g %g %g %g %i %i %s CII\n", x , y+h , w , -h , iw , ih, interpol);
-    }
-  } else {
-    fprintf(output , "%g %g %g %g %i %i CI", x , y+h , w , -h , iw , ih);
-  }
-  
-  int LD=iw*D;
-  uchar *rgbdata=new uchar[LD];
-  uchar *curmask=mask;
-  void *big = prepare_rle85();
-  
-  if (level2_mask) {
+  struct_image85 *big = (struct_image85 *)prepare_image85();
+  if (mask && lang_level_ == 2) { // masked color image with PostScript level 2
+    int i, j;
+    uchar *rgbdata = new uchar[iw*D], *row = new uchar[iw*3];
     for (j = ih - 1; j >= 0; j--) { // output full image data
       call(data, 0, j, iw, rgbdata);
       uchar *curdata = rgbdata;
-      for (i=0 ; i<iw ; i++) {
-        write_rle85(curdata[0], big); write_rle85(curdata[1], big); write_rle85(curdata[2], big);
-        curdata += D;
+      for (i = 0; i < iw; i++, curdata += D) {
+        row[i*3] = curdata[0]; row[i*3+1] = curdata[1]; row[i*3+2] = curdata[2];
       }
+      write_image85(big, row, iw*3);
     }
-    close_rle85(big); fputc('\n', output);
-    big = prepare_rle85();
+    close_image85(big); put("\n");
+    big = (struct_image85 *)prepare_image85();
     for (j = ih - 1; j >= 0; j--) { // output mask data
-      curmask = mask + j * (my/ih) * ((mx+7)/8);
-      for (k=0; k < my/ih; k++) {
-        for (i=0; i < ((mx+7)/8); i++) {
-          write_rle85(swap_byte(*curmask), big);
-          curmask++;
-        }
-      }
-    }
-  }
-  else {
-    for (j=0; j<ih;j++) {
-      if (mask && lang_level_ > 2) {  // InterleaveType 2 mask data
-        for (k=0; k<my/ih;k++) { //for alpha pseudo-masking
-          for (i=0; i<((mx+7)/8);i++) {
-            write_rle85(swap_byte(*curmask), big);
-            curmask++;
-          }
-        }
-      }
-      call(data,0,j,iw,rgbdata);
-      uchar *curdata=rgbdata;
-      for (i=0 ; i<iw ; i++) {
-        uchar r = curdata[0];
-        uchar g =  curdata[1];
-        uchar b =  curdata[2];
-        
-        if (lang_level_<3 && D>3) { //can do  mixing using bg_* colors)
-          unsigned int a2 = curdata[3]; //must be int
-          unsigned int a = 255-a2;
-          r = (a2 * r + bg_r * a)/255;
-          g = (a2 * g + bg_g * a)/255;
-          b = (a2 * b + bg_b * a)/255;
-        }
-        
-        write_rle85(r, big); write_rle85(g, big); write_rle85(b, big);
-        curdata +=D;
-      }
-      
+      write_mask85(big, mask + j * (my/ih) * ((mx+7)/8), (my/ih) * ((mx+7)/8));
     }
+    delete[] row;
+    delete[] rgbdata;
+  } else {
+    write_image_rows(this, big, NULL, 0, call, data, iw, ih, D, 0, lang_level_<3 && D>3);
   }
-  close_rle85(big);
-  fprintf(output,"\nrestore\n");
-  delete[] rgbdata;
+  close_image85(big);
+  put("\nrestore\n");
 }
 
 void Fl_PostScript_Graphics_Driver::draw_image_mono(const uchar *data, int ix, int iy, int iw, int ih, int D, int LD) {
-  double x = ix, y = iy, w = iw, h = ih;
+  if (!LD) LD = iw*D;
 
-  fprintf(output,"save\n");
+  if (draw_cached_image(data, ix, iy, iw, ih, D, LD, 1)) return;
 
-  int i,j, k;
+  put("save\n");
+  image_command(this, ix, iy, iw, ih, 1);
+  void *big = prepare_image85();
+  write_image_rows(this, (struct_image85 *)big, data, LD, NULL, NULL, iw, ih, D, 1, lang_level_<3 && D>1);
+  close_image85(big);
+  put("restore\n");
+}
 
-  const char * interpol;
-  if (lang_level_>1){
-    if (interpolate_)
-      interpol="true";
-    else
-      interpol="false";
-    if (mask && lang_level_>2)
-      fprintf(output, "%g %g %g %g %i %i %i %i %s GIM\n", x , y+h , w , -h , iw , ih, mx, my, interpol);
-    else
-      fprintf(output, "%g %g %g %g %i %i %s GII\n", x , y+h , w , -h , iw , ih, interpol);
-  }else
-    fprintf(output , "%g %g %g %g %i %i GI", x , y+h , w , -h , iw , ih);
 
 
-  if (!LD) LD = iw*D;
+void Fl_PostScript_Graphics_Driver::draw_image_mono(Fl_Draw_Image_Cb call, void *data, int ix, int iy, int iw, int ih, int D) {
+  put("save\n");
+  image_command(this, ix, iy, iw, ih, 1);
+  void *big = prepare_image85();
+  write_image_rows(this, (struct_image85 *)big, NULL, 0, call, data, iw, ih, D, 1, 0);
+  close_image85(big);
+  put("restore\n");
+}
 
 
-  int bg = (bg_r + bg_g + bg_b)/3;
+//
+// Images drawn more than once, such as a logo on every page or the icons of a
+// table, are compressed once into a PostScript array of strings. The array is
+// defined on each page that uses the image, and the image data are read from it
+// rather than from the file. Definitions go away with the page's save/restore,
+// so the pages remain independent as DSC requires.
+//
 
-  uchar *curmask=mask;
-  void *big = prepare_rle85();
-  for (j=0; j<ih;j++){
-    if (mask){
-      for (k=0;k<my/ih;k++){
-        for (i=0; i<((mx+7)/8);i++){
-          write_rle85(swap_byte(*curmask), big);
-          curmask++;
-        }
-      }
-    }
-    const uchar *curdata=data+j*LD;
-    for (i=0 ; i<iw ; i++) {
-      uchar r = curdata[0];
-      if (lang_level_<3 && D>1) { //can do  mixing
+struct ps_cached_image {
+  unsigned h1, h2;   // hash of the image data and of what changes their encoding
+  uchar *key;        // copy of these, to tell apart images whose hashes collide
+  size_t lkey;
+  int id;            // the array is named FI<id>
+  int page;          // page where the array was last defined, or -1
+  int flate;         // the strings hold FlateEncode'd rather than RunLengthEncode'd data
+  char *text;        // the array in PostScript syntax, or NULL while the image was drawn once
+  size_t ltext;
+  ps_cached_image *next;
+};
 
-        unsigned int a2 = curdata[1]; //must be int
-        unsigned int a = 255-a2;
-        r = (a2 * r + bg * a)/255;
-      }
-      write_rle85(r, big);
-      curdata +=D;
-    }
+struct ps_image_cache {
+  ps_cached_image *buckets[256];
+  int count;         // # of images
+  size_t memory;     // total size of their arrays and keys
+};
+
+// limit of the memory used by the arrays and keys, other images are sent with each use
+static const size_t ps_image_cache_max = 32 * 1024 * 1024;
 
+static void hash_bytes(unsigned &h1, unsigned &h2, const uchar *p, int len) {
+  for (; len >= 4; len -= 4, p += 4) {
+    unsigned v;
+    memcpy(&v, p, 4);
+    h1 = (h1 ^ v) * 16777619U;
+    h2 = (h2 + v) * 2654435761U; h2 ^= h2 >> 15;
+  }
+  for (; len > 0; len--, p++) {
+    h1 = (h1 ^ *p) * 16777619U;
+    h2 = (h2 + *p) * 2654435761U; h2 ^= h2 >> 15;
   }
-  close_rle85(big);
-  fprintf(output,"restore\n");
 }
 
-
-
-void Fl_PostScript_Graphics_Driver::draw_image_mono(Fl_Draw_Image_Cb call, void *data, int ix, int iy, int iw, int ih, int D) {
-  double x = ix, y = iy, w = iw, h = ih;
-
-  fprintf(output,"save\n");
-  int i,j,k;
-  const char * interpol;
-  if (lang_level_>1){
-    if (interpolate_) interpol="true";
-    else interpol="false";
-    if (mask && lang_level_>2)
-      fprintf(output, "%g %g %g %g %i %i %i %i %s GIM\n", x , y+h , w , -h , iw , ih, mx, my, interpol);
-    else
-      fprintf(output, "%g %g %g %g %i %i %s GII\n", x , y+h , w , -h , iw , ih, interpol);
-  } else
-    fprintf(output , "%g %g %g %g %i %i GI", x , y+h , w , -h , iw , ih);
-
-  int LD=iw*D;
-  uchar *rgbdata=new uchar[LD];
-  uchar *curmask=mask;
-  void *big = prepare_rle85();
-  for (j=0; j<ih;j++){
-
-    if (mask && lang_level_>2){  // InterleaveType 2 mask data
-      for (k=0; k<my/ih;k++){ //for alpha pseudo-masking
-        for (i=0; i<((mx+7)/8);i++){
-          write_rle85(swap_byte(*curmask), big);
-          curmask++;
-        }
-      }
+// Draws an image from a cached array and returns 1, or returns 0 when the
+// caller should send the image data after the drawing command.
+int Fl_PostScript_Graphics_Driver::draw_cached_image(const uchar *data, int ix, int iy, int iw, int ih, int D, int LD, int gray) {
+  if (lang_level_ < 2 || (mask && lang_level_ == 2) || iw <= 0 || ih <= 0) return 0;
+  int mix = lang_level_ < 3 && (gray ? D > 1 : D > 3);
+  int params[10] = { iw, ih, D, gray, lang_level_, mix ? (bg_r << 16) + (bg_g << 8) + bg_b : -1,
+    mask ? mx : 0, mask ? my : 0, 0, 0 };
+  int lrow = iw * D, lmask = mask ? ((mx+7)/8) * my : 0;
+  unsigned h1 = 2166136261U, h2 = 0;
+  hash_bytes(h1, h2, (const uchar*)params, sizeof(params));
+  for (int j = 0; j < ih; j++) hash_bytes(h1, h2, data + j*LD, lrow);
+  if (mask) hash_bytes(h1, h2, mask, lmask);
+  size_t lkey = sizeof(params) + (size_t)lrow * ih + lmask;
+
+  ps_image_cache *cache = (ps_image_cache *)image_cache_;
+  if (!cache) {
+    cache = new ps_image_cache;
+    memset(cache, 0, sizeof(ps_image_cache));
+    image_cache_ = cache;
+  }
+  ps_cached_image **bucket = cache->buckets + (h1 & 255), *img;
+  for (img = *bucket; img; img = img->next) {
+    if (img->h1 != h1 || img->h2 != h2 || img->lkey != lkey) continue;
+    const uchar *k = img->key;
+    if (memcmp(k, params, sizeof(params))) continue;
+    k += sizeof(params);
+    int j;
+    for (j = 0; j < ih; j++, k += lrow) {
+      if (memcmp(k, data + j*LD, lrow)) break;
     }
-    call(data,0,j,iw,rgbdata);
-    uchar *curdata=rgbdata;
-    for (i=0 ; i<iw ; i++) {
-      write_rle85(curdata[0], big);
-      curdata +=D;
+    if (j == ih && (!mask || !memcmp(k, mask, lmask))) break;
+  }
+  if (!img) { // first use, the image is drawn as usual
+    if (cache->memory + lkey > ps_image_cache_max) return 0;
+    img = new ps_cached_image;
+    img->h1 = h1;
+    img->h2 = h2;
+    img->key = (uchar*)malloc(lkey);
+    img->lkey = lkey;
+    uchar *k = img->key;
+    memcpy(k, params, sizeof(params));
+    k += sizeof(params);
+    for (int j = 0; j < ih; j++, k += lrow) memcpy(k, data + j*LD, lrow);
+    if (mask) memcpy(k, mask, lmask);
+    cache->memory += lkey;
+    img->id = cache->count++;
+    img->page = -1;
+    img->flate = 0;
+    img->text = NULL;
+    img->ltext = 0;
+    img->next = *bucket;
+    *bucket = img;
+    return 0;
+  }
+  if (!img->text) { // second use, compress the image into memory
+    if (cache->memory >= ps_image_cache_max) return 0;
+    struct85 *big85 = new85(NULL);
+    big85->chunk = 65532; // PostScript strings are at most 65535 bytes long
+    text85(big85, "[<~");
+    struct_image85 *big = image85_new(big85, lang_level_ >= 3);
+#if HAVE_LIBZ
+    img->flate = big->flate != NULL;
+#endif
+    write_image_rows(this, big, data, LD, NULL, NULL, iw, ih, D, gray, mix);
+    image85_close(big);
+    text85(big85, "]");
+    flush85(big85);
+    img->text = big85->text;
+    img->ltext = big85->ltext;
+    delete big85;
+    cache->memory += img->ltext;
+  }
+  if (img->page != nPages) { // define the array on this page
+    print("/FI%d ", img->id);
+    put(img->text, (int)img->ltext);
+    put(" def\n");
+    img->page = nPages;
+  }
+  print("save\n/IDS { FI%d IDA /%s filter } def\n", img->id, img->flate ? "FlateDecode" : "RunLengthDecode");
+  image_command(this, ix, iy, iw, ih, gray);
+  put("\nrestore\n");
+  return 1;
+}
+
+void Fl_PostScript_Graphics_Driver::delete_image_cache() {
+  ps_image_cache *cache = (ps_image_cache *)image_cache_;
+  if (!cache) return;
+  for (int i = 0; i < 256; i++) {
+    ps_cached_image *img = cache->buckets[i];
+    while (img) {
+      ps_cached_image *next = img->next;
+      free(img->text);
+      free(img->key);
+      delete img;
+      img = next;
     }
   }
-  close_rle85(big);
-  fprintf(output,"restore\n");
-  delete[] rgbdata;
+  delete cache;
+  image_cache_ = NULL;
 }
 
 
@@ -606,10 +860,13 @@ int Fl_PostScript_Graphics_Driver::draw_scaled(Fl_Image *img, int XP, int YP, in
   clip_box(XP,YP,WP,HP,X,Y,W,H); // X,Y,W,H will give the unclipped area of XP,YP,WP,HP
   if (W == 0 || H == 0) return 1;
   push_no_clip(); // remove the FLTK clip that can't be rescaled
-  clocale_printf("%d %d %i %i CL\n", X, Y, W, H);
-  clocale_printf("GS %d %d TR  %f %f SC GS\n", XP, YP, float(WP)/img->w(), float(HP)/img->h());
+  print("%d %d %i %i CL\n", X, Y, W, H);
+  clip_level_ = -1;
+  print("GS %d %d TR  %f %f SC GS\n", XP, YP, float(WP)/img->w(), float(HP)/img->h());
+  state_saved(2);
   img->draw(0, 0, img->w(), img->h(), 0, 0);
-  clocale_printf("GR GR\n");
+  put("GR GR\n");
+  state_restored(2);
   pop_clip(); // restore FLTK's clip
   return 1;
 }
@@ -635,18 +892,16 @@ void Fl_PostScript_Graphics_Driver::draw(Fl_Bitmap * bitmap,int XP, int YP, int
   di += cy*LD + cx/8;
   int si = cx % 8; // small shift to be clipped, it is simpler than shifting whole mask
 
-  int i,j;
+  int j;
   push_clip(XP, YP, WP, HP);
-  fprintf(output , "%i %i %i %i %i %i MI\n", XP - si, YP + HP , WP , -HP , w , h);
+  print("%i %i %i %i %i %i MI\n", XP - si, YP + HP , WP , -HP , w , h);
 
-  void *rle85 = prepare_rle85();
+  struct_image85 *big = (struct_image85 *)prepare_image85();
   for (j=0; j<HP; j++){
-    for (i=0; i<xx; i++){
-      write_rle85(swap_byte(*di), rle85);
-      di++;
-    }
+    write_mask85(big, di, xx);
+    di += xx;
   }
-  close_rle85(rle85); fputc('\n', output);
+  close_image85(big); put("\n");
   pop_clip();
 }
 
@@ -20,11 +20,15 @@
 #include "../../config_lib.h"
 #include "Fl_X11_Screen_Driver.H"
 #include "../Xlib/Fl_Font.H"
+#include "../Xlib/Fl_Xlib_Graphics_Driver.H"
 #include <FL/Fl.H>
 #include <FL/x.H>
 #include <FL/fl_ask.H>
+#include <FL/Fl_Trace.H>
 
 #include <sys/time.h>
+#include <stdlib.h>
+#include <string.h>
 
 #if HAVE_XINERAMA
 #  include <X11/extensions/Xinerama.h>
@@ -417,8 +421,10 @@ void Fl_X11_Screen_Driver::beep(int type)
 
 void Fl_X11_Screen_Driver::flush()
 {
-  if (fl_display)
+  if (fl_display) {
+    Fl_Xlib_Graphics_Driver::flush_glyphs();
     XFlush(fl_display);
+  }
 }
 
 
@@ -440,7 +446,9 @@ double Fl_X11_Screen_Driver::wait(double time_to_wait)
       t->next = free_timeout;
       free_timeout = t;
       // Now it is safe for the callback to do add_timeout:
+      double start = Fl_Trace::enabled() ? Fl_Trace::now() : 0;
       cb(argp);
+      if (start) Fl_Trace::record(FL_TRACE_TIMEOUT, 0, start);
     }
   } else {
     reset_clock = 1; // we are not going to check the clock
@@ -449,7 +457,9 @@ double Fl_X11_Screen_Driver::wait(double time_to_wait)
   if (Fl::idle) {
     if (!in_idle) {
       in_idle = 1;
+      double start = Fl_Trace::enabled() ? Fl_Trace::now() : 0;
       Fl::idle();
+      if (start) Fl_Trace::record(FL_TRACE_IDLE, 0, start);
       in_idle = 0;
     }
     // the idle function may turn off idle, we can then wait:
@@ -539,6 +549,25 @@ void Fl_X11_Screen_Driver::grab(Fl_Window* win)
 // Wrapper around XParseColor...
 int Fl_X11_Screen_Driver::parse_color(const char* p, uchar& r, uchar& g, uchar& b)
 {
+  // "#rgb", "#rrggbb", ... are decoded here, as XParseColor() does, so that
+  // pixmaps can be used without a display (e.g. with Fl_Framebuffer_Surface)
+  if (*p == '#') {
+    size_t n = strlen(p + 1);
+    if (n && n % 3 == 0 && n <= 12 && strspn(p + 1, "0123456789abcdefABCDEF") == n) {
+      size_t m = n / 3;
+      unsigned v[3];
+      for (int i = 0; i < 3; i++) {
+        char digits[5];
+        memcpy(digits, p + 1 + i * m, m); digits[m] = 0;
+        v[i] = (unsigned)strtoul(digits, NULL, 16);
+        // XParseColor() shifts the digits left to 16 bits, keep the high 8 bits
+        if (m == 1) v[i] <<= 4;
+        else v[i] >>= 4 * (m - 2);
+      }
+      r = (uchar)v[0]; g = (uchar)v[1]; b = (uchar)v[2];
+      return 1;
+    }
+  }
   XColor x;
   if (!fl_display) open_display();
   if (XParseColor(fl_display, fl_colormap, p, &x)) {
@@ -756,6 +785,7 @@ Fl_RGB_Image *Fl_X11_Screen_Driver::read_win_rectangle(uchar *p, int X, int Y, i
   //
   int allow_outside = w < 0;    // negative w allows negative X or Y, that is, window frame
   if (w < 0) w = - w;
+  Fl_Xlib_Graphics_Driver::flush_glyphs(); // read text that is still batched, too
   
 #  ifdef __sgi
   if (XReadDisplayQueryExtension(fl_display, &i, &i)) {
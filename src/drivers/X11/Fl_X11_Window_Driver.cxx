@@ -98,6 +98,7 @@ void Fl_X11_Window_Driver::flush_double_dbe(int erase_overlay)
     draw();
     fl_window = i->xid;
   }
+  Fl_Xlib_Graphics_Driver::flush_glyphs();
   // Copy contents of back buffer to window...
   XdbeSwapInfo s;
   s.swap_window = fl_xid(pWindow);
@@ -204,6 +205,13 @@ void Fl_X11_Window_Driver::draw_begin()
 }
 
 
+void Fl_X11_Window_Driver::flush()
+{
+  Fl_Window_Driver::flush();
+  Fl_Xlib_Graphics_Driver::flush_glyphs(); // draw the text batched by draw()
+}
+
+
 void Fl_X11_Window_Driver::flush_double()
 {
   if (!shown()) return;
@@ -650,6 +658,7 @@ void Fl_X11_Window_Driver::erase_menu() {
 int Fl_X11_Window_Driver::scroll(int src_x, int src_y, int src_w, int src_h, int dest_x, int dest_y,
                                  void (*draw_area)(void*, int,int,int,int), void* data)
 {
+  Fl_Xlib_Graphics_Driver::flush_glyphs();
   XCopyArea(fl_display, fl_window, fl_window, (GC)fl_graphics_driver->gc(),
             src_x, src_y, src_w, src_h, dest_x, dest_y);
   // we have to sync the display and get the GraphicsExpose events! (sigh)
@@ -79,6 +79,7 @@ void Fl_Xlib_Graphics_Driver::gc(void *value) {
 }
 
 void Fl_Xlib_Graphics_Driver::copy_offscreen(int x, int y, int w, int h, Fl_Offscreen pixmap, int srcx, int srcy) {
+  flush_glyphs();
   XCopyArea(fl_display, pixmap, fl_window, gc_, srcx, srcy, w, h, x+offset_x_, y+offset_y_);
 }
 
@@ -24,6 +24,7 @@
 #include <FL/fl_draw.H>
 #include <FL/x.H>
 #include "Fl_Font.H"
+#include "../../utf8_internal.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -654,6 +655,8 @@ Fl_Font_Descriptor::Fl_Font_Descriptor(const char* name, Fl_Fontsize fsize, int
   listbase = 0;
 #endif // HAVE_GL
   font = fontopen(name, fsize, false, angle);
+  memset(width, 0, sizeof(width));
+  wide_widths = NULL;
 }
 
 
@@ -683,6 +686,11 @@ static const wchar_t *utf8reformat(const char *str, int& n)
 static void utf8extents(Fl_Font_Descriptor *desc, const char *str, int n, XGlyphInfo *extents)
 {
   memset(extents, 0, sizeof(XGlyphInfo));
+  if (n > 0 && fl_utf8_ascii_span(str, n) == (unsigned)n) {
+    // plain ASCII needs no conversion
+    XftTextExtents8(fl_display, desc->font, (XftChar8 *)str, n, extents);
+    return;
+  }
   const wchar_t *buffer = utf8reformat(str, n);
 #ifdef __CYGWIN__
     XftTextExtents16(fl_display, desc->font, (XftChar16 *)buffer, n, extents);
@@ -701,22 +709,104 @@ int Fl_Xlib_Graphics_Driver::descent() {
   else return -1;
 }
 
+// Glyph advances are cached per font descriptor, so that measuring text
+// does not need a round trip into libXft for every call. Xft computes the
+// xOff of a string as the sum of the advances of its glyphs, so adding the
+// cached values gives the same result as XftTextExtents32().
+// Advances of the BMP are kept in blocks of 1024 entries that are allocated
+// on demand, the rare characters above U+FFFF go into a small hash table.
+
+#define FL_XFT_NO_WIDTH (-0x8000) // marks an advance that was not measured yet
+
+struct Fl_Xft_Wide_Widths {
+  struct Entry {
+    unsigned c; // 0 marks an empty slot, which is never a valid key here
+    short w;
+  } *table;
+  unsigned size; // always a power of 2
+  unsigned count;
+};
+
+static unsigned wide_width_hash(unsigned c, unsigned size) {
+  return (c * 2654435761U) & (size - 1);
+}
+
+static short *wide_width_slot(Fl_Font_Descriptor *desc, unsigned c) {
+  Fl_Xft_Wide_Widths *h = desc->wide_widths;
+  if (!h) {
+    h = desc->wide_widths = new Fl_Xft_Wide_Widths;
+    h->size = 64;
+    h->count = 0;
+    h->table = (Fl_Xft_Wide_Widths::Entry*)calloc(h->size, sizeof(Fl_Xft_Wide_Widths::Entry));
+  } else if (2 * (h->count + 1) > h->size) { // keep the load factor below 1/2
+    Fl_Xft_Wide_Widths::Entry *old = h->table;
+    unsigned i, j, old_size = h->size;
+    h->size *= 2;
+    h->table = (Fl_Xft_Wide_Widths::Entry*)calloc(h->size, sizeof(Fl_Xft_Wide_Widths::Entry));
+    for (i = 0; i < old_size; i++) {
+      if (!old[i].c) continue;
+      for (j = wide_width_hash(old[i].c, h->size); h->table[j].c; j = (j + 1) & (h->size - 1)) {}
+      h->table[j] = old[i];
+    }
+    free(old);
+  }
+  unsigned i = wide_width_hash(c, h->size);
+  while (h->table[i].c && h->table[i].c != c) i = (i + 1) & (h->size - 1);
+  if (!h->table[i].c) {
+    h->table[i].c = c;
+    h->table[i].w = FL_XFT_NO_WIDTH;
+    h->count++;
+  }
+  return &h->table[i].w;
+}
+
+// returns the advance of character c in this font, measuring it if needed
+static int glyph_width(Fl_Font_Descriptor *desc, unsigned c) {
+  short *w;
+  if (c < 0x10000) {
+    short *block = desc->width[c >> 10];
+    if (!block) {
+      block = desc->width[c >> 10] = (short*)malloc(sizeof(short) * 0x0400);
+      for (int i = 0; i < 0x0400; i++) block[i] = FL_XFT_NO_WIDTH;
+    }
+    w = block + (c & 0x03FF);
+  } else {
+    w = wide_width_slot(desc, c);
+  }
+  if (*w == FL_XFT_NO_WIDTH) {
+    XGlyphInfo i;
+    FcChar32 ucs = c;
+    XftTextExtents32(fl_display, desc->font, &ucs, 1, &i);
+    *w = i.xOff;
+  }
+  return *w;
+}
+
 double Fl_Xlib_Graphics_Driver::width(const char* str, int n) {
   if (!font_descriptor()) return -1.0;
-  XGlyphInfo i;
-  utf8extents(font_descriptor(), str, n, &i);
-  return i.xOff;
+  const char *end = str + n;
+  int w = 0, len;
+  while (str < end) {
+    if (!(*str & 0x80)) { // ascii
+      w += glyph_width(font_descriptor(), *str++);
+    } else {
+      w += glyph_width(font_descriptor(), fl_utf8decode(str, end, &len));
+      str += len;
+    }
+  }
+  return w;
 }
 
 static double fl_xft_width(Fl_Font_Descriptor *desc, FcChar32 *str, int n) {
   if (!desc) return -1.0;
-  XGlyphInfo i;
-  XftTextExtents32(fl_display, desc->font, str, n, &i);
-  return i.xOff;
+  int w = 0;
+  for (int i = 0; i < n; i++) w += glyph_width(desc, str[i]);
+  return w;
 }
 
 double Fl_Xlib_Graphics_Driver::width(unsigned int c) {
-  return fl_xft_width(font_descriptor(), (FcChar32 *)(&c), 1);
+  if (!font_descriptor()) return -1.0;
+  return glyph_width(font_descriptor(), c);
 }
 
 void Fl_Xlib_Graphics_Driver::text_extents(const char *c, int n, int &dx, int &dy, int &w, int &h) {
@@ -735,46 +825,99 @@ void Fl_Xlib_Graphics_Driver::text_extents(const char *c, int n, int &dx, int &d
 } // fl_text_extents
 
 
+// Text is not sent to libXft as soon as it is drawn: consecutive strings
+// drawn with the same color into the same drawable and clip region are
+// collected as positioned glyphs, and sent with a single call to
+// XftDrawGlyphFontSpec(). The Xlib driver draws the collected glyphs before
+// anything else is drawn, before the clip region changes and at the end of
+// each window flush, so that the stacking order of the graphics is kept.
+
+static XftGlyphFontSpec *glyph_specs = 0; // the collected glyphs
+static int glyph_specs_size = 0;          // allocated size of glyph_specs
+static Fl_Color glyph_color;              // color of the collected glyphs
+static XftColor glyph_xft_color;
+int Fl_Xlib_Graphics_Driver::glyph_count_ = 0;
+
+void Fl_Xlib_Graphics_Driver::flush_glyphs_() {
+  XftDrawGlyphFontSpec(draw_, &glyph_xft_color, glyph_specs, glyph_count_);
+  glyph_count_ = 0;
+}
+
 void Fl_Xlib_Graphics_Driver::draw(const char *str, int n, int x, int y) {
   if ( !this->font_descriptor() ) {
     this->font(FL_HELVETICA, FL_NORMAL_SIZE);
   }
+  if (glyph_count_ && (draw_window != fl_window || glyph_color != Fl_Graphics_Driver::color()))
+    flush_glyphs_();
+  if (!glyph_count_) {
 #if USE_OVERLAY
-  XftDraw*& draw_ = fl_overlay ? draw_overlay : ::draw_;
-  if (fl_overlay) {
-    if (!draw_)
-      draw_ = XftDrawCreate(fl_display, draw_overlay_window = fl_window,
-			   fl_overlay_visual->visual, fl_overlay_colormap);
-    else //if (draw_overlay_window != fl_window)
-      XftDrawChange(draw_, draw_overlay_window = fl_window);
-  } else
+    XftDraw*& draw_ = fl_overlay ? draw_overlay : ::draw_;
+    if (fl_overlay) {
+      if (!draw_)
+        draw_ = XftDrawCreate(fl_display, draw_overlay_window = fl_window,
+			     fl_overlay_visual->visual, fl_overlay_colormap);
+      else //if (draw_overlay_window != fl_window)
+        XftDrawChange(draw_, draw_overlay_window = fl_window);
+    } else
 #endif
-  if (!draw_)
-    draw_ = XftDrawCreate(fl_display, draw_window = fl_window,
-			 fl_visual->visual, fl_colormap);
-  else //if (draw_window != fl_window)
-    XftDrawChange(draw_, draw_window = fl_window);
-
-  Region region = fl_clip_region();
-  if (region && XEmptyRegion(region)) return;
-  XftDrawSetClip(draw_, region);
-
-  // Use fltk's color allocator, copy the results to match what
-  // XftCollorAllocValue returns:
-  XftColor color;
-  color.pixel = fl_xpixel(Fl_Graphics_Driver::color());
-  uchar r,g,b; Fl::get_color(Fl_Graphics_Driver::color(), r,g,b);
-  color.color.red   = ((int)r)*0x101;
-  color.color.green = ((int)g)*0x101;
-  color.color.blue  = ((int)b)*0x101;
-  color.color.alpha = 0xffff;
+    if (!draw_)
+      draw_ = XftDrawCreate(fl_display, draw_window = fl_window,
+			   fl_visual->visual, fl_colormap);
+    else //if (draw_window != fl_window)
+      XftDrawChange(draw_, draw_window = fl_window);
+
+    Region region = fl_clip_region();
+    if (region && XEmptyRegion(region)) return;
+    XftDrawSetClip(draw_, region);
+
+    // Use fltk's color allocator, copy the results to match what
+    // XftCollorAllocValue returns:
+    glyph_color = Fl_Graphics_Driver::color();
+    glyph_xft_color.pixel = fl_xpixel(glyph_color);
+    uchar r,g,b; Fl::get_color(glyph_color, r,g,b);
+    glyph_xft_color.color.red   = ((int)r)*0x101;
+    glyph_xft_color.color.green = ((int)g)*0x101;
+    glyph_xft_color.color.blue  = ((int)b)*0x101;
+    glyph_xft_color.color.alpha = 0xffff;
+  }
 
-  const wchar_t *buffer = utf8reformat(str, n);
+  Fl_Font_Descriptor *desc = font_descriptor();
+  if (desc->angle) {
+    // glyphs of rotated text also advance vertically, draw them right away
+    flush_glyphs();
+    const wchar_t *buffer = utf8reformat(str, n);
 #ifdef __CYGWIN__
-  XftDrawString16(draw_, &color, font_descriptor()->font, x+offset_x_, y+offset_y_, (XftChar16 *)buffer, n);
+    XftDrawString16(draw_, &glyph_xft_color, desc->font, x+offset_x_, y+offset_y_, (XftChar16 *)buffer, n);
 #else
-  XftDrawString32(draw_, &color, font_descriptor()->font, x+offset_x_, y+offset_y_, (XftChar32 *)buffer, n);
+    XftDrawString32(draw_, &glyph_xft_color, desc->font, x+offset_x_, y+offset_y_, (XftChar32 *)buffer, n);
 #endif
+    return;
+  }
+
+  // position the glyphs with the cached advances, as Xft itself would do
+  const char *end = str + n;
+  unsigned ucs;
+  int len;
+  x += offset_x_;
+  y += offset_y_;
+  while (str < end) {
+    if (!(*str & 0x80)) { // ascii
+      ucs = *str++;
+    } else {
+      ucs = fl_utf8decode(str, end, &len);
+      str += len;
+    }
+    if (glyph_count_ >= glyph_specs_size) {
+      glyph_specs_size = glyph_specs_size ? 2 * glyph_specs_size : 256;
+      glyph_specs = (XftGlyphFontSpec*)realloc(glyph_specs, glyph_specs_size * sizeof(XftGlyphFontSpec));
+    }
+    XftGlyphFontSpec *spec = glyph_specs + glyph_count_++;
+    spec->font = desc->font;
+    spec->glyph = XftCharIndex(fl_display, desc->font, ucs);
+    spec->x = x;
+    spec->y = y;
+    x += glyph_width(desc, ucs);
+  }
 }
 
 void Fl_Xlib_Graphics_Driver::draw(int angle, const char *str, int n, int x, int y) {
@@ -784,6 +927,7 @@ void Fl_Xlib_Graphics_Driver::draw(int angle, const char *str, int n, int x, int
 }
 
 void Fl_Xlib_Graphics_Driver::drawUCS4(const void *str, int n, int x, int y) {
+  flush_glyphs();
 #if USE_OVERLAY
   XftDraw*& draw_ = fl_overlay ? draw_overlay : ::draw_;
   if (fl_overlay) {
@@ -814,7 +958,7 @@ void Fl_Xlib_Graphics_Driver::drawUCS4(const void *str, int n, int x, int y) {
   color.color.blue  = ((int)b)*0x101;
   color.color.alpha = 0xffff;
 
-  XftDrawString32(draw_, &color, font_descriptor()->font, x+offset_x_, y+offset_x_, (FcChar32 *)str, n);
+  XftDrawString32(draw_, &color, font_descriptor()->font, x+offset_x_, y+offset_y_, (FcChar32 *)str, n);
 }
 
 
@@ -953,12 +1097,25 @@ float Fl_Xlib_Graphics_Driver::scale_bitmap_for_PostScript() {
 Fl_Font_Descriptor::~Fl_Font_Descriptor() {
   if (this == fl_graphics_driver->font_descriptor()) fl_graphics_driver->font_descriptor(NULL);
   //  XftFontClose(fl_display, font);
+#if ! USE_PANGO
+  for (int i = 0; i < 64; i++) {
+    if (width[i]) free(width[i]);
+  }
+  if (wide_widths) {
+    free(wide_widths->table);
+    delete wide_widths;
+  }
+#endif // !USE_PANGO
 }
 
 
 void Fl_Xlib_Graphics_Driver::destroy_xft_draw(Window id) {
-  if (id == draw_window)
+  if (id == draw_window) {
+#if ! USE_PANGO
+    glyph_count_ = 0; // the batched text can no longer be drawn
+#endif
     XftDrawChange(draw_, draw_window = fl_message_window);
+  }
 #if USE_OVERLAY
   if (id == draw_overlay_window)
     XftDrawChange(draw_overlay, draw_overlay_window = fl_message_window);
@@ -56,6 +56,9 @@
 #if HAVE_XRENDER
 #include <X11/extensions/Xrender.h>
 #endif
+#if defined(__SSE2__)
+#  include <emmintrin.h>
+#endif
 
 static XImage xi;	// template used to pass info to X
 static int bytes_per_pixel;
@@ -469,6 +472,7 @@ static void innards(const uchar *buf, int X, int Y, int W, int H,
 		    Fl_Draw_Image_Cb cb, void* userdata,
 		    const bool alpha, GC gc)
 {
+  Fl_Xlib_Graphics_Driver::flush_glyphs();
   if (!linedelta) linedelta = W*abs(delta);
 
   int dx, dy, w, h;
@@ -623,6 +627,7 @@ void Fl_Xlib_Graphics_Driver::delete_bitmask(Fl_Bitmask bm) {
 }
 
 void Fl_Xlib_Graphics_Driver::draw(Fl_Bitmap *bm, int XP, int YP, int WP, int HP, int cx, int cy) {
+  flush_glyphs();
   int X, Y, W, H;
   if (Fl_Graphics_Driver::prepare(bm, XP+offset_x_, YP+offset_y_, WP, HP, cx, cy, X, Y, W, H)) {
     return;
@@ -635,18 +640,197 @@ void Fl_Xlib_Graphics_Driver::draw(Fl_Bitmap *bm, int XP, int YP, int WP, int HP
   XSetFillStyle(fl_display, gc_, FillStippled);
   XFillRectangle(fl_display, fl_window, gc_, X, Y, W, H);
   XSetFillStyle(fl_display, gc_, FillSolid);
+  image_cached(bm, ((bm->w() + 7) / 8) * bm->h());
+}
+
+
+// Images with alpha are composited by the client when the X server can't
+// do it (no XRender). The pixels under the image are read with one
+// XGetImage(), blended in place in the format of the visual, and written
+// back with one XPutImage(). An image is converted to that format, with
+// premultiplied colors, when it is first drawn, and kept in its mask_ until
+// uncache(). Only the part of it that is not fully transparent is kept, so
+// the transparent margins of icons cost nothing.
+struct Fl_Xlib_Blend_Image {
+  int x, y, w, h;   // the part of the image that is kept
+  unsigned *pixels; // w * h premultiplied pixels in the format of the visual
+  uchar *alpha;     // w * h alpha values
+};
+
+// returns the mask of the color bits when the visual has 8 bit color
+// channels in 32 bit pixels in the byte order of this machine, else 0
+static unsigned blend_color_mask() {
+  static int checked = 0;
+  static unsigned mask = 0;
+  if (!checked) {
+    checked = 1;
+    if (!bytes_per_pixel) figure_out_visual();
+    if (fl_visual->c_class != TrueColor || bytes_per_pixel != 4 ||
+        (ImageByteOrder(fl_display) == MSBFirst) != WORDS_BIGENDIAN) return 0;
+    unsigned long m[3] = {fl_visual->red_mask, fl_visual->green_mask, fl_visual->blue_mask};
+    for (int i = 0; i < 3; i++) {
+      if (m[i] != 0xff && m[i] != 0xff00 && m[i] != 0xff0000 && m[i] != 0xff000000UL) return 0;
+    }
+    mask = (unsigned)(m[0] | m[1] | m[2]);
+  }
+  return mask;
+}
+
+static int channel_shift(unsigned long mask) {
+  int s = 0;
+  while (!(mask & 1)) { mask >>= 1; s++; }
+  return s;
+}
+
+// c * a / 255, rounded like the blending below
+static inline unsigned premultiply(unsigned c, unsigned a) {
+  c = c * a + 128;
+  return (c + (c >> 8)) >> 8;
+}
+
+static Fl_Xlib_Blend_Image *make_blend_image(Fl_RGB_Image *img) {
+  int d = img->d(), ld = img->ld();
+  if (ld == 0) ld = img->w() * d;
+  const uchar *array = img->array;
+  // the box around the pixels that are not fully transparent
+  int x0 = img->w(), y0 = img->h(), x1 = -1, y1 = -1, X, Y;
+  for (Y = 0; Y < img->h(); Y++) {
+    const uchar *p = array + Y * ld + d - 1;
+    for (X = 0; X < img->w(); X++, p += d) {
+      if (!*p) continue;
+      if (X < x0) x0 = X;
+      if (X > x1) x1 = X;
+      if (Y < y0) y0 = Y;
+      y1 = Y;
+    }
+  }
+  Fl_Xlib_Blend_Image *b = new Fl_Xlib_Blend_Image;
+  b->x = x0; b->y = y0;
+  b->w = x1 >= x0 ? x1 - x0 + 1 : 0;
+  b->h = y1 >= y0 ? y1 - y0 + 1 : 0;
+  b->pixels = new unsigned[b->w * b->h];
+  b->alpha = new uchar[b->w * b->h];
+  int rs = channel_shift(fl_visual->red_mask);
+  int gs = channel_shift(fl_visual->green_mask);
+  int bs = channel_shift(fl_visual->blue_mask);
+  unsigned *to = b->pixels;
+  uchar *alpha = b->alpha;
+  for (Y = 0; Y < b->h; Y++) {
+    const uchar *p = array + (y0 + Y) * ld + x0 * d;
+    for (X = 0; X < b->w; X++, p += d) {
+      unsigned a = p[d - 1], r = p[0], g = p[0], bl = p[0];
+      if (d == 4) { g = p[1]; bl = p[2]; }
+      *to++ = (premultiply(r, a) << rs) | (premultiply(g, a) << gs) | (premultiply(bl, a) << bs);
+      *alpha++ = (uchar)a;
+    }
+  }
+  return b;
+}
+
+static void delete_blend_image(Fl_Xlib_Blend_Image *b) {
+  delete[] b->pixels;
+  delete[] b->alpha;
+  delete b;
 }
 
+// dst = src + dst * (255 - alpha) / 255 for the bits in keep, the other
+// bits of dst are left alone. Each 32 bit pixel holds 4 channels of 8 bits,
+// they are computed in pairs in the 16 bit halves of one word, and with
+// SSE2 four pixels at a time.
+static void blend_row(unsigned *dst, const unsigned *src, const uchar *alpha, int w, unsigned keep) {
+  int i = 0;
+#if defined(__SSE2__)
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i round = _mm_set1_epi16(128);
+  const __m128i ones = _mm_set1_epi8(-1);
+  const __m128i mask = _mm_set1_epi32((int)keep);
+  for (; i + 4 <= w; i += 4) {
+    unsigned a4;
+    memcpy(&a4, alpha + i, 4);
+    if (!a4) continue;
+    __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+    __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+    // every alpha byte 4 times, inverted
+    __m128i na = _mm_cvtsi32_si128((int)a4);
+    na = _mm_unpacklo_epi8(na, na);
+    na = _mm_xor_si128(_mm_unpacklo_epi16(na, na), ones);
+    __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi8(na, zero)), round);
+    __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi8(na, zero)), round);
+    lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+    hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+    __m128i r = _mm_add_epi8(_mm_packus_epi16(lo, hi), s);
+    r = _mm_or_si128(_mm_and_si128(r, mask), _mm_andnot_si128(mask, d));
+    _mm_storeu_si128((__m128i*)(dst + i), r);
+  }
+#endif
+  for (; i < w; i++) {
+    unsigned a = alpha[i];
+    if (!a) continue;
+    unsigned d = dst[i], na = 255 - a;
+    unsigned rb = (d & 0xff00ff) * na + 0x800080;
+    rb = ((rb + ((rb >> 8) & 0xff00ff)) >> 8) & 0xff00ff;
+    unsigned ag = ((d >> 8) & 0xff00ff) * na + 0x800080;
+    ag = (ag + ((ag >> 8) & 0xff00ff)) & 0xff00ff00;
+    dst[i] = (((rb | ag) + src[i]) & keep) | (d & ~keep);
+  }
+}
+
+static int blend_error;
+static int blend_error_handler(Display *, XErrorEvent *) {
+  blend_error = 1;
+  return 0;
+}
+
+// Composites the part of img at cx, cy of size W, H to X, Y in the
+// drawable, cache is the mask_ of img. Returns 0 when that is not possible,
+// then alpha_blend() does it.
+static int blend_to_drawable(Fl_RGB_Image *img, fl_uintptr_t *cache, int X, int Y, int W, int H, int cx, int cy, GC gc) {
+  unsigned keep = blend_color_mask();
+  if (!keep) return 0;
+  if (!*cache) *cache = (fl_uintptr_t)make_blend_image(img);
+  Fl_Xlib_Blend_Image *b = (Fl_Xlib_Blend_Image*)*cache;
+  int l = cx > b->x ? cx : b->x;
+  int t = cy > b->y ? cy : b->y;
+  int r = cx + W < b->x + b->w ? cx + W : b->x + b->w;
+  int bottom = cy + H < b->y + b->h ? cy + H : b->y + b->h;
+  if (r <= l || bottom <= t) return 1; // only transparent pixels
+  X += l - cx; Y += t - cy; W = r - l; H = bottom - t;
+  // reading outside of the drawable is an error, the caller copes with it
+  blend_error = 0;
+  XErrorHandler old_handler = XSetErrorHandler(blend_error_handler);
+  XImage *image = XGetImage(fl_display, fl_window, X, Y, W, H, AllPlanes, ZPixmap);
+  XSetErrorHandler(old_handler);
+  if (!image) return 0;
+  if (blend_error || image->bits_per_pixel != 32) {
+    XDestroyImage(image);
+    return 0;
+  }
+  int offset = (t - b->y) * b->w + l - b->x;
+  for (int j = 0; j < H; j++, offset += b->w) {
+    blend_row((unsigned*)(image->data + j * image->bytes_per_line),
+              b->pixels + offset, b->alpha + offset, W, keep);
+  }
+  XPutImage(fl_display, fl_window, gc, image, 0, 0, X, Y, W, H);
+  XDestroyImage(image);
+  return 1;
+}
 
 // Composite an image with alpha on systems that don't have accelerated
-// alpha compositing...
+// alpha compositing, and whose visual blend_to_drawable() can't handle...
 static void alpha_blend(Fl_RGB_Image *img, int X, int Y, int W, int H, int cx, int cy) {
   int ld = img->ld();
   if (ld == 0) ld = img->w() * img->d();
   uchar *srcptr = (uchar*)img->array + cy * ld + cx * img->d();
   int srcskip = ld - img->d() * W;
 
-  uchar *dst = new uchar[W * H * 3];
+  // the buffer is kept for the next image
+  static uchar *dst = 0;
+  static int dst_size = 0;
+  if (W * H * 3 > dst_size) {
+    delete[] dst;
+    dst_size = W * H * 3;
+    dst = new uchar[dst_size];
+  }
   uchar *dstptr = dst;
 
   fl_read_image(dst, X, Y, W, H, 0);
@@ -691,8 +875,6 @@ static void alpha_blend(Fl_RGB_Image *img, int X, int Y, int W, int H, int cx, i
   }
 
   fl_draw_image(dst, X, Y, W, H, 3, 0);
-
-  delete[] dst;
 }
 
 static Fl_Offscreen cache_rgb(Fl_RGB_Image *img) {
@@ -715,7 +897,19 @@ static Fl_Offscreen cache_rgb(Fl_RGB_Image *img) {
   return off;
 }
 
+// the memory held by the offscreens of an image, for Fl_Image::cache_budget()
+static size_t cached_bytes(Fl_RGB_Image *img, fl_uintptr_t id, fl_uintptr_t mask) {
+  size_t bytes = 0;
+  if (id) bytes += (size_t)img->w() * img->h() * 4;
+  if (mask) {
+    Fl_Xlib_Blend_Image *b = (Fl_Xlib_Blend_Image*)mask;
+    bytes += sizeof(*b) + (size_t)b->w * b->h * (sizeof(unsigned) + 1);
+  }
+  return bytes;
+}
+
 void Fl_Xlib_Graphics_Driver::draw(Fl_RGB_Image *img, int XP, int YP, int WP, int HP, int cx, int cy) {
+  flush_glyphs();
   int X, Y, W, H;
   XP += offset_x_;
   YP += offset_y_;
@@ -740,8 +934,9 @@ void Fl_Xlib_Graphics_Driver::draw(Fl_RGB_Image *img, int XP, int YP, int WP, in
     }
   } else {
     // Composite image with alpha manually each time...
-    alpha_blend(img, X, Y, W, H, cx, cy);
+    if (!blend_to_drawable(img, Fl_Graphics_Driver::mask(img), X, Y, W, H, cx, cy, gc_)) alpha_blend(img, X, Y, W, H, cx, cy);
   }
+  image_cached(img, cached_bytes(img, *Fl_Graphics_Driver::id(img), *Fl_Graphics_Driver::mask(img)));
 }
 
 void Fl_Xlib_Graphics_Driver::uncache(Fl_RGB_Image*, fl_uintptr_t &id_, fl_uintptr_t &mask_)
@@ -750,6 +945,10 @@ void Fl_Xlib_Graphics_Driver::uncache(Fl_RGB_Image*, fl_uintptr_t &id_, fl_uintp
     XFreePixmap(fl_display, (Fl_Offscreen)id_);
     id_ = 0;
   }
+  if (mask_) {
+    delete_blend_image((Fl_Xlib_Blend_Image*)mask_);
+    mask_ = 0;
+  }
 }
 
 fl_uintptr_t Fl_Xlib_Graphics_Driver::cache(Fl_Bitmap*, int w, int h, const uchar *array) {
@@ -792,6 +991,9 @@ void Fl_Xlib_Graphics_Driver::draw(Fl_Pixmap *pxm, int XP, int YP, int WP, int H
     restore_clip();
   }
   else copy_offscreen(X-offset_x_, Y-offset_y_, W, H, *Fl_Graphics_Driver::id(pxm), cx, cy);
+  size_t bytes = (size_t)pxm->w() * pxm->h() * 4;
+  if (*Fl_Graphics_Driver::mask(pxm)) bytes += ((pxm->w() + 7) / 8) * pxm->h();
+  image_cached(pxm, bytes);
 }
 
 
@@ -814,6 +1016,7 @@ fl_uintptr_t Fl_Xlib_Graphics_Driver::cache(Fl_Pixmap *img, int w, int h, const
 
 #if HAVE_XRENDER
 int Fl_Xlib_Graphics_Driver::scale_and_render_pixmap(Fl_Offscreen pixmap, int depth, double scale_x, double scale_y, int srcx, int srcy, int XP, int YP, int WP, int HP) {
+  flush_glyphs();
   XRenderPictureAttributes srcattr;
   memset(&srcattr, 0, sizeof(XRenderPictureAttributes));
   static XRenderPictFormat *fmt32 = XRenderFindStandardFormat(fl_display, PictStandardARGB32);
@@ -850,6 +1053,7 @@ int Fl_Xlib_Graphics_Driver::draw_scaled(Fl_Image *img, int XP, int YP, int WP,
   if (!*Fl_Graphics_Driver::id(rgb)) {
     *Fl_Graphics_Driver::id(rgb) = cache_rgb(rgb);
   }
+  image_cached(rgb, cached_bytes(rgb, *Fl_Graphics_Driver::id(rgb), *Fl_Graphics_Driver::mask(rgb)));
   return scale_and_render_pixmap(*Fl_Graphics_Driver::id(rgb), rgb->d(), rgb->w()/double(WP), rgb->h()/double(HP),
                           0, 0, XP, YP, WP, HP);
 }
@@ -164,10 +164,12 @@ void Fl_Xlib_Graphics_Driver::XDestroyRegion(Fl_Region r) {
 // --- line and polygon drawing with integer coordinates
 
 void Fl_Xlib_Graphics_Driver::point(int x, int y) {
+  flush_glyphs();
   XDrawPoint(fl_display, fl_window, gc_, clip_x(x+offset_x_), clip_x(y+offset_y_));
 }
 
 void Fl_Xlib_Graphics_Driver::rect(int x, int y, int w, int h) {
+  flush_glyphs();
   if (w<=0 || h<=0) return;
   x+=offset_x_; y+=offset_y_;
   if (!clip_to_short(x, y, w, h, line_width_))
@@ -175,6 +177,7 @@ void Fl_Xlib_Graphics_Driver::rect(int x, int y, int w, int h) {
 }
 
 void Fl_Xlib_Graphics_Driver::rectf(int x, int y, int w, int h) {
+  flush_glyphs();
   if (w<=0 || h<=0) return;
   x+=offset_x_; y+=offset_y_;
   if (!clip_to_short(x, y, w, h, line_width_))
@@ -182,10 +185,12 @@ void Fl_Xlib_Graphics_Driver::rectf(int x, int y, int w, int h) {
 }
 
 void Fl_Xlib_Graphics_Driver::line(int x, int y, int x1, int y1) {
+  flush_glyphs();
   XDrawLine(fl_display, fl_window, gc_, x+offset_x_, y+offset_y_, x1+offset_x_, y1+offset_y_);
 }
 
 void Fl_Xlib_Graphics_Driver::line(int x, int y, int x1, int y1, int x2, int y2) {
+  flush_glyphs();
   XPoint p[3];
   p[0].x = x+offset_x_;  p[0].y = y+offset_y_;
   p[1].x = x1+offset_x_; p[1].y = y1+offset_y_;
@@ -194,10 +199,12 @@ void Fl_Xlib_Graphics_Driver::line(int x, int y, int x1, int y1, int x2, int y2)
 }
 
 void Fl_Xlib_Graphics_Driver::xyline(int x, int y, int x1) {
+  flush_glyphs();
   XDrawLine(fl_display, fl_window, gc_, clip_x(x+offset_x_), clip_x(y+offset_y_), clip_x(x1+offset_x_), clip_x(y+offset_y_));
 }
 
 void Fl_Xlib_Graphics_Driver::xyline(int x, int y, int x1, int y2) {
+  flush_glyphs();
   XPoint p[3];
   p[0].x = clip_x(x+offset_x_);  p[0].y = p[1].y = clip_x(y+offset_y_);
   p[1].x = p[2].x = clip_x(x1+offset_x_); p[2].y = clip_x(y2+offset_y_);
@@ -205,6 +212,7 @@ void Fl_Xlib_Graphics_Driver::xyline(int x, int y, int x1, int y2) {
 }
 
 void Fl_Xlib_Graphics_Driver::xyline(int x, int y, int x1, int y2, int x3) {
+  flush_glyphs();
   XPoint p[4];
   p[0].x = clip_x(x+offset_x_);  p[0].y = p[1].y = clip_x(y+offset_y_);
   p[1].x = p[2].x = clip_x(x1+offset_x_); p[2].y = p[3].y = clip_x(y2+offset_y_);
@@ -213,10 +221,12 @@ void Fl_Xlib_Graphics_Driver::xyline(int x, int y, int x1, int y2, int x3) {
 }
 
 void Fl_Xlib_Graphics_Driver::yxline(int x, int y, int y1) {
+  flush_glyphs();
   XDrawLine(fl_display, fl_window, gc_, clip_x(x+offset_x_), clip_x(y+offset_y_), clip_x(x+offset_x_), clip_x(y1+offset_y_));
 }
 
 void Fl_Xlib_Graphics_Driver::yxline(int x, int y, int y1, int x2) {
+  flush_glyphs();
   XPoint p[3];
   p[0].x = p[1].x = clip_x(x+offset_x_);  p[0].y = clip_x(y+offset_y_);
   p[1].y = p[2].y = clip_x(y1+offset_y_); p[2].x = clip_x(x2+offset_x_);
@@ -224,6 +234,7 @@ void Fl_Xlib_Graphics_Driver::yxline(int x, int y, int y1, int x2) {
 }
 
 void Fl_Xlib_Graphics_Driver::yxline(int x, int y, int y1, int x2, int y3) {
+  flush_glyphs();
   XPoint p[4];
   p[0].x = p[1].x = clip_x(x+offset_x_);  p[0].y = clip_x(y+offset_y_);
   p[1].y = p[2].y = clip_x(y1+offset_y_); p[2].x = p[3].x = clip_x(x2+offset_x_);
@@ -232,6 +243,7 @@ void Fl_Xlib_Graphics_Driver::yxline(int x, int y, int y1, int x2, int y3) {
 }
 
 void Fl_Xlib_Graphics_Driver::loop(int x, int y, int x1, int y1, int x2, int y2) {
+  flush_glyphs();
   XPoint p[4];
   p[0].x = x+offset_x_;  p[0].y = y+offset_y_;
   p[1].x = x1+offset_x_; p[1].y = y1+offset_y_;
@@ -241,6 +253,7 @@ void Fl_Xlib_Graphics_Driver::loop(int x, int y, int x1, int y1, int x2, int y2)
 }
 
 void Fl_Xlib_Graphics_Driver::loop(int x, int y, int x1, int y1, int x2, int y2, int x3, int y3) {
+  flush_glyphs();
   XPoint p[5];
   p[0].x = x+offset_x_;  p[0].y = y+offset_y_;
   p[1].x = x1+offset_x_; p[1].y = y1+offset_y_;
@@ -251,6 +264,7 @@ void Fl_Xlib_Graphics_Driver::loop(int x, int y, int x1, int y1, int x2, int y2,
 }
 
 void Fl_Xlib_Graphics_Driver::polygon(int x, int y, int x1, int y1, int x2, int y2) {
+  flush_glyphs();
   XPoint p[4];
   p[0].x = x+offset_x_;  p[0].y = y+offset_y_;
   p[1].x = x1+offset_x_; p[1].y = y1+offset_y_;
@@ -261,6 +275,7 @@ void Fl_Xlib_Graphics_Driver::polygon(int x, int y, int x1, int y1, int x2, int
 }
 
 void Fl_Xlib_Graphics_Driver::polygon(int x, int y, int x1, int y1, int x2, int y2, int x3, int y3) {
+  flush_glyphs();
   XPoint p[5];
   p[0].x = x+offset_x_;  p[0].y = y+offset_y_;
   p[1].x = x1+offset_x_; p[1].y = y1+offset_y_;
@@ -346,6 +361,7 @@ void Fl_Xlib_Graphics_Driver::pop_clip() {
 }
 
 void Fl_Xlib_Graphics_Driver::restore_clip() {
+  flush_glyphs();
   fl_clip_state_number++;
   if (gc_) {
     Fl_Region r = rstack[rstackptr];
@@ -39,10 +39,12 @@ void Fl_Xlib_Graphics_Driver::vertex(double x,double y) {
 }
 
 void Fl_Xlib_Graphics_Driver::end_points() {
+  flush_glyphs();
   if (n>1) XDrawPoints(fl_display, fl_window, gc_, (XPoint*)p, n, 0);
 }
 
 void Fl_Xlib_Graphics_Driver::end_line() {
+  flush_glyphs();
   if (n < 2) {
     end_points();
     return;
@@ -57,6 +59,7 @@ void Fl_Xlib_Graphics_Driver::end_loop() {
 }
 
 void Fl_Xlib_Graphics_Driver::end_polygon() {
+  flush_glyphs();
   fixloop();
   if (n < 3) {
     end_line();
@@ -81,6 +84,7 @@ void Fl_Xlib_Graphics_Driver::gap() {
 }
 
 void Fl_Xlib_Graphics_Driver::end_complex_polygon() {
+  flush_glyphs();
   gap();
   if (n < 3) {
     end_line();
@@ -94,6 +98,7 @@ void Fl_Xlib_Graphics_Driver::end_complex_polygon() {
 // See fl_arc.c for portable version.
 
 void Fl_Xlib_Graphics_Driver::circle(double x, double y,double r) {
+  flush_glyphs();
   double xt = transform_x(x,y);
   double yt = transform_y(x,y);
   double rx = r * (m.c ? sqrt(m.a*m.a+m.c*m.c) : fabs(m.a));
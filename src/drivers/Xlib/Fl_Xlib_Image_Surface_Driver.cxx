@@ -53,6 +53,10 @@ Fl_Xlib_Image_Surface_Driver::Fl_Xlib_Image_Surface_Driver(int w, int h, int hig
 }
 
 Fl_Xlib_Image_Surface_Driver::~Fl_Xlib_Image_Surface_Driver() {
+#if USE_XFT
+  // also drops the text still batched for the pixmap, as fl_delete_offscreen() ends here
+  if (offscreen) Fl_Xlib_Graphics_Driver::destroy_xft_draw(offscreen);
+#endif
   if (offscreen) XFreePixmap(fl_display, offscreen);
   delete driver();
 }
@@ -26,6 +26,7 @@
 #include <FL/Fl.H>
 #include <FL/Fl_Device.H>
 #include <FL/Fl_Graphics_Driver.H>
+#include "Fl_Sprite_Cache.H"
 #include <FL/Fl.H>
 
 // fl_cmap needs to be defined globally (here) and is used in the device
@@ -70,6 +71,7 @@ void Fl::set_color(Fl_Color i, uchar red, uchar green, uchar blue) {
 void Fl::set_color(Fl_Color i, unsigned c)
 {
   Fl_Graphics_Driver::default_driver().set_color(i, c);
+  Fl_Sprite_Cache::clear(); // the boxes were drawn with the old color
 }
 
 
@@ -0,0 +1,111 @@
+//
+// "$Id$"
+//
+// Compressed image data support for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 1998-2017 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     http://www.fltk.org/COPYING.php
+//
+// Please report all bugs and problems on the following page:
+//
+//     http://www.fltk.org/str.php
+//
+
+#include <config.h>
+#include <FL/Fl_Image.H>
+#include <FL/Fl_Bitmap.H>
+#include <FL/Fl_Pixmap.H>
+#include <stdio.h>
+#include <string.h>
+#if HAVE_LIBZ
+#  include <zlib.h>
+#endif
+
+#if HAVE_LIBZ
+
+// Splits the lines of XPM data, each followed by a nul byte, into the
+// array of strings Fl_Pixmap uses. A colormap in binary form (ncolors < 0)
+// is 4 * -ncolors bytes that may contain nul bytes themselves.
+static char **split_xpm(const uchar *buf, int length) {
+  int w, h, ncolors, cpp;
+  if (sscanf((const char *)buf, "%d%d%d%d", &w, &h, &ncolors, &cpp) != 4 || h <= 0) return 0;
+  int n = 1 + (ncolors < 0 ? 1 : ncolors) + h;
+  char **lines = new char*[n];
+  const uchar *p = buf, *e = buf + length;
+  int i;
+  for (i = 0; i < n && p < e; i++) {
+    int len = (i == 1 && ncolors < 0) ? -4 * ncolors : (int)strlen((const char *)p);
+    if (p + len >= e) break;
+    lines[i] = new char[len + 1];
+    memcpy(lines[i], p, len + 1);
+    p += len + 1;
+  }
+  if (i < n) {
+    while (i > 0) delete[] lines[--i];
+    delete[] lines;
+    return 0;
+  }
+  return lines;
+}
+
+#endif // HAVE_LIBZ
+
+/**
+ Creates an image from image data compressed with zlib.
+
+ This is used by the code fluid writes when its project setting
+ "Compress image data" is on, so that images take less room in the
+ sources and in the program. The data is inflated into memory owned by
+ the new image.
+
+ \param[in] data the compressed data, in zlib format
+ \param[in] size the number of bytes of \p data, if it is \p length the
+   data is not compressed
+ \param[in] length the number of bytes of the data once inflated
+ \param[in] w, h the size of the image, ignored for a pixmap
+ \param[in] d the depth of an Fl_RGB_Image, 0 for an Fl_Bitmap, or -1 for
+   an Fl_Pixmap whose XPM lines each end with a nul byte
+ \param[in] ld the line size of an Fl_RGB_Image, see Fl_RGB_Image::ld()
+ \return the new image, or NULL if the data is damaged, or if the library
+   was built without zlib
+ \version 1.4.0
+ */
+Fl_Image *fl_inflate_image(const uchar *data, int size, int length, int w, int h, int d, int ld) {
+#if HAVE_LIBZ
+  if (!data || size <= 0 || length <= 0) return 0;
+  uchar *buf = new uchar[length];
+  uLongf n = (uLongf)length;
+  if (size == length) memcpy(buf, data, length);
+  else if (uncompress(buf, &n, data, (uLong)size) != Z_OK || n != (uLongf)length) {
+    delete[] buf;
+    return 0;
+  }
+  if (d > 0) {
+    Fl_RGB_Image *image = new Fl_RGB_Image(buf, w, h, d, ld);
+    image->alloc_array = 1;
+    return image;
+  }
+  if (d == 0) {
+    Fl_Bitmap *image = new Fl_Bitmap(buf, w, h);
+    image->alloc_array = 1;
+    return image;
+  }
+  char **lines = split_xpm(buf, length);
+  delete[] buf;
+  if (!lines) return 0;
+  Fl_Pixmap *image = new Fl_Pixmap(lines);
+  image->alloc_data = 1;
+  return image;
+#else
+  return 0;
+#endif // HAVE_LIBZ
+}
+
+//
+// End of "$Id$".
+//
@@ -29,6 +29,9 @@
 
 #ifdef USE_XOR
 #include <config.h>
+#  if defined(USE_X11)
+#    include "drivers/Xlib/Fl_Xlib_Graphics_Driver.H"
+#  endif
 #endif
 
 static int px,py,pw,ph;
@@ -42,6 +45,7 @@ static int bgx, bgy, bgw, bgh;
 static void draw_current_rect() {
 #ifdef USE_XOR
 # if defined(USE_X11)
+  Fl_Xlib_Graphics_Driver::flush_glyphs(); // the rectangle goes over the text drawn so far
   GC gc = (GC)fl_graphics_driver->gc();
   XSetFunction(fl_display, gc, GXxor);
   XSetForeground(fl_display, gc, 0xffffffff);
@@ -351,17 +351,19 @@ static void down_round(int x, int y, int w, int h, Fl_Color c) {
 
 
 extern void fl_internal_boxtype(Fl_Boxtype, Fl_Box_Draw_F*);
+extern void fl_internal_cached_boxtype(Fl_Boxtype, Fl_Box_Draw_F*);
 
 
 Fl_Boxtype fl_define_FL_PLASTIC_UP_BOX() {
-  fl_internal_boxtype(_FL_PLASTIC_UP_BOX, up_box);
-  fl_internal_boxtype(_FL_PLASTIC_DOWN_BOX, down_box);
+  fl_internal_cached_boxtype(_FL_PLASTIC_UP_BOX, up_box);
+  fl_internal_cached_boxtype(_FL_PLASTIC_DOWN_BOX, down_box);
+  // frames are not cached, see fl_internal_cached_boxtype()
   fl_internal_boxtype(_FL_PLASTIC_UP_FRAME, up_frame);
   fl_internal_boxtype(_FL_PLASTIC_DOWN_FRAME, down_frame);
-  fl_internal_boxtype(_FL_PLASTIC_THIN_UP_BOX, thin_up_box);
-  fl_internal_boxtype(_FL_PLASTIC_THIN_DOWN_BOX, down_box);
-  fl_internal_boxtype(_FL_PLASTIC_ROUND_UP_BOX, up_round);
-  fl_internal_boxtype(_FL_PLASTIC_ROUND_DOWN_BOX, down_round);
+  fl_internal_cached_boxtype(_FL_PLASTIC_THIN_UP_BOX, thin_up_box);
+  fl_internal_cached_boxtype(_FL_PLASTIC_THIN_DOWN_BOX, down_box);
+  fl_internal_cached_boxtype(_FL_PLASTIC_ROUND_UP_BOX, up_round);
+  fl_internal_cached_boxtype(_FL_PLASTIC_ROUND_DOWN_BOX, down_round);
 
   return _FL_PLASTIC_UP_BOX;
 }
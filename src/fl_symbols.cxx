@@ -29,6 +29,7 @@
 #include <FL/fl_draw.H>
 #include <FL/math.h>
 #include "flstring.h"
+#include "Fl_Sprite_Cache.H"
 
 typedef struct {
   const char *name;
@@ -102,6 +103,7 @@ int fl_return_arrow(int x,int y,int w,int h);
 // provided for back compatibility:
 int fl_draw_symbol(const char *label,int x,int y,int w,int h,Fl_Color col) {  
   const char *p = label;
+  int x0 = x, y0 = y, w0 = w, h0 = h;
   if (*p++ != '@') return 0;
   fl_init_symbols();
   int equalscale = 0;
@@ -150,6 +152,12 @@ int fl_draw_symbol(const char *label,int x,int y,int w,int h,Fl_Color col) {
     fl_return_arrow(x,y,w,h);
     return 1;
   }
+  if (symbols[pos].scalable == 1) {
+    // leave room for the corners of rotated symbols
+    int mx = w/4 + 2, my = h/4 + 2;
+    if (Fl_Sprite_Cache::draw_symbol(label, x0, y0, w0, h0, col, x-mx, y-my, w+2*mx, h+2*my))
+      return 1;
+  }
   fl_push_matrix();
   fl_translate(x+w/2,y+h/2);
   if (symbols[pos].scalable) {
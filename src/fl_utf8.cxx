@@ -119,6 +119,26 @@ int fl_utf8len1(char c)
 } // fl_utf8len1
 
 
+/*
+  Returns the number of ASCII characters at the start of \p src, looking
+  at a machine word at a time. Meant for long runs of text, the conversion
+  loops use fl_utf8_ascii8() instead.
+*/
+unsigned fl_utf8_ascii_span(const char *src, unsigned srclen)
+{
+  const size_t high_bits = ((size_t)-1 / 0xff) * 0x80; // 0x8080...80
+  const char *p = src;
+  const char *e = src + srclen;
+  while ((size_t)(e - p) >= sizeof(size_t)) {
+    size_t w;
+    memcpy(&w, p, sizeof(w)); // unaligned load
+    if (w & high_bits) break;
+    p += sizeof(w);
+  }
+  while (p < e && !(*p & 0x80)) p++;
+  return (unsigned)(p - src);
+}
+
 /**
   Returns the number of Unicode chars in the UTF-8 string.
 */
@@ -130,6 +150,11 @@ fl_utf_nb_char(
   int i = 0;
   int nbc = 0;
   while (i < len) {
+    if (!(buf[i] & 0x80) && len - i >= 8 && fl_utf8_ascii8((const char*)buf+i)) {
+      nbc += 8;
+      i += 8;
+      continue;
+    }
     int cl = fl_utf8len((buf+i)[0]);
     if (cl < 1) cl = 1;
     nbc++;
@@ -891,9 +916,15 @@ unsigned fl_utf8toUtf16(const char* src, unsigned srclen,
   if (dstlen) for (;;) {
     if (p >= e) {dst[count] = 0; return count;}
     if (!(*p & 0x80)) { /* ascii */
+      if (e-p >= 8 && dstlen-count > 8 && fl_utf8_ascii8(p)) {
+        for (int i = 0; i < 8; i++) dst[count+i] = p[i];
+        p += 8;
+        count += 8;
+        continue;
+      }
       dst[count] = *p++;
     } else {
-      int len; unsigned ucs = fl_utf8decode(p,e,&len);
+      int len; unsigned ucs = fl_utf8decode_fast(p,e,&len);
       p += len;
       if (ucs < 0x10000) {
         dst[count] = ucs;
@@ -908,9 +939,11 @@ unsigned fl_utf8toUtf16(const char* src, unsigned srclen,
   }
   /* we filled dst, measure the rest: */
   while (p < e) {
-    if (!(*p & 0x80)) p++;
-    else {
-      int len; unsigned ucs = fl_utf8decode(p,e,&len);
+    if (!(*p & 0x80)) {
+      if (e-p >= 8 && fl_utf8_ascii8(p)) {p += 8; count += 8; continue;}
+      p++;
+    } else {
+      int len; unsigned ucs = fl_utf8decode_fast(p,e,&len);
       p += len;
       if (ucs >= 0x10000) ++count;
     }
@@ -1052,10 +1085,12 @@ int fl_utf8test(const char* src, unsigned srclen) {
   const char* e = src+srclen;
   while (p < e) {
     if (*p & 0x80) {
-      int len; fl_utf8decode(p,e,&len);
+      int len; fl_utf8decode_fast(p,e,&len);
       if (len < 2) return 0;
       if (len > ret) ret = len;
       p += len;
+    } else if (e-p >= 8 && fl_utf8_ascii8(p)) {
+      p += 8;
     } else {
       p++;
     }
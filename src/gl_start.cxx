@@ -97,6 +97,7 @@ void Fl_Cocoa_Gl_Window_Driver::gl_start() {
 #ifdef FL_CFG_GFX_XLIB
 #include <FL/x.H>
 #include "Fl_Gl_Choice.H"
+#include "drivers/Xlib/Fl_Xlib_Graphics_Driver.H"
 
 void Fl_X11_Gl_Window_Driver::gl_visual(Fl_Gl_Choice *c) {
   Fl_Gl_Window_Driver::gl_visual(c);
@@ -105,6 +106,7 @@ void Fl_X11_Gl_Window_Driver::gl_visual(Fl_Gl_Choice *c) {
 }
 
 void Fl_X11_Gl_Window_Driver::gl_start() {
+  Fl_Xlib_Graphics_Driver::flush_glyphs();
   glXWaitX();
 }
 
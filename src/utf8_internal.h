@@ -50,9 +50,60 @@ int
 XUtf8Toupper(
         int ucs);
 
+unsigned
+fl_utf8_ascii_span(
+        const char *src,
+        unsigned srclen);
+
 
 #  ifdef __cplusplus
 }
+
+#include <FL/fl_utf8.h>
+#include <string.h>
+
+/*
+  Returns non-zero if the 8 bytes at \p p are all ASCII. The conversion
+  loops use it to handle runs of ASCII 8 characters at a time.
+*/
+static inline int fl_utf8_ascii8(const char *p)
+{
+  unsigned int a, b;
+  if (p[7] & 0x80) return 0; // quick exit in short runs of ASCII
+  memcpy(&a, p, 4); // unaligned loads
+  memcpy(&b, p + 4, 4);
+  return !((a | b) & 0x80808080U);
+}
+
+/*
+  Same as fl_utf8decode(), but decodes the well-formed multibyte sequences
+  that make up most non-ASCII text inline. Sequences that fl_utf8decode()
+  may reject, depending on how it was configured, are left to it.
+  \p end must be set.
+*/
+static inline unsigned fl_utf8decode_fast(const char *p, const char *end, int *len)
+{
+  const unsigned char *u = (const unsigned char *)p;
+  if (u[0] >= 0xc2 && u[0] < 0xe0) {
+    if (end - p >= 2 && (u[1] & 0xc0) == 0x80) {
+      *len = 2;
+      return ((u[0] & 0x1f) << 6) | (u[1] & 0x3f);
+    }
+  } else if (u[0] > 0xe0 && u[0] < 0xef && u[0] != 0xed) {
+    if (end - p >= 3 && (u[1] & 0xc0) == 0x80 && (u[2] & 0xc0) == 0x80) {
+      *len = 3;
+      return ((u[0] & 0x0f) << 12) | ((u[1] & 0x3f) << 6) | (u[2] & 0x3f);
+    }
+  } else if (u[0] >= 0xf0 && u[0] < 0xf4 && end - p >= 4) {
+    if ((u[0] > 0xf0 || u[1] >= 0x90) && (u[1] & 0xc0) == 0x80 &&
+        (u[2] & 0xc0) == 0x80 && (u[3] & 0xc0) == 0x80 &&
+        !((u[1] & 0x0f) == 0x0f && u[2] == 0xbf && u[3] >= 0xbe)) {
+      *len = 4;
+      return ((u[0] & 0x07) << 18) | ((u[1] & 0x3f) << 12) | ((u[2] & 0x3f) << 6) | (u[3] & 0x3f);
+    }
+  }
+  return fl_utf8decode(p, end, len);
+}
 #  endif
 
 #endif /* _SRC__FL_UTF8_H */
@@ -0,0 +1,581 @@
+//
+// "$Id$"
+//
+// Benchmarks for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 1998-2017 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     http://www.fltk.org/COPYING.php
+//
+// Please report all bugs and problems on the following page:
+//
+//     http://www.fltk.org/str.php
+//
+
+#include <config.h>
+#include <FL/Fl_Window.H>
+#include <FL/Fl_Button.H>
+#include <FL/Fl_Table.H>
+#include <FL/Fl_Tree.H>
+#include <FL/Fl_Image_Surface.H>
+#include <FL/Fl_Framebuffer_Surface.H>
+#include <FL/Fl_PostScript.H>
+#include <FL/fl_draw.H>
+#include <FL/fl_utf8.h>
+#include <FL/filename.H>
+#include <FL/math.h>
+#if HAVE_GL
+#  include <FL/Fl_Gl_Window.H>
+#  include <FL/gl.h>
+#endif
+
+//
+// --- offscreen drawing throughput -------------------------------------------
+//
+// Renders a fixed set of scenes into a drawing surface, as many frames as
+// fit in about half a second per scene, and reports frames per second and
+// drawing primitives per second. The same scenes are drawn with each
+// graphics driver:
+//
+//   draw_framebuffer     Fl_Framebuffer_Surface, FLTK's software rasterizer.
+//                        Needs no display, so it also runs on build servers.
+//   draw_image_surface   Fl_Image_Surface, the platform's graphics system.
+//
+enum { DRAW_W = 640, DRAW_H = 480 };
+
+// repeatable pseudo random numbers, so every run draws the same frames
+static unsigned draw_seed;
+static int draw_random(int n) {
+  draw_seed = draw_seed * 1103515245 + 12345;
+  return (int)((draw_seed >> 8) % (unsigned)n);
+}
+
+static void draw_clear() {
+  fl_color(FL_BACKGROUND_COLOR);
+  fl_rectf(0, 0, DRAW_W, DRAW_H);
+}
+
+// many small filled and outlined rectangles in random colors
+static int draw_rects_scene() {
+  const int n = 2000;
+  draw_clear();
+  for (int i = 0; i < n; i++) {
+    int x = draw_random(DRAW_W), y = draw_random(DRAW_H);
+    fl_color(fl_rgb_color(draw_random(256), draw_random(256), draw_random(256)));
+    if (i & 1) fl_rectf(x, y, 8 + draw_random(64), 8 + draw_random(48));
+    else fl_rect(x, y, 8 + draw_random(64), 8 + draw_random(48));
+  }
+  return n;
+}
+
+// a screen full of text lines
+static int draw_text_scene() {
+  static const char *line = "The quick brown fox jumps over the lazy dog 0123456789 !?";
+  int n = 0;
+  draw_clear();
+  fl_font(FL_HELVETICA, 12);
+  fl_color(FL_FOREGROUND_COLOR);
+  for (int y = 14; y < DRAW_H; y += 14) {
+    for (int x = 2; x < DRAW_W; x += DRAW_W / 2, n++) fl_draw(line, x, y);
+  }
+  return n;
+}
+
+// opaque and translucent image blits
+static Fl_RGB_Image *draw_images[2];
+static int draw_images_scene() {
+  const int n = 400;
+  if (!draw_images[0]) {
+    static uchar rgb[32*32*3], rgba[32*32*4];
+    for (int i = 0; i < 32*32; i++) {
+      rgb[i*3] = (uchar)(i * 8); rgb[i*3+1] = (uchar)(i / 4); rgb[i*3+2] = 0x80;
+      rgba[i*4] = 0xff; rgba[i*4+1] = (uchar)(i / 4); rgba[i*4+2] = 0; rgba[i*4+3] = (uchar)(i % 32 * 8);
+    }
+    draw_images[0] = new Fl_RGB_Image(rgb, 32, 32, 3);
+    draw_images[1] = new Fl_RGB_Image(rgba, 32, 32, 4);
+  }
+  draw_clear();
+  for (int i = 0; i < n; i++) draw_images[i & 1]->draw(draw_random(DRAW_W - 32), draw_random(DRAW_H - 32));
+  return n;
+}
+
+// a view full of icons with alpha: round 16x16 and 32x32 icons with smooth
+// edges and transparent corners, in a grid like a file manager shows them.
+// On X11 without the RENDER extension (e.g. Xvfb -extension RENDER) FLTK
+// composites them itself.
+static Fl_RGB_Image *draw_icons[2];
+static int draw_icons_scene() {
+  int n = 0;
+  if (!draw_icons[0]) {
+    static uchar icon16[16*16*4], icon32[32*32*4];
+    for (int k = 0; k < 2; k++) {
+      int size = k ? 32 : 16;
+      uchar *p = k ? icon32 : icon16;
+      for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++, p += 4) {
+          double dx = x + 0.5 - size / 2.0, dy = y + 0.5 - size / 2.0;
+          double a = (size / 2.0 - 1 - sqrt(dx * dx + dy * dy)) * 255;
+          p[0] = (uchar)(x * 255 / size); p[1] = (uchar)(y * 255 / size); p[2] = 0xc0;
+          p[3] = a <= 0 ? 0 : a >= 255 ? 255 : (uchar)a;
+        }
+      }
+    }
+    draw_icons[0] = new Fl_RGB_Image(icon16, 16, 16, 4);
+    draw_icons[1] = new Fl_RGB_Image(icon32, 32, 32, 4);
+  }
+  draw_clear();
+  for (int y = 0; y + 40 <= DRAW_H; y += 40) {
+    for (int x = 0; x + 40 <= DRAW_W; x += 40, n += 2) {
+      draw_icons[1]->draw(x + 4, y + 4);
+      draw_icons[0]->draw(x + draw_random(24), y + draw_random(24));
+    }
+  }
+  return n;
+}
+
+// stars with a hole, drawn with the complex polygon functions
+static int draw_polygons_scene() {
+  const int n = 300;
+  draw_clear();
+  for (int i = 0; i < n; i++) {
+    double x = draw_random(DRAW_W), y = draw_random(DRAW_H), r = 10 + draw_random(40);
+    fl_color(fl_rgb_color(draw_random(256), draw_random(256), draw_random(256)));
+    fl_begin_complex_polygon();
+    for (int k = 0; k < 10; k++) {
+      double a = k * M_PI / 5, d = (k & 1) ? r / 2 : r;
+      fl_vertex(x + d * cos(a), y + d * sin(a));
+    }
+    fl_gap();
+    for (int k = 0; k < 6; k++) fl_vertex(x + r / 5 * cos(k * M_PI / 3), y + r / 5 * sin(k * M_PI / 3));
+    fl_end_complex_polygon();
+  }
+  return n;
+}
+
+// a table with text in every cell, drawn like test/table does
+class Draw_Table : public Fl_Table {
+  void draw_cell(TableContext context, int R, int C, int X, int Y, int W, int H) {
+    char s[40];
+    sprintf(s, "%d/%d", R, C);
+    switch (context) {
+      case CONTEXT_STARTPAGE:
+        fl_font(FL_HELVETICA, 12);
+        return;
+      case CONTEXT_COL_HEADER:
+      case CONTEXT_ROW_HEADER:
+        fl_push_clip(X, Y, W, H);
+        fl_draw_box(FL_THIN_UP_BOX, X, Y, W, H, FL_BACKGROUND_COLOR);
+        fl_color(FL_BLACK);
+        fl_draw(s, X, Y, W, H, FL_ALIGN_CENTER);
+        fl_pop_clip();
+        return;
+      case CONTEXT_CELL:
+        fl_push_clip(X, Y, W, H);
+        fl_color(FL_WHITE);
+        fl_rectf(X, Y, W, H);
+        fl_color(FL_BLACK);
+        fl_draw(s, X, Y, W, H, FL_ALIGN_CENTER);
+        fl_color(FL_LIGHT2);
+        fl_rect(X, Y, W, H);
+        fl_pop_clip();
+        return;
+      default:
+        return;
+    }
+  }
+public:
+  Draw_Table(int X, int Y, int W, int H) : Fl_Table(X, Y, W, H) {
+    rows(500); row_header(1); row_height_all(20);
+    cols(50); col_header(1); col_width_all(60);
+    end();
+  }
+};
+
+static Fl_Window *draw_table_window, *draw_tree_window;
+
+static Fl_Window *draw_window() {
+  Fl_Window *win = new Fl_Window(DRAW_W, DRAW_H);
+  win->set_visible(); // drawn without being shown
+  return win;
+}
+
+static Fl_Window *draw_table() {
+  if (!draw_table_window) {
+    draw_table_window = draw_window();
+    new Draw_Table(0, 0, DRAW_W, DRAW_H);
+    draw_table_window->end();
+  }
+  return draw_table_window;
+}
+
+static int draw_table_scene() {
+  ((Fl_Widget_Surface*)Fl_Surface_Device::surface())->draw(draw_table());
+  return 0;
+}
+
+static int draw_tree_scene() {
+  if (!draw_tree_window) {
+    draw_tree_window = draw_window();
+    Fl_Tree *tree = new Fl_Tree(0, 0, DRAW_W, DRAW_H);
+    char path[80];
+    for (int i = 0; i < 2000; i++) {
+      sprintf(path, "Group %d/Subgroup %d/Item %d", i / 100, i / 10 % 10, i);
+      tree->add(path);
+    }
+    draw_tree_window->end();
+  }
+  ((Fl_Widget_Surface*)Fl_Surface_Device::surface())->draw(draw_tree_window);
+  return 0;
+}
+
+static struct {
+  const char *name;
+  int (*draw)(); // draws one frame, returns the number of primitives or 0
+} draw_scenes[] = {
+  { "rects", draw_rects_scene },
+  { "text", draw_text_scene },
+  { "images", draw_images_scene },
+  { "icons", draw_icons_scene },
+  { "polygons", draw_polygons_scene },
+  { "table", draw_table_scene },
+  { "tree", draw_tree_scene },
+};
+
+// sync() waits until the surface has executed all drawing requests
+static void draw_benchmark(const char *name, Fl_Widget_Surface *surface, void (*sync)(Fl_Widget_Surface*)) {
+  for (unsigned s = 0; s < sizeof(draw_scenes) / sizeof(draw_scenes[0]); s++) {
+    char what[80];
+    double primitives = 0;
+    int frames = 0;
+    Fl_Surface_Device::push_current(surface);
+    draw_seed = 1;
+    draw_scenes[s].draw(); // warm up caches
+    sync(surface);
+    double t = Benchmark::now();
+    do {
+      draw_seed = 1;
+      primitives += draw_scenes[s].draw();
+      frames++;
+      if (frames % 4 == 0) sync(surface);
+    } while (Benchmark::now() - t < 0.5 && frames < 10000);
+    sync(surface);
+    t = Benchmark::now() - t;
+    Fl_Surface_Device::pop_current();
+    if (t <= 0) t = 1e-9;
+    snprintf(what, sizeof(what), "%s frames", draw_scenes[s].name);
+    Benchmark::report(name, what, frames / t, "frames/s");
+    if (primitives > 0) {
+      snprintf(what, sizeof(what), "%s primitives", draw_scenes[s].name);
+      Benchmark::report(name, what, primitives / t, "primitives/s");
+    }
+  }
+}
+
+static void draw_framebuffer_sync(Fl_Widget_Surface *) {
+}
+
+static void draw_framebuffer_benchmark() {
+  Fl_Framebuffer_Surface *surface = new Fl_Framebuffer_Surface(DRAW_W, DRAW_H);
+  draw_benchmark("draw_framebuffer", surface, draw_framebuffer_sync);
+  delete surface;
+}
+
+Benchmark draw_framebuffer("draw_framebuffer", draw_framebuffer_benchmark);
+
+// reading back one pixel makes the graphics system finish all drawings
+static void draw_image_surface_sync(Fl_Widget_Surface *) {
+  uchar pixel[3];
+  fl_read_image(pixel, 0, 0, 1, 1);
+}
+
+static void draw_image_surface_benchmark() {
+  fl_open_display();
+  Fl_Image_Surface *surface = new Fl_Image_Surface(DRAW_W, DRAW_H);
+  draw_benchmark("draw_image_surface", surface, draw_image_surface_sync);
+  delete surface;
+}
+
+Benchmark draw_image_surface("draw_image_surface", draw_image_surface_benchmark);
+
+//
+// --- a plot made of many polygons -------------------------------------------
+//
+// Two filled curves of 2000 points each, in one complex polygon so that
+// they overlap, and 3000 small markers: circles, triangles and diamonds,
+// drawn into an Fl_Framebuffer_Surface as many times as fit in about half a
+// second, with and without anti-aliasing and with both fill rules.
+//
+enum { POLYGON_PLOT_POINTS = 2000, POLYGON_PLOT_MARKERS = 3000 };
+
+static int polygon_plot_scene() {
+  const int n = POLYGON_PLOT_POINTS, base = DRAW_H - 20;
+  draw_clear();
+  fl_color(FL_DARK_CYAN);
+  fl_begin_complex_polygon();
+  for (int curve = 0; curve < 2; curve++) {
+    fl_vertex(DRAW_W - 10, base);
+    fl_vertex(10, base);
+    for (int i = 0; i < n; i++) {
+      double x = 10 + (DRAW_W - 20) * i / (double)(n - 1);
+      double y = DRAW_H / 2 - (DRAW_H / 3) * sin(x / (curve ? 37.0 : 53.0)) * cos(x / 211.0);
+      fl_vertex(x, y + draw_random(7));
+    }
+    fl_gap();
+  }
+  fl_end_complex_polygon();
+  for (int i = 0; i < POLYGON_PLOT_MARKERS; i++) {
+    int x = 10 + draw_random(DRAW_W - 20), y = 10 + draw_random(DRAW_H - 20);
+    fl_color(i & 1 ? FL_RED : FL_DARK_BLUE);
+    switch (i % 3) {
+      case 0: fl_pie(x - 3, y - 3, 7, 7, 0, 360); break;
+      case 1: fl_polygon(x, y - 4, x + 4, y + 3, x - 4, y + 3); break;
+      default: fl_polygon(x, y - 4, x + 4, y, x, y + 4, x - 4, y); break;
+    }
+  }
+  return 1 + POLYGON_PLOT_MARKERS;
+}
+
+static void polygon_plot_benchmark() {
+  Fl_Framebuffer_Surface *surface = new Fl_Framebuffer_Surface(DRAW_W, DRAW_H);
+  for (int mode = 0; mode < 4; mode++) {
+    surface->antialias(mode >= 2);
+    surface->nonzero_fill(mode & 1);
+    Fl_Surface_Device::push_current(surface);
+    int frames = 0;
+    double polygons = 0, t = Benchmark::now();
+    do {
+      draw_seed = 1;
+      polygons += polygon_plot_scene();
+      frames++;
+    } while (Benchmark::now() - t < 0.5 && frames < 10000);
+    t = Benchmark::now() - t;
+    Fl_Surface_Device::pop_current();
+    char what[80];
+    snprintf(what, sizeof(what), "%s, %s frames", mode >= 2 ? "anti-aliased" : "aliased",
+             mode & 1 ? "non-zero" : "even-odd");
+    Benchmark::report("polygon_plot", what, frames / t, "frames/s");
+    snprintf(what, sizeof(what), "%s, %s polygons", mode >= 2 ? "anti-aliased" : "aliased",
+             mode & 1 ? "non-zero" : "even-odd");
+    Benchmark::report("polygon_plot", what, polygons / t, "polygons/s");
+  }
+  delete surface;
+}
+
+Benchmark polygon_plot("polygon_plot", polygon_plot_benchmark);
+
+//
+// --- scrolling through many thumbnails --------------------------------------
+//
+// An image browser that shows 30 of IMAGE_CACHE_N thumbnails at a time, and
+// scrolls from the first to the last and back. The graphics driver keeps a
+// copy of each thumbnail it has drawn (an X Pixmap on X11) until
+// Fl_Image::cache_budget() makes it free the least recently drawn ones.
+//
+enum { IMAGE_CACHE_N = 3000, IMAGE_CACHE_SIZE = 96 };
+
+static void image_cache_benchmark() {
+  fl_open_display();
+  Fl_Image_Surface *surface = new Fl_Image_Surface(DRAW_W, DRAW_H);
+  const int size = IMAGE_CACHE_SIZE, n = IMAGE_CACHE_N, page = 30;
+  uchar *pixels = new uchar[size * size * 3];
+  Fl_RGB_Image **images = new Fl_RGB_Image*[n];
+  for (int i = 0; i < n; i++) {
+    for (int k = 0; k < size * size * 3; k++) pixels[k] = (uchar)(k * i);
+    Fl_RGB_Image thumbnail(pixels, size, size, 3);
+    images[i] = (Fl_RGB_Image*)thumbnail.copy(); // with its own pixels
+  }
+  size_t old_budget = Fl_Image::cache_budget();
+  static const size_t budgets[] = { 16 * 1024 * 1024, 0 };
+  Fl_Surface_Device::push_current(surface);
+  for (unsigned b = 0; b < sizeof(budgets) / sizeof(budgets[0]); b++) {
+    Fl_Image::cache_budget(budgets[b]);
+    Fl_Image::reset_cache_statistics();
+    size_t peak = 0;
+    int draws = 0;
+    Fl_Image_Cache_Statistics stats;
+    double t = Benchmark::now();
+    for (int pass = 0; pass < 2; pass++) {
+      for (int first = 0; first + page <= n; first += page / 3) {
+        int top = pass ? n - page - first : first;
+        for (int i = 0; i < page; i++, draws++) {
+          images[top + i]->draw((i % 6) * size, (i / 6) * size);
+        }
+        draw_image_surface_sync(surface);
+        Fl_Image::cache_statistics(stats);
+        if (stats.bytes > peak) peak = stats.bytes;
+      }
+    }
+    t = Benchmark::now() - t;
+    char what[40];
+    snprintf(what, sizeof(what), "budget %lu MB", (unsigned long)(budgets[b] >> 20));
+    if (!budgets[b]) strcpy(what, "no budget");
+    Benchmark::report("image_cache", what, draws / t, "draws/s");
+    Benchmark::report("image_cache", "  hits", stats.hits, "draws");
+    Benchmark::report("image_cache", "  misses", stats.misses, "draws");
+    Benchmark::report("image_cache", "  evictions", stats.evictions, "images");
+    Benchmark::report("image_cache", "  peak memory", peak / 1048576.0, "MB");
+    // start the next budget with no cached images
+    for (int i = 0; i < n; i++) images[i]->uncache();
+  }
+  Fl_Surface_Device::pop_current();
+  Fl_Image::cache_budget(old_budget);
+  for (int i = 0; i < n; i++) delete images[i];
+  delete[] images;
+  delete[] pixels;
+  delete surface;
+}
+
+Benchmark image_cache("image_cache", image_cache_benchmark);
+
+//
+// --- scheme boxes and symbols from the sprite cache -------------------------
+//
+// A shown window full of buttons with "plastic" and "gleam" boxes and
+// arrow symbols, redrawn as many times as fit in about half a second with
+// Fl::sprite_cache() off and on.
+//
+static void sprite_cache_benchmark() {
+  static const char *labels[] = { "@->", "@<-", "@2->", "@8->", "@+2>", "@search" };
+  Fl_Window *win = new Fl_Window(DRAW_W, DRAW_H, "sprite_cache");
+  for (int y = 0; y + 24 <= DRAW_H; y += 24) {
+    for (int x = 0; x + 64 <= DRAW_W; x += 64) {
+      Fl_Button *b = new Fl_Button(x, y, 64, 24, labels[(x / 64 + y / 24) % 6]);
+      b->box((x / 64) & 1 ? FL_GLEAM_UP_BOX : FL_PLASTIC_UP_BOX);
+      if ((x / 64 + y / 24) % 5 == 0) b->deactivate();
+    }
+  }
+  win->end();
+  win->show();
+  Fl::check();
+  int old_cache = Fl::sprite_cache();
+  for (int on = 0; on < 2; on++) {
+    Fl::sprite_cache(on);
+    int frames = 0;
+    double t = Benchmark::now();
+    do {
+      win->redraw();
+      Fl::flush();
+      frames++;
+      win->make_current();
+      uchar pixel[3];
+      fl_read_image(pixel, 0, 0, 1, 1); // waits for the drawings
+    } while (Benchmark::now() - t < 0.5 && frames < 10000);
+    t = Benchmark::now() - t;
+    Benchmark::report("sprite_cache", on ? "cache on" : "cache off", frames / t, "frames/s");
+  }
+  Fl::sprite_cache(old_cache);
+  delete win;
+}
+
+Benchmark sprite_cache("sprite_cache", sprite_cache_benchmark);
+
+//
+// --- widgets in an OpenGL window --------------------------------------------
+//
+// The table of draw_table_scene() and a tree like the one of draw_tree_scene()
+// as children of a shown Fl_Gl_Window, drawn by the OpenGL graphics driver
+// as many times as fit in about half a second. With Mesa, setting
+// LIBGL_ALWAYS_SOFTWARE=1 measures its software rasterizer.
+//
+#if HAVE_GL
+
+static void draw_opengl_benchmark() {
+  Fl_Gl_Window *win = new Fl_Gl_Window(DRAW_W, DRAW_H, "draw_opengl");
+  Fl_Widget *scenes[2];
+  scenes[0] = new Draw_Table(0, 0, DRAW_W, DRAW_H);
+  Fl_Tree *tree = new Fl_Tree(0, 0, DRAW_W, DRAW_H);
+  char path[80];
+  for (int i = 0; i < 2000; i++) {
+    sprintf(path, "Group %d/Subgroup %d/Item %d", i / 100, i / 10 % 10, i);
+    tree->add(path);
+  }
+  tree->hide();
+  scenes[1] = tree;
+  win->end();
+  win->show();
+  Fl::check();
+  for (int s = 0; s < 2; s++) {
+    char what[80];
+    int frames = 0;
+    scenes[s]->show();
+    scenes[1 - s]->hide();
+    win->redraw();
+    Fl::flush(); // warm up the glyph texture
+    win->make_current();
+    glFinish();
+    double t = Benchmark::now();
+    do {
+      win->redraw();
+      Fl::flush();
+      frames++;
+      if (frames % 4 == 0) { win->make_current(); glFinish(); }
+    } while (Benchmark::now() - t < 0.5 && frames < 10000);
+    win->make_current();
+    glFinish();
+    t = Benchmark::now() - t;
+    snprintf(what, sizeof(what), "%s frames", s ? "tree" : "table");
+    Benchmark::report("draw_opengl", what, frames / t, "frames/s");
+  }
+  delete win;
+}
+
+Benchmark draw_opengl("draw_opengl", draw_opengl_benchmark);
+
+#endif // HAVE_GL
+
+//
+// --- printing table pages to PostScript -------------------------------------
+//
+// A batch print job: the table of draw_table_scene() on as many pages as
+// fit in about half a second, written by Fl_PostScript_File_Device to a
+// scratch file with each PostScript language level.
+//
+static void print_postscript_benchmark() {
+  char path[FL_PATH_MAX], what[80];
+  const char *tmp = getenv("TMPDIR");
+#ifdef WIN32
+  if (!tmp) tmp = getenv("TEMP");
+#endif
+  if (!tmp) tmp = "/tmp";
+  snprintf(path, sizeof(path), "%s/fltk-benchmark-%lu.ps", tmp, (unsigned long)(Benchmark::now() * 1000));
+  fl_open_display(); // PostScript text is measured with the display's fonts
+  for (int level = 2; level <= 3; level++) {
+    FILE *f = fl_fopen(path, "w");
+    if (!f) {
+      fprintf(stderr, "print_postscript: cannot create %s\n", path);
+      return;
+    }
+    Fl_PostScript_File_Device *printer = new Fl_PostScript_File_Device;
+    printer->language_level(level);
+    printer->start_job(f, 0, Fl_Paged_Device::A4);
+    int pages = 0;
+    double t = Benchmark::now();
+    do {
+      printer->start_page();
+      printer->scale(0.8f);
+      printer->draw(draw_table());
+      printer->end_page();
+      pages++;
+    } while (Benchmark::now() - t < 0.5 && pages < 10000);
+    printer->end_job(); // leaves the file open
+    t = Benchmark::now() - t;
+    long size = ftell(f);
+    fclose(f);
+    delete printer;
+    snprintf(what, sizeof(what), "level %d pages", level);
+    Benchmark::report("print_postscript", what, pages / t, "pages/s");
+    snprintf(what, sizeof(what), "level %d output", level);
+    Benchmark::report("print_postscript", what, size / 1024.0 / pages, "KB/page");
+  }
+  fl_unlink(path);
+}
+
+Benchmark print_postscript("print_postscript", print_postscript_benchmark);
+
+//
+// End of "$Id$".
+//
@@ -0,0 +1,189 @@
+//
+// "$Id$"
+//
+// Benchmarks for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 1998-2017 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     http://www.fltk.org/COPYING.php
+//
+// Please report all bugs and problems on the following page:
+//
+//     http://www.fltk.org/str.php
+//
+
+#include <FL/Fl_Double_Window.H>
+#include <FL/Fl_Group.H>
+#include <FL/Fl_Button.H>
+#include <FL/Fl_Menu_Bar.H>
+#include <FL/Fl_Light_Button.H>
+#include <FL/Fl_Framebuffer_Surface.H>
+#include <FL/Fl_Trace.H>
+#include <FL/filename.H>
+#include <FL/fl_utf8.h>
+
+//
+// --- shortcut dispatch in a large window ------------------------------------
+//
+// A window with SHORTCUT_BUTTONS buttons in groups, some of them with a
+// shortcut, and a menu bar with SHORTCUT_ITEMS items that all have one.
+// Keystrokes are sent to the window like the platform code does, with
+// Fl::shortcut_index() off and on.
+//
+enum { SHORTCUT_BUTTONS = 3000, SHORTCUT_ITEMS = 1500, SHORTCUT_KEYS = 20000 };
+
+static int shortcut_hits;
+static void shortcut_cb(Fl_Widget *, void *) { shortcut_hits++; }
+
+// the shortcut of menu item i, there are more items than keys
+static int shortcut_of_item(int i) {
+  static const int mods[] = { FL_CTRL, FL_ALT, FL_CTRL|FL_SHIFT, FL_CTRL|FL_ALT, FL_META };
+  return mods[(i / 36) % 5] + (i % 36 < 26 ? 'a' + i % 36 : '0' + i % 36 - 26);
+}
+
+static Fl_Window *shortcut_window() {
+  Fl_Window *window = new Fl_Double_Window(800, 600);
+  Fl_Menu_Bar *bar = new Fl_Menu_Bar(0, 0, 800, 25);
+  char path[64];
+  for (int i = 0; i < SHORTCUT_ITEMS; i++) {
+    snprintf(path, sizeof(path), "Menu %d/Submenu %d/Item %d", i / 100, i / 10, i);
+    bar->add(path, shortcut_of_item(i), shortcut_cb);
+  }
+  for (int g = 0; g < SHORTCUT_BUTTONS / 30; g++) {
+    Fl_Group *group = new Fl_Group(0, 25, 800, 575);
+    for (int i = 0; i < 30; i++) {
+      Fl_Button *b = new Fl_Button(i * 26, 25 + g * 5, 25, 5, "Button");
+      b->type(FL_TOGGLE_BUTTON); // a push button would start a timer
+      b->callback(shortcut_cb);
+      if (i == 0) b->shortcut(FL_SHIFT + FL_F + 1 + g % 12);
+    }
+    group->end();
+  }
+  window->end();
+  window->set_visible(); // as if it was shown
+  return window;
+}
+
+static void shortcut_send(Fl_Window *window, int state, int key) {
+  static char text[2];
+  text[0] = (char)(key < 128 && !(state & (FL_CTRL|FL_ALT|FL_META)) ? key : 0);
+  Fl::e_state = state;
+  Fl::e_keysym = key;
+  Fl::e_text = text;
+  Fl::e_length = text[0] ? 1 : 0;
+  Fl::e_x = 400; Fl::e_y = 300; // the mouse is over the buttons
+  Fl::handle(FL_SHORTCUT, window);
+}
+
+static void shortcut_dispatch_benchmark() {
+  int old_index = Fl::shortcut_index(), old_focus = Fl::visible_focus();
+  Fl::visible_focus(0); // the window has no focus to take
+  for (int on = 0; on < 2; on++) {
+    Fl::shortcut_index(on);
+    Fl_Window *window = shortcut_window();
+    const char *mode = on ? "index" : "no index";
+    char what[60];
+
+    shortcut_hits = 0;
+    double t = Benchmark::now();
+    for (int i = 0; i < SHORTCUT_KEYS; i++) {
+      int s = shortcut_of_item(SHORTCUT_ITEMS - 1 - i % 200);
+      shortcut_send(window, s & ~FL_KEY_MASK, s & FL_KEY_MASK);
+    }
+    t = Benchmark::now() - t;
+    snprintf(what, sizeof(what), "%s, menu item", mode);
+    Benchmark::report("shortcut_dispatch", what, SHORTCUT_KEYS / t, "keys/s");
+    if (shortcut_hits != SHORTCUT_KEYS) printf("shortcut_dispatch: %d menu items of %d found\n", shortcut_hits, SHORTCUT_KEYS);
+
+    shortcut_hits = 0;
+    t = Benchmark::now();
+    for (int i = 0; i < SHORTCUT_KEYS; i++) shortcut_send(window, FL_SHIFT, FL_F + 1 + i % 12);
+    t = Benchmark::now() - t;
+    snprintf(what, sizeof(what), "%s, button", mode);
+    Benchmark::report("shortcut_dispatch", what, SHORTCUT_KEYS / t, "keys/s");
+    if (shortcut_hits != SHORTCUT_KEYS) printf("shortcut_dispatch: %d buttons of %d found\n", shortcut_hits, SHORTCUT_KEYS);
+
+    shortcut_hits = 0;
+    t = Benchmark::now();
+    for (int i = 0; i < SHORTCUT_KEYS / 10; i++) shortcut_send(window, FL_CTRL|FL_SHIFT, FL_F + 1 + i % 12);
+    t = Benchmark::now() - t;
+    snprintf(what, sizeof(what), "%s, no shortcut", mode);
+    Benchmark::report("shortcut_dispatch", what, SHORTCUT_KEYS / 10 / t, "keys/s");
+    if (shortcut_hits) printf("shortcut_dispatch: %d keys without shortcut found one\n", shortcut_hits);
+
+    delete window;
+  }
+  Fl::shortcut_index(old_index);
+  Fl::visible_focus(old_focus);
+  Fl::e_text = (char*)"";
+  Fl::e_length = 0;
+}
+
+Benchmark shortcut_dispatch("shortcut_dispatch", shortcut_dispatch_benchmark);
+
+//
+// --- cost of Fl_Trace when drawing many widgets -----------------------------
+//
+// A group of TRACE_WIDGETS buttons in subgroups is drawn with the
+// framebuffer driver, which needs no display, with tracing off and on.
+//
+enum { TRACE_WIDGETS = 2000, TRACE_DRAWS = 50 };
+
+static void trace_overhead_benchmark() {
+  Fl_Group::current(0);
+  Fl_Group *all = new Fl_Group(0, 0, 800, 600);
+  for (int i = 0; i < TRACE_WIDGETS / 20; i++) {
+    Fl_Group *g = new Fl_Group((i % 10) * 80, (i / 10) * 60, 80, 60);
+    for (int k = 0; k < 20; k++) {
+      if (k & 1) new Fl_Button(g->x() + (k % 4) * 20, g->y() + (k / 4) * 12, 20, 12, "b");
+      else new Fl_Light_Button(g->x() + (k % 4) * 20, g->y() + (k / 4) * 12, 20, 12, "l");
+    }
+    g->end();
+  }
+  all->end();
+  Fl_Framebuffer_Surface *surface = new Fl_Framebuffer_Surface(800, 600);
+  Fl_Surface_Device::push_current(surface);
+  char path[FL_PATH_MAX];
+  const char *tmp = getenv("TMPDIR");
+#ifdef WIN32
+  if (!tmp) tmp = getenv("TEMP");
+#endif
+  if (!tmp) tmp = "/tmp";
+  snprintf(path, sizeof(path), "%s/fltk-benchmark-%lu.json", tmp, (unsigned long)(Benchmark::now() * 1000));
+
+  for (int on = 0; on < 2; on++) {
+    Fl_Trace::reset();
+    Fl_Trace::enable(on);
+    double t = Benchmark::now();
+    for (int i = 0; i < TRACE_DRAWS; i++) surface->draw(all);
+    t = Benchmark::now() - t;
+    Fl_Trace::enable(0);
+    Benchmark::report("trace_overhead", on ? "draw, tracing" : "draw", TRACE_DRAWS * TRACE_WIDGETS / t, "widgets/s");
+  }
+  for (int i = 0; i < Fl_Trace::widget_classes(); i++) {
+    const Fl_Trace_Histogram *h = Fl_Trace::widget_class(i);
+    char what[80];
+    snprintf(what, sizeof(what), "%s, 99th percentile", h->name);
+    Benchmark::report("trace_overhead", what, h->percentile(99) * 1e6, "us");
+  }
+  double t = Benchmark::now();
+  if (Fl_Trace::write_chrome_trace(path)) fprintf(stderr, "trace_overhead: cannot write %s\n", path);
+  t = Benchmark::now() - t;
+  Benchmark::report("trace_overhead", "write trace", t * 1000, "ms");
+  fl_unlink(path);
+  Fl_Trace::reset();
+
+  Fl_Surface_Device::pop_current();
+  delete surface;
+  delete all;
+}
+
+Benchmark trace_overhead("trace_overhead", trace_overhead_benchmark);
+
+//
+// End of "$Id$".
+//
@@ -0,0 +1,199 @@
+//
+// "$Id$"
+//
+// Benchmarks for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 1998-2017 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     http://www.fltk.org/COPYING.php
+//
+// Please report all bugs and problems on the following page:
+//
+//     http://www.fltk.org/str.php
+//
+
+#include <FL/Fl_File_Browser.H>
+#include <FL/Fl_File_Icon.H>
+#include <FL/Fl_Framebuffer_Surface.H>
+#include <FL/fl_utf8.h>
+#include <FL/filename.H>
+#include <ctype.h>
+
+//
+// --- loading a large directory into Fl_File_Browser -------------------------
+//
+enum { FILES_N = 20000, FILES_DIRS = 1000 };
+
+// creates a scratch directory with FILES_N files and FILES_DIRS directories
+static const char *files_make_directory() {
+  static char dir[FL_PATH_MAX];
+  char path[FL_PATH_MAX + 32]; // dir, a slash and the longest name below
+  const char *tmp = getenv("TMPDIR");
+#ifdef WIN32
+  if (!tmp) tmp = getenv("TEMP");
+#endif
+  if (!tmp) tmp = "/tmp";
+  snprintf(dir, sizeof(dir), "%s/fltk-benchmark-%lu", tmp, (unsigned long)(Benchmark::now() * 1000));
+  if (fl_mkdir(dir, 0700)) return 0;
+  for (int i = 0; i < FILES_N; i++) {
+    if (i < FILES_DIRS) {
+      snprintf(path, sizeof(path), "%s/folder%d", dir, i);
+      fl_mkdir(path, 0700);
+    }
+    snprintf(path, sizeof(path), "%s/file%d.%s", dir, i, (i & 1) ? "txt" : "cxx");
+    FILE *f = fl_fopen(path, "w");
+    if (f) fclose(f);
+  }
+  return dir;
+}
+
+static void files_remove_directory(const char *dir) {
+  char path[FL_PATH_MAX + 32];
+  for (int i = 0; i < FILES_N; i++) {
+    if (i < FILES_DIRS) {
+      snprintf(path, sizeof(path), "%s/folder%d", dir, i);
+      fl_rmdir(path);
+    }
+    snprintf(path, sizeof(path), "%s/file%d.%s", dir, i, (i & 1) ? "txt" : "cxx");
+    fl_unlink(path);
+  }
+  fl_rmdir(dir);
+}
+
+static void file_browser_load_benchmark() {
+  const char *dir = files_make_directory();
+  if (!dir) {
+    fprintf(stderr, "file_browser_load: cannot create a scratch directory\n");
+    return;
+  }
+  // a few icons, so that the browser looks them up like Fl_File_Chooser does
+  if (!Fl_File_Icon::first()) {
+    new Fl_File_Icon("*", Fl_File_Icon::PLAIN);
+    new Fl_File_Icon("*.cxx", Fl_File_Icon::PLAIN);
+    new Fl_File_Icon("*", Fl_File_Icon::DIRECTORY);
+  }
+  // measure text with the framebuffer driver, which needs no display
+  Fl_Framebuffer_Surface *surface = new Fl_Framebuffer_Surface(400, 300);
+  Fl_Surface_Device::push_current(surface);
+  Fl_File_Browser *browser = new Fl_File_Browser(0, 0, 400, 300);
+  browser->incremental(1);
+  double t = Benchmark::now(), t0 = t;
+  int n = browser->load(dir);
+  t = Benchmark::now() - t;
+  Benchmark::report("file_browser_load", "load", t * 1000, "ms");
+
+  // the first screen full of lines, as the user sees it after load()
+  t = Benchmark::now();
+  surface->draw(browser);
+  t = Benchmark::now() - t;
+  Benchmark::report("file_browser_load", "first draw", t * 1000, "ms");
+
+  // the entries that load() left to its idle callback
+  browser->load_finish();
+  t = Benchmark::now();
+  Fl_Surface_Device::pop_current();
+  Benchmark::report("file_browser_load", "complete list", (t - t0) * 1000, "ms");
+  Benchmark::report("file_browser_load", "entries", n / (t - t0), "entries/s");
+
+  delete surface;
+  delete browser;
+  files_remove_directory(dir);
+}
+
+Benchmark file_browser_load("file_browser_load", file_browser_load_benchmark);
+
+//
+// --- looking up file icons --------------------------------------------------
+//
+// A set of patterns like load_system_icons() registers from the KDE or
+// GNOME mime types, and 100000 filenames to look up.
+//
+static const char *icon_exts[] = {
+  "txt", "c", "cxx", "cpp", "h", "hpp", "py", "pl", "sh", "java", "js", "html",
+  "htm", "css", "xml", "json", "md", "tex", "pdf", "ps", "eps", "png", "jpg",
+  "jpeg", "gif", "bmp", "tif", "tiff", "xpm", "xbm", "svg", "ico", "mp3",
+  "ogg", "wav", "flac", "mp4", "avi", "mkv", "mov", "mpg", "zip", "gz", "bz2",
+  "xz", "tar", "tgz", "rar", "7z", "deb", "rpm", "iso", "img", "doc", "docx",
+  "xls", "xlsx", "ppt", "pptx", "odt", "ods", "odp", "rtf", "csv", "sql",
+  "db", "log", "conf", "ini", "cfg", "desktop", "o", "a", "so", "dll", "exe",
+  "fl", "cmake", "in", "am", "m4", "diff", "patch", "po", "pot", "ttf", "otf",
+  "pfa", "pfb", "afm", "bdf", "pcf", "fon", "ppd", "rb", "go", "rs", "lua"
+};
+
+static void file_icon_find_benchmark() {
+  const int nexts = (int)(sizeof(icon_exts) / sizeof(icon_exts[0]));
+  const int nnames = 100000;
+  Fl_File_Icon *icons[4 * nexts + 8];
+  char *patterns[2 * nexts], **names;
+  int i, nicons = 0, npatterns = 0;
+
+  // each extension in lower and upper case, like kde_to_fltk_pattern()
+  // makes them, and a few other patterns
+  icons[nicons++] = new Fl_File_Icon("*", Fl_File_Icon::PLAIN);
+  icons[nicons++] = new Fl_File_Icon("*", Fl_File_Icon::DIRECTORY);
+  icons[nicons++] = new Fl_File_Icon("core", Fl_File_Icon::PLAIN);
+  icons[nicons++] = new Fl_File_Icon("*.{bmp|bw|gif|jpg|pbm|pcd|pgm|ppm|png|ras|rgb|tif|xbm|xpm}", Fl_File_Icon::PLAIN);
+  icons[nicons++] = new Fl_File_Icon("{README*|INSTALL*|COPYING*}", Fl_File_Icon::PLAIN);
+  icons[nicons++] = new Fl_File_Icon("*.[ch]", Fl_File_Icon::PLAIN);
+  for (i = 0; i < nexts; i++) {
+    char upper[20];
+    int k;
+    for (k = 0; icon_exts[i][k]; k++) upper[k] = (char)toupper(icon_exts[i][k]);
+    upper[k] = 0;
+    patterns[npatterns] = new char[40];
+    snprintf(patterns[npatterns], 40, "{*.%s|*.%s}", icon_exts[i], upper);
+    icons[nicons++] = new Fl_File_Icon(patterns[npatterns++], Fl_File_Icon::PLAIN);
+    patterns[npatterns] = new char[40];
+    snprintf(patterns[npatterns], 40, "*.%s.bak", icon_exts[i]);
+    icons[nicons++] = new Fl_File_Icon(patterns[npatterns++], Fl_File_Icon::PLAIN);
+  }
+  icons[nicons++] = new Fl_File_Icon("*~", Fl_File_Icon::PLAIN);
+
+  names = new char*[nnames];
+  for (i = 0; i < nnames; i++) {
+    names[i] = new char[40];
+    switch (i % 10) {
+      case 0: snprintf(names[i], 40, "/home/user/README%d", i); break;
+      case 1: snprintf(names[i], 40, "/home/user/file%d.unknown", i); break;
+      case 2: snprintf(names[i], 40, "/home/user/file%d.%s.bak", i, icon_exts[i % nexts]); break;
+      default: snprintf(names[i], 40, "/home/user/File%d.%s", i, icon_exts[i % nexts]); break;
+    }
+  }
+
+  Fl_File_Icon::find(names[0], Fl_File_Icon::PLAIN); // compiles the patterns
+  double t = Benchmark::now();
+  for (i = 0; i < nnames; i++) {
+    Fl_File_Icon::find(names[i], Fl_File_Icon::PLAIN);
+  }
+  t = Benchmark::now() - t;
+  Benchmark::report("file_icon_find", "patterns", nicons, "icons");
+  Benchmark::report("file_icon_find", "find", nnames / t, "lookups/s");
+
+  // the same lookups done by matching every pattern in turn
+  t = Benchmark::now();
+  for (i = 0; i < nnames; i++) {
+    const char *name = fl_filename_name(names[i]);
+    for (Fl_File_Icon *icon = Fl_File_Icon::first(); icon; icon = icon->next()) {
+      if ((icon->type() == Fl_File_Icon::PLAIN || icon->type() == Fl_File_Icon::ANY) &&
+          (fl_filename_match(names[i], icon->pattern()) || fl_filename_match(name, icon->pattern())))
+        break;
+    }
+  }
+  t = Benchmark::now() - t;
+  Benchmark::report("file_icon_find", "pattern list", nnames / t, "lookups/s");
+
+  for (i = 0; i < nnames; i++) delete[] names[i];
+  delete[] names;
+  for (i = 0; i < nicons; i++) delete icons[i];
+  for (i = 0; i < npatterns; i++) delete[] patterns[i];
+}
+
+Benchmark file_icon_find("file_icon_find", file_icon_find_benchmark);
+
+//
+// End of "$Id$".
+//
@@ -0,0 +1,160 @@
+//
+// "$Id$"
+//
+// Benchmarks for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 1998-2017 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     http://www.fltk.org/COPYING.php
+//
+// Please report all bugs and problems on the following page:
+//
+//     http://www.fltk.org/str.php
+//
+
+#include <FL/Fl_Preferences.H>
+#include <FL/filename.H>
+#include <FL/fl_utf8.h>
+
+//
+// --- many entries and groups in one preferences node ------------------------
+//
+enum { PREFS_N = 100000, PREFS_GROUPS = 10000 };
+
+static void preferences_get_set_benchmark() {
+  // runtime preferences live in memory only
+  Fl_Preferences prefs((Fl_Preferences*)0, "benchmark");
+  char key[32];
+  int i, value, sum = 0;
+
+  double t = Benchmark::now();
+  for (i = 0; i < PREFS_N; i++) {
+    snprintf(key, sizeof(key), "key%d", i);
+    prefs.set(key, i);
+  }
+  t = Benchmark::now() - t;
+  Benchmark::report("preferences_get_set", "set new", PREFS_N / t, "calls/s");
+
+  t = Benchmark::now();
+  for (i = 0; i < PREFS_N; i++) {
+    snprintf(key, sizeof(key), "key%d", (i * 7919) % PREFS_N);
+    prefs.set(key, i);
+  }
+  t = Benchmark::now() - t;
+  Benchmark::report("preferences_get_set", "set existing", PREFS_N / t, "calls/s");
+
+  t = Benchmark::now();
+  for (i = 0; i < PREFS_N; i++) {
+    snprintf(key, sizeof(key), "key%d", (i * 7919) % PREFS_N);
+    prefs.get(key, value, 0);
+    sum += value;
+  }
+  t = Benchmark::now() - t;
+  Benchmark::report("preferences_get_set", "get", PREFS_N / t, "calls/s");
+
+  // one group per table column, each opened again by name
+  t = Benchmark::now();
+  for (i = 0; i < PREFS_GROUPS; i++) {
+    snprintf(key, sizeof(key), "column%d", i);
+    Fl_Preferences column(prefs, key);
+    column.set("width", 80);
+  }
+  for (i = 0; i < PREFS_GROUPS; i++) {
+    snprintf(key, sizeof(key), "column%d", (i * 7919) % PREFS_GROUPS);
+    Fl_Preferences column(prefs, key);
+    column.get("width", value, 0);
+    sum += value;
+  }
+  t = Benchmark::now() - t;
+  Benchmark::report("preferences_get_set", "groups", 2 * PREFS_GROUPS / t, "groups/s");
+
+  t = Benchmark::now();
+  for (i = 0; i < PREFS_GROUPS; i++) {
+    snprintf(key, sizeof(key), "column%d", i);
+    if (!prefs.groupExists(key)) sum = 0;
+  }
+  t = Benchmark::now() - t;
+  Benchmark::report("preferences_get_set", "groupExists", PREFS_GROUPS / t, "calls/s");
+
+  prefs.deleteAllGroups();
+  prefs.deleteAllEntries();
+  if (sum == 42) puts("");	// keep the compiler from dropping the get() calls
+}
+
+Benchmark preferences_get_set("preferences_get_set", preferences_get_set_benchmark);
+
+//
+// --- opening a large preferences file ---------------------------------------
+//
+// An application that stores PREFS_LOAD_GROUPS groups of 50 entries, but
+// reads only a few of them at startup.
+//
+enum { PREFS_LOAD_GROUPS = 2000 };
+
+static void preferences_load_benchmark() {
+  char path[FL_PATH_MAX], key[32];
+  const char *tmp = getenv("TMPDIR");
+#ifdef WIN32
+  if (!tmp) tmp = getenv("TEMP");
+#endif
+  if (!tmp) tmp = "/tmp";
+  snprintf(path, sizeof(path), "%s/fltk-benchmark-%lu.prefs", tmp, (unsigned long)(Benchmark::now() * 1000));
+  int i, k, value, sum = 0;
+
+  double t = Benchmark::now();
+  {
+    Fl_Preferences prefs(path, "fltk.org", 0);
+    for (i = 0; i < PREFS_LOAD_GROUPS; i++) {
+      snprintf(key, sizeof(key), "document%d", i);
+      Fl_Preferences doc(prefs, key);
+      for (k = 0; k < 50; k++) doc.set(Fl_Preferences::Name("setting%d", k), i + k);
+    }
+  }
+  t = Benchmark::now() - t;
+  Benchmark::report("preferences_load", "create and write", t * 1000, "ms");
+
+  const int runs = 10;
+  t = Benchmark::now();
+  for (i = 0; i < runs; i++) {
+    Fl_Preferences prefs(path, "fltk.org", 0);
+    Fl_Preferences doc(prefs, "document7");
+    doc.get("setting1", value, 0); sum += value;
+    doc.get("setting2", value, 0); sum += value;
+    doc.get("setting3", value, 0); sum += value;
+  }
+  t = Benchmark::now() - t;
+  Benchmark::report("preferences_load", "open, read 3 keys", t * 1000 / runs, "ms");
+
+  t = Benchmark::now();
+  {
+    Fl_Preferences prefs(path, "fltk.org", 0);
+    for (i = 0; i < prefs.groups(); i++) {
+      Fl_Preferences doc(prefs, prefs.group(i));
+      for (k = 0; k < doc.entries(); k++) { doc.get(doc.entry(k), value, 0); sum += value; }
+    }
+  }
+  t = Benchmark::now() - t;
+  Benchmark::report("preferences_load", "open, read all keys", t * 1000, "ms");
+
+  t = Benchmark::now();
+  {
+    Fl_Preferences prefs(path, "fltk.org", 0);
+    Fl_Preferences doc(prefs, "document7");
+    doc.set("setting1", -1);
+  }
+  t = Benchmark::now() - t;
+  Benchmark::report("preferences_load", "open, change 1 key", t * 1000, "ms");
+
+  fl_unlink(path);
+  if (sum == 42) puts("");
+}
+
+Benchmark preferences_load("preferences_load", preferences_load_benchmark);
+
+//
+// End of "$Id$".
+//
@@ -0,0 +1,143 @@
+//
+// "$Id$"
+//
+// Benchmarks for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 1998-2017 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     http://www.fltk.org/COPYING.php
+//
+// Please report all bugs and problems on the following page:
+//
+//     http://www.fltk.org/str.php
+//
+
+#include <FL/fl_draw.H>
+#include <FL/fl_utf8.h>
+#include <FL/Fl_Text_Buffer.H>
+#include <FL/filename.H>
+
+//
+// --- fl_width() throughput -------------------------------------------------
+//
+// Text heavy widgets measure the same short strings over and over again,
+// so this measures repeated calls with a few typical strings.
+//
+static const char *text_width_samples[][2] = {
+  { "ascii", "The quick brown fox jumps over the lazy dog 0123456789" },
+  { "latin", "Falsches \xc3\x9c" "ben von Xylophonmusik qu\xc3\xa4lt jeden gr\xc3\xb6\xc3\x9f" "eren Zwerg" },
+  { "cjk",   "\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e\xe3\x81\xae\xe3\x83\x86\xe3\x82\xad\xe3\x82\xb9\xe3\x83\x88"
+             "\xe4\xb8\xad\xe6\x96\x87\xe6\x96\x87\xe6\x9c\xac\xed\x95\x9c\xea\xb5\xad\xec\x96\xb4" },
+  { "emoji", "\xf0\x9f\x98\x80\xf0\x9f\x98\x83 smile \xf0\x9f\x8e\x89\xf0\x9f\x9a\x80 party" },
+};
+
+static void text_width_benchmark() {
+  const int calls = 200000;
+  fl_open_display();
+  fl_font(FL_HELVETICA, 14);
+  double sum = 0;
+  for (unsigned s = 0; s < sizeof(text_width_samples) / sizeof(text_width_samples[0]); s++) {
+    const char *str = text_width_samples[s][1];
+    int n = (int)strlen(str);
+    int chars = fl_utf_nb_char((const unsigned char*)str, n);
+    char what[80];
+    double t = Benchmark::now();
+    for (int i = 0; i < calls; i++) sum += fl_width(str, n);
+    t = Benchmark::now() - t;
+    if (t <= 0) t = 1e-9;
+    snprintf(what, sizeof(what), "fl_width(str,n) %s", text_width_samples[s][0]);
+    Benchmark::report("text_width", what, calls / t, "calls/s");
+    Benchmark::report("text_width", what, (double)calls * chars / t, "chars/s");
+  }
+  // single characters as used by cursor positioning and text wrapping
+  double t = Benchmark::now();
+  for (int i = 0; i < calls; i++) sum += fl_width((unsigned)(0x20 + i % 0x5f));
+  t = Benchmark::now() - t;
+  if (t <= 0) t = 1e-9;
+  Benchmark::report("text_width", "fl_width(c)", calls / t, "calls/s");
+  if (sum < 0) puts("unexpected negative text width");
+}
+
+Benchmark text_width("text_width", text_width_benchmark);
+
+//
+// --- UTF-8 conversions ------------------------------------------------------
+//
+// Each sample above repeated to about 1 MB, run through the functions that
+// count, check and transcode UTF-8 text, and loaded into an Fl_Text_Buffer.
+//
+static void utf8_convert_report(const char *sample, const char *function, double t, unsigned bytes) {
+  char what[80];
+  if (t <= 0) t = 1e-9;
+  snprintf(what, sizeof(what), "%s %s", function, sample);
+  Benchmark::report("utf8_convert", what, bytes / t / 1e6, "MB/s");
+}
+
+static void utf8_convert_benchmark() {
+  const unsigned size = 1000000;
+  const int runs = 10;
+  char *text = (char*)malloc(size + 100);
+  unsigned short *utf16 = (unsigned short*)malloc((size + 1) * sizeof(unsigned short));
+  wchar_t *wc = (wchar_t*)malloc((size + 1) * sizeof(wchar_t));
+  char *back = (char*)malloc(size * 2 + 1);
+  char path[FL_PATH_MAX];
+  const char *tmp = getenv("TMPDIR");
+#ifdef WIN32
+  if (!tmp) tmp = getenv("TEMP");
+#endif
+  if (!tmp) tmp = "/tmp";
+  snprintf(path, sizeof(path), "%s/fltk-benchmark-%lu.txt", tmp, (unsigned long)(Benchmark::now() * 1000));
+  unsigned sum = 0;
+  for (unsigned s = 0; s < sizeof(text_width_samples) / sizeof(text_width_samples[0]); s++) {
+    const char *sample = text_width_samples[s][0];
+    unsigned n = 0, len = (unsigned)strlen(text_width_samples[s][1]);
+    while (n + len + 1 < size) {
+      memcpy(text + n, text_width_samples[s][1], len);
+      n += len;
+      text[n++] = '\n';
+    }
+    text[n] = 0;
+    int i;
+    double t = Benchmark::now();
+    for (i = 0; i < runs; i++) sum += fl_utf_nb_char((const unsigned char*)text, n);
+    utf8_convert_report(sample, "fl_utf_nb_char", Benchmark::now() - t, runs * n);
+    t = Benchmark::now();
+    for (i = 0; i < runs; i++) sum += fl_utf8test(text, n);
+    utf8_convert_report(sample, "fl_utf8test", Benchmark::now() - t, runs * n);
+    t = Benchmark::now();
+    for (i = 0; i < runs; i++) sum += fl_utf8toUtf16(text, n, utf16, size + 1);
+    utf8_convert_report(sample, "fl_utf8toUtf16", Benchmark::now() - t, runs * n);
+    unsigned nwc = 0;
+    t = Benchmark::now();
+    for (i = 0; i < runs; i++) nwc = fl_utf8towc(text, n, wc, size + 1);
+    utf8_convert_report(sample, "fl_utf8towc", Benchmark::now() - t, runs * n);
+    t = Benchmark::now();
+    for (i = 0; i < runs; i++) sum += fl_utf8fromwc(back, size * 2 + 1, wc, nwc);
+    utf8_convert_report(sample, "fl_utf8fromwc", Benchmark::now() - t, runs * n);
+    if (memcmp(back, text, n)) printf("utf8_convert: fl_utf8fromwc() did not restore the %s text\n", sample);
+
+    FILE *f = fl_fopen(path, "wb");
+    if (!f) continue;
+    fwrite(text, 1, n, f);
+    fclose(f);
+    Fl_Text_Buffer *buffer = new Fl_Text_Buffer();
+    t = Benchmark::now();
+    buffer->loadfile(path);
+    utf8_convert_report(sample, "Fl_Text_Buffer::loadfile", Benchmark::now() - t, n);
+    if (buffer->length() != (int)n) printf("utf8_convert: loadfile() changed the %s text\n", sample);
+    delete buffer;
+    fl_unlink(path);
+  }
+  free(text); free(utf16); free(wc); free(back);
+  if (sum == 42) puts("");
+}
+
+Benchmark utf8_convert("utf8_convert", utf8_convert_benchmark);
+
+//
+// End of "$Id$".
+//
@@ -0,0 +1,127 @@
+//
+// "$Id$"
+//
+// Benchmarks for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 1998-2017 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     http://www.fltk.org/COPYING.php
+//
+// Please report all bugs and problems on the following page:
+//
+//     http://www.fltk.org/str.php
+//
+
+// Fltk benchmarks
+//
+// Usage: benchmarks [-l] [name ...]
+//
+//   -l      list the available benchmarks and exit
+//   name    run only the benchmarks whose name starts with one of the
+//           given names, e.g. "benchmarks text" (default: run all)
+//
+// Every measurement is printed as one tab separated line:
+//
+//   <benchmark> <measurement> <value> <unit>
+//
+// so that the results can be collected by scripts and compared between
+// builds to catch performance regressions.
+
+#include <FL/Fl.H>
+#include <FL/fl_draw.H>
+#include <FL/x.H>		// fl_open_display()
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef WIN32
+#  include <windows.h>
+#else
+#  include <sys/time.h>
+#endif
+
+// This class helps to automagically register a new benchmark with the
+// benchmarks app. Please see the examples on how this is used.
+class Benchmark {
+public:
+  Benchmark(const char *name, void (*run)()) {
+    fName = name;
+    fRun = run;
+    add(this);
+  }
+  const char *name() {
+    return fName;
+  }
+  void run() {
+    fRun();
+    fflush(stdout);
+  }
+  // print one measurement in the machine readable output format
+  static void report(const char *name, const char *what, double value, const char *unit) {
+    printf("%s\t%s\t%.6g\t%s\n", name, what, value, unit);
+  }
+  // wall clock time in seconds
+  static double now() {
+#ifdef WIN32
+    LARGE_INTEGER freq, t;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&t);
+    return (double)t.QuadPart / (double)freq.QuadPart;
+#else
+    struct timeval tv;
+    gettimeofday(&tv, 0);
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+#endif
+  }
+  static int numBenchmark() { return nBenchmark; }
+  static Benchmark *benchmark(int i) { return fBenchmark[i]; }
+private:
+  const char *fName;
+  void (*fRun)();
+
+  static void add(Benchmark *b) {
+    fBenchmark[nBenchmark] = b;
+    nBenchmark++;
+  }
+  static int nBenchmark;
+  static Benchmark *fBenchmark[];
+};
+
+int Benchmark::nBenchmark = 0;
+Benchmark *Benchmark::fBenchmark[200];
+
+//------- include the various benchmarks as inline code -------
+
+#include "benchmark_text.cxx"
+#include "benchmark_drawing.cxx"
+#include "benchmark_files.cxx"
+#include "benchmark_preferences.cxx"
+#include "benchmark_events.cxx"
+
+static int selected(const char *name, int argc, char **argv) {
+  if (argc < 2) return 1;
+  for (int i = 1; i < argc; i++) {
+    if (!strncmp(name, argv[i], strlen(argv[i]))) return 1;
+  }
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  int i, n = Benchmark::numBenchmark();
+  if (argc > 1 && !strcmp(argv[1], "-l")) {
+    for (i = 0; i < n; i++) puts(Benchmark::benchmark(i)->name());
+    return 0;
+  }
+  for (i = 0; i < n; i++) {
+    Benchmark *b = Benchmark::benchmark(i);
+    if (selected(b->name(), argc, argv)) b->run();
+  }
+  return 0;
+}
+
+//
+// End of "$Id$".
+//